@@ -35,6 +35,7 @@
 /* includes ----------------------------------------------------------------- */
 #include "crc/crc16_lookup.h"
 #include "crc/bit_utils.h"
+#include "crc/crc_combine.h"
 
 /* Private variables -------------------------------------------------------- */
 /**
@@ -294,4 +295,55 @@ void crc16_generate_table(uint16_t polynomial, uint16_t table[],
     }
 }
 
+uint16_t crc16_lookup_combine(crc16_lookup_param_model_e model, uint16_t crc1,
+                              uint16_t crc2, uint32_t len2) {
+    crc16_lookup_ctx_t ctx;
+    crc16_lookup_init(&ctx, model);
+
+    // Map both checksums back to raw register values
+    uint16_t reg1 = crc1 ^ ctx.xor_out;
+    uint16_t reg2 = crc2 ^ ctx.xor_out;
+    if (ctx.ref_out) {
+        reg1 = reverse_bits_16(reg1);
+        reg2 = reverse_bits_16(reg2);
+    }
+
+    // Block B started from ctx.init; restart it from the register left by A
+    uint16_t reg = reg2 ^ crc16_shift(ctx.poly, reg1 ^ ctx.init, len2);
+
+    if (ctx.ref_out) {
+        reg = reverse_bits_16(reg);
+    }
+    return reg ^ ctx.xor_out;
+}
+
+uint16_t crc16_lookup_patch(crc16_lookup_param_model_e model, uint16_t crc,
+                            const uint8_t* old_buf, const uint8_t* new_buf,
+                            uint32_t len, uint32_t tail_len) {
+    if (old_buf == NULL || new_buf == NULL) {
+        return crc;
+    }
+
+    crc16_lookup_ctx_t ctx;
+    crc16_lookup_init(&ctx, model);
+    uint16_t poly = ctx.poly;
+    bool ref_out = ctx.ref_out;
+
+    // Raw register (zero init, no final XOR) of the changed bits only
+    ctx.init = 0;
+    ctx.xor_out = 0;
+    ctx.ref_out = false;
+    for (uint32_t i = 0; i < len; i++) {
+        uint8_t diff = old_buf[i] ^ new_buf[i];
+        crc16_lookup_update(&ctx, &diff, 1);
+    }
+
+    // CRC is linear: XOR in the difference shifted over the tail
+    uint16_t delta = crc16_shift(poly, ctx.init, tail_len);
+    if (ref_out) {
+        delta = reverse_bits_16(delta);
+    }
+    return crc ^ delta;
+}
+
 /* ----------------------------- end of file -------------------------------- */
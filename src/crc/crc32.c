@@ -35,6 +35,7 @@
 /* includes ----------------------------------------------------------------- */
 #include "crc/crc32.h"
 #include "crc/bit_utils.h"
+#include "crc/crc_combine.h"
 
 /* Public functions --------------------------------------------------------- */
 void crc32_init(crc32_ctx_t* ctx, crc32_param_model_e model) {
@@ -141,4 +142,55 @@ bool crc32_verify_buf(crc32_param_model_e model, const uint8_t* buf,
     return (stored_crc == calculated_crc);
 }
 
+uint32_t crc32_combine(crc32_param_model_e model, uint32_t crc1,
+                       uint32_t crc2, uint32_t len2) {
+    crc32_ctx_t ctx;
+    crc32_init(&ctx, model);
+
+    // Map both checksums back to raw register values
+    uint32_t reg1 = crc1 ^ ctx.xor_out;
+    uint32_t reg2 = crc2 ^ ctx.xor_out;
+    if (ctx.ref_out) {
+        reg1 = reverse_bits_32(reg1);
+        reg2 = reverse_bits_32(reg2);
+    }
+
+    // Block B started from ctx.init; restart it from the register left by A
+    uint32_t reg = reg2 ^ crc32_shift(ctx.poly, reg1 ^ ctx.init, len2);
+
+    if (ctx.ref_out) {
+        reg = reverse_bits_32(reg);
+    }
+    return reg ^ ctx.xor_out;
+}
+
+uint32_t crc32_patch(crc32_param_model_e model, uint32_t crc,
+                     const uint8_t* old_buf, const uint8_t* new_buf,
+                     uint32_t len, uint32_t tail_len) {
+    if (old_buf == NULL || new_buf == NULL) {
+        return crc;
+    }
+
+    crc32_ctx_t ctx;
+    crc32_init(&ctx, model);
+    uint32_t poly = ctx.poly;
+    bool ref_out = ctx.ref_out;
+
+    // Raw register (zero init, no final XOR) of the changed bits only
+    ctx.init = 0;
+    ctx.xor_out = 0;
+    ctx.ref_out = false;
+    for (uint32_t i = 0; i < len; i++) {
+        uint8_t diff = old_buf[i] ^ new_buf[i];
+        crc32_update(&ctx, &diff, 1);
+    }
+
+    // CRC is linear: XOR in the difference shifted over the tail
+    uint32_t delta = crc32_shift(poly, ctx.init, tail_len);
+    if (ref_out) {
+        delta = reverse_bits_32(delta);
+    }
+    return crc ^ delta;
+}
+
 /* ----------------------------- end of file -------------------------------- */
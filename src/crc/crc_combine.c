@@ -0,0 +1,91 @@
+/**
+ * \file            crc_combine.c
+ * \brief           GF(2) polynomial arithmetic for combining and patching CRCs
+ * \date            2026-10-18
+ */
+
+/*
+ * Copyright (c) 2024 Vector Qiu
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE
+ * AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * This file is part of the CRC library.
+ *
+ * Author:          Vector Qiu <vetor.qiu@gmail.com>
+ * Version:         v0.0.1
+ */
+/* includes ----------------------------------------------------------------- */
+#include "crc/crc_combine.h"
+
+/* Public functions --------------------------------------------------------- */
+uint16_t crc16_multmodp(uint16_t poly, uint16_t a, uint16_t b) {
+    uint16_t p = 0;
+
+    // Horner's rule: walk a from its highest term, multiplying by x each step
+    for (int i = 15; i >= 0; i--) {
+        p = (p & 0x8000) ? (uint16_t)((p << 1) ^ poly) : (uint16_t)(p << 1);
+        if (a & (1U << i)) {
+            p ^= b;
+        }
+    }
+    return p;
+}
+
+uint16_t crc16_shift(uint16_t poly, uint16_t reg, uint32_t len) {
+    uint16_t xp = 0x0100; // x^8, one zero byte
+
+    // Square-and-multiply: reg * x^(8 * len) mod poly
+    while (len) {
+        if (len & 1) {
+            reg = crc16_multmodp(poly, xp, reg);
+        }
+        xp = crc16_multmodp(poly, xp, xp);
+        len >>= 1;
+    }
+    return reg;
+}
+
+uint32_t crc32_multmodp(uint32_t poly, uint32_t a, uint32_t b) {
+    uint32_t p = 0;
+
+    for (int i = 31; i >= 0; i--) {
+        p = (p & 0x80000000) ? (p << 1) ^ poly : p << 1;
+        if (a & (1UL << i)) {
+            p ^= b;
+        }
+    }
+    return p;
+}
+
+uint32_t crc32_shift(uint32_t poly, uint32_t reg, uint32_t len) {
+    uint32_t xp = 0x00000100; // x^8, one zero byte
+
+    while (len) {
+        if (len & 1) {
+            reg = crc32_multmodp(poly, xp, reg);
+        }
+        xp = crc32_multmodp(poly, xp, xp);
+        len >>= 1;
+    }
+    return reg;
+}
+
+/* ----------------------------- end of file -------------------------------- */
@@ -42,6 +42,7 @@
 
 /* includes ----------------------------------------------------------------- */
 #include <stdbool.h>
+#include <stddef.h>
 #include <stdint.h>
 
 #ifdef __cplusplus
@@ -170,6 +171,41 @@ void crc16_pack_buf(crc16_param_model_e model, uint8_t* buf, uint32_t len);
 bool crc16_verify_buf(crc16_param_model_e model, const uint8_t* buf,
                       uint32_t len);
 
+/**
+ * \brief           Combine the checksums of two adjacent data blocks.
+ *
+ * Given the CRC16 of block A and the CRC16 of block B, this function returns
+ * the CRC16 of A followed by B without reading either block again. It runs in
+ * O(log len2) time.
+ *
+ * \param[in]       model: The CRC16 model both checksums were computed with.
+ * \param[in]       crc1: CRC16 checksum of the first block.
+ * \param[in]       crc2: CRC16 checksum of the second block.
+ * \param[in]       len2: Length of the second block in bytes.
+ * \return          The CRC16 checksum of the concatenated blocks.
+ */
+uint16_t crc16_combine(crc16_param_model_e model, uint16_t crc1,
+                       uint16_t crc2, uint32_t len2);
+
+/**
+ * \brief           Update a checksum after bytes inside the data changed.
+ *
+ * Only the changed bytes are read; the data following them is accounted for
+ * by shifting in O(log tail_len) time. This is meant for frames whose header
+ * is rewritten while the payload stays the same.
+ *
+ * \param[in]       model: The CRC16 model the checksum was computed with.
+ * \param[in]       crc: CRC16 checksum of the data before the change.
+ * \param[in]       old_buf: The changed bytes before the change.
+ * \param[in]       new_buf: The changed bytes after the change.
+ * \param[in]       len: Number of changed bytes.
+ * \param[in]       tail_len: Number of checksummed bytes following the
+ *                  changed bytes.
+ * \return          The CRC16 checksum of the data after the change.
+ */
+uint16_t crc16_patch(crc16_param_model_e model, uint16_t crc,
+                     const uint8_t* old_buf, const uint8_t* new_buf,
+                     uint32_t len, uint32_t tail_len);
 /**
  * \}
  */
@@ -42,6 +42,7 @@
 
 /* includes ----------------------------------------------------------------- */
 #include <stdbool.h>
+#include <stddef.h>
 #include <stdint.h>
 
 #ifdef __cplusplus
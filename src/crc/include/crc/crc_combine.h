@@ -0,0 +1,112 @@
+/**
+ * \file            crc_combine.h
+ * \brief           GF(2) polynomial arithmetic for combining and patching CRCs
+ * \date            2026-10-18
+ *
+ * This file provides the polynomial primitives used to shift a CRC register
+ * over a run of zero bytes in O(log n) time. They back the `*_combine` and
+ * `*_patch` functions of the CRC16 and CRC32 modules.
+ */
+
+/*
+ * Copyright (c) 2024 Vector Qiu
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE
+ * AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * This file is part of the CRC library.
+ *
+ * Author:          Vector Qiu <vetor.qiu@gmail.com>
+ * Version:         v0.0.1
+ */
+#ifndef __CRC_COMBINE_H__
+#define __CRC_COMBINE_H__
+
+/* includes ----------------------------------------------------------------- */
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+/**
+ * \defgroup        crc_combine_manager CRC Combine Manager
+ * \brief           Polynomial arithmetic modulo a CRC generator polynomial.
+ * \{
+ */
+
+/* Public functions --------------------------------------------------------- */
+/**
+ * \brief           Multiply two polynomials modulo a 16-bit CRC polynomial.
+ *
+ * Polynomials are in the non-reflected register domain: bit 0 holds x^0 and
+ * the implicit x^16 term of \p poly is omitted.
+ *
+ * \param[in]       poly: The CRC16 generator polynomial.
+ * \param[in]       a: First polynomial.
+ * \param[in]       b: Second polynomial.
+ * \return          a * b mod poly.
+ */
+uint16_t crc16_multmodp(uint16_t poly, uint16_t a, uint16_t b);
+
+/**
+ * \brief           Shift a CRC16 register over a run of zero bytes.
+ *
+ * This is equivalent to feeding \p len zero bytes into a CRC16 register that
+ * holds \p reg, but runs in O(log len) time.
+ *
+ * \param[in]       poly: The CRC16 generator polynomial.
+ * \param[in]       reg: The register value, in the non-reflected domain.
+ * \param[in]       len: Number of zero bytes to shift over.
+ * \return          The register value after the shift.
+ */
+uint16_t crc16_shift(uint16_t poly, uint16_t reg, uint32_t len);
+
+/**
+ * \brief           Multiply two polynomials modulo a 32-bit CRC polynomial.
+ *
+ * \param[in]       poly: The CRC32 generator polynomial.
+ * \param[in]       a: First polynomial.
+ * \param[in]       b: Second polynomial.
+ * \return          a * b mod poly.
+ */
+uint32_t crc32_multmodp(uint32_t poly, uint32_t a, uint32_t b);
+
+/**
+ * \brief           Shift a CRC32 register over a run of zero bytes.
+ *
+ * \param[in]       poly: The CRC32 generator polynomial.
+ * \param[in]       reg: The register value, in the non-reflected domain.
+ * \param[in]       len: Number of zero bytes to shift over.
+ * \return          The register value after the shift.
+ */
+uint32_t crc32_shift(uint32_t poly, uint32_t reg, uint32_t len);
+
+/**
+ * \}
+ */
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* __CRC_COMBINE_H__ */
+
+/* ----------------------------- end of file -------------------------------- */
@@ -36,8 +36,8 @@
 #include "./h1_protocol/h1_cmd_common.h"
 
 /* Private function prototypes ---------------------------------------------- */
-extern etype_e h1_protocol_tx_data(u8 source_id, u8 target_id, bool reliable_tx,
-                                   u8* data, size_t data_len);
+extern etype_e h1_protocol_tx_data(m1_t* m1, u8 source_id, u8 target_id,
+                                   bool reliable_tx, u8* data, size_t data_len);
 
 /* Public functions --------------------------------------------------------- */
 etype_e h1_cmd_ping_req(void* param, void* data) {
@@ -47,8 +47,8 @@ etype_e h1_cmd_ping_req(void* param, void* data) {
     link_hex("Ping Req", 16, ping_req->data, ping_req->size);
 
     frame_head->send_attr = H1_PROTO_SEND_ATTR_RESP;
-    h1_protocol_tx_data(rx_data->target_id, rx_data->source_id, false,
-                        (u8*)frame_head, rx_data->data_len);
+    h1_protocol_tx_data(rx_data->m1, rx_data->target_id, rx_data->source_id,
+                        false, (u8*)frame_head, rx_data->data_len);
 
     return E_STATE_OK;
 }
@@ -76,7 +76,7 @@ etype_e h1_cmd_set_module_status_req(void* param, void* data) {
             break;
     }
 
-    H1_SEND_RESP(rx_data->target_id, rx_data->source_id, &resp,
+    H1_SEND_RESP(rx_data->m1, rx_data->target_id, rx_data->source_id, &resp,
                  h1_set_module_status_resp_t, frame_head->cmd_type,
                  frame_head->cmd_id, H1_PROTO_RESP_ATTR_NO_ACK);
     return E_STATE_OK;
@@ -106,7 +106,7 @@ etype_e h1_cmd_get_module_status_req(void* param, void* data) {
             break;
     }
 
-    H1_SEND_RESP(rx_data->target_id, rx_data->source_id, &resp,
+    H1_SEND_RESP(rx_data->m1, rx_data->target_id, rx_data->source_id, &resp,
                  h1_get_module_status_resp_t, frame_head->cmd_type,
                  frame_head->cmd_id, H1_PROTO_RESP_ATTR_NO_ACK);
     return E_STATE_OK;
@@ -149,7 +149,7 @@ etype_e h1_cmd_set_device_info_req(void* param, void* data) {
         default:
             break;
     }
-    H1_SEND_RESP(rx_data->target_id, rx_data->source_id, &resp,
+    H1_SEND_RESP(rx_data->m1, rx_data->target_id, rx_data->source_id, &resp,
                  h1_set_device_info_resp_t, frame_head->cmd_type,
                  frame_head->cmd_id, H1_PROTO_RESP_ATTR_NO_ACK);
     return E_STATE_OK;
@@ -193,8 +193,8 @@ etype_e h1_cmd_get_device_info_req(void* param, void* data) {
         resp->size = 0;
     }
     u8 data_len = sizeof(h1_get_device_info_resp_t) + resp->size;
-    return h1_protocol_tx_data(rx_data->target_id, rx_data->source_id, false,
-                               resp_frame_buf,
+    return h1_protocol_tx_data(rx_data->m1, rx_data->target_id,
+                               rx_data->source_id, false, resp_frame_buf,
                                sizeof(h1_frame_head_t) + data_len);
 }
 
@@ -219,21 +219,24 @@ etype_e h1_cmd_get_device_info_resp(void* param, void* data) {
     return E_STATE_OK;
 }
 
-etype_e h1_set_module_status(u8 target_id, h1_set_module_status_req_t* req) {
-    H1_SEND_REQ(HOST_ID_SOURCE, target_id, req, h1_set_module_status_req_t,
+etype_e h1_set_module_status(m1_t* m1, u8 target_id,
+                             h1_set_module_status_req_t* req) {
+    H1_SEND_REQ(m1, HOST_ID_SOURCE, target_id, req, h1_set_module_status_req_t,
                 H1_PROTO_TYPE_COMMON, H1_CMD_ID_SET_MODULE_STATUS,
                 H1_PROTO_RESP_ATTR_ACK_NOW);
     return E_STATE_OK;
 }
 
-etype_e h1_get_module_status(u8 target_id, h1_get_module_status_req_t* req) {
-    H1_SEND_REQ(HOST_ID_SOURCE, target_id, req, h1_get_module_status_req_t,
+etype_e h1_get_module_status(m1_t* m1, u8 target_id,
+                             h1_get_module_status_req_t* req) {
+    H1_SEND_REQ(m1, HOST_ID_SOURCE, target_id, req, h1_get_module_status_req_t,
                 H1_PROTO_TYPE_COMMON, H1_CMD_ID_GET_MODULE_STATUS,
                 H1_PROTO_RESP_ATTR_ACK_NOW);
     return E_STATE_OK;
 }
 
-etype_e h1_set_device_info(u8 target_id, h1_set_device_info_req_t* req) {
+etype_e h1_set_device_info(m1_t* m1, u8 target_id,
+                           h1_set_device_info_req_t* req) {
     u16 data_len = sizeof(h1_set_device_info_req_t) + req->size;
     if (req->size > 64) {
         return E_STATE_NO_SPACE;
@@ -245,11 +248,12 @@ etype_e h1_set_device_info(u8 target_id, h1_set_device_info_req_t* req) {
     frame_head->cmd_type = H1_PROTO_TYPE_COMMON;
     frame_head->cmd_id = H1_CMD_ID_SET_DEVICE_INFO;
     memcpy(frame_head->data, req, data_len);
-    return h1_protocol_tx_data(HOST_ID_SOURCE, target_id, false, frame_buf,
+    return h1_protocol_tx_data(m1, HOST_ID_SOURCE, target_id, false, frame_buf,
                                sizeof(h1_frame_head_t) + data_len);
 }
 
-etype_e h1_get_device_info(u8 target_id, h1_get_device_info_req_t* req) {
+etype_e h1_get_device_info(m1_t* m1, u8 target_id,
+                           h1_get_device_info_req_t* req) {
     u8 frame_buf[sizeof(h1_frame_head_t) + sizeof(h1_get_device_info_req_t)] = {
         0};
     h1_frame_head_t* frame_head = (h1_frame_head_t*)frame_buf;
@@ -258,7 +262,7 @@ etype_e h1_get_device_info(u8 target_id, h1_get_device_info_req_t* req) {
     frame_head->cmd_type = H1_PROTO_TYPE_COMMON;
     frame_head->cmd_id = H1_CMD_ID_GET_DEVICE_INFO;
     memcpy(frame_head->data, req, sizeof(h1_get_device_info_req_t));
-    return h1_protocol_tx_data(HOST_ID_SOURCE, target_id, false, frame_buf,
+    return h1_protocol_tx_data(m1, HOST_ID_SOURCE, target_id, false, frame_buf,
                                sizeof(frame_buf));
 }
 
@@ -103,8 +103,8 @@ void h1_cmd_callback_handle(void* param, void* data) {
     }
 }
 
-etype_e h1_protocol_tx_data(u8 source_id, u8 target_id, bool reliable_tx,
-                            u8* data, size_t data_len) {
+etype_e h1_protocol_tx_data(m1_t* m1, u8 source_id, u8 target_id,
+                            bool reliable_tx, u8* data, size_t data_len) {
     m1_tx_data_t tx_data = {0};
 
     tx_data.version = M1_FRAME_VERSION_0;
@@ -116,7 +116,7 @@ etype_e h1_protocol_tx_data(u8 source_id, u8 target_id, bool reliable_tx,
     tx_data.data = data;
     tx_data.data_len = data_len;
 
-    return m1_protocol_tx_data(&tx_data);
+    return m1_protocol_tx_data(m1, &tx_data);
 }
 
 /* Private functions -------------------------------------------------------- */
@@ -135,11 +135,15 @@ etype_e h1_cmd_set_device_info_resp(void* param, void* data);
 etype_e h1_cmd_get_device_info_req(void* param, void* data);
 etype_e h1_cmd_get_device_info_resp(void* param, void* data);
 
-etype_e h1_set_module_status(u8 target_id, h1_set_module_status_req_t* req);
-etype_e h1_get_module_status(u8 target_id, h1_get_module_status_req_t* req);
-
-etype_e h1_set_device_info(u8 target_id, h1_set_device_info_req_t* req);
-etype_e h1_get_device_info(u8 target_id, h1_get_device_info_req_t* req);
+etype_e h1_set_module_status(m1_t* m1, u8 target_id,
+                             h1_set_module_status_req_t* req);
+etype_e h1_get_module_status(m1_t* m1, u8 target_id,
+                             h1_get_module_status_req_t* req);
+
+etype_e h1_set_device_info(m1_t* m1, u8 target_id,
+                           h1_set_device_info_req_t* req);
+etype_e h1_get_device_info(m1_t* m1, u8 target_id,
+                           h1_get_device_info_req_t* req);
 
 /**
  * \}
@@ -52,8 +52,8 @@ extern "C" {
 /* Public functions --------------------------------------------------------- */
 void h1_cmd_callback_handle(void* param, void* data);
 
-etype_e h1_protocol_tx_data(u8 source_id, u8 target_id, bool reliable_tx,
-                            u8* data, size_t data_len);
+etype_e h1_protocol_tx_data(m1_t* m1, u8 source_id, u8 target_id,
+                            bool reliable_tx, u8* data, size_t data_len);
 /**
  * \}
  */
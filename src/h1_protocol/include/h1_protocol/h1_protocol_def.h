@@ -93,8 +93,8 @@ typedef struct {
 } h1_callback_table_t;
 
 /* Public functions --------------------------------------------------------- */
-extern etype_e h1_protocol_tx_data(u8 source_id, u8 target_id, bool reliable_tx,
-                                   u8* data, size_t data_len);
+extern etype_e h1_protocol_tx_data(m1_t* m1, u8 source_id, u8 target_id,
+                                   bool reliable_tx, u8* data, size_t data_len);
 #define H1_FRAME_PARSE(rx_data, data, frame_head, frame_data, frame_type)      \
     m1_rx_data_t* rx_data = data;                                              \
     h1_frame_head_t* frame_head = (h1_frame_head_t*)rx_data->data;             \
@@ -103,7 +103,7 @@ extern etype_e h1_protocol_tx_data(u8 source_id, u8 target_id, bool reliable_tx,
     (void)frame_head;                                                          \
     (void)frame_data;
 
-#define H1_SEND(_source_id, _target_id, _reliable_tx, _data, _data_type,       \
+#define H1_SEND(_m1, _source_id, _target_id, _reliable_tx, _data, _data_type,  \
                 _cmd_type, _cmd_id, _req_attr, _resp_attr)                     \
     do {                                                                       \
         u8 _frame_buf[sizeof(h1_frame_head_t) + sizeof(_data_type)] = {0};     \
@@ -113,29 +113,29 @@ extern etype_e h1_protocol_tx_data(u8 source_id, u8 target_id, bool reliable_tx,
         _frame_head->cmd_type = _cmd_type;                                     \
         _frame_head->cmd_id = _cmd_id;                                         \
         memcpy(_frame_head->data, _data, sizeof(_data_type));                  \
-        h1_protocol_tx_data(_source_id, _target_id, _reliable_tx, _frame_buf,  \
-                            sizeof(_frame_buf));                               \
+        h1_protocol_tx_data(_m1, _source_id, _target_id, _reliable_tx,         \
+                            _frame_buf, sizeof(_frame_buf));                   \
     } while (0)
 
-#define H1_SEND_REQ(_source_id, _target_id, _data, _data_type, _cmd_type,      \
-                    _cmd_id, _resp_attr)                                       \
-    H1_SEND(_source_id, _target_id, false, _data, _data_type, _cmd_type,       \
-            _cmd_id, H1_PROTO_SEND_ATTR_REQ, _resp_attr)
+#define H1_SEND_REQ(_m1, _source_id, _target_id, _data, _data_type,            \
+                    _cmd_type, _cmd_id, _resp_attr)                            \
+    H1_SEND(_m1, _source_id, _target_id, false, _data, _data_type,             \
+            _cmd_type, _cmd_id, H1_PROTO_SEND_ATTR_REQ, _resp_attr)
 
-#define H1_SEND_RELIABLE_REQ(_source_id, _target_id, _data, _data_type,        \
+#define H1_SEND_RELIABLE_REQ(_m1, _source_id, _target_id, _data, _data_type,   \
                              _cmd_type, _cmd_id, _resp_attr)                   \
-    H1_SEND(_source_id, _target_id, true, _data, _data_type, _cmd_type,        \
-            _cmd_id, H1_PROTO_SEND_ATTR_REQ, _resp_attr)
+    H1_SEND(_m1, _source_id, _target_id, true, _data, _data_type,              \
+            _cmd_type, _cmd_id, H1_PROTO_SEND_ATTR_REQ, _resp_attr)
 
-#define H1_SEND_RESP(_source_id, _target_id, _data, _data_type, _cmd_type,     \
-                     _cmd_id, _resp_attr)                                      \
-    H1_SEND(_source_id, _target_id, false, _data, _data_type, _cmd_type,       \
-            _cmd_id, H1_PROTO_SEND_ATTR_RESP, _resp_attr)
+#define H1_SEND_RESP(_m1, _source_id, _target_id, _data, _data_type,           \
+                     _cmd_type, _cmd_id, _resp_attr)                           \
+    H1_SEND(_m1, _source_id, _target_id, false, _data, _data_type,             \
+            _cmd_type, _cmd_id, H1_PROTO_SEND_ATTR_RESP, _resp_attr)
 
-#define H1_SEND_RELIABLE_RESP(_source_id, _target_id, _data, _data_type,       \
+#define H1_SEND_RELIABLE_RESP(_m1, _source_id, _target_id, _data, _data_type,  \
                               _cmd_type, _cmd_id, _resp_attr)                  \
-    H1_SEND(_source_id, _target_id, true, _data, _data_type, _cmd_type,        \
-            _cmd_id, H1_PROTO_SEND_ATTR_RESP, _resp_attr)
+    H1_SEND(_m1, _source_id, _target_id, true, _data, _data_type,              \
+            _cmd_type, _cmd_id, H1_PROTO_SEND_ATTR_RESP, _resp_attr)
 /**
  * \}
  */
@@ -0,0 +1,175 @@
+/**
+ * \file            m1_link_dgram.h
+ * \brief           Datagram socket (UDP, AF_UNIX) link driver.
+ * \date            2026-10-18
+ */
+
+/*
+ * Copyright (c) 2024 Vector Qiu
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE
+ * AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * This file is part of the m1 protocol library.
+ *
+ * Author:          Vector Qiu <vetor.qiu@gmail.com>
+ * Version:         V0.0.1
+ */
+
+#ifndef __M1_LINK_DGRAM_H__
+#define __M1_LINK_DGRAM_H__
+
+/* includes ----------------------------------------------------------------- */
+#include "./m1_protocol/m1_async_rx_tx.h" /*!< Provides asynchronous RX and TX operations. */
+#include "./m1_protocol/m1_typedef.h" /*!< General type definitions for the M1 protocol. */
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+/**
+ * \defgroup        m1_link_dgram_manager
+ * \brief           Datagram socket driver implementing \ref rx_async_t and
+ *                  \ref tx_async_t, one M1 frame per datagram.
+ * \{
+ */
+
+/* public config ------------------------------------------------------------ */
+/**
+ * \brief           Maximum number of datagrams moved by one `recvmmsg` or
+ *                  `sendmmsg` call.
+ */
+#ifndef M1_LINK_DGRAM_BATCH
+#define M1_LINK_DGRAM_BATCH 32
+#endif /* M1_LINK_DGRAM_BATCH */
+
+/**
+ * \brief           Largest frame carried by one datagram, in bytes.
+ */
+#ifndef M1_LINK_DGRAM_FRAME_MAX
+#define M1_LINK_DGRAM_FRAME_MAX 2048
+#endif /* M1_LINK_DGRAM_FRAME_MAX */
+
+/* public typedefs ---------------------------------------------------------- */
+/**
+ * \brief           One datagram socket link.
+ *
+ * Register it with \ref M1_LINK_TYPE_UDP, \ref M1_LINK_TYPE_UNIX_DGRAM or
+ * \ref M1_LINK_TYPE_UNIX_SEQPACKET and pass `&dgram.tx` and `&dgram.rx` to
+ * the route table.
+ *
+ * `rx` receives as many datagrams as fit in the caller's buffer with one
+ * system call and returns them as whole frames back to back. Datagrams that
+ * were truncated or do not hold exactly one frame are dropped here, so the
+ * data link layer can walk the frames without searching for their start.
+ *
+ * `tx` keeps frames until \ref M1_LINK_DGRAM_BATCH are queued or `flush` is
+ * called by the run loop, then sends them all with one system call.
+ */
+typedef struct m1_link_dgram {
+    int fd;          /*!< Socket descriptor, -1 when closed. */
+    etype_e state;   /*!< `E_STATE_IO` once the socket failed. */
+    tx_async_t tx;   /*!< TX driver bound to this socket. */
+    rx_async_t rx;   /*!< RX driver bound to this socket. */
+    u32 rx_drop_cnt; /*!< Datagrams dropped on reception. */
+    u32 tx_drop_cnt; /*!< Frames the peer refused. */
+    u8* tx_buf;      /*!< Held frames, one \ref M1_LINK_DGRAM_FRAME_MAX
+                        slot each. */
+    size_t tx_len[M1_LINK_DGRAM_BATCH]; /*!< Length of each held frame. */
+    size_t tx_cnt;                      /*!< Number of held frames. */
+} m1_link_dgram_t;
+
+/* public functions --------------------------------------------------------- */
+/**
+ * \brief           Use an existing datagram or seqpacket socket.
+ *
+ * Takes ownership of `fd`, e.g. one end of a `socketpair` or a connection
+ * accepted on a SOCK_SEQPACKET listener. The socket is made non-blocking.
+ *
+ * \param[out]      dgram: Link to initialize.
+ * \param[in]       fd: Connected socket.
+ * \return          `E_STATE_OK` on success, `E_STATE_INVAL` for a bad
+ *                  descriptor, or `E_STATE_NO_SPACE` on allocation failure.
+ */
+etype_e m1_link_dgram_attach(m1_link_dgram_t* dgram, int fd);
+
+/**
+ * \brief           Open a UDP link.
+ *
+ * \param[out]      dgram: Link to initialize.
+ * \param[in]       local_addr: Numeric address to bind, e.g. "0.0.0.0" or
+ *                  "::1".
+ * \param[in]       local_port: Port to bind, 0 for an ephemeral one.
+ * \param[in]       peer_addr: Numeric address of the peer, NULL for a
+ *                  receive-only link.
+ * \param[in]       peer_port: Port of the peer.
+ * \return          `E_STATE_OK` on success, `E_STATE_ADDR` for an invalid
+ *                  address, or `E_STATE_IO` if the socket cannot be set up.
+ */
+etype_e m1_link_dgram_open_udp(m1_link_dgram_t* dgram, const char* local_addr,
+                               u16 local_port, const char* peer_addr,
+                               u16 peer_port);
+
+/**
+ * \brief           Open an AF_UNIX link.
+ *
+ * A SOCK_DGRAM link binds `local_path` and sends to `peer_path`; either may
+ * be NULL. A stale socket file at `local_path` is not removed. A
+ * SOCK_SEQPACKET link connects to the listener at `peer_path`; the
+ * listening side uses \ref m1_link_dgram_attach on accepted connections.
+ *
+ * \param[out]      dgram: Link to initialize.
+ * \param[in]       type: `SOCK_DGRAM` or `SOCK_SEQPACKET`.
+ * \param[in]       local_path: Path to bind, or NULL.
+ * \param[in]       peer_path: Path of the peer, or NULL.
+ * \return          `E_STATE_OK` on success, `E_STATE_INVAL` for an invalid
+ *                  type or path, or `E_STATE_IO` if the socket cannot be set
+ *                  up.
+ */
+etype_e m1_link_dgram_open_unix(m1_link_dgram_t* dgram, int type,
+                                const char* local_path, const char* peer_path);
+
+/**
+ * \brief           Send the held frames and close the link.
+ *
+ * \param[in]       dgram: Link to close.
+ */
+void m1_link_dgram_close(m1_link_dgram_t* dgram);
+
+/**
+ * \brief           Send the held frames.
+ *
+ * \param[in]       dgram: Link to flush.
+ * \return          `E_STATE_OK` once nothing is held, `E_STATE_BUSY` if the
+ *                  socket buffer is full, or `E_STATE_IO` on failure.
+ */
+etype_e m1_link_dgram_flush(m1_link_dgram_t* dgram);
+
+/**
+ * \}
+ */
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* __M1_LINK_DGRAM_H__ */
+
+/* ----------------------------- end of file -------------------------------- */
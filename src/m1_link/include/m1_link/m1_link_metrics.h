@@ -0,0 +1,208 @@
+/**
+ * \file            m1_link_metrics.h
+ * \brief           Local HTTP endpoint serving the M1 OpenMetrics text.
+ * \date            2026-10-18
+ */
+
+/*
+ * Copyright (c) 2024 Vector Qiu
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE
+ * AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * This file is part of the m1 protocol library.
+ *
+ * Author:          Vector Qiu <vetor.qiu@gmail.com>
+ * Version:         V0.0.1
+ */
+#ifndef __M1_LINK_METRICS_H__
+#define __M1_LINK_METRICS_H__
+
+/* includes ----------------------------------------------------------------- */
+#include "./m1_protocol/m1_protocol_def.h" /*!< Defines the M1 protocol instance. */
+#include "./m1_protocol/m1_typedef.h" /*!< General type definitions for the M1 protocol. */
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+/**
+ * \defgroup        m1_link_metrics_manager
+ * \brief           Scrape endpoint answering HTTP GET requests with
+ *                  \ref m1_metrics_render, over TCP or AF_UNIX SOCK_STREAM.
+ * \{
+ */
+
+/* public config ------------------------------------------------------------ */
+/**
+ * \brief           Initial size of the buffer a response is built in, one
+ *                  per connection.
+ *
+ * The buffer grows to the rendered length when it is too small.
+ */
+#ifndef M1_LINK_METRICS_BUF_SIZE
+#define M1_LINK_METRICS_BUF_SIZE (16 * 1024)
+#endif /* M1_LINK_METRICS_BUF_SIZE */
+
+/**
+ * \brief           Longest request header read, in bytes.
+ */
+#ifndef M1_LINK_METRICS_REQUEST_SIZE
+#define M1_LINK_METRICS_REQUEST_SIZE 1024
+#endif /* M1_LINK_METRICS_REQUEST_SIZE */
+
+/**
+ * \brief           Connections served at the same time.
+ *
+ * Further clients wait in the listen backlog until a connection closes.
+ */
+#ifndef M1_LINK_METRICS_CLIENT_NUM
+#define M1_LINK_METRICS_CLIENT_NUM 4
+#endif /* M1_LINK_METRICS_CLIENT_NUM */
+
+/**
+ * \brief           Longest a scrape connection may stay open, in ms.
+ *
+ * A slow or silent client is disconnected once it expires, freeing its slot
+ * for the next one. Clients never block the run loop, and
+ * \ref m1_protocol_run_wait wakes at the earliest expiry.
+ */
+#ifndef M1_LINK_METRICS_TIMEOUT_MS
+#define M1_LINK_METRICS_TIMEOUT_MS 1000
+#endif /* M1_LINK_METRICS_TIMEOUT_MS */
+
+/* public typedefs ---------------------------------------------------------- */
+/**
+ * \brief           State of one scrape connection.
+ */
+typedef struct m1_link_metrics_client {
+    int fd;              /*!< Non-blocking connection, -1 if the slot is
+                            free. */
+    u64 open_ms;         /*!< Time of accept, see
+                            \ref M1_LINK_METRICS_TIMEOUT_MS. */
+    size_t request_len;  /*!< Bytes of `request` read so far. */
+    size_t response_off; /*!< Next byte of `buf` to send. */
+    size_t response_end; /*!< End of the response in `buf`, 0 while the
+                            request is read. */
+    char* buf;           /*!< Response buffer, kept for the next client of
+                            the slot. */
+    size_t buf_len;      /*!< Size of `buf`. */
+    char request[M1_LINK_METRICS_REQUEST_SIZE]; /*!< Request header. */
+} m1_link_metrics_client_t;
+
+/**
+ * \brief           One listening scrape endpoint.
+ *
+ * The endpoint has no thread of its own. Its sockets are non-blocking and
+ * registered with the wait set of the instance, so
+ * \ref m1_protocol_run_wait returns when a client connects or can make
+ * progress, and \ref m1_link_metrics_poll then moves every connection as far
+ * as it can without blocking. Calling it from the run loop thread between
+ * \ref m1_protocol_run passes reads the memory pools without locking.
+ * `GET /metrics` and `GET /` are answered with the OpenMetrics text, other
+ * paths with 404, other methods with 405, and every connection is closed
+ * after its response.
+ */
+typedef struct m1_link_metrics {
+    int fd;         /*!< Listening socket, -1 when closed. */
+    m1_t* m1;       /*!< Instance whose statistics are served. */
+    bool accepting; /*!< `fd` is in the wait set, i.e. a slot is free. */
+    m1_link_metrics_client_t
+        client[M1_LINK_METRICS_CLIENT_NUM]; /*!< Connection slots. */
+} m1_link_metrics_t;
+
+/* public functions --------------------------------------------------------- */
+/**
+ * \brief           Listen for scrapes on TCP.
+ *
+ * \param[out]      server: Endpoint to initialize.
+ * \param[in]       m1: Instance whose statistics are served.
+ * \param[in]       addr: Numeric local address, e.g. "127.0.0.1".
+ * \param[in]       port: Local port, 0 to let the system pick one.
+ * \return          `E_STATE_OK` on success, `E_STATE_INVAL` on invalid
+ *                  arguments, `E_STATE_ADDR` for an invalid address,
+ *                  `E_STATE_NO_SPACE` on allocation failure or once
+ *                  \ref M1_EVENT_TIMEOUT_NUM endpoints are open, or
+ *                  `E_STATE_IO` if the socket cannot listen.
+ */
+etype_e m1_link_metrics_open_tcp(m1_link_metrics_t* server, m1_t* m1,
+                                 const char* addr, u16 port);
+
+/**
+ * \brief           Listen for scrapes on an AF_UNIX SOCK_STREAM socket.
+ *
+ * A stale socket file at `path` is replaced.
+ *
+ * \param[out]      server: Endpoint to initialize.
+ * \param[in]       m1: Instance whose statistics are served.
+ * \param[in]       path: Path of the socket.
+ * \return          `E_STATE_OK` on success, `E_STATE_INVAL` on invalid
+ *                  arguments, `E_STATE_NO_SPACE` on allocation failure or
+ *                  once \ref M1_EVENT_TIMEOUT_NUM endpoints are open, or
+ *                  `E_STATE_IO` if the socket cannot listen.
+ */
+etype_e m1_link_metrics_open_unix(m1_link_metrics_t* server, m1_t* m1,
+                                  const char* path);
+
+/**
+ * \brief           Accept waiting clients into the free slots and serve the
+ *                  open connections.
+ *
+ * Never blocks: a connection is read and written until its socket would
+ * block, and is closed once answered or expired. At most
+ * \ref M1_LINK_METRICS_CLIENT_NUM connections are served per call. Must be
+ * called from the thread running \ref m1_protocol_run.
+ *
+ * \param[in]       server: Endpoint to serve.
+ * \return          Number of responses completed.
+ */
+size_t m1_link_metrics_poll(m1_link_metrics_t* server);
+
+/**
+ * \brief           Time left until the earliest open connection expires.
+ *
+ * The endpoint registers this with \ref m1_event_add_timeout, so a run loop
+ * waiting without a timeout still wakes to drop silent clients.
+ *
+ * \param[in]       server: Endpoint to check.
+ * \return          Milliseconds until \ref m1_link_metrics_poll must run,
+ *                  or -1 if no connection is open.
+ */
+i32 m1_link_metrics_next_timeout(m1_link_metrics_t* server);
+
+/**
+ * \brief           Close the open connections and stop listening, removing
+ *                  the socket file of an AF_UNIX endpoint.
+ *
+ * \param[in]       server: Endpoint to close.
+ */
+void m1_link_metrics_close(m1_link_metrics_t* server);
+
+/**
+ * \}
+ */
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* __M1_LINK_METRICS_H__ */
+
+/* ----------------------------- end of file -------------------------------- */
@@ -0,0 +1,182 @@
+/**
+ * \file            m1_link_serial.h
+ * \brief           Linux serial (termios) link driver.
+ * \date            2026-10-18
+ */
+
+/*
+ * Copyright (c) 2024 Vector Qiu
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE
+ * AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * This file is part of the m1 protocol library.
+ *
+ * Author:          Vector Qiu <vetor.qiu@gmail.com>
+ * Version:         V0.0.1
+ */
+
+#ifndef __M1_LINK_SERIAL_H__
+#define __M1_LINK_SERIAL_H__
+
+/* includes ----------------------------------------------------------------- */
+#include <sys/uio.h>
+#include "./m1_protocol/m1_async_rx_tx.h" /*!< Provides asynchronous RX and TX operations. */
+#include "./m1_protocol/m1_typedef.h" /*!< General type definitions for the M1 protocol. */
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+/**
+ * \defgroup        m1_link_serial_manager
+ * \brief           Serial port driver implementing \ref rx_async_t and
+ *                  \ref tx_async_t on top of a termios device.
+ * \{
+ */
+
+/* public config ------------------------------------------------------------ */
+/**
+ * \brief           Size of the per-port buffer holding frame bytes the
+ *                  device did not accept yet.
+ *
+ * While bytes are pending, new frames are appended behind them and the whole
+ * backlog is written with one `writev`. A frame that does not fit is
+ * rejected with `E_STATE_BUSY` so the byte stream never carries a partial
+ * frame.
+ */
+#ifndef M1_LINK_SERIAL_TX_BUF_SIZE
+#define M1_LINK_SERIAL_TX_BUF_SIZE 4096
+#endif /* M1_LINK_SERIAL_TX_BUF_SIZE */
+
+/**
+ * \brief           Maximum number of buffers in one
+ *                  \ref m1_link_serial_writev call.
+ */
+#ifndef M1_LINK_SERIAL_IOV_MAX
+#define M1_LINK_SERIAL_IOV_MAX 8
+#endif /* M1_LINK_SERIAL_IOV_MAX */
+
+/* public typedefs ---------------------------------------------------------- */
+/**
+ * \brief           One open serial port.
+ *
+ * Pass `&serial.tx` and `&serial.rx` to the route table. The descriptor is
+ * non-blocking: reads return whatever the kernel has buffered, up to the
+ * size of the caller's buffer, in one system call, and `rx.get_fd` lets
+ * \ref m1_protocol_run_wait sleep until the port is readable.
+ *
+ * After a read or write error, or a hangup, `state` becomes `E_STATE_IO`
+ * and the next flush from the run loop closes the descriptor; the port stays
+ * silent until it is opened again.
+ */
+typedef struct m1_link_serial {
+    int fd;                /*!< Device descriptor, -1 when closed. */
+    etype_e state;         /*!< `E_STATE_IO` once the device failed,
+                              accessed atomically. */
+    tx_async_t tx;         /*!< TX driver bound to this port. */
+    rx_async_t rx;         /*!< RX driver bound to this port. */
+    u8* tx_pending;        /*!< Bytes accepted but not written yet. */
+    size_t tx_pending_len; /*!< Number of bytes in `tx_pending`. */
+} m1_link_serial_t;
+
+/* public functions --------------------------------------------------------- */
+/**
+ * \brief           Open and configure a serial port.
+ *
+ * The line is set to raw 8N1 without flow control. Pseudo terminals are
+ * accepted as well, which makes the driver usable in tests. Rates without a
+ * termios speed constant, e.g. the 6, 8 or 12 Mbaud of fast USB adapters,
+ * are set through \ref m1_link_serial_set_rate.
+ *
+ * \param[out]      serial: Port to initialize.
+ * \param[in]       path: Device path, e.g. "/dev/ttyUSB0".
+ * \param[in]       baud: Line rate in bit/s, 0 to keep the current rate.
+ * \return          `E_STATE_OK` on success, `E_STATE_INVAL` for an
+ *                  unsupported rate, `E_STATE_NO_SPACE` on allocation
+ *                  failure, or `E_STATE_IO` if the device cannot be opened
+ *                  or configured.
+ */
+etype_e m1_link_serial_open(m1_link_serial_t* serial, const char* path,
+                            u32 baud);
+
+/**
+ * \brief           Close a serial port. Pending TX bytes are discarded.
+ *
+ * \param[in]       serial: Port to close.
+ */
+void m1_link_serial_close(m1_link_serial_t* serial);
+
+/**
+ * \brief           Send one frame made of several buffers.
+ *
+ * Pending bytes and the new frame go out in a single `writev`. Whatever the
+ * device does not take is kept and sent first on the next call or
+ * \ref m1_link_serial_flush.
+ *
+ * \param[in]       serial: Port to write to.
+ * \param[in]       iov: Buffers of the frame.
+ * \param[in]       iov_cnt: Number of buffers, at most
+ *                  \ref M1_LINK_SERIAL_IOV_MAX.
+ * \return          `E_STATE_OK` if the frame was written or queued,
+ *                  `E_STATE_BUSY` if it does not fit behind the pending
+ *                  bytes, `E_STATE_ARGUMENT_BIG` if it exceeds
+ *                  \ref M1_LINK_SERIAL_TX_BUF_SIZE, or `E_STATE_IO` if the
+ *                  device failed.
+ */
+etype_e m1_link_serial_writev(m1_link_serial_t* serial, const struct iovec* iov,
+                              int iov_cnt);
+
+/**
+ * \brief           Write pending TX bytes.
+ *
+ * \param[in]       serial: Port to flush.
+ * \return          `E_STATE_OK` once nothing is pending, `E_STATE_BUSY` if
+ *                  bytes are still pending, or `E_STATE_IO` on failure.
+ */
+etype_e m1_link_serial_flush(m1_link_serial_t* serial);
+
+/**
+ * \brief           Set an arbitrary line rate with the Linux `termios2`
+ *                  interface (`TCSETS2` with `BOTHER`).
+ *
+ * Lives in its own translation unit: `<asm/termbits.h>` cannot be included
+ * next to the C library's `<termios.h>`.
+ *
+ * \param[in]       fd: Device descriptor, already in raw mode.
+ * \param[in]       baud: Line rate in bit/s.
+ * \return          `E_STATE_OK` on success, `E_STATE_INVAL` if the driver
+ *                  refuses the rate, `E_STATE_IO` if the settings cannot be
+ *                  read, or `E_STATE_NOT_IMPLEMENT` where `termios2` is not
+ *                  available.
+ */
+etype_e m1_link_serial_set_rate(int fd, u32 baud);
+
+/**
+ * \}
+ */
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* __M1_LINK_SERIAL_H__ */
+
+/* ----------------------------- end of file -------------------------------- */
@@ -0,0 +1,173 @@
+/**
+ * \file            m1_link_stream.h
+ * \brief           Stream socket (TCP, AF_UNIX) link driver.
+ * \date            2026-10-18
+ */
+
+/*
+ * Copyright (c) 2024 Vector Qiu
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE
+ * AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * This file is part of the m1 protocol library.
+ *
+ * Author:          Vector Qiu <vetor.qiu@gmail.com>
+ * Version:         V0.0.1
+ */
+
+#ifndef __M1_LINK_STREAM_H__
+#define __M1_LINK_STREAM_H__
+
+/* includes ----------------------------------------------------------------- */
+#include "./m1_protocol/m1_async_rx_tx.h" /*!< Provides asynchronous RX and TX operations. */
+#include "./m1_protocol/m1_typedef.h" /*!< General type definitions for the M1 protocol. */
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+/**
+ * \defgroup        m1_link_stream_manager
+ * \brief           Stream socket driver implementing \ref rx_async_t and
+ *                  \ref tx_async_t for TCP and AF_UNIX SOCK_STREAM
+ *                  connections.
+ * \{
+ */
+
+/* public config ------------------------------------------------------------ */
+/**
+ * \brief           Size of the per-connection buffer holding frames that
+ *                  were not written to the socket yet.
+ *
+ * A frame that does not fit is rejected with `E_STATE_BUSY`, so the byte
+ * stream never carries a partial frame.
+ */
+#ifndef M1_LINK_STREAM_TX_BUF_SIZE
+#define M1_LINK_STREAM_TX_BUF_SIZE (64 * 1024)
+#endif /* M1_LINK_STREAM_TX_BUF_SIZE */
+
+/**
+ * \brief           Default lowest frame priority that is written at once.
+ *
+ * Frames of a lower priority are coalesced in the TX buffer and written
+ * together when the run loop flushes the link.
+ */
+#ifndef M1_LINK_STREAM_NODELAY_PRIORITY
+#define M1_LINK_STREAM_NODELAY_PRIORITY 1
+#endif /* M1_LINK_STREAM_NODELAY_PRIORITY */
+
+/* public typedefs ---------------------------------------------------------- */
+/**
+ * \brief           One stream socket connection.
+ *
+ * Register it with \ref M1_LINK_TYPE_TCP or \ref M1_LINK_TYPE_UNIX_STREAM
+ * and pass `&stream.tx` and `&stream.rx` to the route table. The data link
+ * layer then reads the link into its own \ref M1_STREAM_RX_BUF_SIZE buffer
+ * and parses whole frames in place.
+ *
+ * TCP connections run with `TCP_NODELAY`; batching is done here instead, per
+ * frame: frames whose header priority is at least `nodelay_priority` are
+ * written together with everything held before them, lower priority frames
+ * wait for `flush`, which the run loop calls once per pass.
+ *
+ * When the peer closes the connection or it fails, `state` becomes
+ * `E_STATE_IO` and the link stays silent until it is opened again. A
+ * failure seen by RX, which may run on a reader thread, only shuts the
+ * socket down; the next flush from the run loop closes it.
+ */
+typedef struct m1_link_stream {
+    int fd;              /*!< Socket descriptor, -1 when closed. */
+    etype_e state;       /*!< `E_STATE_IO` once the connection is gone,
+                            accessed atomically. */
+    tx_async_t tx;       /*!< TX driver bound to this connection. */
+    rx_async_t rx;       /*!< RX driver bound to this connection. */
+    u8 nodelay_priority; /*!< Lowest frame priority written at once, see
+                            \ref M1_LINK_STREAM_NODELAY_PRIORITY. */
+    u8* tx_buf;          /*!< Frames not written yet. */
+    size_t tx_len;       /*!< Number of bytes in `tx_buf`. */
+} m1_link_stream_t;
+
+/* public functions --------------------------------------------------------- */
+/**
+ * \brief           Use an existing connected stream socket.
+ *
+ * Takes ownership of `fd`, e.g. one end of a `socketpair` or a connection
+ * returned by `accept`. The socket is made non-blocking and, for TCP,
+ * `TCP_NODELAY` is set.
+ *
+ * \param[out]      stream: Link to initialize.
+ * \param[in]       fd: Connected socket.
+ * \return          `E_STATE_OK` on success, `E_STATE_INVAL` for a bad
+ *                  descriptor, or `E_STATE_NO_SPACE` on allocation failure.
+ */
+etype_e m1_link_stream_attach(m1_link_stream_t* stream, int fd);
+
+/**
+ * \brief           Connect a TCP link.
+ *
+ * The connection is made in blocking mode before the socket is attached.
+ *
+ * \param[out]      stream: Link to initialize.
+ * \param[in]       addr: Numeric address of the peer, e.g. "127.0.0.1".
+ * \param[in]       port: Port of the peer.
+ * \return          `E_STATE_OK` on success, `E_STATE_ADDR` for an invalid
+ *                  address, or `E_STATE_IO` if the connection fails.
+ */
+etype_e m1_link_stream_open_tcp(m1_link_stream_t* stream, const char* addr,
+                                u16 port);
+
+/**
+ * \brief           Connect an AF_UNIX SOCK_STREAM link.
+ *
+ * \param[out]      stream: Link to initialize.
+ * \param[in]       path: Path of the listening peer.
+ * \return          `E_STATE_OK` on success, `E_STATE_INVAL` for an invalid
+ *                  path, or `E_STATE_IO` if the connection fails.
+ */
+etype_e m1_link_stream_open_unix(m1_link_stream_t* stream, const char* path);
+
+/**
+ * \brief           Write the held frames and close the link.
+ *
+ * \param[in]       stream: Link to close.
+ */
+void m1_link_stream_close(m1_link_stream_t* stream);
+
+/**
+ * \brief           Write the held frames.
+ *
+ * \param[in]       stream: Link to flush.
+ * \return          `E_STATE_OK` once nothing is held, `E_STATE_BUSY` if the
+ *                  socket buffer is full, or `E_STATE_IO` on failure.
+ */
+etype_e m1_link_stream_flush(m1_link_stream_t* stream);
+
+/**
+ * \}
+ */
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* __M1_LINK_STREAM_H__ */
+
+/* ----------------------------- end of file -------------------------------- */
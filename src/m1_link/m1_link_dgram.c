@@ -0,0 +1,478 @@
+/**
+ * \file            m1_link_dgram.c
+ * \brief           Datagram socket (UDP, AF_UNIX) link driver.
+ * \date            2026-10-18
+ */
+
+/*
+ * Copyright (c) 2024 Vector Qiu
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE
+ * AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * This file is part of the m1 protocol library.
+ *
+ * Author:          Vector Qiu <vetor.qiu@gmail.com>
+ * Version:         V0.0.1
+ */
+
+/* includes ----------------------------------------------------------------- */
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE /*!< recvmmsg and sendmmsg */
+#endif
+#include "./m1_link/m1_link_dgram.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <netdb.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#include "./m1_protocol/m1_layer_datalink.h"
+
+/* private defines ---------------------------------------------------------- */
+#if !defined(__linux__)
+/**
+ * \brief           Batch entry of `recvmmsg`/`sendmmsg`, emulated with one
+ *                  `recvmsg`/`sendmsg` per datagram elsewhere.
+ */
+struct mmsghdr {
+    struct msghdr msg_hdr; /*!< Message header. */
+    unsigned int msg_len;  /*!< Bytes received. */
+};
+#endif /* __linux__ */
+
+#ifndef SOCK_CLOEXEC
+#define SOCK_CLOEXEC 0
+#endif /* SOCK_CLOEXEC */
+
+/* private function prototypes ---------------------------------------------- */
+static etype_e m1_link_dgram_tx(void* user_data, u8* buf, size_t len);
+static etype_e m1_link_dgram_get_state(void* user_data);
+static etype_e m1_link_dgram_tx_flush(void* user_data);
+static etype_e m1_link_dgram_rx(void* user_data, u8* buf, size_t* len);
+static int m1_link_dgram_get_fd(void* user_data);
+static int m1_link_dgram_recv_batch(int fd, struct mmsghdr* msg, size_t num);
+static int m1_link_dgram_send_batch(int fd, struct mmsghdr* msg, size_t num);
+static etype_e m1_link_dgram_udp_addr(const char* addr, u16 port,
+                                      struct addrinfo** res);
+
+/* public functions --------------------------------------------------------- */
+/**
+ * \brief           Use an existing datagram or seqpacket socket.
+ *
+ * \param[out]      dgram: Link to initialize.
+ * \param[in]       fd: Connected socket.
+ * \return          `E_STATE_OK` on success, or an error code otherwise.
+ */
+etype_e m1_link_dgram_attach(m1_link_dgram_t* dgram, int fd) {
+    if (!dgram || fd < 0) {
+        return E_STATE_INVAL;
+    }
+
+    memset(dgram, 0, sizeof(m1_link_dgram_t));
+    dgram->fd = -1;
+    int flags = fcntl(fd, F_GETFL);
+    if (flags < 0 || fcntl(fd, F_SETFL, flags | O_NONBLOCK)) {
+        return E_STATE_INVAL;
+    }
+    dgram->tx_buf = m1_malloc(M1_LINK_DGRAM_BATCH * M1_LINK_DGRAM_FRAME_MAX);
+    if (!dgram->tx_buf) {
+        return E_STATE_NO_SPACE;
+    }
+
+    dgram->fd = fd;
+    dgram->state = E_STATE_OK;
+    dgram->tx.tx = m1_link_dgram_tx;
+    dgram->tx.get_state = m1_link_dgram_get_state;
+    dgram->tx.flush = m1_link_dgram_tx_flush;
+    dgram->tx.user_data = dgram;
+    dgram->rx.rx = m1_link_dgram_rx;
+    dgram->rx.get_fd = m1_link_dgram_get_fd;
+    dgram->rx.user_data = dgram;
+    return E_STATE_OK;
+}
+
+/**
+ * \brief           Open a UDP link.
+ *
+ * \param[out]      dgram: Link to initialize.
+ * \param[in]       local_addr: Numeric address to bind.
+ * \param[in]       local_port: Port to bind, 0 for an ephemeral one.
+ * \param[in]       peer_addr: Numeric address of the peer, NULL for a
+ *                  receive-only link.
+ * \param[in]       peer_port: Port of the peer.
+ * \return          `E_STATE_OK` on success, or an error code otherwise.
+ */
+etype_e m1_link_dgram_open_udp(m1_link_dgram_t* dgram, const char* local_addr,
+                               u16 local_port, const char* peer_addr,
+                               u16 peer_port) {
+    if (!dgram || !local_addr) {
+        return E_STATE_INVAL;
+    }
+
+    struct addrinfo* local = NULL;
+    struct addrinfo* peer = NULL;
+    etype_e ret = m1_link_dgram_udp_addr(local_addr, local_port, &local);
+    if (ret == E_STATE_OK && peer_addr) {
+        ret = m1_link_dgram_udp_addr(peer_addr, peer_port, &peer);
+    }
+    if (ret != E_STATE_OK) {
+        goto out;
+    }
+
+    int fd = socket(local->ai_family, SOCK_DGRAM | SOCK_CLOEXEC, IPPROTO_UDP);
+    if (fd < 0) {
+        ret = E_STATE_IO;
+        goto out;
+    }
+    if (bind(fd, local->ai_addr, local->ai_addrlen) ||
+        (peer && connect(fd, peer->ai_addr, peer->ai_addrlen))) {
+        close(fd);
+        ret = E_STATE_IO;
+        goto out;
+    }
+    ret = m1_link_dgram_attach(dgram, fd);
+    if (ret != E_STATE_OK) {
+        close(fd);
+    }
+
+out:
+    if (local) {
+        freeaddrinfo(local);
+    }
+    if (peer) {
+        freeaddrinfo(peer);
+    }
+    return ret;
+}
+
+/**
+ * \brief           Open an AF_UNIX link.
+ *
+ * \param[out]      dgram: Link to initialize.
+ * \param[in]       type: `SOCK_DGRAM` or `SOCK_SEQPACKET`.
+ * \param[in]       local_path: Path to bind, or NULL.
+ * \param[in]       peer_path: Path of the peer, or NULL.
+ * \return          `E_STATE_OK` on success, or an error code otherwise.
+ */
+etype_e m1_link_dgram_open_unix(m1_link_dgram_t* dgram, int type,
+                                const char* local_path, const char* peer_path) {
+    struct sockaddr_un local = {.sun_family = AF_UNIX};
+    struct sockaddr_un peer = {.sun_family = AF_UNIX};
+    if (!dgram || (type != SOCK_DGRAM && type != SOCK_SEQPACKET) ||
+        (type == SOCK_SEQPACKET && (local_path || !peer_path)) ||
+        (local_path && strlen(local_path) >= sizeof(local.sun_path)) ||
+        (peer_path && strlen(peer_path) >= sizeof(peer.sun_path))) {
+        return E_STATE_INVAL;
+    }
+
+    int fd = socket(AF_UNIX, type | SOCK_CLOEXEC, 0);
+    if (fd < 0) {
+        return E_STATE_IO;
+    }
+    if (local_path) {
+        strcpy(local.sun_path, local_path);
+        if (bind(fd, (struct sockaddr*)&local, sizeof(local))) {
+            close(fd);
+            return E_STATE_IO;
+        }
+    }
+    if (peer_path) {
+        strcpy(peer.sun_path, peer_path);
+        if (connect(fd, (struct sockaddr*)&peer, sizeof(peer))) {
+            close(fd);
+            return E_STATE_IO;
+        }
+    }
+
+    etype_e ret = m1_link_dgram_attach(dgram, fd);
+    if (ret != E_STATE_OK) {
+        close(fd);
+    }
+    return ret;
+}
+
+/**
+ * \brief           Send the held frames and close the link.
+ *
+ * \param[in]       dgram: Link to close.
+ */
+void m1_link_dgram_close(m1_link_dgram_t* dgram) {
+    if (!dgram) {
+        return;
+    }
+    if (dgram->fd >= 0) {
+        m1_link_dgram_flush(dgram);
+        close(dgram->fd);
+        dgram->fd = -1;
+    }
+    m1_free(dgram->tx_buf);
+    dgram->tx_buf = NULL;
+    dgram->tx_cnt = 0;
+}
+
+/**
+ * \brief           Send the held frames.
+ *
+ * Frames are sent in order. A frame refused by the peer (e.g. nobody
+ * listens on the UDP port) is dropped and counted; the others still go out.
+ *
+ * \param[in]       dgram: Link to flush.
+ * \return          `E_STATE_OK` once nothing is held, `E_STATE_BUSY` if the
+ *                  socket buffer is full, or `E_STATE_IO` on failure.
+ */
+etype_e m1_link_dgram_flush(m1_link_dgram_t* dgram) {
+    if (!dgram || dgram->fd < 0) {
+        return E_STATE_INVAL;
+    }
+    if (dgram->state != E_STATE_OK) {
+        return dgram->state;
+    }
+
+    size_t done = 0;
+    etype_e ret = E_STATE_OK;
+    while (done < dgram->tx_cnt) {
+        struct mmsghdr msg[M1_LINK_DGRAM_BATCH];
+        struct iovec iov[M1_LINK_DGRAM_BATCH];
+        size_t num = dgram->tx_cnt - done;
+        memset(msg, 0, sizeof(struct mmsghdr) * num);
+        for (size_t i = 0; i < num; i++) {
+            iov[i].iov_base =
+                dgram->tx_buf + (done + i) * M1_LINK_DGRAM_FRAME_MAX;
+            iov[i].iov_len = dgram->tx_len[done + i];
+            msg[i].msg_hdr.msg_iov = &iov[i];
+            msg[i].msg_hdr.msg_iovlen = 1;
+        }
+
+        int sent = m1_link_dgram_send_batch(dgram->fd, msg, num);
+        if (sent > 0) {
+            done += (size_t)sent;
+        } else if (errno == EINTR) {
+            continue;
+        } else if (errno == EAGAIN || errno == EWOULDBLOCK ||
+                   errno == ENOBUFS) {
+            ret = E_STATE_BUSY;
+            break;
+        } else if (errno == ECONNREFUSED || errno == EMSGSIZE) {
+            /*! Only the first frame failed, skip it */
+            dgram->tx_drop_cnt++;
+            done++;
+        } else {
+            dgram->state = E_STATE_IO;
+            ret = E_STATE_IO;
+            break;
+        }
+    }
+
+    /*! Keep what is left at the front, in order */
+    if (done && done < dgram->tx_cnt) {
+        memmove(dgram->tx_buf,
+                dgram->tx_buf + done * M1_LINK_DGRAM_FRAME_MAX,
+                (dgram->tx_cnt - done) * M1_LINK_DGRAM_FRAME_MAX);
+        memmove(dgram->tx_len, dgram->tx_len + done,
+                (dgram->tx_cnt - done) * sizeof(size_t));
+    }
+    dgram->tx_cnt -= done;
+    return ret;
+}
+
+/* private functions -------------------------------------------------------- */
+/**
+ * \brief           \ref tx_async_t::tx of a datagram link.
+ *
+ * Holds the frame for the next batch; sends the batch once it is full.
+ */
+static etype_e m1_link_dgram_tx(void* user_data, u8* buf, size_t len) {
+    m1_link_dgram_t* dgram = user_data;
+    if (len > M1_LINK_DGRAM_FRAME_MAX) {
+        return E_STATE_ARGUMENT_BIG;
+    }
+    if (dgram->state != E_STATE_OK) {
+        return dgram->state;
+    }
+    if (dgram->tx_cnt == M1_LINK_DGRAM_BATCH &&
+        m1_link_dgram_flush(dgram) != E_STATE_OK &&
+        dgram->tx_cnt == M1_LINK_DGRAM_BATCH) {
+        return dgram->state == E_STATE_OK ? E_STATE_BUSY : dgram->state;
+    }
+
+    memcpy(dgram->tx_buf + dgram->tx_cnt * M1_LINK_DGRAM_FRAME_MAX, buf, len);
+    dgram->tx_len[dgram->tx_cnt++] = len;
+    if (dgram->tx_cnt == M1_LINK_DGRAM_BATCH) {
+        m1_link_dgram_flush(dgram);
+    }
+    return E_STATE_OK;
+}
+
+/**
+ * \brief           \ref tx_async_t::get_state of a datagram link.
+ *
+ * \return          `E_STATE_BUSY` while a full batch cannot be sent,
+ *                  `E_STATE_IO` after a socket failure, `E_STATE_OK`
+ *                  otherwise.
+ */
+static etype_e m1_link_dgram_get_state(void* user_data) {
+    m1_link_dgram_t* dgram = user_data;
+    if (dgram->state != E_STATE_OK) {
+        return dgram->state;
+    }
+    return dgram->tx_cnt == M1_LINK_DGRAM_BATCH ? E_STATE_BUSY : E_STATE_OK;
+}
+
+/**
+ * \brief           \ref tx_async_t::flush of a datagram link.
+ */
+static etype_e m1_link_dgram_tx_flush(void* user_data) {
+    return m1_link_dgram_flush(user_data);
+}
+
+/**
+ * \brief           \ref rx_async_t::rx of a datagram link.
+ *
+ * The caller's buffer is split into slots of at most
+ * \ref M1_LINK_DGRAM_FRAME_MAX bytes, one per datagram, and filled with one
+ * system call. Valid frames are then packed to the front of the buffer.
+ */
+static etype_e m1_link_dgram_rx(void* user_data, u8* buf, size_t* len) {
+    m1_link_dgram_t* dgram = user_data;
+    size_t slot_len = *len < M1_LINK_DGRAM_FRAME_MAX ? *len
+                                                      : M1_LINK_DGRAM_FRAME_MAX;
+    size_t slot_num = slot_len ? *len / slot_len : 0;
+    if (slot_num > M1_LINK_DGRAM_BATCH) {
+        slot_num = M1_LINK_DGRAM_BATCH;
+    }
+    *len = 0;
+    if (!slot_num) {
+        return E_STATE_OK;
+    }
+
+    struct mmsghdr msg[M1_LINK_DGRAM_BATCH];
+    struct iovec iov[M1_LINK_DGRAM_BATCH];
+    memset(msg, 0, sizeof(struct mmsghdr) * slot_num);
+    for (size_t i = 0; i < slot_num; i++) {
+        iov[i].iov_base = buf + i * slot_len;
+        iov[i].iov_len = slot_len;
+        msg[i].msg_hdr.msg_iov = &iov[i];
+        msg[i].msg_hdr.msg_iovlen = 1;
+    }
+
+    int num = m1_link_dgram_recv_batch(dgram->fd, msg, slot_num);
+    if (num < 0) {
+        if (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR ||
+            errno == ECONNREFUSED) {
+            return E_STATE_OK;
+        }
+        dgram->state = E_STATE_IO;
+        return E_STATE_IO;
+    }
+
+    size_t out = 0;
+    for (int i = 0; i < num; i++) {
+        u8* frame = iov[i].iov_base;
+        size_t frame_len = msg[i].msg_len;
+        if ((msg[i].msg_hdr.msg_flags & MSG_TRUNC) ||
+            m1_datalink_frame_len(frame, frame_len) != frame_len) {
+            dgram->rx_drop_cnt++;
+            continue;
+        }
+        if (frame != buf + out) {
+            memmove(buf + out, frame, frame_len);
+        }
+        out += frame_len;
+    }
+    *len = out;
+    return E_STATE_OK;
+}
+
+/**
+ * \brief           \ref rx_async_t::get_fd of a datagram link.
+ */
+static int m1_link_dgram_get_fd(void* user_data) {
+    return ((m1_link_dgram_t*)user_data)->fd;
+}
+
+/**
+ * \brief           Receive up to `num` datagrams.
+ *
+ * \return          Number of datagrams received, or -1 with `errno` set.
+ */
+static int m1_link_dgram_recv_batch(int fd, struct mmsghdr* msg, size_t num) {
+#if defined(__linux__)
+    return recvmmsg(fd, msg, (unsigned int)num, MSG_DONTWAIT, NULL);
+#else
+    size_t i = 0;
+    for (; i < num; i++) {
+        ssize_t n = recvmsg(fd, &msg[i].msg_hdr, MSG_DONTWAIT);
+        if (n < 0) {
+            return i ? (int)i : -1;
+        }
+        msg[i].msg_len = (unsigned int)n;
+    }
+    return (int)i;
+#endif /* __linux__ */
+}
+
+/**
+ * \brief           Send up to `num` datagrams.
+ *
+ * \return          Number of datagrams sent, or -1 with `errno` set when
+ *                  the first one could not be sent.
+ */
+static int m1_link_dgram_send_batch(int fd, struct mmsghdr* msg, size_t num) {
+#if defined(__linux__)
+    return sendmmsg(fd, msg, (unsigned int)num, MSG_DONTWAIT);
+#else
+    size_t i = 0;
+    for (; i < num; i++) {
+        if (sendmsg(fd, &msg[i].msg_hdr, MSG_DONTWAIT) < 0) {
+            return i ? (int)i : -1;
+        }
+    }
+    return (int)i;
+#endif /* __linux__ */
+}
+
+/**
+ * \brief           Resolve a numeric UDP address.
+ *
+ * \param[in]       addr: Numeric IPv4 or IPv6 address.
+ * \param[in]       port: Port number.
+ * \param[out]      res: Resolved address, released with `freeaddrinfo`.
+ * \return          `E_STATE_OK` on success, or `E_STATE_ADDR` if `addr` is
+ *                  not a numeric address.
+ */
+static etype_e m1_link_dgram_udp_addr(const char* addr, u16 port,
+                                      struct addrinfo** res) {
+    struct addrinfo hints;
+    memset(&hints, 0, sizeof(hints));
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_DGRAM;
+    hints.ai_protocol = IPPROTO_UDP;
+    hints.ai_flags = AI_NUMERICHOST | AI_NUMERICSERV;
+
+    char service[8];
+    snprintf(service, sizeof(service), "%u", (unsigned int)port);
+    return getaddrinfo(addr, service, &hints, res) ? E_STATE_ADDR : E_STATE_OK;
+}
+
+/* ----------------------------- end of file -------------------------------- */
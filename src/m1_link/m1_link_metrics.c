@@ -0,0 +1,577 @@
+/**
+ * \file            m1_link_metrics.c
+ * \brief           Local HTTP endpoint serving the M1 OpenMetrics text.
+ * \date            2026-10-18
+ */
+
+/*
+ * Copyright (c) 2024 Vector Qiu
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE
+ * AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * This file is part of the m1 protocol library.
+ *
+ * Author:          Vector Qiu <vetor.qiu@gmail.com>
+ * Version:         V0.0.1
+ */
+
+/* includes ----------------------------------------------------------------- */
+#include "./m1_link/m1_link_metrics.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#include "./m1_protocol/m1_event.h"
+#include "./m1_protocol/m1_metrics.h"
+
+/* private defines ---------------------------------------------------------- */
+#ifndef SOCK_CLOEXEC
+#define SOCK_CLOEXEC 0
+#endif /* SOCK_CLOEXEC */
+
+#ifndef MSG_NOSIGNAL
+#define MSG_NOSIGNAL 0
+#endif /* MSG_NOSIGNAL */
+
+#define M1_LINK_METRICS_HEAD_SIZE 256 /*!< Room kept for the response head. */
+
+/* private function prototypes ---------------------------------------------- */
+static etype_e m1_link_metrics_listen(m1_link_metrics_t* server, m1_t* m1,
+                                      int fd, const struct sockaddr* addr,
+                                      socklen_t addr_len);
+static bool m1_link_metrics_accept(m1_link_metrics_t* server,
+                                   m1_link_metrics_client_t* client,
+                                   u64 now_ms);
+static void m1_link_metrics_watch_listener(m1_link_metrics_t* server);
+static i32 m1_link_metrics_event_timeout(void* user_data);
+static bool m1_link_metrics_serve(m1_link_metrics_t* server,
+                                  m1_link_metrics_client_t* client,
+                                  u64 now_ms);
+static etype_e m1_link_metrics_read(m1_link_metrics_client_t* client);
+static etype_e m1_link_metrics_respond(m1_link_metrics_t* server,
+                                       m1_link_metrics_client_t* client);
+static etype_e m1_link_metrics_reply(m1_link_metrics_client_t* client,
+                                     const char* status, const char* type,
+                                     size_t body_len);
+static bool m1_link_metrics_reserve(m1_link_metrics_client_t* client,
+                                    size_t size);
+static etype_e m1_link_metrics_write(m1_link_metrics_client_t* client);
+static void m1_link_metrics_drop(m1_link_metrics_t* server,
+                                 m1_link_metrics_client_t* client);
+
+/* public functions --------------------------------------------------------- */
+/**
+ * \brief           Listen for scrapes on TCP.
+ *
+ * \param[out]      server: Endpoint to initialize.
+ * \param[in]       m1: Instance whose statistics are served.
+ * \param[in]       addr: Numeric local address.
+ * \param[in]       port: Local port, 0 to let the system pick one.
+ * \return          `E_STATE_OK` on success, or an error code otherwise.
+ */
+etype_e m1_link_metrics_open_tcp(m1_link_metrics_t* server, m1_t* m1,
+                                 const char* addr, u16 port) {
+    if (!server || !m1 || !addr) {
+        return E_STATE_INVAL;
+    }
+
+    struct addrinfo hints;
+    memset(&hints, 0, sizeof(hints));
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+    hints.ai_protocol = IPPROTO_TCP;
+    hints.ai_flags = AI_NUMERICHOST | AI_NUMERICSERV | AI_PASSIVE;
+
+    char service[8];
+    struct addrinfo* local = NULL;
+    snprintf(service, sizeof(service), "%u", (unsigned int)port);
+    if (getaddrinfo(addr, service, &hints, &local)) {
+        return E_STATE_ADDR;
+    }
+
+    etype_e ret = E_STATE_IO;
+    int fd = socket(local->ai_family, SOCK_STREAM | SOCK_CLOEXEC, IPPROTO_TCP);
+    if (fd >= 0) {
+        int one = 1;
+        setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+        ret = m1_link_metrics_listen(server, m1, fd, local->ai_addr,
+                                     local->ai_addrlen);
+    }
+    freeaddrinfo(local);
+    return ret;
+}
+
+/**
+ * \brief           Listen for scrapes on an AF_UNIX SOCK_STREAM socket.
+ *
+ * \param[out]      server: Endpoint to initialize.
+ * \param[in]       m1: Instance whose statistics are served.
+ * \param[in]       path: Path of the socket.
+ * \return          `E_STATE_OK` on success, or an error code otherwise.
+ */
+etype_e m1_link_metrics_open_unix(m1_link_metrics_t* server, m1_t* m1,
+                                  const char* path) {
+    struct sockaddr_un local = {.sun_family = AF_UNIX};
+    if (!server || !m1 || !path || !*path ||
+        strlen(path) >= sizeof(local.sun_path)) {
+        return E_STATE_INVAL;
+    }
+    strcpy(local.sun_path, path);
+
+    int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (fd < 0) {
+        return E_STATE_IO;
+    }
+    unlink(path);
+    return m1_link_metrics_listen(server, m1, fd, (struct sockaddr*)&local,
+                                  sizeof(local));
+}
+
+/**
+ * \brief           Accept waiting clients into the free slots and serve the
+ *                  open connections.
+ *
+ * \param[in]       server: Endpoint to serve.
+ * \return          Number of responses completed.
+ */
+size_t m1_link_metrics_poll(m1_link_metrics_t* server) {
+    if (!server || server->fd < 0) {
+        return 0;
+    }
+
+    u64 now_ms = m1_event_now_ms();
+    for (size_t i = 0; i < M1_LINK_METRICS_CLIENT_NUM; i++) {
+        if (server->client[i].fd < 0 &&
+            !m1_link_metrics_accept(server, &server->client[i], now_ms)) {
+            break;
+        }
+    }
+
+    size_t served = 0;
+    for (size_t i = 0; i < M1_LINK_METRICS_CLIENT_NUM; i++) {
+        if (server->client[i].fd >= 0 &&
+            m1_link_metrics_serve(server, &server->client[i], now_ms)) {
+            served++;
+        }
+    }
+    m1_link_metrics_watch_listener(server);
+    return served;
+}
+
+/**
+ * \brief           Time left until the earliest open connection expires.
+ *
+ * \param[in]       server: Endpoint to check.
+ * \return          Milliseconds until a connection expires, 0 if one already
+ *                  has, or -1 if no connection is open.
+ */
+i32 m1_link_metrics_next_timeout(m1_link_metrics_t* server) {
+    if (!server || server->fd < 0) {
+        return -1;
+    }
+
+    u64 now_ms = m1_event_now_ms();
+    i32 timeout_ms = -1;
+    for (size_t i = 0; i < M1_LINK_METRICS_CLIENT_NUM; i++) {
+        const m1_link_metrics_client_t* client = &server->client[i];
+        if (client->fd < 0) {
+            continue;
+        }
+        u64 age_ms = now_ms - client->open_ms;
+        i32 left_ms = age_ms < M1_LINK_METRICS_TIMEOUT_MS
+                          ? (i32)(M1_LINK_METRICS_TIMEOUT_MS - age_ms)
+                          : 0;
+        if (timeout_ms < 0 || left_ms < timeout_ms) {
+            timeout_ms = left_ms;
+        }
+    }
+    return timeout_ms;
+}
+
+/**
+ * \brief           Close the open connections and stop listening.
+ *
+ * \param[in]       server: Endpoint to close.
+ */
+void m1_link_metrics_close(m1_link_metrics_t* server) {
+    if (!server) {
+        return;
+    }
+    for (size_t i = 0; i < M1_LINK_METRICS_CLIENT_NUM; i++) {
+        m1_link_metrics_client_t* client = &server->client[i];
+        if (client->fd >= 0) {
+            m1_link_metrics_drop(server, client);
+        }
+        m1_free(client->buf);
+        client->buf = NULL;
+        client->buf_len = 0;
+    }
+    if (server->fd >= 0) {
+        if (server->accepting) {
+            m1_event_watch_fd(server->m1, server->fd, 0);
+            server->accepting = false;
+        }
+        m1_event_remove_timeout(server->m1, server);
+        struct sockaddr_un local;
+        socklen_t local_len = sizeof(local);
+        if (!getsockname(server->fd, (struct sockaddr*)&local, &local_len) &&
+            local.sun_family == AF_UNIX &&
+            local_len > offsetof(struct sockaddr_un, sun_path) &&
+            local.sun_path[0]) {
+            unlink(local.sun_path);
+        }
+        close(server->fd);
+        server->fd = -1;
+    }
+}
+
+/* private functions -------------------------------------------------------- */
+/**
+ * \brief           Bind a socket, listen on it and initialize the endpoint.
+ *
+ * \param[out]      server: Endpoint to initialize.
+ * \param[in]       m1: Instance whose statistics are served.
+ * \param[in]       fd: Unbound socket, closed on failure.
+ * \param[in]       addr: Local address.
+ * \param[in]       addr_len: Length of `addr`.
+ * \return          `E_STATE_OK` on success, or an error code otherwise.
+ */
+static etype_e m1_link_metrics_listen(m1_link_metrics_t* server, m1_t* m1,
+                                      int fd, const struct sockaddr* addr,
+                                      socklen_t addr_len) {
+    memset(server, 0, sizeof(m1_link_metrics_t));
+    server->fd = -1;
+    for (size_t i = 0; i < M1_LINK_METRICS_CLIENT_NUM; i++) {
+        server->client[i].fd = -1;
+    }
+
+    if (m1_event_add_timeout(m1, m1_link_metrics_event_timeout, server) ==
+        E_STATE_NO_SPACE) {
+        close(fd);
+        return E_STATE_NO_SPACE;
+    }
+    int flags = fcntl(fd, F_GETFL);
+    if (flags < 0 || fcntl(fd, F_SETFL, flags | O_NONBLOCK) ||
+        bind(fd, addr, addr_len) || listen(fd, 4)) {
+        m1_event_remove_timeout(m1, server);
+        close(fd);
+        return E_STATE_IO;
+    }
+
+    server->fd = fd;
+    server->m1 = m1;
+    m1_link_metrics_watch_listener(server);
+    return E_STATE_OK;
+}
+
+/**
+ * \brief           Deadline callback registered with
+ *                  \ref m1_event_add_timeout.
+ *
+ * \param[in]       user_data: Endpoint to check.
+ * \return          Milliseconds until a connection expires, -1 if none.
+ */
+static i32 m1_link_metrics_event_timeout(void* user_data) {
+    return m1_link_metrics_next_timeout((m1_link_metrics_t*)user_data);
+}
+
+/**
+ * \brief           Accept one waiting client into a free slot.
+ *
+ * \param[in]       server: Endpoint accepting the client.
+ * \param[out]      client: Free slot.
+ * \param[in]       now_ms: Current time from \ref m1_event_now_ms.
+ * \return          false if no client was waiting, true otherwise.
+ */
+static bool m1_link_metrics_accept(m1_link_metrics_t* server,
+                                   m1_link_metrics_client_t* client,
+                                   u64 now_ms) {
+    int fd;
+    do {
+        fd = accept(server->fd, NULL, NULL);
+    } while (fd < 0 && (errno == EINTR || errno == ECONNABORTED));
+    if (fd < 0) {
+        return false;
+    }
+
+    /*! Accepted sockets do not inherit O_NONBLOCK on every system */
+    int flags = fcntl(fd, F_GETFL);
+    if (flags < 0 || fcntl(fd, F_SETFL, flags | O_NONBLOCK)) {
+        close(fd);
+        return true;
+    }
+    client->fd = fd;
+    client->open_ms = now_ms;
+    client->request_len = 0;
+    client->response_off = 0;
+    client->response_end = 0;
+    m1_event_watch_fd(server->m1, fd, M1_EVENT_READ);
+    return true;
+}
+
+/**
+ * \brief           Wait for new clients only while a slot can take them.
+ *
+ * A pending connection keeps the listening socket readable, which would
+ * keep the run loop from sleeping while every slot is busy.
+ *
+ * \param[in]       server: Endpoint to update.
+ */
+static void m1_link_metrics_watch_listener(m1_link_metrics_t* server) {
+    bool accepting = false;
+    for (size_t i = 0; i < M1_LINK_METRICS_CLIENT_NUM; i++) {
+        if (server->client[i].fd < 0) {
+            accepting = true;
+            break;
+        }
+    }
+    if (accepting != server->accepting) {
+        m1_event_watch_fd(server->m1, server->fd,
+                          accepting ? M1_EVENT_READ : 0);
+        server->accepting = accepting;
+    }
+}
+
+/**
+ * \brief           Move one connection on as far as it goes without
+ *                  blocking.
+ *
+ * \param[in]       server: Endpoint serving the client.
+ * \param[in]       client: Open connection.
+ * \param[in]       now_ms: Current time from \ref m1_event_now_ms.
+ * \return          true if the whole response was sent.
+ */
+static bool m1_link_metrics_serve(m1_link_metrics_t* server,
+                                  m1_link_metrics_client_t* client,
+                                  u64 now_ms) {
+    etype_e ret = E_STATE_OK;
+    if (!client->response_end) {
+        ret = m1_link_metrics_read(client);
+        if (ret == E_STATE_OK) {
+            ret = m1_link_metrics_respond(server, client);
+        }
+        if (ret == E_STATE_OK) {
+            /*! Nothing more is read: wake the loop when the socket drains */
+            m1_event_watch_fd(server->m1, client->fd, M1_EVENT_WRITE);
+        }
+    }
+    if (ret == E_STATE_OK) {
+        ret = m1_link_metrics_write(client);
+    }
+    if (ret == E_STATE_BUSY &&
+        now_ms - client->open_ms < M1_LINK_METRICS_TIMEOUT_MS) {
+        return false;
+    }
+    m1_link_metrics_drop(server, client);
+    return ret == E_STATE_OK;
+}
+
+/**
+ * \brief           Read the request header of a client.
+ *
+ * The whole header is read so closing does not reset the connection. A full
+ * buffer or the end of the stream ends the header too.
+ *
+ * \param[in]       client: Open connection.
+ * \return          `E_STATE_OK` once the header is read, `E_STATE_BUSY` if
+ *                  more is expected, or `E_STATE_IO` on a socket error.
+ */
+static etype_e m1_link_metrics_read(m1_link_metrics_client_t* client) {
+    char* request = client->request;
+    while (client->request_len < sizeof(client->request) - 1) {
+        ssize_t n = recv(client->fd, request + client->request_len,
+                         sizeof(client->request) - 1 - client->request_len,
+                         0);
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n < 0) {
+            return (errno == EAGAIN || errno == EWOULDBLOCK) ? E_STATE_BUSY
+                                                             : E_STATE_IO;
+        }
+        if (n == 0) {
+            break;
+        }
+        client->request_len += (size_t)n;
+        request[client->request_len] = '\0';
+        if (strstr(request, "\r\n\r\n") || strstr(request, "\n\n")) {
+            break;
+        }
+    }
+    request[client->request_len] = '\0';
+    return E_STATE_OK;
+}
+
+/**
+ * \brief           Build the response to the request of a client.
+ *
+ * \param[in]       server: Endpoint serving the client.
+ * \param[in]       client: Connection whose request was read.
+ * \return          `E_STATE_OK` on success, or `E_STATE_NO_SPACE` on
+ *                  allocation failure.
+ */
+static etype_e m1_link_metrics_respond(m1_link_metrics_t* server,
+                                       m1_link_metrics_client_t* client) {
+    if (!m1_link_metrics_reserve(client, M1_LINK_METRICS_BUF_SIZE)) {
+        return E_STATE_NO_SPACE;
+    }
+    const char* text = "text/plain; charset=utf-8";
+    char* body = client->buf + M1_LINK_METRICS_HEAD_SIZE;
+    size_t body_size = client->buf_len - M1_LINK_METRICS_HEAD_SIZE;
+
+    const char* request = client->request;
+    if (strncmp(request, "GET ", 4)) {
+        return m1_link_metrics_reply(
+            client, "405 Method Not Allowed", text,
+            snprintf(body, body_size, "method not allowed\n"));
+    }
+    const char* path = request + 4;
+    size_t path_len = strcspn(path, " ?\r\n");
+    if (!(path_len == 1 && path[0] == '/') &&
+        !(path_len == 8 && !strncmp(path, "/metrics", 8))) {
+        return m1_link_metrics_reply(client, "404 Not Found", text,
+                                     snprintf(body, body_size, "not found\n"));
+    }
+
+    size_t body_len = 0;
+    etype_e ret = m1_metrics_render(server->m1, body, body_size, &body_len);
+    if (ret == E_STATE_NO_SPACE &&
+        m1_link_metrics_reserve(client,
+                                M1_LINK_METRICS_HEAD_SIZE + body_len + 1)) {
+        body = client->buf + M1_LINK_METRICS_HEAD_SIZE;
+        body_size = client->buf_len - M1_LINK_METRICS_HEAD_SIZE;
+        ret = m1_metrics_render(server->m1, body, body_size, &body_len);
+    }
+    if (ret != E_STATE_OK) {
+        return m1_link_metrics_reply(
+            client, "500 Internal Server Error", text,
+            snprintf(body, body_size, "render failed\n"));
+    }
+    return m1_link_metrics_reply(client, "200 OK", M1_METRICS_CONTENT_TYPE,
+                                 body_len);
+}
+
+/**
+ * \brief           Put an HTTP/1.0 head in front of a body and start sending.
+ *
+ * \param[in]       client: Connection to answer.
+ * \param[in]       status: Status code and reason.
+ * \param[in]       type: Content type of the body.
+ * \param[in]       body_len: Length of the body, which starts
+ *                  \ref M1_LINK_METRICS_HEAD_SIZE bytes into the buffer.
+ * \return          `E_STATE_OK` on success, or `E_STATE_ARGUMENT_BIG` if the
+ *                  head does not fit.
+ */
+static etype_e m1_link_metrics_reply(m1_link_metrics_client_t* client,
+                                     const char* status, const char* type,
+                                     size_t body_len) {
+    char head[M1_LINK_METRICS_HEAD_SIZE];
+    int head_len = snprintf(head, sizeof(head),
+                            "HTTP/1.0 %s\r\n"
+                            "Content-Type: %s\r\n"
+                            "Content-Length: %zu\r\n"
+                            "Connection: close\r\n"
+                            "\r\n",
+                            status, type, body_len);
+    if (head_len <= 0 || (size_t)head_len >= sizeof(head)) {
+        return E_STATE_ARGUMENT_BIG;
+    }
+
+    /*! The head goes right before the body, nothing is moved */
+    client->response_off = M1_LINK_METRICS_HEAD_SIZE - (size_t)head_len;
+    client->response_end = M1_LINK_METRICS_HEAD_SIZE + body_len;
+    memcpy(client->buf + client->response_off, head, (size_t)head_len);
+    return E_STATE_OK;
+}
+
+/**
+ * \brief           Grow the response buffer of a client.
+ *
+ * The content is not kept.
+ *
+ * \param[in]       client: Connection owning the buffer.
+ * \param[in]       size: Size needed, at least
+ *                  \ref M1_LINK_METRICS_HEAD_SIZE is always added.
+ * \return          true if the buffer is large enough.
+ */
+static bool m1_link_metrics_reserve(m1_link_metrics_client_t* client,
+                                    size_t size) {
+    if (size < 2 * M1_LINK_METRICS_HEAD_SIZE) {
+        size = 2 * M1_LINK_METRICS_HEAD_SIZE;
+    }
+    if (client->buf_len >= size) {
+        return true;
+    }
+    char* buf = m1_malloc(size);
+    if (!buf) {
+        return false;
+    }
+    m1_free(client->buf);
+    client->buf = buf;
+    client->buf_len = size;
+    return true;
+}
+
+/**
+ * \brief           Send as much of the response as the socket takes.
+ *
+ * \param[in]       client: Connection being answered.
+ * \return          `E_STATE_OK` once everything was sent, `E_STATE_BUSY` if
+ *                  the socket is full, or `E_STATE_IO` on a socket error.
+ */
+static etype_e m1_link_metrics_write(m1_link_metrics_client_t* client) {
+    while (client->response_off < client->response_end) {
+        ssize_t n = send(client->fd, client->buf + client->response_off,
+                         client->response_end - client->response_off,
+                         MSG_NOSIGNAL);
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n < 0) {
+            return (errno == EAGAIN || errno == EWOULDBLOCK) ? E_STATE_BUSY
+                                                             : E_STATE_IO;
+        }
+        client->response_off += (size_t)n;
+    }
+    return E_STATE_OK;
+}
+
+/**
+ * \brief           Close a connection and free its slot.
+ *
+ * \param[in]       server: Endpoint serving the client.
+ * \param[in]       client: Open connection.
+ */
+static void m1_link_metrics_drop(m1_link_metrics_t* server,
+                                 m1_link_metrics_client_t* client) {
+    m1_event_watch_fd(server->m1, client->fd, 0);
+    close(client->fd);
+    client->fd = -1;
+}
+
+/* ----------------------------- end of file -------------------------------- */
@@ -0,0 +1,423 @@
+/**
+ * \file            m1_link_serial.c
+ * \brief           Linux serial (termios) link driver.
+ * \date            2026-10-18
+ */
+
+/*
+ * Copyright (c) 2024 Vector Qiu
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE
+ * AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * This file is part of the m1 protocol library.
+ *
+ * Author:          Vector Qiu <vetor.qiu@gmail.com>
+ * Version:         V0.0.1
+ */
+
+/* includes ----------------------------------------------------------------- */
+#include "./m1_link/m1_link_serial.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <string.h>
+#include <termios.h>
+#include <unistd.h>
+
+/* private typedefs --------------------------------------------------------- */
+/**
+ * \brief           Mapping of a line rate to its termios constant.
+ */
+typedef struct m1_link_serial_baud {
+    u32 baud;      /*!< Rate in bit/s. */
+    speed_t speed; /*!< termios speed constant. */
+} m1_link_serial_baud_t;
+
+/* private variables -------------------------------------------------------- */
+static const m1_link_serial_baud_t baud_table[] = {
+    {9600, B9600},       {19200, B19200},     {38400, B38400},
+    {57600, B57600},     {115200, B115200},   {230400, B230400},
+#ifdef B460800
+    {460800, B460800},
+#endif
+#ifdef B921600
+    {921600, B921600},
+#endif
+#ifdef B1000000
+    {1000000, B1000000},
+#endif
+#ifdef B1500000
+    {1500000, B1500000},
+#endif
+#ifdef B2000000
+    {2000000, B2000000},
+#endif
+#ifdef B3000000
+    {3000000, B3000000},
+#endif
+#ifdef B4000000
+    {4000000, B4000000},
+#endif
+};
+
+/* private function prototypes ---------------------------------------------- */
+static etype_e m1_link_serial_tx(void* user_data, u8* buf, size_t len);
+static etype_e m1_link_serial_get_state(void* user_data);
+static etype_e m1_link_serial_tx_flush(void* user_data);
+static etype_e m1_link_serial_rx(void* user_data, u8* buf, size_t* len);
+static int m1_link_serial_get_fd(void* user_data);
+static etype_e m1_link_serial_configure(int fd, u32 baud);
+static etype_e m1_link_serial_state(m1_link_serial_t* serial);
+static void m1_link_serial_fail(m1_link_serial_t* serial);
+
+/* public functions --------------------------------------------------------- */
+/**
+ * \brief           Open and configure a serial port.
+ *
+ * \param[out]      serial: Port to initialize.
+ * \param[in]       path: Device path, e.g. "/dev/ttyUSB0".
+ * \param[in]       baud: Line rate in bit/s, 0 to keep the current rate.
+ * \return          `E_STATE_OK` on success, or an error code otherwise.
+ */
+etype_e m1_link_serial_open(m1_link_serial_t* serial, const char* path,
+                            u32 baud) {
+    if (!serial || !path) {
+        return E_STATE_INVAL;
+    }
+
+    memset(serial, 0, sizeof(m1_link_serial_t));
+    serial->fd = -1;
+    serial->tx_pending = m1_malloc(M1_LINK_SERIAL_TX_BUF_SIZE);
+    if (!serial->tx_pending) {
+        return E_STATE_NO_SPACE;
+    }
+
+    serial->fd = open(path, O_RDWR | O_NOCTTY | O_NONBLOCK | O_CLOEXEC);
+    if (serial->fd < 0) {
+        m1_link_serial_close(serial);
+        return E_STATE_IO;
+    }
+    etype_e ret = m1_link_serial_configure(serial->fd, baud);
+    if (ret != E_STATE_OK) {
+        m1_link_serial_close(serial);
+        return ret;
+    }
+
+    serial->state = E_STATE_OK;
+    serial->tx.tx = m1_link_serial_tx;
+    serial->tx.get_state = m1_link_serial_get_state;
+    serial->tx.flush = m1_link_serial_tx_flush;
+    serial->tx.user_data = serial;
+    serial->rx.rx = m1_link_serial_rx;
+    serial->rx.get_fd = m1_link_serial_get_fd;
+    serial->rx.user_data = serial;
+    return E_STATE_OK;
+}
+
+/**
+ * \brief           Close a serial port. Pending TX bytes are discarded.
+ *
+ * \param[in]       serial: Port to close.
+ */
+void m1_link_serial_close(m1_link_serial_t* serial) {
+    if (!serial) {
+        return;
+    }
+    if (serial->fd >= 0) {
+        close(serial->fd);
+        serial->fd = -1;
+    }
+    m1_free(serial->tx_pending);
+    serial->tx_pending = NULL;
+    serial->tx_pending_len = 0;
+}
+
+/**
+ * \brief           Send one frame made of several buffers.
+ *
+ * \param[in]       serial: Port to write to.
+ * \param[in]       iov: Buffers of the frame.
+ * \param[in]       iov_cnt: Number of buffers.
+ * \return          `E_STATE_OK` if the frame was written or queued,
+ *                  `E_STATE_BUSY` if it does not fit behind the pending
+ *                  bytes, `E_STATE_ARGUMENT_BIG` if it exceeds
+ *                  \ref M1_LINK_SERIAL_TX_BUF_SIZE, or `E_STATE_IO` if the
+ *                  device failed.
+ */
+etype_e m1_link_serial_writev(m1_link_serial_t* serial, const struct iovec* iov,
+                              int iov_cnt) {
+    if (!serial || !iov || iov_cnt <= 0 || iov_cnt > M1_LINK_SERIAL_IOV_MAX) {
+        return E_STATE_INVAL;
+    }
+    if (m1_link_serial_state(serial) != E_STATE_OK) {
+        return m1_link_serial_flush(serial);
+    }
+
+    size_t frame_len = 0;
+    for (int i = 0; i < iov_cnt; i++) {
+        frame_len += iov[i].iov_len;
+    }
+    if (frame_len > M1_LINK_SERIAL_TX_BUF_SIZE) {
+        return E_STATE_ARGUMENT_BIG;
+    }
+    if (serial->tx_pending_len + frame_len > M1_LINK_SERIAL_TX_BUF_SIZE) {
+        etype_e ret = m1_link_serial_flush(serial);
+        if (ret == E_STATE_IO) {
+            return ret;
+        }
+        /*! Still backed up: only accept what can be kept whole */
+        if (serial->tx_pending_len + frame_len > M1_LINK_SERIAL_TX_BUF_SIZE) {
+            return E_STATE_BUSY;
+        }
+    }
+
+    /*! Backlog first, then the frame, in one system call */
+    struct iovec vec[1 + M1_LINK_SERIAL_IOV_MAX];
+    int vec_cnt = 0;
+    if (serial->tx_pending_len) {
+        vec[vec_cnt].iov_base = serial->tx_pending;
+        vec[vec_cnt].iov_len = serial->tx_pending_len;
+        vec_cnt++;
+    }
+    memcpy(&vec[vec_cnt], iov, sizeof(struct iovec) * iov_cnt);
+    vec_cnt += iov_cnt;
+
+    ssize_t written = writev(serial->fd, vec, vec_cnt);
+    if (written < 0) {
+        if (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR) {
+            m1_link_serial_fail(serial);
+            return E_STATE_IO;
+        }
+        written = 0;
+    }
+
+    /*! Keep whatever the device did not take, in order */
+    size_t done = (size_t)written;
+    size_t keep = 0;
+    for (int i = 0; i < vec_cnt; i++) {
+        size_t len = vec[i].iov_len;
+        if (done >= len) {
+            done -= len;
+            continue;
+        }
+        const u8* src = (const u8*)vec[i].iov_base + done;
+        memmove(serial->tx_pending + keep, src, len - done);
+        keep += len - done;
+        done = 0;
+    }
+    serial->tx_pending_len = keep;
+    return E_STATE_OK;
+}
+
+/**
+ * \brief           Write pending TX bytes.
+ *
+ * \param[in]       serial: Port to flush.
+ * \return          `E_STATE_OK` once nothing is pending, `E_STATE_BUSY` if
+ *                  bytes are still pending, or `E_STATE_IO` on failure.
+ */
+etype_e m1_link_serial_flush(m1_link_serial_t* serial) {
+    if (!serial) {
+        return E_STATE_INVAL;
+    }
+    etype_e state = m1_link_serial_state(serial);
+    if (state != E_STATE_OK) {
+        /*! RX only marks the port, the descriptor is closed on this side */
+        m1_link_serial_fail(serial);
+        return state;
+    }
+    if (serial->fd < 0) {
+        return E_STATE_INVAL;
+    }
+
+    while (serial->tx_pending_len) {
+        ssize_t written =
+            write(serial->fd, serial->tx_pending, serial->tx_pending_len);
+        if (written < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            if (errno == EAGAIN || errno == EWOULDBLOCK) {
+                return E_STATE_BUSY;
+            }
+            m1_link_serial_fail(serial);
+            return E_STATE_IO;
+        }
+        serial->tx_pending_len -= (size_t)written;
+        memmove(serial->tx_pending, serial->tx_pending + written,
+                serial->tx_pending_len);
+    }
+    return E_STATE_OK;
+}
+
+/* private functions -------------------------------------------------------- */
+/**
+ * \brief           \ref tx_async_t::tx of a serial port.
+ */
+static etype_e m1_link_serial_tx(void* user_data, u8* buf, size_t len) {
+    struct iovec iov = {.iov_base = buf, .iov_len = len};
+    return m1_link_serial_writev(user_data, &iov, 1);
+}
+
+/**
+ * \brief           \ref tx_async_t::get_state of a serial port.
+ *
+ * \return          `E_STATE_BUSY` while TX bytes are pending, `E_STATE_IO`
+ *                  after a device failure, `E_STATE_OK` otherwise.
+ */
+static etype_e m1_link_serial_get_state(void* user_data) {
+    return m1_link_serial_flush(user_data);
+}
+
+/**
+ * \brief           \ref tx_async_t::flush of a serial port.
+ */
+static etype_e m1_link_serial_tx_flush(void* user_data) {
+    return m1_link_serial_flush(user_data);
+}
+
+/**
+ * \brief           \ref rx_async_t::rx of a serial port.
+ *
+ * Reads everything the kernel has buffered, up to `*len`, in one call.
+ * An empty port is not an error and yields `*len == 0`. A read error or a
+ * hangup marks the port failed; RX may run on a reader thread, so the
+ * descriptor is left to the next flush of the run loop to close, which also
+ * takes it out of the level triggered wait set.
+ */
+static etype_e m1_link_serial_rx(void* user_data, u8* buf, size_t* len) {
+    m1_link_serial_t* serial = user_data;
+    size_t size = *len;
+    *len = 0;
+    etype_e state = m1_link_serial_state(serial);
+    if (state != E_STATE_OK) {
+        return state;
+    }
+
+    ssize_t n;
+    do {
+        n = read(serial->fd, buf, size);
+    } while (n < 0 && errno == EINTR);
+    if (n > 0) {
+        *len = (size_t)n;
+        return E_STATE_OK;
+    }
+    if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+        return E_STATE_OK;
+    }
+    if (n == 0) {
+        /*! Raw mode reads 0 from an empty port as well as a hung up one */
+        struct pollfd pfd = {.fd = serial->fd, .events = POLLIN};
+        if (poll(&pfd, 1, 0) <= 0 || !(pfd.revents & (POLLHUP | POLLERR))) {
+            return E_STATE_OK;
+        }
+    }
+    __atomic_store_n(&serial->state, E_STATE_IO, __ATOMIC_RELEASE);
+    return E_STATE_IO;
+}
+
+/**
+ * \brief           \ref rx_async_t::get_fd of a serial port.
+ */
+static int m1_link_serial_get_fd(void* user_data) {
+    return ((m1_link_serial_t*)user_data)->fd;
+}
+
+/**
+ * \brief           Get the state of a port, which RX may change from a
+ *                  reader thread.
+ *
+ * \param[in]       serial: Port to check.
+ * \return          `E_STATE_OK`, or `E_STATE_IO` once the device failed.
+ */
+static etype_e m1_link_serial_state(m1_link_serial_t* serial) {
+    return __atomic_load_n(&serial->state, __ATOMIC_ACQUIRE);
+}
+
+/**
+ * \brief           Drop a failed device from the TX side.
+ *
+ * Closing the descriptor takes it out of the run loop's wait set, so a
+ * device that hung up does not keep the loop awake, and `rx.get_fd` stops
+ * reporting it. Pending TX bytes are discarded.
+ *
+ * \param[in]       serial: Port whose device failed.
+ */
+static void m1_link_serial_fail(m1_link_serial_t* serial) {
+    __atomic_store_n(&serial->state, E_STATE_IO, __ATOMIC_RELEASE);
+    serial->tx_pending_len = 0;
+    if (serial->fd >= 0) {
+        close(serial->fd);
+        serial->fd = -1;
+    }
+}
+
+/**
+ * \brief           Put a descriptor in raw 8N1 mode at the given rate.
+ *
+ * \param[in]       fd: Device descriptor.
+ * \param[in]       baud: Line rate in bit/s, 0 to keep the current rate.
+ * \return          `E_STATE_OK` on success, `E_STATE_INVAL` for an
+ *                  unsupported rate, or `E_STATE_IO` on failure.
+ */
+static etype_e m1_link_serial_configure(int fd, u32 baud) {
+    struct termios tio;
+    if (tcgetattr(fd, &tio)) {
+        return E_STATE_IO;
+    }
+
+    cfmakeraw(&tio);
+    tio.c_cflag &= ~(CSTOPB | PARENB | CRTSCTS);
+    tio.c_cflag |= CLOCAL | CREAD | CS8;
+    tio.c_iflag &= ~(IXON | IXOFF | IXANY);
+    /*! Reads never wait: readiness comes from the event loop */
+    tio.c_cc[VMIN] = 0;
+    tio.c_cc[VTIME] = 0;
+
+    if (baud) {
+        size_t i = 0;
+        size_t table_len = sizeof(baud_table) / sizeof(baud_table[0]);
+        while (i < table_len && baud_table[i].baud != baud) {
+            i++;
+        }
+        if (i < table_len) {
+            cfsetispeed(&tio, baud_table[i].speed);
+            cfsetospeed(&tio, baud_table[i].speed);
+            baud = 0;
+        }
+    }
+
+    if (tcsetattr(fd, TCSANOW, &tio)) {
+        return E_STATE_IO;
+    }
+    /*! No speed constant: the raw mode is set, now the rate itself */
+    if (baud) {
+        etype_e ret = m1_link_serial_set_rate(fd, baud);
+        if (ret != E_STATE_OK) {
+            return ret == E_STATE_NOT_IMPLEMENT ? E_STATE_INVAL : ret;
+        }
+    }
+    tcflush(fd, TCIOFLUSH);
+    return E_STATE_OK;
+}
+
+/* ----------------------------- end of file -------------------------------- */
@@ -0,0 +1,78 @@
+/**
+ * \file            m1_link_serial_rate.c
+ * \brief           Arbitrary serial line rates through Linux termios2.
+ * \date            2026-10-18
+ */
+
+/*
+ * Copyright (c) 2024 Vector Qiu
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE
+ * AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * This file is part of the m1 protocol library.
+ *
+ * Author:          Vector Qiu <vetor.qiu@gmail.com>
+ * Version:         V0.0.1
+ */
+
+/* includes ----------------------------------------------------------------- */
+/*! Only the kernel's termios definitions: this file must not see the C
+    library's <termios.h>, which declares a different struct termios */
+#ifdef __linux__
+#include <asm/termbits.h>
+#include <sys/ioctl.h>
+#endif /* __linux__ */
+#include "./m1_link/m1_link_serial.h"
+
+/* public functions --------------------------------------------------------- */
+/**
+ * \brief           Set an arbitrary line rate with the Linux `termios2`
+ *                  interface.
+ *
+ * \param[in]       fd: Device descriptor, already in raw mode.
+ * \param[in]       baud: Line rate in bit/s.
+ * \return          `E_STATE_OK` on success, `E_STATE_INVAL` if the driver
+ *                  refuses the rate, `E_STATE_IO` if the settings cannot be
+ *                  read, or `E_STATE_NOT_IMPLEMENT` where `termios2` is not
+ *                  available.
+ */
+etype_e m1_link_serial_set_rate(int fd, u32 baud) {
+#if defined(TCGETS2) && defined(TCSETS2) && defined(BOTHER)
+    struct termios2 tio;
+    if (ioctl(fd, TCGETS2, &tio)) {
+        return E_STATE_IO;
+    }
+    tio.c_cflag &= ~CBAUD;
+    tio.c_cflag |= BOTHER;
+    tio.c_ispeed = baud;
+    tio.c_ospeed = baud;
+    if (ioctl(fd, TCSETS2, &tio)) {
+        return E_STATE_INVAL;
+    }
+    return E_STATE_OK;
+#else
+    (void)fd;
+    (void)baud;
+    return E_STATE_NOT_IMPLEMENT;
+#endif /* TCGETS2 && TCSETS2 && BOTHER */
+}
+
+/* ----------------------------- end of file -------------------------------- */
@@ -0,0 +1,404 @@
+/**
+ * \file            m1_link_stream.c
+ * \brief           Stream socket (TCP, AF_UNIX) link driver.
+ * \date            2026-10-18
+ */
+
+/*
+ * Copyright (c) 2024 Vector Qiu
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE
+ * AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * This file is part of the m1 protocol library.
+ *
+ * Author:          Vector Qiu <vetor.qiu@gmail.com>
+ * Version:         V0.0.1
+ */
+
+
+/* includes ----------------------------------------------------------------- */
+#include "./m1_link/m1_link_stream.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#include "./m1_protocol/m1_format_frame.h"
+
+/* private defines ---------------------------------------------------------- */
+#ifndef SOCK_CLOEXEC
+#define SOCK_CLOEXEC 0
+#endif /* SOCK_CLOEXEC */
+
+#ifndef MSG_NOSIGNAL
+#define MSG_NOSIGNAL 0
+#endif /* MSG_NOSIGNAL */
+
+/* private function prototypes ---------------------------------------------- */
+static etype_e m1_link_stream_tx(void* user_data, u8* buf, size_t len);
+static etype_e m1_link_stream_get_state(void* user_data);
+static etype_e m1_link_stream_tx_flush(void* user_data);
+static etype_e m1_link_stream_rx(void* user_data, u8* buf, size_t* len);
+static int m1_link_stream_get_fd(void* user_data);
+static etype_e m1_link_stream_connect(m1_link_stream_t* stream, int fd,
+                                      const struct sockaddr* addr,
+                                      socklen_t addr_len);
+static etype_e m1_link_stream_state(m1_link_stream_t* stream);
+static void m1_link_stream_fail(m1_link_stream_t* stream);
+static void m1_link_stream_fail_rx(m1_link_stream_t* stream);
+
+/* public functions --------------------------------------------------------- */
+/**
+ * \brief           Use an existing connected stream socket.
+ *
+ * \param[out]      stream: Link to initialize.
+ * \param[in]       fd: Connected socket.
+ * \return          `E_STATE_OK` on success, or an error code otherwise.
+ */
+etype_e m1_link_stream_attach(m1_link_stream_t* stream, int fd) {
+    if (!stream || fd < 0) {
+        return E_STATE_INVAL;
+    }
+
+    memset(stream, 0, sizeof(m1_link_stream_t));
+    stream->fd = -1;
+    int flags = fcntl(fd, F_GETFL);
+    if (flags < 0 || fcntl(fd, F_SETFL, flags | O_NONBLOCK)) {
+        return E_STATE_INVAL;
+    }
+    /*! Fails harmlessly on AF_UNIX sockets */
+    int one = 1;
+    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+
+    stream->tx_buf = m1_malloc(M1_LINK_STREAM_TX_BUF_SIZE);
+    if (!stream->tx_buf) {
+        return E_STATE_NO_SPACE;
+    }
+
+    stream->fd = fd;
+    stream->state = E_STATE_OK;
+    stream->nodelay_priority = M1_LINK_STREAM_NODELAY_PRIORITY;
+    stream->tx.tx = m1_link_stream_tx;
+    stream->tx.get_state = m1_link_stream_get_state;
+    stream->tx.flush = m1_link_stream_tx_flush;
+    stream->tx.user_data = stream;
+    stream->rx.rx = m1_link_stream_rx;
+    stream->rx.get_fd = m1_link_stream_get_fd;
+    stream->rx.user_data = stream;
+    return E_STATE_OK;
+}
+
+/**
+ * \brief           Connect a TCP link.
+ *
+ * \param[out]      stream: Link to initialize.
+ * \param[in]       addr: Numeric address of the peer.
+ * \param[in]       port: Port of the peer.
+ * \return          `E_STATE_OK` on success, or an error code otherwise.
+ */
+etype_e m1_link_stream_open_tcp(m1_link_stream_t* stream, const char* addr,
+                                u16 port) {
+    if (!stream || !addr) {
+        return E_STATE_INVAL;
+    }
+
+    struct addrinfo hints;
+    memset(&hints, 0, sizeof(hints));
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+    hints.ai_protocol = IPPROTO_TCP;
+    hints.ai_flags = AI_NUMERICHOST | AI_NUMERICSERV;
+
+    char service[8];
+    struct addrinfo* peer = NULL;
+    snprintf(service, sizeof(service), "%u", (unsigned int)port);
+    if (getaddrinfo(addr, service, &hints, &peer)) {
+        return E_STATE_ADDR;
+    }
+
+    etype_e ret = E_STATE_IO;
+    int fd = socket(peer->ai_family, SOCK_STREAM | SOCK_CLOEXEC, IPPROTO_TCP);
+    if (fd >= 0) {
+        ret = m1_link_stream_connect(stream, fd, peer->ai_addr,
+                                     peer->ai_addrlen);
+    }
+    freeaddrinfo(peer);
+    return ret;
+}
+
+/**
+ * \brief           Connect an AF_UNIX SOCK_STREAM link.
+ *
+ * \param[out]      stream: Link to initialize.
+ * \param[in]       path: Path of the listening peer.
+ * \return          `E_STATE_OK` on success, or an error code otherwise.
+ */
+etype_e m1_link_stream_open_unix(m1_link_stream_t* stream, const char* path) {
+    struct sockaddr_un peer = {.sun_family = AF_UNIX};
+    if (!stream || !path || strlen(path) >= sizeof(peer.sun_path)) {
+        return E_STATE_INVAL;
+    }
+    strcpy(peer.sun_path, path);
+
+    int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (fd < 0) {
+        return E_STATE_IO;
+    }
+    return m1_link_stream_connect(stream, fd, (struct sockaddr*)&peer,
+                                  sizeof(peer));
+}
+
+/**
+ * \brief           Write the held frames and close the link.
+ *
+ * \param[in]       stream: Link to close.
+ */
+void m1_link_stream_close(m1_link_stream_t* stream) {
+    if (!stream) {
+        return;
+    }
+    if (stream->fd >= 0) {
+        m1_link_stream_flush(stream);
+        close(stream->fd);
+        stream->fd = -1;
+    }
+    m1_free(stream->tx_buf);
+    stream->tx_buf = NULL;
+    stream->tx_len = 0;
+}
+
+/**
+ * \brief           Write the held frames.
+ *
+ * A partial write keeps the rest at the front of the buffer for the next
+ * call.
+ *
+ * \param[in]       stream: Link to flush.
+ * \return          `E_STATE_OK` once nothing is held, `E_STATE_BUSY` if the
+ *                  socket buffer is full, or `E_STATE_IO` on failure.
+ */
+etype_e m1_link_stream_flush(m1_link_stream_t* stream) {
+    if (!stream) {
+        return E_STATE_INVAL;
+    }
+    etype_e state = m1_link_stream_state(stream);
+    if (state != E_STATE_OK) {
+        /*! RX only marks the link, the socket is closed on this side */
+        m1_link_stream_fail(stream);
+        return state;
+    }
+
+    size_t done = 0;
+    etype_e ret = E_STATE_OK;
+    while (done < stream->tx_len) {
+        ssize_t n = send(stream->fd, stream->tx_buf + done,
+                         stream->tx_len - done, MSG_NOSIGNAL);
+        if (n > 0) {
+            done += (size_t)n;
+        } else if (n < 0 && errno == EINTR) {
+            continue;
+        } else if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+            ret = E_STATE_BUSY;
+            break;
+        } else {
+            m1_link_stream_fail(stream);
+            return E_STATE_IO;
+        }
+    }
+
+    if (done && done < stream->tx_len) {
+        memmove(stream->tx_buf, stream->tx_buf + done, stream->tx_len - done);
+    }
+    stream->tx_len -= done;
+    return ret;
+}
+
+/* private functions -------------------------------------------------------- */
+/**
+ * \brief           \ref tx_async_t::tx of a stream link.
+ *
+ * Appends the frame to the held bytes. Frames of at least
+ * `nodelay_priority` are written out right away; the others wait for the
+ * next flush.
+ */
+static etype_e m1_link_stream_tx(void* user_data, u8* buf, size_t len) {
+    m1_link_stream_t* stream = user_data;
+    if (len > M1_LINK_STREAM_TX_BUF_SIZE) {
+        return E_STATE_ARGUMENT_BIG;
+    }
+    if (m1_link_stream_state(stream) != E_STATE_OK) {
+        return m1_link_stream_flush(stream);
+    }
+    if (stream->tx_len + len > M1_LINK_STREAM_TX_BUF_SIZE) {
+        etype_e ret = m1_link_stream_flush(stream);
+        if (ret != E_STATE_OK && ret != E_STATE_BUSY) {
+            return ret;
+        }
+        if (stream->tx_len + len > M1_LINK_STREAM_TX_BUF_SIZE) {
+            return E_STATE_BUSY;
+        }
+    }
+
+    memcpy(stream->tx_buf + stream->tx_len, buf, len);
+    stream->tx_len += len;
+    if (len >= sizeof(m1_frame_head_t) &&
+        ((m1_frame_head_t*)buf)->attr.lsb.priority >=
+            stream->nodelay_priority) {
+        m1_link_stream_flush(stream);
+    }
+    return E_STATE_OK;
+}
+
+/**
+ * \brief           \ref tx_async_t::get_state of a stream link.
+ *
+ * \return          `E_STATE_BUSY` while the held bytes cannot be written,
+ *                  `E_STATE_IO` once the connection is gone, `E_STATE_OK`
+ *                  otherwise.
+ */
+static etype_e m1_link_stream_get_state(void* user_data) {
+    return m1_link_stream_flush(user_data);
+}
+
+/**
+ * \brief           \ref tx_async_t::flush of a stream link.
+ */
+static etype_e m1_link_stream_tx_flush(void* user_data) {
+    return m1_link_stream_flush(user_data);
+}
+
+/**
+ * \brief           \ref rx_async_t::rx of a stream link.
+ *
+ * Reads as much as the caller's buffer holds with one system call.
+ */
+static etype_e m1_link_stream_rx(void* user_data, u8* buf, size_t* len) {
+    m1_link_stream_t* stream = user_data;
+    size_t size = *len;
+    *len = 0;
+    etype_e state = m1_link_stream_state(stream);
+    if (state != E_STATE_OK) {
+        return state;
+    }
+
+    ssize_t n;
+    do {
+        n = recv(stream->fd, buf, size, MSG_DONTWAIT);
+    } while (n < 0 && errno == EINTR);
+    if (n > 0) {
+        *len = (size_t)n;
+        return E_STATE_OK;
+    }
+    if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+        return E_STATE_OK;
+    }
+    /*! Peer closed or connection reset */
+    m1_link_stream_fail_rx(stream);
+    return E_STATE_IO;
+}
+
+/**
+ * \brief           \ref rx_async_t::get_fd of a stream link.
+ */
+static int m1_link_stream_get_fd(void* user_data) {
+    return ((m1_link_stream_t*)user_data)->fd;
+}
+
+/**
+ * \brief           Connect a socket and attach it to a link.
+ *
+ * \param[out]      stream: Link to initialize.
+ * \param[in]       fd: Unconnected socket, closed on failure.
+ * \param[in]       addr: Address of the peer.
+ * \param[in]       addr_len: Length of `addr`.
+ * \return          `E_STATE_OK` on success, or an error code otherwise.
+ */
+static etype_e m1_link_stream_connect(m1_link_stream_t* stream, int fd,
+                                      const struct sockaddr* addr,
+                                      socklen_t addr_len) {
+    int ret;
+    do {
+        ret = connect(fd, addr, addr_len);
+    } while (ret && errno == EINTR);
+    if (ret) {
+        close(fd);
+        return E_STATE_IO;
+    }
+
+    etype_e state = m1_link_stream_attach(stream, fd);
+    if (state != E_STATE_OK) {
+        close(fd);
+    }
+    return state;
+}
+
+/**
+ * \brief           Get the state of a link, which RX may change from a
+ *                  reader thread.
+ *
+ * \param[in]       stream: Link to check.
+ * \return          `E_STATE_OK`, or `E_STATE_IO` once the connection is
+ *                  gone.
+ */
+static etype_e m1_link_stream_state(m1_link_stream_t* stream) {
+    return __atomic_load_n(&stream->state, __ATOMIC_ACQUIRE);
+}
+
+/**
+ * \brief           Drop a broken connection from the TX side.
+ *
+ * Only the thread sending on the link closes the socket, so it never writes
+ * to a descriptor the kernel has handed out again. Closing also takes the
+ * socket out of the run loop's wait set, so a peer that hung up does not keep
+ * the loop awake.
+ *
+ * \param[in]       stream: Link whose connection failed.
+ */
+static void m1_link_stream_fail(m1_link_stream_t* stream) {
+    __atomic_store_n(&stream->state, E_STATE_IO, __ATOMIC_RELEASE);
+    stream->tx_len = 0;
+    if (stream->fd >= 0) {
+        close(stream->fd);
+        stream->fd = -1;
+    }
+}
+
+/**
+ * \brief           Mark a connection broken from the RX side.
+ *
+ * RX may run on a reader thread, so it leaves the descriptor and the TX
+ * buffer alone: the socket is shut down and closed by the next flush of the
+ * run loop.
+ *
+ * \param[in]       stream: Link whose connection failed.
+ */
+static void m1_link_stream_fail_rx(m1_link_stream_t* stream) {
+    __atomic_store_n(&stream->state, E_STATE_IO, __ATOMIC_RELEASE);
+    shutdown(stream->fd, SHUT_RDWR);
+}
+
+/* ----------------------------- end of file -------------------------------- */
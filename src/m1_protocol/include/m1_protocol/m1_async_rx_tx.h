@@ -37,6 +37,7 @@
 #define __M1_ASYNC_RX_TX_H__
 
 /* includes ----------------------------------------------------------------- */
+#include "./m1_protocol/m1_spsc_ring.h" /*!< Byte ring filled by RX drivers. */
 #include "./m1_protocol/m1_typedef.h" /*!< Includes the M1 protocol type definitions. */
 
 #ifdef __cplusplus
@@ -54,10 +55,13 @@ extern "C" {
  *
  * This structure defines a function pointer for receiving data asynchronously.
  * The user is expected to implement the \ref rx function to handle RX logic.
+ * Every callback receives \ref user_data, so one driver implementation can
+ * serve several links.
  */
 typedef struct rx_async {
     /**
      * \brief       Function to perform asynchronous data reception.
+     * \param[in]   user_data: The \ref user_data of this structure.
      * \param[out]  buf: Pointer to the buffer where received data will be
      *              stored.
      * \param[out]  len: Pointer to a variable to store the length of received
@@ -69,7 +73,32 @@ typedef struct rx_async {
      *   - Ensure `buf` and `len` are updated with valid data and length.
      *   - Return an appropriate error code if the operation fails.
      */
-    etype_e (*rx)(u8* buf, size_t* len);
+    etype_e (*rx)(void* user_data, u8* buf, size_t* len);
+
+    /**
+     * \brief       Optional function returning a file descriptor that becomes
+     *              readable when \ref rx has data.
+     * \param[in]   user_data: The \ref user_data of this structure.
+     * \return      The descriptor, or a negative value if the link cannot be
+     *              waited on.
+     *
+     * Links providing a descriptor are only read when it is readable by the
+     * event driven run loop; the others are polled at `read_freq`. May be
+     * NULL.
+     */
+    int (*get_fd)(void* user_data);
+
+    void* user_data; /*!< Driver context passed to every callback. */
+
+    /**
+     * \brief       Optional ring the driver fills from its interrupt handler
+     *              or its own thread.
+     *
+     * When set, \ref rx is not called: the data link layer parses the bytes
+     * where they lie in the ring and releases them, so the link needs no
+     * read buffer and no copy. Only for byte stream links. May be NULL.
+     */
+    m1_spsc_ring_t* ring;
 } rx_async_t;
 
 /**
@@ -81,6 +110,7 @@ typedef struct rx_async {
 typedef struct tx_async {
     /**
      * \brief       Function to perform asynchronous data transmission.
+     * \param[in]   user_data: The \ref user_data of this structure.
      * \param[in]   buf: Pointer to the buffer containing data to be
      *              transmitted.
      * \param[in]   len: Length of the data to be transmitted.
@@ -91,17 +121,31 @@ typedef struct tx_async {
      *   - Validate input parameters (`buf` and `len`).
      *   - Return an appropriate error code if the operation fails.
      */
-    etype_e (*tx)(u8* buf, size_t len);
+    etype_e (*tx)(void* user_data, u8* buf, size_t len);
 
     /**
      * \brief       Function to get the current state of the TX module.
+     * \param[in]   user_data: The \ref user_data of this structure.
      * \return      Current state of the TX module as an \ref etype_e value.
      *
      * The implementation of this function should:
      *   - Provide the current operational state (e.g., idle, busy, error).
      *   - Return an appropriate state code as defined in \ref etype_e.
      */
-    etype_e (*get_state)(void);
+    etype_e (*get_state)(void* user_data);
+
+    /**
+     * \brief       Optional function sending the frames \ref tx held back.
+     * \param[in]   user_data: The \ref user_data of this structure.
+     * \return      Status of the flush as an \ref etype_e value.
+     *
+     * Drivers that batch frames into fewer system calls may keep them in
+     * \ref tx until this is called. The run loop flushes every link after
+     * each batch of sends. May be NULL.
+     */
+    etype_e (*flush)(void* user_data);
+
+    void* user_data; /*!< Driver context passed to every callback. */
 } tx_async_t;
 
 /**
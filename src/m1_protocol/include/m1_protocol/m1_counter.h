@@ -0,0 +1,120 @@
+/**
+ * \file            m1_counter.h
+ * \brief           Sharded 64-bit event counters.
+ * \date            2026-10-18
+ */
+
+/*
+ * Copyright (c) 2024 Vector Qiu
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE
+ * AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * This file is part of the m1 protocol library.
+ *
+ * Author:          Vector Qiu <vetor.qiu@gmail.com>
+ * Version:         V0.0.1
+ */
+#ifndef __M1_COUNTER_H__
+#define __M1_COUNTER_H__
+
+/* includes ----------------------------------------------------------------- */
+#include "./m1_protocol/m1_typedef.h" /*!< General type definitions for the M1 protocol. */
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+/**
+ * \defgroup        m1_counter_manager
+ * \brief           Statistics counters that threads bump without sharing
+ *                  cache lines.
+ * \{
+ */
+
+/* public typedefs ---------------------------------------------------------- */
+/**
+ * \brief           Opaque counter set handle.
+ *
+ * The set holds one copy of every counter per shard, each shard on its own
+ * cache lines. A thread always adds to the same shard, picked round-robin the
+ * first time it counts, with a relaxed atomic add. Reads sum all shards.
+ */
+typedef struct m1_counter m1_counter_t;
+
+/* public functions --------------------------------------------------------- */
+/**
+ * \brief           Create a zeroed counter set.
+ *
+ * \param[in]       counter_num: Number of counters in the set.
+ * \return          Pointer to the set, or NULL on invalid size or allocation
+ *                  failure.
+ */
+m1_counter_t* m1_counter_create(size_t counter_num);
+
+/**
+ * \brief           Destroy a counter set.
+ *
+ * \param[in]       counter: Pointer to the set, may be NULL.
+ */
+void m1_counter_destroy(m1_counter_t* counter);
+
+/**
+ * \brief           Add to a counter. Safe to call from any thread.
+ *
+ * \param[in]       counter: Pointer to the set, may be NULL.
+ * \param[in]       index: Index of the counter, out of range is ignored.
+ * \param[in]       value: Amount to add.
+ */
+void m1_counter_add(m1_counter_t* counter, size_t index, u64 value);
+
+/**
+ * \brief           Read a counter, summed over all shards.
+ *
+ * \param[in]       counter: Pointer to the set.
+ * \param[in]       index: Index of the counter.
+ * \return          The counter, or 0 on invalid arguments.
+ */
+u64 m1_counter_read(const m1_counter_t* counter, size_t index);
+
+/**
+ * \brief           Read a run of counters, summed over all shards.
+ *
+ * \param[in]       counter: Pointer to the set.
+ * \param[in]       first: Index of the first counter.
+ * \param[out]      value: Receives `num` counters.
+ * \param[in]       num: Number of counters to read.
+ * \return          `E_STATE_OK` on success, or `E_STATE_INVAL` on invalid
+ *                  arguments.
+ */
+etype_e m1_counter_snapshot(const m1_counter_t* counter, size_t first,
+                            u64* value, size_t num);
+
+/**
+ * \}
+ */
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* __M1_COUNTER_H__ */
+
+/* ----------------------------- end of file -------------------------------- */
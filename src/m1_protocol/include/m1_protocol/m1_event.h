@@ -0,0 +1,196 @@
+/**
+ * \file            m1_event.h
+ * \brief           Event loop backend of the M1 protocol.
+ * \date            2026-10-18
+ */
+
+/*
+ * Copyright (c) 2024 Vector Qiu
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE
+ * AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * This file is part of the m1 protocol library.
+ *
+ * Author:          Vector Qiu <vetor.qiu@gmail.com>
+ * Version:         V0.0.1
+ */
+
+#ifndef __M1_EVENT_H__
+#define __M1_EVENT_H__
+
+/* includes ----------------------------------------------------------------- */
+#include "./m1_protocol/m1_protocol_def.h" /*!< Defines the M1 protocol instance. */
+#include "./m1_protocol/m1_typedef.h" /*!< General type definitions for the M1 protocol. */
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+/**
+ * \defgroup        m1_event_manager
+ * \brief           Waits on the RX links and the wakeup descriptor of an
+ *                  instance so the run loop only runs when there is work.
+ * \{
+ */
+
+/* public define ------------------------------------------------------------ */
+#define M1_EVENT_READ  (1u << 0) /*!< Wait for a descriptor to be readable. */
+#define M1_EVENT_WRITE (1u << 1) /*!< Wait for a descriptor to be writable. */
+
+/* public typedefs ---------------------------------------------------------- */
+/**
+ * \brief           Time left until the next deadline of an outside
+ *                  descriptor owner.
+ *
+ * \param[in]       user_data: Owner given to \ref m1_event_add_timeout.
+ * \return          Milliseconds until the owner has work, -1 if none.
+ */
+typedef i32 (*m1_event_timeout_fn)(void* user_data);
+
+/* public functions --------------------------------------------------------- */
+/**
+ * \brief           Create the event state of an instance.
+ *
+ * Every RX link whose driver provides `get_fd` is watched for readability,
+ * together with a wakeup descriptor signalled by \ref m1_event_wake. A
+ * descriptor that cannot be watched leaves its link polled.
+ *
+ * \param[in]       m1: Pointer to the M1 protocol instance.
+ * \return          `E_STATE_OK` on success (also without
+ *                  \ref M1_USING_EPOLL), or an error code otherwise.
+ */
+etype_e m1_event_init(m1_t* m1);
+
+/**
+ * \brief           Release the event state of an instance.
+ *
+ * \param[in]       m1: Pointer to the M1 protocol instance.
+ */
+void m1_event_deinit(m1_t* m1);
+
+/**
+ * \brief           Wake a thread blocked in \ref m1_event_wait.
+ *
+ * Safe to call from any thread. Only the first call after the waiter last
+ * ran issues a system call.
+ *
+ * \param[in]       m1: Pointer to the M1 protocol instance.
+ */
+void m1_event_wake(m1_t* m1);
+
+/**
+ * \brief           Add or remove the RX link descriptors from the wait set.
+ *
+ * Links served by reader threads must not be read by the run loop as well.
+ *
+ * \param[in]       m1: Pointer to the M1 protocol instance.
+ * \param[in]       watch: true to wait on the links, false to ignore them.
+ */
+void m1_event_watch_links(m1_t* m1, bool watch);
+
+/**
+ * \brief           Wake \ref m1_event_wait when a descriptor the instance
+ *                  does not own is ready.
+ *
+ * The descriptor is not read: \ref m1_event_wait just returns, and its
+ * owner serves it between the passes of the run loop. The wait set is level
+ * triggered, so a descriptor left ready keeps the loop from sleeping.
+ *
+ * \param[in]       m1: Pointer to the M1 protocol instance.
+ * \param[in]       fd: Descriptor to watch.
+ * \param[in]       events: \ref M1_EVENT_READ and/or \ref M1_EVENT_WRITE, 0
+ *                  to stop watching `fd`.
+ * \return          `E_STATE_OK` on success, `E_STATE_ERROR` if the wait set
+ *                  refused `fd`, or `E_STATE_NOT_IMPLEMENT` without
+ *                  \ref M1_USING_EPOLL.
+ */
+etype_e m1_event_watch_fd(m1_t* m1, int fd, u32 events);
+
+/**
+ * \brief           Cut the waits of \ref m1_event_wait short to the next
+ *                  deadline of an outside descriptor owner.
+ *
+ * Owners that expire their own work, e.g. connection timeouts, register
+ * here so the run loop wakes for it even when none of their descriptors
+ * becomes ready.
+ *
+ * \param[in]       m1: Pointer to the M1 protocol instance.
+ * \param[in]       fn: Returns the time left until the owner's deadline.
+ * \param[in]       user_data: Owner passed to `fn`.
+ * \return          `E_STATE_OK` on success, `E_STATE_INVAL` without `fn`,
+ *                  `E_STATE_NO_SPACE` once \ref M1_EVENT_TIMEOUT_NUM owners
+ *                  are registered, or `E_STATE_NOT_IMPLEMENT` without
+ *                  \ref M1_USING_EPOLL.
+ */
+etype_e m1_event_add_timeout(m1_t* m1, m1_event_timeout_fn fn,
+                             void* user_data);
+
+/**
+ * \brief           Unregister an owner added by \ref m1_event_add_timeout.
+ *
+ * \param[in]       m1: Pointer to the M1 protocol instance.
+ * \param[in]       user_data: Owner to remove.
+ */
+void m1_event_remove_timeout(m1_t* m1, void* user_data);
+
+/**
+ * \brief           Wait for link data or a wakeup, then read the ready
+ *                  links.
+ *
+ * Links without a descriptor, or whose descriptor cannot be waited on, are
+ * read on every call, and the wait is cut short to their read period and to
+ * the deadlines registered with \ref m1_event_add_timeout.
+ *
+ * \param[in]       m1: Pointer to the M1 protocol instance.
+ * \param[in]       timeout_ms: Maximum wait in milliseconds, -1 to wait
+ *                  forever.
+ * \return          `E_STATE_OK` on success, `E_STATE_ERROR` if the wait
+ *                  failed, or `E_STATE_NOT_IMPLEMENT` without
+ *                  \ref M1_USING_EPOLL.
+ */
+etype_e m1_event_wait(m1_t* m1, i32 timeout_ms);
+
+/**
+ * \brief           Get a monotonic timestamp.
+ *
+ * \return          Milliseconds since an unspecified starting point.
+ */
+u64 m1_event_now_ms(void);
+
+/**
+ * \brief           Get a monotonic timestamp with microsecond resolution.
+ *
+ * \return          Microseconds since the same starting point as
+ *                  \ref m1_event_now_ms.
+ */
+u64 m1_event_now_us(void);
+
+/**
+ * \}
+ */
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* __M1_EVENT_H__ */
+
+/* ----------------------------- end of file -------------------------------- */
@@ -49,6 +49,8 @@ extern "C" {
  * \{
  */
 
+struct m1_internal_data;
+
 /**
  * \brief           Structure for transmitting data in the M1 protocol.
  *
@@ -88,6 +90,9 @@ typedef struct m1_rx_data {
     u8 target_id; /*!< ID of the target device. */
     u8* data;     /*!< Pointer to the received payload data. */
     u16 data_len; /*!< Length of the received payload data. */
+
+    struct m1_internal_data* m1; /*!< Protocol instance that received the
+                                    frame. */
 } m1_rx_data_t;
 
 /**
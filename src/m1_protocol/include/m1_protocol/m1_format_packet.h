@@ -37,6 +37,7 @@
 
 /* includes ----------------------------------------------------------------- */
 #include "./m1_protocol/m1_async_rx_tx.h" /*!< Provides asynchronous RX and TX operations. */
+#include "./m1_protocol/m1_buf.h" /*!< Provides reference-counted buffers. */
 #include "./m1_protocol/m1_format_frame.h" /*!< Defines M1 protocol frame structure and attributes. */
 #include "./m1_protocol/m1_typedef.h" /*!< General type definitions for the M1 protocol. */
 
@@ -53,13 +54,15 @@ extern "C" {
 /**
  * \brief           Structure for storing packet data in the M1 protocol.
  *
- * This structure holds the actual data content of a packet, along with a
- * reference counter.
+ * When `buf` is set, it is a frame buffer from \ref m1_datalink_frame_alloc
+ * and `data` points at its payload: the frame is then encoded around the
+ * payload in place. Otherwise `data` is borrowed from the caller for the
+ * duration of the send and copied into a temporary frame.
  */
 typedef struct m1_packet_data {
-    u8 reference_counter; /*!< Reference count for the packet data. */
-    size_t data_len;      /*!< Length of the data buffer. */
-    u8* data;             /*!< Pointer to the data buffer. */
+    m1_buf_t* buf;   /*!< Frame buffer holding the data, or NULL. */
+    size_t data_len; /*!< Length of the data buffer. */
+    u8* data;        /*!< Pointer to the data buffer. */
 } m1_packet_data_t;
 
 /**
@@ -97,6 +100,19 @@ typedef struct m1_packet {
         node; /*!< Node for managing the packet in a single-linked list. */
 } m1_packet_t;
 
+/**
+ * \brief           Per-target header fields of a multicast packet.
+ *
+ * A multicast packet is encoded once; only the fields below differ between
+ * the frames that are put on the wire for each target.
+ */
+typedef struct m1_multicast_target {
+    u8 target_id;   /*!< ID of the target device. */
+    u8 seq_num;     /*!< Sequence number of the frame for this target. */
+    tx_async_t* tx; /*!< Egress link used to reach the target. */
+    int route;      /*!< Index of the egress route in the route table. */
+} m1_multicast_target_t;
+
 /**
  * \}
  */
@@ -0,0 +1,155 @@
+/**
+ * \file            m1_histogram.h
+ * \brief           Log-linear latency histograms.
+ * \date            2026-10-18
+ */
+
+/*
+ * Copyright (c) 2024 Vector Qiu
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE
+ * AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * This file is part of the m1 protocol library.
+ *
+ * Author:          Vector Qiu <vetor.qiu@gmail.com>
+ * Version:         V0.0.1
+ */
+#ifndef __M1_HISTOGRAM_H__
+#define __M1_HISTOGRAM_H__
+
+/* includes ----------------------------------------------------------------- */
+#include "./m1_protocol/m1_typedef.h" /*!< General type definitions for the M1 protocol. */
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+/**
+ * \defgroup        m1_histogram_manager
+ * \brief           Fixed-size histograms with bounded relative error, in the
+ *                  style of HdrHistogram.
+ * \{
+ */
+
+/* public config ------------------------------------------------------------ */
+/**
+ * \brief           Number of bits of precision kept for every value.
+ *
+ * Values below 2^bits are counted exactly; larger values land in buckets
+ * whose width is at most 1 / 2^bits of the value, i.e. 6.25% for 4 bits.
+ */
+#ifndef M1_HISTOGRAM_SUB_BITS
+#define M1_HISTOGRAM_SUB_BITS 4
+#endif /* M1_HISTOGRAM_SUB_BITS */
+
+/**
+ * \brief           Values of 2^bits and above are counted in the last bucket.
+ *
+ * With microsecond values the default covers a little over an hour.
+ */
+#ifndef M1_HISTOGRAM_MAX_BITS
+#define M1_HISTOGRAM_MAX_BITS 32
+#endif /* M1_HISTOGRAM_MAX_BITS */
+
+/* public define ------------------------------------------------------------ */
+/*! Number of buckets of a histogram */
+#define M1_HISTOGRAM_BUCKET_NUM                                                \
+    ((M1_HISTOGRAM_MAX_BITS - M1_HISTOGRAM_SUB_BITS + 1)                       \
+     << M1_HISTOGRAM_SUB_BITS)
+
+/* public typedefs ---------------------------------------------------------- */
+/**
+ * \brief           Histogram of non-negative values.
+ *
+ * Bucket `i` counts the values from \ref m1_histogram_bucket_min (i) to
+ * \ref m1_histogram_bucket_max (i).
+ */
+typedef struct m1_histogram {
+    u64 count; /*!< Number of recorded values. */
+    u64 sum;   /*!< Sum of the recorded values. */
+    u64 min;   /*!< Smallest recorded value, UINT64_MAX if empty. */
+    u64 max;   /*!< Largest recorded value, 0 if empty. */
+    u64 bucket[M1_HISTOGRAM_BUCKET_NUM]; /*!< Value counts per bucket. */
+} m1_histogram_t;
+
+/* public functions --------------------------------------------------------- */
+/**
+ * \brief           Empty a histogram.
+ *
+ * \param[out]      hist: Pointer to the histogram.
+ */
+void m1_histogram_reset(m1_histogram_t* hist);
+
+/**
+ * \brief           Count one value.
+ *
+ * \param[in,out]   hist: Pointer to the histogram.
+ * \param[in]       value: Value to count.
+ */
+void m1_histogram_record(m1_histogram_t* hist, u64 value);
+
+/**
+ * \brief           Get the bucket a value is counted in.
+ *
+ * \param[in]       value: Value to look up.
+ * \return          Bucket index, below \ref M1_HISTOGRAM_BUCKET_NUM.
+ */
+size_t m1_histogram_index(u64 value);
+
+/**
+ * \brief           Get the smallest value counted in a bucket.
+ *
+ * \param[in]       index: Bucket index.
+ * \return          Lower bound of the bucket.
+ */
+u64 m1_histogram_bucket_min(size_t index);
+
+/**
+ * \brief           Get the largest value counted in a bucket.
+ *
+ * \param[in]       index: Bucket index.
+ * \return          Upper bound of the bucket, UINT64_MAX for the last one.
+ */
+u64 m1_histogram_bucket_max(size_t index);
+
+/**
+ * \brief           Get the value below which a share of the recorded values
+ *                  lie.
+ *
+ * \param[in]       hist: Pointer to the histogram.
+ * \param[in]       percentile: Share in percent, from 0 to 100.
+ * \return          Upper bound of the bucket holding that value, capped at
+ *                  the largest recorded value, or 0 if the histogram is
+ *                  empty.
+ */
+u64 m1_histogram_percentile(const m1_histogram_t* hist, double percentile);
+
+/**
+ * \}
+ */
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* __M1_HISTOGRAM_H__ */
+
+/* ----------------------------- end of file -------------------------------- */
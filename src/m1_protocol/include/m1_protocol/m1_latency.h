@@ -0,0 +1,132 @@
+/**
+ * \file            m1_latency.h
+ * \brief           Per-route latency histograms of a protocol instance.
+ * \date            2026-10-18
+ */
+
+/*
+ * Copyright (c) 2024 Vector Qiu
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE
+ * AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * This file is part of the m1 protocol library.
+ *
+ * Author:          Vector Qiu <vetor.qiu@gmail.com>
+ * Version:         V0.0.1
+ */
+#ifndef __M1_LATENCY_H__
+#define __M1_LATENCY_H__
+
+/* includes ----------------------------------------------------------------- */
+#include "./m1_protocol/m1_histogram.h" /*!< Histogram snapshots. */
+#include "./m1_protocol/m1_typedef.h" /*!< General type definitions for the M1 protocol. */
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+/**
+ * \defgroup        m1_latency_manager
+ * \brief           Latency histograms kept for every route, in microseconds.
+ * \{
+ */
+
+/* public typedefs ---------------------------------------------------------- */
+/**
+ * \brief           Measured latencies.
+ */
+typedef enum m1_latency_kind {
+    M1_LATENCY_ACK_RTT = 0, /*!< First transmission of a reliable packet to
+                               its ACK, by target route. */
+    M1_LATENCY_RX_CALLBACK, /*!< Frame verified by the data link layer to the
+                               start of its RX callback, by source route. */
+    M1_LATENCY_TX_QUEUE,    /*!< \ref m1_protocol_tx_data to the send on the
+                               run loop, by target route. */
+    M1_LATENCY_KIND_MAX,    /*!< Number of latency kinds. */
+} m1_latency_kind_e;
+
+/**
+ * \brief           Opaque set of histograms, one per route and kind.
+ *
+ * Values may be recorded from any thread; counters are updated with relaxed
+ * atomics, so a snapshot taken while values are recorded is consistent per
+ * bucket but not across buckets.
+ */
+typedef struct m1_latency m1_latency_t;
+
+/* public functions --------------------------------------------------------- */
+/**
+ * \brief           Create empty histograms for a number of routes.
+ *
+ * \param[in]       route_num: Number of routes.
+ * \return          Pointer to the histograms, or NULL on allocation failure.
+ */
+m1_latency_t* m1_latency_create(size_t route_num);
+
+/**
+ * \brief           Destroy the histograms.
+ *
+ * \param[in]       latency: Pointer to the histograms, may be NULL.
+ */
+void m1_latency_destroy(m1_latency_t* latency);
+
+/**
+ * \brief           Count one latency.
+ *
+ * \param[in]       latency: Pointer to the histograms, may be NULL.
+ * \param[in]       route: Route index; out of range values are ignored.
+ * \param[in]       kind: Measured latency.
+ * \param[in]       value_us: Latency in microseconds.
+ */
+void m1_latency_record(m1_latency_t* latency, size_t route,
+                       m1_latency_kind_e kind, u64 value_us);
+
+/**
+ * \brief           Copy one histogram.
+ *
+ * \param[in]       latency: Pointer to the histograms.
+ * \param[in]       route: Route index.
+ * \param[in]       kind: Measured latency.
+ * \param[out]      hist: Receives the histogram.
+ * \return          `E_STATE_OK` on success, or `E_STATE_INVAL` on invalid
+ *                  arguments.
+ */
+etype_e m1_latency_snapshot(m1_latency_t* latency, size_t route,
+                            m1_latency_kind_e kind, m1_histogram_t* hist);
+
+/**
+ * \brief           Empty every histogram.
+ *
+ * \param[in]       latency: Pointer to the histograms, may be NULL.
+ */
+void m1_latency_reset(m1_latency_t* latency);
+
+/**
+ * \}
+ */
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* __M1_LATENCY_H__ */
+
+/* ----------------------------- end of file -------------------------------- */
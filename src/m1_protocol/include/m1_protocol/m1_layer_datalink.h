@@ -37,6 +37,7 @@
 
 /* includes ----------------------------------------------------------------- */
 #include "./m1_protocol/m1_format_packet.h" /*!< Defines packet structures and attributes for the M1 protocol. */
+#include "./m1_protocol/m1_protocol_def.h" /*!< Defines the M1 protocol instance. */
 #include "./m1_protocol/m1_typedef.h" /*!< General type definitions for the M1 protocol. */
 
 #ifdef __cplusplus
@@ -56,12 +57,55 @@ extern "C" {
  * layer. It ensures that the packet is properly formatted and transmitted
  * according to the M1 protocol requirements.
  *
+ * \param[in]       m1: Pointer to the M1 protocol instance.
  * \param[in]       packet: Pointer to the packet structure to be sent.
  * \return          An error type indicating the status of the transmission.
  *                   - `E_STATE_OK` if the transmission is successful.
  *                   - An appropriate error code otherwise.
  */
-etype_e m1_datalink_send(m1_packet_t* packet);
+etype_e m1_datalink_send(m1_t* m1, m1_packet_t* packet);
+
+/**
+ * \brief           Sends one packet to several targets through the data link
+ *                  layer.
+ *
+ * The frame is built and checksummed once. For every following target only
+ * the header fields in \ref m1_multicast_target_t are patched, the header
+ * CRC8 is recomputed and the trailing CRC16 is adjusted without walking the
+ * payload again.
+ *
+ * \param[in]       m1: Pointer to the M1 protocol instance.
+ * \param[in]       packet: Pointer to the packet holding the shared fields.
+ * \param[in]       target: Array of per-target fields, grouped by egress link.
+ * \param[in]       target_len: Number of entries in \p target.
+ * \return          An error type indicating the status of the transmission.
+ *                   - `E_STATE_OK` if every frame was sent successfully.
+ *                   - The first error returned by a link otherwise.
+ */
+etype_e m1_datalink_send_multicast(m1_t* m1, m1_packet_t* packet,
+                                   const m1_multicast_target_t* target,
+                                   size_t target_len);
+
+/**
+ * \brief           Allocate a frame buffer for a payload.
+ *
+ * The buffer has room for the frame header in front of the payload and for
+ * the CRC16 behind it, so a packet whose \ref m1_packet_data_t::buf is set is
+ * sent, retransmitted and multicast without copying the payload again.
+ *
+ * \param[in]       data_len: Length of the payload.
+ * \return          The buffer holding one reference, or NULL on allocation
+ *                  failure.
+ */
+m1_buf_t* m1_datalink_frame_alloc(size_t data_len);
+
+/**
+ * \brief           Get the payload area of a frame buffer.
+ *
+ * \param[in]       frame: Buffer from \ref m1_datalink_frame_alloc.
+ * \return          Start of the payload.
+ */
+u8* m1_datalink_frame_data(m1_buf_t* frame);
 
 /**
  * \brief           Receives and processes packets at the data link layer.
@@ -69,9 +113,66 @@ etype_e m1_datalink_send(m1_packet_t* packet);
  * This function listens for incoming packets at the specified frequency and
  * processes them according to the M1 protocol.
  *
+ * \param[in]       m1: Pointer to the M1 protocol instance.
  * \param[in]       freq: Frequency of the data reception process in Hz.
  */
-void m1_datalink_receive(u32 freq);
+void m1_datalink_receive(m1_t* m1, u32 freq);
+
+/**
+ * \brief           Reads one RX link once and parses the returned bytes.
+ *
+ * A link fed through \ref rx_async_t::ring is not read; the bytes waiting
+ * in its ring are parsed in place and released instead.
+ *
+ * \param[in]       m1: Pointer to the M1 protocol instance.
+ * \param[in]       node: The receive parsing node of the link.
+ * \return          Number of bytes read, 0 if the link had no data or
+ *                  failed.
+ */
+size_t m1_datalink_read(m1_t* m1, m1_rx_parse_node_t* node);
+
+/**
+ * \brief           Get the length of the frame starting at a buffer.
+ *
+ * Lets datagram drivers check that a datagram holds exactly one frame
+ * before handing it to the stack.
+ *
+ * \param[in]       buf: Start of the frame.
+ * \param[in]       len: Number of bytes available at `buf`.
+ * \return          Length of the whole frame, header and CRC16 included, or
+ *                  0 if `buf` does not start with a frame header.
+ */
+size_t m1_datalink_frame_len(const u8* buf, size_t len);
+
+/**
+ * \brief           Push out the frames the TX drivers are holding back.
+ *
+ * Calls \ref tx_async_t::flush of every route that has one.
+ *
+ * \param[in]       m1: Pointer to the M1 protocol instance.
+ */
+void m1_datalink_flush(m1_t* m1);
+
+/**
+ * \brief           Start one reader thread per RX parse node.
+ *
+ * Each thread reads and parses its own link; completed frames are queued and
+ * routed by \ref m1_datalink_receive on the run loop.
+ *
+ * \param[in]       m1: Pointer to the M1 protocol instance.
+ * \return          `E_STATE_OK` on success, `E_STATE_REPEATED` if already
+ *                  started, `E_STATE_NO_SPACE` on allocation failure, or
+ *                  `E_STATE_NOT_IMPLEMENT` without \ref M1_USING_PTHREAD.
+ */
+etype_e m1_datalink_rx_thread_start(m1_t* m1);
+
+/**
+ * \brief           Stop the reader threads and go back to polling the links
+ *                  from \ref m1_datalink_receive.
+ *
+ * \param[in]       m1: Pointer to the M1 protocol instance.
+ */
+void m1_datalink_rx_thread_stop(m1_t* m1);
 
 /**
  * \}
@@ -37,6 +37,7 @@
 
 /* includes ----------------------------------------------------------------- */
 #include "./m1_protocol/m1_format_packet.h" /*!< Defines packet structures and attributes for the M1 protocol. */
+#include "./m1_protocol/m1_protocol_def.h" /*!< Defines the M1 protocol instance. */
 #include "./m1_protocol/m1_typedef.h" /*!< General type definitions for the M1 protocol. */
 
 #ifdef __cplusplus
@@ -55,6 +56,7 @@ extern "C" {
  * This function processes a frame received from the lower layers and converts
  * it into a higher-level representation according to the M1 protocol.
  *
+ * \param[in]       m1: Pointer to the M1 protocol instance.
  * \param[in]       frame_buf: Pointer to the buffer containing the received
  * frame.
  * \param[in]       frame_len: Length of the received frame in bytes.
@@ -62,7 +64,7 @@ extern "C" {
  *                   - `ETYPE_OK` if the processing is successful.
  *                   - An appropriate error code otherwise.
  */
-etype_e m1_network_receive(u8* frame_buf, size_t frame_len);
+etype_e m1_network_receive(m1_t* m1, u8* frame_buf, size_t frame_len);
 
 /**
  * \brief           Sends a packet through the network layer.
@@ -71,6 +73,7 @@ etype_e m1_network_receive(u8* frame_buf, size_t frame_len);
  * layer. It ensures that the packet is properly prepared and optionally adds a
  * sequence number.
  *
+ * \param[in]       m1: Pointer to the M1 protocol instance.
  * \param[in]       packet: Pointer to the packet structure to be sent.
  * \param[in]       add_seq_num: Boolean flag indicating whether to add a
  * sequence number.
@@ -78,7 +81,41 @@ etype_e m1_network_receive(u8* frame_buf, size_t frame_len);
  *                   - `ETYPE_OK` if the transmission is successful.
  *                   - An appropriate error code otherwise.
  */
-etype_e m1_network_send(m1_packet_t* packet, bool add_seq_num);
+etype_e m1_network_send(m1_t* m1, m1_packet_t* packet, bool add_seq_num);
+
+/**
+ * \brief           Sends a packet to several targets through the network
+ *                  layer.
+ *
+ * Targets are resolved against the routing table and grouped by egress link,
+ * then handed to the data link layer, which encodes the packet only once.
+ * Targets without a route are skipped, counted in
+ * \ref m1_stats_net_t::tx_no_route_cnt and traced.
+ *
+ * \param[in]       m1: Pointer to the M1 protocol instance.
+ * \param[in]       packet: Pointer to the packet structure to be sent.
+ * \param[in]       target_id: Array of target device IDs.
+ * \param[in]       target_id_len: Number of entries in \p target_id.
+ * \param[in]       add_seq_num: Boolean flag indicating whether to add a
+ * sequence number.
+ * \return          An error type indicating the status of the transmission.
+ *                   - `ETYPE_OK` if the transmission is successful.
+ *                   - `E_STATE_NOT_EXIST` if a target has no route.
+ *                   - `E_STATE_INVAL` for more than `UINT8_MAX` targets.
+ *                   - An appropriate error code otherwise.
+ */
+etype_e m1_network_send_multicast(m1_t* m1, m1_packet_t* packet,
+                                  const u8* target_id, size_t target_id_len,
+                                  bool add_seq_num);
+
+/**
+ * \brief           Finds the routing table index for a given target ID.
+ *
+ * \param[in]       m1: Pointer to the M1 protocol instance.
+ * \param[in]       target_id: The ID of the target node.
+ * \return          Index into the routing table, or -1 if no route matches.
+ */
+int m1_network_route_index(m1_t* m1, u16 target_id);
 
 /**
  * \}
@@ -38,6 +38,7 @@
 
 /* includes ----------------------------------------------------------------- */
 #include "./m1_protocol/m1_format_data.h" /*!< Provides data structure definitions for M1 protocol. */
+#include "./m1_protocol/m1_protocol_def.h" /*!< Defines the M1 protocol instance. */
 #include "./m1_protocol/m1_typedef.h" /*!< Includes common type definitions for the M1 protocol. */
 
 #ifdef __cplusplus
@@ -51,15 +52,41 @@ extern "C" {
  * \{
  */
 
+/**
+ * \brief           A packet waiting for its acknowledgment.
+ *
+ * Taken from \ref m1_t::packet_pool. The packet's data descriptor lives in
+ * the same object and holds one reference on the shared frame buffer, so the
+ * payload of a multi-target send exists once however many targets wait.
+ */
+typedef struct m1_wait_ack_packet {
+    m1_packet_t packet;    /*!< The packet, `packet.data` points at `data`. */
+    m1_packet_data_t data; /*!< Payload of the packet. */
+    u64 send_us; /*!< Time of the first transmission, 0 when latencies are not
+                    recorded. */
+    int route;   /*!< Route of the target, -1 if it has none. */
+} m1_wait_ack_packet_t;
+
 /**
  * \brief           Executes periodic transport layer tasks.
  *
  * This function performs tasks such as retransmission handling, timeouts, and
  * state management. It should be called periodically by the application.
  *
- * \param[in]       freq: Frequency of the data reception process in Hz.
+ * \param[in]       m1: Pointer to the M1 protocol instance.
+ * \param[in]       elapsed_ms: Time elapsed since the previous call, in
+ *                  milliseconds.
+ */
+void m1_transport_run(m1_t* m1, u32 elapsed_ms);
+
+/**
+ * \brief           Time until the next retransmission deadline.
+ *
+ * \param[in]       m1: Pointer to the M1 protocol instance.
+ * \return          Milliseconds until the earliest packet waiting for an ACK
+ *                  times out (0 if already due), or -1 if none is waiting.
  */
-void m1_transport_run(u32 freq);
+i32 m1_transport_next_timeout(m1_t* m1);
 
 /**
  * \brief           Receives data from the network layer.
@@ -67,6 +94,7 @@ void m1_transport_run(u32 freq);
  * This function processes raw data received from the network layer, extracts
  * useful information, and prepares it for further processing at higher layers.
  *
+ * \param[in]       m1: Pointer to the M1 protocol instance.
  * \param[in]       frame_buf: Pointer to the buffer containing the raw
  *                  frame data.
  * \param[in]       frame_len: Length of the raw frame data.
@@ -75,7 +103,7 @@ void m1_transport_run(u32 freq);
  *                   - `ETYPE_OK` on success.
  *                   - Other error codes indicating specific failures.
  */
-etype_e m1_transport_receive(u8* frame_buf, size_t frame_len);
+etype_e m1_transport_receive(m1_t* m1, u8* frame_buf, size_t frame_len);
 
 /**
  * \brief           Sends data to the network layer.
@@ -84,14 +112,70 @@ etype_e m1_transport_receive(u8* frame_buf, size_t frame_len);
  * appropriate transport layer structure and sends it to the network layer for
  * further processing.
  *
+ * \param[in]       m1: Pointer to the M1 protocol instance.
  * \param[in]       tx_data: Pointer to the data structure containing
  *                  information about the transmission.
  * \return          Returns an error code of type `etype_e` indicating the
  *                  success or failure of the operation.
  *                   - `ETYPE_OK` on success.
+ *                   - `E_STATE_BUSY` if a reliable transmission has to wait
+ *                     for packets to be acknowledged; nothing was sent.
+ *                   - `E_STATE_ARGUMENT_BIG` if a reliable transmission has
+ *                     more targets than \ref M1_PACKET_POOL_SIZE.
+ *                   - The network layer error if an unreliable transmission
+ *                     could not be sent to every target.
  *                   - Other error codes indicating specific failures.
  */
-etype_e m1_transport_send(m1_tx_data_t* tx_data);
+etype_e m1_transport_send(m1_t* m1, m1_tx_data_t* tx_data);
+
+/**
+ * \brief           Sends data whose payload already sits in a frame buffer.
+ *
+ * Like \ref m1_transport_send, but `tx_data->data` must point at the payload
+ * of `frame`, a buffer from \ref m1_datalink_frame_alloc. Frames are encoded
+ * around the payload in place and packets waiting for an acknowledgment keep
+ * a reference on `frame` instead of a copy. The caller keeps its own
+ * reference.
+ *
+ * \param[in]       m1: Pointer to the M1 protocol instance.
+ * \param[in]       tx_data: Pointer to the data structure containing
+ *                  information about the transmission.
+ * \param[in]       frame: Frame buffer holding the payload, or NULL to send
+ *                  `tx_data->data` as \ref m1_transport_send does.
+ * \return          Same as \ref m1_transport_send.
+ */
+etype_e m1_transport_send_frame(m1_t* m1, m1_tx_data_t* tx_data,
+                                m1_buf_t* frame);
+
+/**
+ * \brief           Start the workers running the RX callbacks.
+ *
+ * Besides the \ref m1_work_pool_t, \ref M1_RX_JOB_POOL_SIZE callback jobs
+ * large enough for the biggest `max_pkg_size` of the route table are
+ * preallocated, so dispatching a frame does not allocate.
+ *
+ * \param[in]       m1: Pointer to the M1 protocol instance.
+ * \param[in]       worker_num: Number of worker threads, at least 1.
+ * \return          `E_STATE_OK` on success, `E_STATE_NO_SPACE` on allocation
+ *                  failure, or `E_STATE_NOT_IMPLEMENT` without
+ *                  \ref M1_USING_PTHREAD.
+ */
+etype_e m1_transport_rx_pool_start(m1_t* m1, size_t worker_num);
+
+/**
+ * \brief           Run the dispatched callbacks to completion and stop the
+ *                  workers.
+ *
+ * \param[in]       m1: Pointer to the M1 protocol instance.
+ */
+void m1_transport_rx_pool_stop(m1_t* m1);
+
+/**
+ * \brief           Drop every packet waiting for an acknowledgment.
+ *
+ * \param[in]       m1: Pointer to the M1 protocol instance.
+ */
+void m1_transport_clear(m1_t* m1);
 
 /**
  * \}
@@ -0,0 +1,98 @@
+/**
+ * \file            m1_metrics.h
+ * \brief           OpenMetrics text exporter for the stack statistics.
+ * \date            2026-10-18
+ */
+
+/*
+ * Copyright (c) 2024 Vector Qiu
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE
+ * AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * This file is part of the m1 protocol library.
+ *
+ * Author:          Vector Qiu <vetor.qiu@gmail.com>
+ * Version:         V0.0.1
+ */
+#ifndef __M1_METRICS_H__
+#define __M1_METRICS_H__
+
+/* includes ----------------------------------------------------------------- */
+#include "./m1_protocol/m1_protocol_def.h" /*!< Defines the M1 protocol instance. */
+#include "./m1_protocol/m1_typedef.h" /*!< General type definitions for the M1 protocol. */
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+/**
+ * \defgroup        m1_metrics_manager
+ * \brief           Renders the statistics of an instance in the OpenMetrics
+ *                  text format, for Prometheus style scrapers.
+ * \{
+ */
+
+/* public config ------------------------------------------------------------ */
+/**
+ * \brief           MIME type of the text produced by \ref m1_metrics_render.
+ */
+#define M1_METRICS_CONTENT_TYPE                                                \
+    "application/openmetrics-text; version=1.0.0; charset=utf-8"
+
+/* public functions --------------------------------------------------------- */
+/**
+ * \brief           Render every statistic of an instance as OpenMetrics text.
+ *
+ * Exported families, all labelled with `instance`:
+ *  - `m1_rx_*`: \ref m1_stats_rx_parse_t of every RX link, labelled `link`.
+ *  - `m1_tx_*` and `m1_forward_*`: \ref m1_stats_tx_t of every route,
+ *    labelled `link` and `target`.
+ *  - `m1_*_no_route`: \ref m1_stats_net_t.
+ *  - `m1_ack_rtt_seconds`, `m1_rx_callback_seconds` and
+ *    `m1_tx_queue_seconds`: summaries of the latency histograms.
+ *  - `m1_tx_pool_*` and `m1_packet_pool_*`: TX memory pool and packet pool
+ *    usage, and `m1_trace_dropped`.
+ *
+ * The pool gauges are read without locking; call this from the thread
+ * running \ref m1_protocol_run.
+ *
+ * \param[in]       m1: Pointer to the M1 protocol instance.
+ * \param[out]      buf: Output buffer, NUL-terminated on success.
+ * \param[in]       len: Size of `buf`.
+ * \param[out]      out_len: Length of the text, without the NUL. Also set
+ *                  when `buf` is too small, so the caller can retry with
+ *                  `*out_len + 1` bytes.
+ * \return          `E_STATE_OK` on success, `E_STATE_NO_SPACE` if `buf` is
+ *                  too small, or `E_STATE_INVAL` on invalid arguments.
+ */
+etype_e m1_metrics_render(m1_t* m1, char* buf, size_t len, size_t* out_len);
+
+/**
+ * \}
+ */
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* __M1_METRICS_H__ */
+
+/* ----------------------------- end of file -------------------------------- */
@@ -0,0 +1,116 @@
+/**
+ * \file            m1_mpsc_queue.h
+ * \brief           Bounded lock-free multi-producer single-consumer queue.
+ * \date            2026-10-18
+ */
+
+/*
+ * Copyright (c) 2024 Vector Qiu
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE
+ * AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * This file is part of the m1 protocol library.
+ *
+ * Author:          Vector Qiu <vetor.qiu@gmail.com>
+ * Version:         V0.0.1
+ */
+#ifndef __M1_MPSC_QUEUE_H__
+#define __M1_MPSC_QUEUE_H__
+
+/* includes ----------------------------------------------------------------- */
+#include "./m1_protocol/m1_typedef.h" /*!< General type definitions for the M1 protocol. */
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+/**
+ * \defgroup        m1_mpsc_queue_manager
+ * \brief           Lock-free queue of pointers used to hand work to the
+ *                  protocol run loop.
+ * \{
+ */
+
+/* public typedefs ---------------------------------------------------------- */
+/**
+ * \brief           Opaque queue handle.
+ *
+ * Any number of threads may push concurrently; exactly one thread may pop.
+ * Every slot carries its own sequence number, so producers only contend on a
+ * single compare-and-swap of the write index and never take a lock.
+ */
+typedef struct m1_mpsc_queue m1_mpsc_queue_t;
+
+/* public functions --------------------------------------------------------- */
+/**
+ * \brief           Create a queue.
+ *
+ * \param[in]       capacity: Minimum number of items the queue can hold,
+ *                  rounded up to the next power of two.
+ * \return          Pointer to the queue, or NULL on invalid capacity or
+ *                  allocation failure.
+ */
+m1_mpsc_queue_t* m1_mpsc_queue_create(size_t capacity);
+
+/**
+ * \brief           Destroy a queue. Items still queued are not released.
+ *
+ * \param[in]       queue: Pointer to the queue, may be NULL.
+ */
+void m1_mpsc_queue_destroy(m1_mpsc_queue_t* queue);
+
+/**
+ * \brief           Push an item. Safe to call from any thread.
+ *
+ * \param[in]       queue: Pointer to the queue.
+ * \param[in]       item: Item to enqueue, must not be NULL.
+ * \return          `E_STATE_OK` on success, `E_STATE_BUSY` if the queue is
+ *                  full, or `E_STATE_INVAL` on invalid arguments.
+ */
+etype_e m1_mpsc_queue_push(m1_mpsc_queue_t* queue, void* item);
+
+/**
+ * \brief           Pop the oldest item. Must only be called by the consumer.
+ *
+ * \param[in]       queue: Pointer to the queue.
+ * \return          The item, or NULL if the queue is empty.
+ */
+void* m1_mpsc_queue_pop(m1_mpsc_queue_t* queue);
+
+/**
+ * \brief           Get the capacity of a queue.
+ *
+ * \param[in]       queue: Pointer to the queue.
+ * \return          Number of slots in the queue.
+ */
+size_t m1_mpsc_queue_capacity(const m1_mpsc_queue_t* queue);
+
+/**
+ * \}
+ */
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* __M1_MPSC_QUEUE_H__ */
+
+/* ----------------------------- end of file -------------------------------- */
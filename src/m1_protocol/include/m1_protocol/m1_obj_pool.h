@@ -0,0 +1,127 @@
+/**
+ * \file            m1_obj_pool.h
+ * \brief           Fixed-size object pool with an intrusive free list.
+ * \date            2026-10-18
+ */
+
+/*
+ * Copyright (c) 2024 Vector Qiu
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE
+ * AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * This file is part of the m1 protocol library.
+ *
+ * Author:          Vector Qiu <vetor.qiu@gmail.com>
+ * Version:         V0.0.1
+ */
+#ifndef __M1_OBJ_POOL_H__
+#define __M1_OBJ_POOL_H__
+
+/* includes ----------------------------------------------------------------- */
+#include "./m1_protocol/m1_typedef.h" /*!< General type definitions for the M1 protocol. */
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+/**
+ * \defgroup        m1_obj_pool_manager
+ * \brief           Preallocated pools of equally sized objects used for the
+ *                  protocol's packet bookkeeping.
+ * \{
+ */
+
+/* public typedefs ---------------------------------------------------------- */
+/**
+ * \brief           Opaque object pool handle.
+ *
+ * All objects are carved from one allocation made at creation. A free object
+ * stores the link to the next free one in its own first bytes, so allocation
+ * and release are a single pointer swap and the pool never fragments. A pool
+ * is not thread-safe; it belongs to the thread running the instance.
+ */
+typedef struct m1_obj_pool m1_obj_pool_t;
+
+/* public functions --------------------------------------------------------- */
+/**
+ * \brief           Create a pool.
+ *
+ * \param[in]       obj_size: Size of one object in bytes.
+ * \param[in]       capacity: Number of objects the pool holds.
+ * \return          Pointer to the pool, or NULL on invalid arguments or
+ *                  allocation failure.
+ */
+m1_obj_pool_t* m1_obj_pool_create(size_t obj_size, size_t capacity);
+
+/**
+ * \brief           Destroy a pool together with every object in it.
+ *
+ * \param[in]       pool: Pointer to the pool, may be NULL.
+ */
+void m1_obj_pool_destroy(m1_obj_pool_t* pool);
+
+/**
+ * \brief           Take an object from a pool.
+ *
+ * \param[in]       pool: Pointer to the pool.
+ * \return          Pointer to an uninitialized object, or NULL if every
+ *                  object is in use.
+ */
+void* m1_obj_pool_alloc(m1_obj_pool_t* pool);
+
+/**
+ * \brief           Return an object to the pool it was taken from.
+ *
+ * \param[in]       pool: Pointer to the pool.
+ * \param[in]       obj: Object returned by \ref m1_obj_pool_alloc, may be
+ *                  NULL.
+ * \return          `E_STATE_OK` on success, or `E_STATE_INVAL` if `obj` does
+ *                  not belong to the pool.
+ */
+etype_e m1_obj_pool_free(m1_obj_pool_t* pool, void* obj);
+
+/**
+ * \brief           Get the number of objects that can still be allocated.
+ *
+ * \param[in]       pool: Pointer to the pool.
+ * \return          Number of free objects.
+ */
+size_t m1_obj_pool_available(const m1_obj_pool_t* pool);
+
+/**
+ * \brief           Get the capacity of a pool.
+ *
+ * \param[in]       pool: Pointer to the pool.
+ * \return          Number of objects in the pool.
+ */
+size_t m1_obj_pool_capacity(const m1_obj_pool_t* pool);
+
+/**
+ * \}
+ */
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* __M1_OBJ_POOL_H__ */
+
+/* ----------------------------- end of file -------------------------------- */
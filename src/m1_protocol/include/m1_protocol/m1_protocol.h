@@ -52,7 +52,10 @@ extern "C" {
 
 /* public functions --------------------------------------------------------- */
 /**
- * \brief           Initialize the M1 protocol.
+ * \brief           Initialize an M1 protocol instance.
+ *
+ * Every instance owns its memory pool, parser state, sequence numbers and
+ * retransmission list, so several stacks can live in one process.
  *
  * \param[in]       name: Name of the M1 protocol instance.
  * \param[in]       tx_pool_size: Tx memory pool size.
@@ -64,31 +67,192 @@ extern "C" {
  * \param[in]       rx_cb_len: Number of callbacks in the table.
  * \param[in]       source_id: Pointer to the source device ID.
  * \param[in]       source_id_len: Length of the source device ID.
- * \return          etype_e indicating success or failure of initialization.
+ * \return          Handle of the new instance, or NULL if the arguments are
+ *                  invalid or memory is exhausted.
+ */
+m1_t* m1_protocol_init(const char name[], size_t tx_pool_size,
+                       m1_route_item_t* route_table, size_t route_len,
+                       m1_rx_parse_callback_item_t* rx_cb_table,
+                       size_t rx_cb_len, u8* source_id, size_t source_id_len);
+
+/**
+ * \brief           Release an M1 protocol instance.
+ *
+ * \param[in]       m1: Pointer to the M1 protocol instance, may be NULL.
+ */
+void m1_protocol_deinit(m1_t* m1);
+
+/**
+ * \brief           Switch an instance to threaded RX.
+ *
+ * Every RX link gets its own reader thread running the frame parser, and RX
+ * callbacks are executed by a pool of `worker_num` work-stealing threads
+ * instead of the thread calling \ref m1_protocol_run, so a slow handler on
+ * one link no longer stalls parsing on the others. Frames from the same
+ * source are delivered to the callbacks in order. Routing, acknowledgments
+ * and retransmissions stay on the run loop.
+ *
+ * \param[in]       m1: Pointer to the M1 protocol instance.
+ * \param[in]       worker_num: Number of callback workers, 0 keeps the
+ *                  callbacks on the run loop.
+ * \return          `E_STATE_OK` on success, `E_STATE_REPEATED` if already
+ *                  started, `E_STATE_NOT_IMPLEMENT` without
+ *                  \ref M1_USING_PTHREAD, or another error code otherwise.
  */
-etype_e m1_protocol_init(const char name[], size_t tx_pool_size,
-                         m1_route_item_t* route_table, size_t route_len,
-                         m1_rx_parse_callback_item_t* rx_cb_table,
-                         size_t rx_cb_len, u8* source_id, size_t source_id_len);
+etype_e m1_protocol_rx_thread_start(m1_t* m1, size_t worker_num);
+
+/**
+ * \brief           Stop the threads started by
+ *                  \ref m1_protocol_rx_thread_start.
+ *
+ * Callbacks already dispatched are run to completion before returning.
+ *
+ * \param[in]       m1: Pointer to the M1 protocol instance.
+ */
+void m1_protocol_rx_thread_stop(m1_t* m1);
 
 /**
  * \brief           Transmit data using the M1 protocol.
  *
+ * The request is copied into a lock-free submission queue and sent by the
+ * next \ref m1_protocol_run, so any number of threads may call this function
+ * concurrently. The caller's buffers can be reused once it returns.
+ *
+ * \param[in]       m1: Pointer to the M1 protocol instance.
  * \param[in]       tx_data: Pointer to the structure containing data to be
  *                  transmitted.
- * \return          etype_e indicating success or failure of the transmission.
+ * \return          `E_STATE_OK` once queued, `E_STATE_BUSY` if the queue is
+ *                  full, `E_STATE_NO_SPACE` on allocation failure, or
+ *                  `E_STATE_INVAL` on invalid arguments.
  */
-etype_e m1_protocol_tx_data(m1_tx_data_t* tx_data);
+etype_e m1_protocol_tx_data(m1_t* m1, m1_tx_data_t* tx_data);
 
 /**
  * \brief           Run the periodic tasks of the M1 protocol.
  *
  * This function should be called regularly to handle time-dependent tasks such
  * as retransmissions, acknowledgments, and other protocol-specific processes.
+ * All layer state is owned by the thread calling it, so it must not be called
+ * concurrently for the same instance.
  *
+ * \param[in]       m1: Pointer to the M1 protocol instance.
  * \param[in]       freq: Frequency of execution in Hz.
  */
-void m1_protocol_run(u32 freq);
+void m1_protocol_run(m1_t* m1, u32 freq);
+
+/**
+ * \brief           Run the M1 protocol from an event loop.
+ *
+ * Blocks until a link with a descriptor is readable, a transmission or a
+ * frame from a reader thread is queued, a retransmission is due, a link
+ * without descriptor must be polled, or `timeout_ms` expires; then performs
+ * the work of \ref m1_protocol_run. Retransmission timers follow the
+ * monotonic clock.
+ *
+ * \param[in]       m1: Pointer to the M1 protocol instance.
+ * \param[in]       timeout_ms: Maximum time to block in milliseconds, -1 to
+ *                  block until there is work.
+ * \return          `E_STATE_OK` on success, `E_STATE_INVAL` on invalid
+ *                  arguments, `E_STATE_ERROR` if waiting failed, or
+ *                  `E_STATE_NOT_IMPLEMENT` without \ref M1_USING_EPOLL.
+ */
+etype_e m1_protocol_run_wait(m1_t* m1, i32 timeout_ms);
+
+/**
+ * \brief           Get the route table of an instance.
+ *
+ * \param[in]       m1: Pointer to the M1 protocol instance.
+ * \param[out]      table: Pointer to store the route table address.
+ * \param[out]      len: Pointer to store the route table length.
+ * \return          E_STATE_OK on success, or E_STATE_INVAL if inputs are
+ *                  invalid.
+ */
+etype_e m1_get_route_table(m1_t* m1, m1_route_item_t** table, size_t* len);
+
+/**
+ * \brief           Copy one latency histogram of a route.
+ *
+ * Histograms are kept per entry of the route table: ACK round trips and TX
+ * queue waits by target, RX callback delays by source. Read percentiles with
+ * \ref m1_histogram_percentile.
+ *
+ * \param[in]       m1: Pointer to the M1 protocol instance.
+ * \param[in]       route: Index of the route in the route table.
+ * \param[in]       kind: Measured latency.
+ * \param[out]      hist: Receives the histogram, in microseconds.
+ * \return          `E_STATE_OK` on success, `E_STATE_INVAL` on invalid
+ *                  arguments, or `E_STATE_NOT_IMPLEMENT` without
+ *                  \ref M1_LATENCY_STATS.
+ */
+etype_e m1_protocol_latency_snapshot(m1_t* m1, size_t route,
+                                     m1_latency_kind_e kind,
+                                     m1_histogram_t* hist);
+
+/**
+ * \brief           Empty the latency histograms of every route.
+ *
+ * \param[in]       m1: Pointer to the M1 protocol instance.
+ */
+void m1_protocol_latency_reset(m1_t* m1);
+
+/**
+ * \brief           Copy the transmit statistics of a route.
+ *
+ * Counters are 64-bit and only ever grow. Frames, bytes, link and buffer
+ * failures and retransmissions are charged to the route a frame leaves on,
+ * ACKs to the route leading back to their source. Safe to call from any
+ * thread; counts made concurrently may or may not be included.
+ *
+ * \param[in]       m1: Pointer to the M1 protocol instance.
+ * \param[in]       route: Index of the route in the route table.
+ * \param[out]      stats: Receives the statistics.
+ * \return          `E_STATE_OK` on success, or `E_STATE_INVAL` on invalid
+ *                  arguments.
+ */
+etype_e m1_protocol_tx_stats(m1_t* m1, size_t route, m1_stats_tx_t* stats);
+
+/**
+ * \brief           Copy the network statistics that belong to no route,
+ *                  such as frames dropped for lack of one.
+ *
+ * \param[in]       m1: Pointer to the M1 protocol instance.
+ * \param[out]      stats: Receives the statistics.
+ * \return          `E_STATE_OK` on success, or `E_STATE_INVAL` on invalid
+ *                  arguments.
+ */
+etype_e m1_protocol_net_stats(m1_t* m1, m1_stats_net_t* stats);
+
+/**
+ * \brief           Copy the RX parse statistics of the link of a route.
+ *
+ * Routes sharing one RX link report the same counters. Safe to call from any
+ * thread, including while reader threads are running.
+ *
+ * \param[in]       m1: Pointer to the M1 protocol instance.
+ * \param[in]       route: Index of the route in the route table.
+ * \param[out]      stats: Receives the statistics.
+ * \return          `E_STATE_OK` on success, `E_STATE_INVAL` on invalid
+ *                  arguments, or `E_STATE_NOT_EXIST` if the route has no RX
+ *                  link.
+ */
+etype_e m1_protocol_rx_stats(m1_t* m1, size_t route,
+                             m1_stats_rx_parse_t* stats);
+
+/**
+ * \brief           Take the oldest records off the trace ring.
+ *
+ * The stack records ACKs, retransmissions, send failures and dropped frames
+ * as binary \ref m1_trace_record_t without formatting or I/O. Call this from
+ * a low-priority thread, one at a time, and format the records with
+ * \ref m1_trace_format or ship them as they are.
+ *
+ * \param[in]       m1: Pointer to the M1 protocol instance.
+ * \param[out]      record: Receives up to `record_num` records.
+ * \param[in]       record_num: Capacity of `record`.
+ * \return          Number of records taken, 0 without \ref M1_TRACE_SIZE.
+ */
+size_t m1_protocol_trace_drain(m1_t* m1, m1_trace_record_t* record,
+                               size_t record_num);
 
 /**
  * \}
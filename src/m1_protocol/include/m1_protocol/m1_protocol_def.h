@@ -37,9 +37,15 @@
 
 /* includes ----------------------------------------------------------------- */
 #include "./m1_protocol/m1_format_data.h" /*!< Includes definitions for formatting M1 protocol data. */
+#include "./m1_protocol/m1_latency.h" /*!< Includes the per-route latency histograms. */
+#include "./m1_protocol/m1_mpsc_queue.h" /*!< Includes the TX submission queue. */
+#include "./m1_protocol/m1_obj_pool.h" /*!< Includes the packet object pools. */
 #include "./m1_protocol/m1_route.h" /*!< Includes routing logic for the M1 protocol. */
 #include "./m1_protocol/m1_rx_parse.h" /*!< Includes parsing logic for received data. */
+#include "./m1_protocol/m1_trace.h" /*!< Includes the binary trace ring. */
 #include "./m1_protocol/m1_typedef.h" /*!< Includes common type definitions for the M1 protocol. */
+#include "./m1_protocol/m1_work_pool.h" /*!< Includes the RX callback worker pool. */
+#include "./m1_protocol/single_list_ex.h" /*!< Includes the list of parked submissions. */
 #include "./memory_pool/memory_pool.h"
 
 #ifdef __cplusplus
@@ -53,8 +59,194 @@ extern "C" {
  */
 
 /* Public configuration ----------------------------------------------------- */
+/**
+ * \brief           Cache line size of the target, in bytes.
+ *
+ * Protocol instances are aligned to this size so that two stacks running on
+ * different cores never share a cache line.
+ */
+#ifndef M1_CACHE_LINE_SIZE
+#define M1_CACHE_LINE_SIZE 64
+#endif /* M1_CACHE_LINE_SIZE */
+
+/**
+ * \brief           Number of pending submissions accepted by
+ *                  \ref m1_protocol_tx_data before it reports `E_STATE_BUSY`.
+ *
+ * Rounded up to a power of two.
+ */
+#ifndef M1_TX_QUEUE_SIZE
+#define M1_TX_QUEUE_SIZE 64
+#endif /* M1_TX_QUEUE_SIZE */
+
+/**
+ * \brief           Number of packets that can wait for an acknowledgment at
+ *                  the same time.
+ *
+ * Every target of a reliable transmission holds one packet until it is
+ * acknowledged or its retries run out. Once all are in use the run loop keeps
+ * the next reliable submission back, and \ref m1_protocol_tx_data reports
+ * `E_STATE_BUSY` when the TX queue fills up behind it.
+ */
+#ifndef M1_PACKET_POOL_SIZE
+#define M1_PACKET_POOL_SIZE 64
+#endif /* M1_PACKET_POOL_SIZE */
+
+/**
+ * \brief           Number of frames RX reader threads can hand to the run
+ *                  loop before they have to wait. Rounded up to a power of
+ *                  two.
+ */
+#ifndef M1_RX_QUEUE_SIZE
+#define M1_RX_QUEUE_SIZE 256
+#endif /* M1_RX_QUEUE_SIZE */
+
+/**
+ * \brief           Number of preallocated RX callback jobs handed to the
+ *                  worker pool of \ref m1_protocol_rx_thread_start. Jobs
+ *                  beyond it are allocated on demand.
+ */
+#ifndef M1_RX_JOB_POOL_SIZE
+#define M1_RX_JOB_POOL_SIZE M1_RX_QUEUE_SIZE
+#endif /* M1_RX_JOB_POOL_SIZE */
+
+/**
+ * \brief           Time in microseconds a reader thread sleeps before
+ *                  retrying a full RX queue.
+ */
+#ifndef M1_RX_QUEUE_RETRY_US
+#define M1_RX_QUEUE_RETRY_US 100
+#endif /* M1_RX_QUEUE_RETRY_US */
+
+/**
+ * \brief           Maximum number of ready descriptors handled per wait of
+ *                  \ref m1_protocol_run_wait.
+ */
+#ifndef M1_EVENT_BATCH_SIZE
+#define M1_EVENT_BATCH_SIZE 16
+#endif /* M1_EVENT_BATCH_SIZE */
+
+/**
+ * \brief           Maximum number of back-to-back reads of one readable link
+ *                  per wait of \ref m1_protocol_run_wait.
+ */
+#ifndef M1_EVENT_READ_BUDGET
+#define M1_EVENT_READ_BUDGET 16
+#endif /* M1_EVENT_READ_BUDGET */
+
+/**
+ * \brief           Maximum number of deadlines of outside descriptors folded
+ *                  into the wait of \ref m1_protocol_run_wait, see
+ *                  \ref m1_event_add_timeout.
+ */
+#ifndef M1_EVENT_TIMEOUT_NUM
+#define M1_EVENT_TIMEOUT_NUM 4
+#endif /* M1_EVENT_TIMEOUT_NUM */
+
+/**
+ * \brief           Read buffer size of each stream socket link
+ *                  (\ref M1_LINK_TYPE_IS_SOCKET_STREAM), in bytes.
+ *
+ * One read of this size is parsed in place, so a fast peer is drained with
+ * few system calls.
+ */
+#ifndef M1_STREAM_RX_BUF_SIZE
+#define M1_STREAM_RX_BUF_SIZE (64 * 1024)
+#endif /* M1_STREAM_RX_BUF_SIZE */
+
+/**
+ * \brief           Read buffer size of each datagram link
+ *                  (\ref M1_LINK_TYPE_IS_DGRAM) without `rx_buf_size`, in
+ *                  bytes.
+ *
+ * Datagram drivers split the buffer into one slot per datagram, so it has to
+ * hold a whole batch of the largest frames; the default fits 32 slots of
+ * 2 KiB.
+ */
+#ifndef M1_DGRAM_RX_BUF_SIZE
+#define M1_DGRAM_RX_BUF_SIZE (64 * 1024)
+#endif /* M1_DGRAM_RX_BUF_SIZE */
+
+/**
+ * \brief           Read buffer size of a link whose route gives neither
+ *                  `rx_buf_size` nor `link_rate`, and lower bound of derived
+ *                  sizes.
+ */
+#ifndef M1_RX_BUF_MIN_SIZE
+#define M1_RX_BUF_MIN_SIZE 128
+#endif /* M1_RX_BUF_MIN_SIZE */
+
+/**
+ * \brief           Upper bound of read buffer sizes derived from
+ *                  \ref m1_route_item_t::link_rate.
+ */
+#ifndef M1_RX_BUF_MAX_SIZE
+#define M1_RX_BUF_MAX_SIZE (256 * 1024)
+#endif /* M1_RX_BUF_MAX_SIZE */
+
+/**
+ * \brief           Number of poll periods worth of link traffic one read
+ *                  buffer holds, so a late poll does not leave data behind.
+ */
+#ifndef M1_RX_BUF_POLL_MARGIN
+#define M1_RX_BUF_POLL_MARGIN 2
+#endif /* M1_RX_BUF_POLL_MARGIN */
+
+/**
+ * \brief           Record the latency histograms of \ref m1_latency_kind_e.
+ *
+ * Costs two monotonic clock reads per frame and
+ * \ref M1_LATENCY_KIND_MAX histograms of
+ * \ref M1_HISTOGRAM_BUCKET_NUM counters per route. Set to 0 to leave them
+ * out.
+ */
+#ifndef M1_LATENCY_STATS
+#define M1_LATENCY_STATS 1
+#endif /* M1_LATENCY_STATS */
+
+/**
+ * \brief           Number of copies of every statistics counter.
+ *
+ * Threads counting the same event add to different copies, which are summed
+ * when the statistics are read. More shards than counting threads only cost
+ * memory.
+ */
+#ifndef M1_STATS_SHARD_NUM
+#if M1_USING_PTHREAD
+#define M1_STATS_SHARD_NUM 8
+#else
+#define M1_STATS_SHARD_NUM 1
+#endif
+#endif /* M1_STATS_SHARD_NUM */
+
+/**
+ * \brief           Number of records in the trace ring of each instance,
+ *                  rounded up to a power of two. Set to 0 to compile the
+ *                  trace points out.
+ *
+ * Drain the ring with \ref m1_protocol_trace_drain.
+ */
+#ifndef M1_TRACE_SIZE
+#define M1_TRACE_SIZE 256
+#endif /* M1_TRACE_SIZE */
 
 /* Public definitions ------------------------------------------------------- */
+/**
+ * \brief           Record an event in the trace ring of an instance.
+ *
+ * \param[in]       m1: Pointer to the M1 protocol instance.
+ * \param[in]       event: Event ID, see \ref m1_trace_event_e.
+ * \param[in]       arg0: First argument.
+ * \param[in]       arg1: Second argument.
+ * \param[in]       arg2: Third argument.
+ */
+#define M1_TRACE(m1, event, arg0, arg1, arg2)                                  \
+    do {                                                                       \
+        if (M1_TRACE_SIZE) {                                                   \
+            m1_trace_record((m1)->trace, (event), (u32)(arg0), (u32)(arg1),    \
+                            (u32)(arg2));                                      \
+        }                                                                      \
+    } while (0)
 
 /* Public typedefs ---------------------------------------------------------- */
 /**
@@ -82,7 +274,16 @@ typedef struct m1_internal_data {
 
     MemoryPool* tx_pool; /* tx memory pool */
     size_t tx_pool_size; /* tx memory pool size */
-    // 互斥锁
+    m1_mpsc_queue_t* tx_queue; /*!< Submissions from \ref m1_protocol_tx_data,
+                                  drained by \ref m1_protocol_run. */
+    single_list_ex_t tx_pending; /*!< Reliable submissions popped from
+                                    `tx_queue` that wait for free packets,
+                                    oldest first. */
+    size_t tx_pending_num;       /*!< Number of entries in `tx_pending`, at
+                                    most \ref M1_TX_QUEUE_SIZE. */
+    m1_obj_pool_t* packet_pool; /*!< Packets waiting for acknowledgment,
+                                   \ref M1_PACKET_POOL_SIZE entries. */
+    m1_obj_pool_t* rx_node_pool; /*!< RX parse nodes, one per route. */
 
     m1_route_item_t* route_item; /*!< Pointer to the routing table. */
     size_t route_item_len;       /*!< Number of entries in the routing table. */
@@ -91,10 +292,6 @@ typedef struct m1_internal_data {
 
     single_list_t rx_parse_head; /*!< Head node of the list for received data
                                     parsing. \ref m1_rx_node_t */
-    u8* datalink_rx_buf; /*!< Buffer for receiving data from the data link
-                            layer. */
-    size_t datalink_rx_buf_len; /*!< Length of the data link layer receive
-                                   buffer. */
 
     m1_rx_parse_callback_t
         rx_parse_cb[M1_DATA_TYPE_MAX]; /*!< Array of callbacks for parsing
@@ -104,15 +301,35 @@ typedef struct m1_internal_data {
 
     single_list_t wait_ack_packet_head; /*!< Head node of the list for packets
                                            waiting for acknowledgment. */
-} m1_t;
 
-/* Public variables --------------------------------------------------------- */
-/**
- * \brief           Global M1 protocol instance.
- *
- * This variable holds the internal state and configuration of the M1 protocol.
- */
-extern m1_t m1;
+    struct m1_rx_reader* rx_reader; /*!< Per-link reader threads, NULL when
+                                       the links are polled by the run loop. */
+    size_t rx_reader_num;           /*!< Number of reader threads. */
+    m1_mpsc_queue_t* rx_queue; /*!< Frames parsed by the reader threads. */
+    m1_work_pool_t* rx_pool;   /*!< Workers running the RX callbacks, NULL to
+                                  run them inline on the run loop. */
+    m1_obj_pool_t* rx_job_pool; /*!< Callback jobs handed to `rx_pool`. */
+    m1_mpsc_queue_t* rx_job_free; /*!< Jobs the workers finished, returned
+                                     to `rx_job_pool` by the run loop. */
+    size_t rx_job_data_size;      /*!< Largest payload a pooled job holds. */
+
+    u32 run_cnt; /*!< Number of data link receive passes, used to derive the
+                    read period of each RX link. */
+    struct m1_event* event; /*!< Wait set of \ref m1_protocol_run_wait, NULL
+                               without \ref M1_USING_EPOLL. */
+    u64 last_run_ms; /*!< Time of the previous \ref m1_protocol_run_wait
+                        pass, 0 before the first one. */
+    m1_latency_t* latency; /*!< Latency histograms, NULL without
+                              \ref M1_LATENCY_STATS. */
+    u64 rx_stamp_us; /*!< Time the frame being routed was verified, 0 when
+                        latencies are not recorded. */
+    m1_counter_t* tx_stats;  /*!< \ref m1_stats_tx_t counters of every
+                                route, one block per route. */
+    m1_counter_t* net_stats; /*!< \ref m1_stats_net_t counters. */
+    m1_trace_t* trace; /*!< Trace ring, NULL without \ref M1_TRACE_SIZE. */
+    void* alloc_base; /*!< Address returned by the allocator for this
+                         instance, before cache line alignment. */
+} m1_t;
 
 /**
  * \}
@@ -54,9 +54,38 @@ extern "C" {
  * \brief           Enumeration for different types of communication links.
  */
 typedef enum {
-    M1_LINK_TYPE_UART = 0, /*!< Link type for UART communication. */
+    M1_LINK_TYPE_UART = 0,       /*!< Link type for UART communication. */
+    M1_LINK_TYPE_UDP,            /*!< UDP socket, one frame per datagram. */
+    M1_LINK_TYPE_UNIX_DGRAM,     /*!< AF_UNIX SOCK_DGRAM socket, one frame per
+                                    datagram. */
+    M1_LINK_TYPE_UNIX_SEQPACKET, /*!< AF_UNIX SOCK_SEQPACKET socket, one frame
+                                    per packet. */
+    M1_LINK_TYPE_TCP,            /*!< TCP connection, byte stream. */
+    M1_LINK_TYPE_UNIX_STREAM,    /*!< AF_UNIX SOCK_STREAM socket, byte
+                                    stream. */
 } m1_link_type_e;
 
+/**
+ * \brief           Check whether a link type preserves frame boundaries.
+ *
+ * The RX driver of such a link returns whole frames placed back to back,
+ * so the data link layer validates them in place instead of scanning the
+ * bytes for a start of frame. Without a configured size their read buffer
+ * is \ref M1_DGRAM_RX_BUF_SIZE.
+ */
+#define M1_LINK_TYPE_IS_DGRAM(type)                                            \
+    ((type) == M1_LINK_TYPE_UDP || (type) == M1_LINK_TYPE_UNIX_DGRAM ||        \
+     (type) == M1_LINK_TYPE_UNIX_SEQPACKET)
+
+/**
+ * \brief           Check whether a link type is a stream socket.
+ *
+ * Such links can deliver far more bytes per read than a UART, so without a
+ * configured size their read buffer is \ref M1_STREAM_RX_BUF_SIZE.
+ */
+#define M1_LINK_TYPE_IS_SOCKET_STREAM(type)                                    \
+    ((type) == M1_LINK_TYPE_TCP || (type) == M1_LINK_TYPE_UNIX_STREAM)
+
 /* public typedef struct ---------------------------------------------------- */
 /**
  * \brief           Structure defining a routing item for M1 protocol.
@@ -70,6 +99,11 @@ typedef struct m1_route_item {
     rx_async_t* rx;  /*!< Pointer to the asynchronous reception instance. */
     u16 read_freq;   /*!< Frequency (in Hz) for reading data from this link. */
     size_t max_pkg_size; /*!< Maximum allowable package size for this link. */
+    u32 link_rate;       /*!< Link throughput in bytes per second, 0 if
+                            unknown. Sizes the RX buffer with `read_freq`. */
+    size_t rx_buf_size;  /*!< RX buffer size of this link, 0 to derive it
+                            from the link type, `link_rate` and
+                            `read_freq`. */
 } m1_route_item_t;
 
 /**
@@ -39,6 +39,7 @@
 #include "./m1_protocol/m1_async_rx_tx.h"  /*!< Asynchronous RX/TX handling. */
 #include "./m1_protocol/m1_format_data.h"  /*!< Data format definitions. */
 #include "./m1_protocol/m1_format_frame.h" /*!< Frame format definitions. */
+#include "./m1_protocol/m1_route.h"        /*!< Link type definitions. */
 #include "./m1_protocol/m1_statistic.h" /*!< Statistic tracking for parsing. */
 #include "./m1_protocol/m1_typedef.h"   /*!< Type definitions used across M1. */
 
@@ -107,6 +108,11 @@ typedef struct m1_rx_parse_item {
     m1_parse_t parse; /*!< Parsing state information. */
     u16 read_freq; /*!< Frequency at which data is read from this RX instance.
                     */
+    m1_link_type_e link_type; /*!< Type of the link, selects the parser. */
+    u8* rx_buf;        /*!< Read buffer of this link, NULL if it is fed
+                          through \ref rx_async_t::ring. */
+    size_t rx_buf_len; /*!< Length of `rx_buf`, see
+                          \ref m1_route_item_t::rx_buf_size. */
 } m1_rx_parse_item_t;
 
 /**
@@ -115,7 +121,11 @@ typedef struct m1_rx_parse_item {
 typedef struct m1_rx_parse_node {
     m1_rx_parse_item_t item;   /*!< RX parse item data. */
     single_list_t node;        /*!< Node for linked list implementation. */
-    m1_stats_rx_parse_t stats; /*!< Statistics for RX parsing performance. */
+    m1_counter_t* stats; /*!< \ref m1_stats_rx_parse_t counters of this
+                            link. */
+    bool fd_watched;     /*!< The link descriptor is in the wait set of
+                            \ref m1_protocol_run_wait; otherwise the link is
+                            polled. */
 } m1_rx_parse_node_t;
 
 /**
@@ -0,0 +1,160 @@
+/**
+ * \file            m1_spsc_ring.h
+ * \brief           Lock-free single-producer single-consumer byte ring.
+ * \date            2026-10-18
+ */
+
+/*
+ * Copyright (c) 2024 Vector Qiu
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE
+ * AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * This file is part of the m1 protocol library.
+ *
+ * Author:          Vector Qiu <vetor.qiu@gmail.com>
+ * Version:         V0.0.1
+ */
+#ifndef __M1_SPSC_RING_H__
+#define __M1_SPSC_RING_H__
+
+/* includes ----------------------------------------------------------------- */
+#include "./m1_protocol/m1_typedef.h" /*!< General type definitions for the M1 protocol. */
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+/**
+ * \defgroup        m1_spsc_ring_manager
+ * \brief           Byte ring a driver fills from interrupt or thread context
+ *                  and the data link parser drains in place.
+ * \{
+ */
+
+/* public typedefs ---------------------------------------------------------- */
+/**
+ * \brief           Opaque ring handle.
+ *
+ * Exactly one producer and one consumer may use the ring concurrently. The
+ * capacity is a power of two and the write and read indices live on
+ * separate cache lines, each next to the side's cached copy of the other
+ * index, so a side only touches the other's line when its copy does not
+ * cover a whole span.
+ *
+ * Both sides work on contiguous spans of the ring: the producer asks for a
+ * writable span, fills it (e.g. by DMA or `read`) and commits what it
+ * wrote; the consumer asks for a readable span, parses it where it lies and
+ * commits what it consumed.
+ */
+typedef struct m1_spsc_ring m1_spsc_ring_t;
+
+/* public functions --------------------------------------------------------- */
+/**
+ * \brief           Create a ring.
+ *
+ * \param[in]       capacity: Minimum number of bytes the ring can hold,
+ *                  rounded up to the next power of two.
+ * \return          Pointer to the ring, or NULL on invalid capacity or
+ *                  allocation failure.
+ */
+m1_spsc_ring_t* m1_spsc_ring_create(size_t capacity);
+
+/**
+ * \brief           Destroy a ring.
+ *
+ * \param[in]       ring: Pointer to the ring, may be NULL.
+ */
+void m1_spsc_ring_destroy(m1_spsc_ring_t* ring);
+
+/**
+ * \brief           Get the next contiguous writable span. Producer only.
+ *
+ * \param[in]       ring: Pointer to the ring.
+ * \param[out]      span: Start of the span.
+ * \return          Length of the span, 0 if the ring is full.
+ */
+size_t m1_spsc_ring_write_span(m1_spsc_ring_t* ring, u8** span);
+
+/**
+ * \brief           Publish bytes written into the span from
+ *                  \ref m1_spsc_ring_write_span. Producer only.
+ *
+ * \param[in]       ring: Pointer to the ring.
+ * \param[in]       len: Number of bytes written, at most the span length.
+ */
+void m1_spsc_ring_write_commit(m1_spsc_ring_t* ring, size_t len);
+
+/**
+ * \brief           Copy bytes into the ring. Producer only.
+ *
+ * \param[in]       ring: Pointer to the ring.
+ * \param[in]       buf: Bytes to copy.
+ * \param[in]       len: Number of bytes to copy.
+ * \return          Number of bytes copied, less than `len` if the ring
+ *                  filled up.
+ */
+size_t m1_spsc_ring_write(m1_spsc_ring_t* ring, const u8* buf, size_t len);
+
+/**
+ * \brief           Get the next contiguous readable span. Consumer only.
+ *
+ * \param[in]       ring: Pointer to the ring.
+ * \param[out]      span: Start of the span.
+ * \return          Length of the span, 0 if the ring is empty.
+ */
+size_t m1_spsc_ring_read_span(m1_spsc_ring_t* ring, u8** span);
+
+/**
+ * \brief           Release bytes of the span from
+ *                  \ref m1_spsc_ring_read_span. Consumer only.
+ *
+ * \param[in]       ring: Pointer to the ring.
+ * \param[in]       len: Number of bytes consumed, at most the span length.
+ */
+void m1_spsc_ring_read_commit(m1_spsc_ring_t* ring, size_t len);
+
+/**
+ * \brief           Get the number of bytes waiting in a ring.
+ *
+ * \param[in]       ring: Pointer to the ring.
+ * \return          Number of bytes written and not yet consumed.
+ */
+size_t m1_spsc_ring_used(m1_spsc_ring_t* ring);
+
+/**
+ * \brief           Get the capacity of a ring.
+ *
+ * \param[in]       ring: Pointer to the ring.
+ * \return          Number of bytes the ring holds.
+ */
+size_t m1_spsc_ring_capacity(const m1_spsc_ring_t* ring);
+
+/**
+ * \}
+ */
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* __M1_SPSC_RING_H__ */
+
+/* ----------------------------- end of file -------------------------------- */
@@ -39,6 +39,7 @@
 #define __M1_STATISTIC_H__
 
 /* includes ----------------------------------------------------------------- */
+#include "./m1_protocol/m1_counter.h"
 #include "./m1_protocol/m1_typedef.h"
 
 #ifdef __cplusplus
@@ -56,6 +57,29 @@ extern "C" {
 /* public config ------------------------------------------------------------ */
 
 /* public define ------------------------------------------------------------ */
+/**
+ * \brief           Index of a counter in a counter set laid out like a
+ *                  statistics structure made of `u64` fields.
+ * \param[in]       type: Statistics structure.
+ * \param[in]       field: Field of `type`.
+ */
+#define M1_STATS_INDEX(type, field) (offsetof(type, field) / sizeof(u64))
+
+/**
+ * \brief           Number of counters of a statistics structure.
+ * \param[in]       type: Statistics structure.
+ */
+#define M1_STATS_NUM(type)          (sizeof(type) / sizeof(u64))
+
+/**
+ * \brief           Add to one RX parse counter of a node.
+ * \param[in]       node: Pointer to the node object.
+ * \param[in]       field: Field of \ref m1_stats_rx_parse_t.
+ * \param[in]       len: Amount to add.
+ */
+#define M1_STATS_RX_NODE_ADD(node, field, len)                                 \
+    m1_counter_add((node)->stats,                                              \
+                   M1_STATS_INDEX(m1_stats_rx_parse_t, field), (len))
 
 /**
  * \brief           Increment total bytes received for a node.
@@ -63,67 +87,236 @@ extern "C" {
  * \param[in]       len: Number of bytes to increment.
  */
 #define M1_STATS_RX_NODE_TOTAL_BYTES(node, len)                                \
-    ((node)->stats.total_bytes += (len))
+    M1_STATS_RX_NODE_ADD(node, total_bytes, len)
 
 /**
  * \brief           Increment count of bytes that are not part of a valid frame.
  * \param[in]       node: Pointer to the node object.
  */
-#define M1_STATS_RX_NODE_NOT_FRAME_BYTES(node) ((node)->stats.not_frame_bytes++)
+#define M1_STATS_RX_NODE_NOT_FRAME_BYTES(node)                                 \
+    M1_STATS_RX_NODE_ADD(node, not_frame_bytes, 1)
+
+/**
+ * \brief           Increment count of bytes that are not part of a valid frame
+ *                  by a whole run of bytes.
+ * \param[in]       node: Pointer to the node object.
+ * \param[in]       len: Number of bytes to increment.
+ */
+#define M1_STATS_RX_NODE_NOT_FRAME_LEN(node, len)                              \
+    M1_STATS_RX_NODE_ADD(node, not_frame_bytes, len)
 
 /**
  * \brief           Increment count of Start-of-Frame (SOF) successfully
  * detected.
  * \param[in]       node: Pointer to the node object.
  */
-#define M1_STATS_RX_NODE_SOF_OK(node)          ((node)->stats.sof_ok_cnt++)
+#define M1_STATS_RX_NODE_SOF_OK(node)                                          \
+    M1_STATS_RX_NODE_ADD(node, sof_ok_cnt, 1)
 
 /**
  * \brief           Increment count of CRC8 checks successfully passed.
  * \param[in]       node: Pointer to the node object.
  */
-#define M1_STATS_RX_NODE_CRC8_OK(node)         ((node)->stats.crc8_ok_cnt++)
+#define M1_STATS_RX_NODE_CRC8_OK(node)                                         \
+    M1_STATS_RX_NODE_ADD(node, crc8_ok_cnt, 1)
 
 /**
  * \brief           Increment count of CRC8 check failures.
  * \param[in]       node: Pointer to the node object.
  */
-#define M1_STATS_RX_NODE_CRC8_ERR(node)        ((node)->stats.crc8_err_cnt++)
+#define M1_STATS_RX_NODE_CRC8_ERR(node)                                        \
+    M1_STATS_RX_NODE_ADD(node, crc8_err_cnt, 1)
 
 /**
  * \brief           Increment count of CRC16 checks successfully passed.
  * \param[in]       node: Pointer to the node object.
  */
-#define M1_STATS_RX_NODE_CRC16_OK(node)        ((node)->stats.crc16_ok_cnt++)
+#define M1_STATS_RX_NODE_CRC16_OK(node)                                        \
+    M1_STATS_RX_NODE_ADD(node, crc16_ok_cnt, 1)
 
 /**
  * \brief           Increment count of CRC16 check failures.
  * \param[in]       node: Pointer to the node object.
  */
-#define M1_STATS_RX_NODE_CRC16_ERR(node)       ((node)->stats.crc16_err_cnt++)
+#define M1_STATS_RX_NODE_CRC16_ERR(node)                                       \
+    M1_STATS_RX_NODE_ADD(node, crc16_err_cnt, 1)
 
 /**
  * \brief           Increment count of length overflows detected.
  * \param[in]       node: Pointer to the node object.
  */
-#define M1_STATS_RX_NODE_LEN_OVERFLOW(node)    ((node)->stats.len_overflow_cnt++)
+#define M1_STATS_RX_NODE_LEN_OVERFLOW(node)                                    \
+    M1_STATS_RX_NODE_ADD(node, len_overflow_cnt, 1)
+
+/**
+ * \brief           Increment count of valid frames dropped because the RX
+ *                  queue of the run loop was full.
+ * \param[in]       node: Pointer to the node object.
+ */
+#define M1_STATS_RX_NODE_QUEUE_FULL(node)                                      \
+    M1_STATS_RX_NODE_ADD(node, queue_full_cnt, 1)
+
+/**
+ * \brief           Increment count of valid frames dropped because no buffer
+ *                  was left to queue them in.
+ * \param[in]       node: Pointer to the node object.
+ */
+#define M1_STATS_RX_NODE_NO_SPACE(node)                                        \
+    M1_STATS_RX_NODE_ADD(node, no_space_cnt, 1)
+
+/**
+ * \brief           Add to one transmit counter of a route.
+ * \param[in]       m1: Pointer to the M1 protocol instance.
+ * \param[in]       route: Index of the route.
+ * \param[in]       field: Field of \ref m1_stats_tx_t.
+ * \param[in]       len: Amount to add.
+ */
+#define M1_STATS_TX_ADD(m1, route, field, len)                                 \
+    m1_counter_add((m1)->tx_stats,                                             \
+                   (size_t)(route) * M1_STATS_NUM(m1_stats_tx_t) +             \
+                       M1_STATS_INDEX(m1_stats_tx_t, field),                   \
+                   (len))
+
+/**
+ * \brief           Count a frame handed to a TX link.
+ * \param[in]       m1: Pointer to the M1 protocol instance.
+ * \param[in]       route: Index of the egress route.
+ * \param[in]       len: Length of the frame in bytes.
+ */
+#define M1_STATS_TX_FRAME(m1, route, len)                                      \
+    (M1_STATS_TX_ADD(m1, route, frame_cnt, 1),                                 \
+     M1_STATS_TX_ADD(m1, route, bytes, len))
+
+/**
+ * \brief           Count a frame a TX link failed to send.
+ * \param[in]       m1: Pointer to the M1 protocol instance.
+ * \param[in]       route: Index of the egress route.
+ */
+#define M1_STATS_TX_ERR(m1, route) M1_STATS_TX_ADD(m1, route, tx_err_cnt, 1)
+
+/**
+ * \brief           Count a frame dropped because no TX buffer was left.
+ * \param[in]       m1: Pointer to the M1 protocol instance.
+ * \param[in]       route: Index of the egress route.
+ */
+#define M1_STATS_TX_NO_SPACE(m1, route)                                        \
+    M1_STATS_TX_ADD(m1, route, no_space_cnt, 1)
+
+/**
+ * \brief           Count a retransmission of a reliable packet.
+ * \param[in]       m1: Pointer to the M1 protocol instance.
+ * \param[in]       route: Index of the egress route.
+ */
+#define M1_STATS_TX_RETRANSMIT(m1, route)                                      \
+    M1_STATS_TX_ADD(m1, route, retransmit_cnt, 1)
+
+/**
+ * \brief           Count a reliable packet given up after its last retry.
+ * \param[in]       m1: Pointer to the M1 protocol instance.
+ * \param[in]       route: Index of the egress route.
+ */
+#define M1_STATS_TX_RETRY_EXHAUSTED(m1, route)                                 \
+    M1_STATS_TX_ADD(m1, route, retry_exhausted_cnt, 1)
+
+/**
+ * \brief           Count an ACK that matched a waiting packet.
+ * \param[in]       m1: Pointer to the M1 protocol instance.
+ * \param[in]       route: Index of the route to the ACK's source.
+ */
+#define M1_STATS_TX_ACK(m1, route) M1_STATS_TX_ADD(m1, route, ack_cnt, 1)
+
+/**
+ * \brief           Count an ACK that matched no waiting packet.
+ * \param[in]       m1: Pointer to the M1 protocol instance.
+ * \param[in]       route: Index of the route to the ACK's source.
+ */
+#define M1_STATS_TX_ACK_UNMATCHED(m1, route)                                   \
+    M1_STATS_TX_ADD(m1, route, ack_unmatched_cnt, 1)
+
+/**
+ * \brief           Count a frame forwarded to another node.
+ * \param[in]       m1: Pointer to the M1 protocol instance.
+ * \param[in]       route: Index of the egress route.
+ * \param[in]       len: Length of the frame in bytes.
+ */
+#define M1_STATS_TX_FORWARD(m1, route, len)                                    \
+    (M1_STATS_TX_ADD(m1, route, forward_cnt, 1),                               \
+     M1_STATS_TX_ADD(m1, route, forward_bytes, len))
+
+/**
+ * \brief           Count a frame a TX link failed to forward.
+ * \param[in]       m1: Pointer to the M1 protocol instance.
+ * \param[in]       route: Index of the egress route.
+ */
+#define M1_STATS_TX_FORWARD_ERR(m1, route)                                     \
+    M1_STATS_TX_ADD(m1, route, forward_err_cnt, 1)
+
+/**
+ * \brief           Count an event of \ref m1_stats_net_t that no route can
+ *                  be charged with.
+ * \param[in]       m1: Pointer to the M1 protocol instance.
+ * \param[in]       field: Counter of \ref m1_stats_net_t.
+ */
+#define M1_STATS_NET(m1, field)                                                \
+    m1_counter_add((m1)->net_stats, M1_STATS_INDEX(m1_stats_net_t, field), 1)
 
 /* public typedef struct ---------------------------------------------------- */
 /**
  * \brief           Structure to store statistics for parsing M1 protocol
  * frames.
+ *
+ * Statistics structures are made of `u64` fields only: the counters live in
+ * an \ref m1_counter_t laid out in field order, and a snapshot is read
+ * straight into the structure.
  */
 typedef struct m1_stats_rx_parse {
-    u32 total_bytes;     /*!< Total bytes processed. */
-    u32 not_frame_bytes; /*!< Bytes not part of valid frames. */
-    u32 sof_ok_cnt; /*!< Count of successfully detected Start-of-Frame (SOF). */
-    u32 crc8_ok_cnt;      /*!< Count of successfully passed CRC8 checks. */
-    u32 crc8_err_cnt;     /*!< Count of CRC8 check failures. */
-    u32 crc16_ok_cnt;     /*!< Count of successfully passed CRC16 checks. */
-    u32 crc16_err_cnt;    /*!< Count of CRC16 check failures. */
-    u32 len_overflow_cnt; /*!< Count of length overflows. */
+    u64 total_bytes;     /*!< Total bytes processed. */
+    u64 not_frame_bytes; /*!< Bytes not part of valid frames. */
+    u64 sof_ok_cnt; /*!< Count of successfully detected Start-of-Frame (SOF). */
+    u64 crc8_ok_cnt;      /*!< Count of successfully passed CRC8 checks. */
+    u64 crc8_err_cnt;     /*!< Count of CRC8 check failures. */
+    u64 crc16_ok_cnt;     /*!< Count of successfully passed CRC16 checks. */
+    u64 crc16_err_cnt;    /*!< Count of CRC16 check failures. */
+    u64 len_overflow_cnt; /*!< Count of length overflows. */
+    u64 queue_full_cnt;   /*!< Count of frames dropped on a full RX queue. */
+    u64 no_space_cnt;     /*!< Count of frames dropped without a buffer. */
 } m1_stats_rx_parse_t;
 
+/**
+ * \brief           Transmit statistics of one route.
+ *
+ * Frames are charged to the route they leave on; ACKs to the route leading
+ * back to their source.
+ */
+typedef struct m1_stats_tx {
+    u64 frame_cnt;           /*!< Frames handed to the TX link. */
+    u64 bytes;               /*!< Bytes of those frames, headers included. */
+    u64 tx_err_cnt;          /*!< Frames the TX link failed to send. */
+    u64 no_space_cnt;        /*!< Frames dropped on TX pool exhaustion. */
+    u64 retransmit_cnt;      /*!< Retransmissions of reliable packets. */
+    u64 retry_exhausted_cnt; /*!< Reliable packets given up unacknowledged. */
+    u64 ack_cnt;             /*!< ACKs that matched a waiting packet. */
+    u64 ack_unmatched_cnt;   /*!< ACKs that matched no waiting packet. */
+    u64 forward_cnt;         /*!< Frames forwarded to another node. */
+    u64 forward_bytes;       /*!< Bytes of forwarded frames. */
+    u64 forward_err_cnt;     /*!< Frames the TX link failed to forward. */
+} m1_stats_tx_t;
+
+/**
+ * \brief           Network statistics of an instance that belong to no
+ *                  route.
+ */
+typedef struct m1_stats_net {
+    u64 tx_no_route_cnt;  /*!< Frames to send to a target without a route. */
+    u64 fwd_no_route_cnt; /*!< Received frames for another node that has no
+                             route, dropped. */
+    u64 ack_no_route_cnt; /*!< ACKs from a source without a route. */
+    u64 tx_drop_cnt;      /*!< Queued submissions the transport layer
+                             rejected, dropped. */
+    u64 rx_job_drop_cnt;  /*!< Received payloads dropped because no RX
+                             callback job could be allocated. */
+} m1_stats_net_t;
+
 /**
  * \}
  */
@@ -0,0 +1,162 @@
+/**
+ * \file            m1_trace.h
+ * \brief           Binary in-memory trace ring.
+ * \date            2026-10-18
+ */
+
+/*
+ * Copyright (c) 2024 Vector Qiu
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE
+ * AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * This file is part of the m1 protocol library.
+ *
+ * Author:          Vector Qiu <vetor.qiu@gmail.com>
+ * Version:         V0.0.1
+ */
+#ifndef __M1_TRACE_H__
+#define __M1_TRACE_H__
+
+/* includes ----------------------------------------------------------------- */
+#include "./m1_protocol/m1_typedef.h" /*!< General type definitions for the M1 protocol. */
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+/**
+ * \defgroup        m1_trace_manager
+ * \brief           Fixed-size binary event records, written lock-free from
+ *                  any thread and drained by one consumer.
+ * \{
+ */
+
+/* public typedefs ---------------------------------------------------------- */
+/**
+ * \brief           Events recorded by the protocol stack.
+ *
+ * Applications may record their own events from \ref M1_TRACE_USER up.
+ */
+typedef enum {
+    M1_TRACE_ACK_RX = 1,        /*!< ACK matched: source, ack_num. */
+    M1_TRACE_ACK_UNMATCHED,     /*!< ACK matched nothing: source, ack_num. */
+    M1_TRACE_RETRANSMIT,        /*!< Retransmission: target, seq_num, retries
+                                   left. */
+    M1_TRACE_RETRY_EXHAUSTED,   /*!< Packet given up: target, seq_num. */
+    M1_TRACE_TX_ERR,            /*!< TX link failed: target, seq_num, error. */
+    M1_TRACE_TX_NO_SPACE,       /*!< No TX buffer: target, payload length. */
+    M1_TRACE_TX_NO_ROUTE,       /*!< No route to send: target. */
+    M1_TRACE_FWD_NO_ROUTE,      /*!< No route to forward: source, target. */
+    M1_TRACE_RX_DROP,           /*!< Received frame dropped: source, target,
+                                   seq_num. */
+    M1_TRACE_TX_DROP,           /*!< Queued submission dropped: first
+                                   target, target count, error. */
+    M1_TRACE_USER = 0x8000,     /*!< First application event. */
+} m1_trace_event_e;
+
+/**
+ * \brief           One trace record.
+ */
+typedef struct m1_trace_record {
+    u64 stamp_us; /*!< \ref m1_event_now_us when recorded. */
+    u32 event;    /*!< \ref m1_trace_event_e. */
+    u32 arg[3];   /*!< Event arguments, unused ones are 0. */
+} m1_trace_record_t;
+
+/**
+ * \brief           Opaque trace ring handle.
+ *
+ * Recording never blocks and never calls into the C library beyond reading
+ * the clock: when the ring is full the record is dropped and counted.
+ */
+typedef struct m1_trace m1_trace_t;
+
+/* public functions --------------------------------------------------------- */
+/**
+ * \brief           Create a trace ring.
+ *
+ * \param[in]       capacity: Minimum number of records the ring holds,
+ *                  rounded up to the next power of two.
+ * \return          Pointer to the ring, or NULL on invalid capacity or
+ *                  allocation failure.
+ */
+m1_trace_t* m1_trace_create(size_t capacity);
+
+/**
+ * \brief           Destroy a trace ring.
+ *
+ * \param[in]       trace: Pointer to the ring, may be NULL.
+ */
+void m1_trace_destroy(m1_trace_t* trace);
+
+/**
+ * \brief           Record an event. Safe to call from any thread.
+ *
+ * \param[in]       trace: Pointer to the ring, may be NULL.
+ * \param[in]       event: Event ID, see \ref m1_trace_event_e.
+ * \param[in]       arg0: First argument.
+ * \param[in]       arg1: Second argument.
+ * \param[in]       arg2: Third argument.
+ */
+void m1_trace_record(m1_trace_t* trace, u32 event, u32 arg0, u32 arg1,
+                     u32 arg2);
+
+/**
+ * \brief           Take the oldest records off the ring. Must only be called
+ *                  by one thread at a time.
+ *
+ * \param[in]       trace: Pointer to the ring.
+ * \param[out]      record: Receives up to `record_num` records.
+ * \param[in]       record_num: Capacity of `record`.
+ * \return          Number of records taken.
+ */
+size_t m1_trace_drain(m1_trace_t* trace, m1_trace_record_t* record,
+                      size_t record_num);
+
+/**
+ * \brief           Get the number of records dropped on a full ring.
+ *
+ * \param[in]       trace: Pointer to the ring.
+ * \return          Number of dropped records.
+ */
+u64 m1_trace_dropped(const m1_trace_t* trace);
+
+/**
+ * \brief           Render a record as one line of text.
+ *
+ * \param[in]       record: Record to render.
+ * \param[out]      buf: Output buffer, always NUL-terminated if `len` > 0.
+ * \param[in]       len: Size of `buf`.
+ * \return          Length of the full line, as `snprintf` reports it.
+ */
+int m1_trace_format(const m1_trace_record_t* record, char* buf, size_t len);
+
+/**
+ * \}
+ */
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* __M1_TRACE_H__ */
+
+/* ----------------------------- end of file -------------------------------- */
@@ -53,15 +53,86 @@ extern "C" {
  */
 
 /* public config ------------------------------------------------------------ */
+/**
+ * \brief           Enable the pthread based helpers (RX reader threads and the
+ *                  callback worker pool). Defaults to on for POSIX hosts.
+ */
+#ifndef M1_USING_PTHREAD
+#if defined(__unix__) || defined(__APPLE__)
+#define M1_USING_PTHREAD 1
+#else
+#define M1_USING_PTHREAD 0
+#endif
+#endif /* M1_USING_PTHREAD */
+
+/**
+ * \brief           Enable the epoll based run loop
+ *                  (\ref m1_protocol_run_wait). Defaults to on for Linux.
+ */
+#ifndef M1_USING_EPOLL
+#if defined(__linux__)
+#define M1_USING_EPOLL 1
+#else
+#define M1_USING_EPOLL 0
+#endif
+#endif /* M1_USING_EPOLL */
 
 /* public define ------------------------------------------------------------ */
 #define m1_malloc malloc
 #define m1_free   free
 
+/**
+ * \brief           Log levels of \ref M1_LOG_LEVEL.
+ */
+#define M1_LOG_LEVEL_NONE    0 /*!< Nothing is logged. */
+#define M1_LOG_LEVEL_ERROR   1 /*!< `link_error`. */
+#define M1_LOG_LEVEL_WARNING 2 /*!< And `link_warning`. */
+#define M1_LOG_LEVEL_INFO    3 /*!< And `link_info`. */
+#define M1_LOG_LEVEL_DEBUG   4 /*!< And `link_debug` and `link_hex`. */
+
+/**
+ * \brief           Most verbose log level compiled in.
+ *
+ * Calls above it are removed by the compiler, arguments included, so per
+ * frame logging costs nothing unless asked for. Events that should stay
+ * visible in production go to the trace ring of the instance instead, see
+ * \ref M1_TRACE_SIZE.
+ */
+#ifndef M1_LOG_LEVEL
+#define M1_LOG_LEVEL M1_LOG_LEVEL_WARNING
+#endif /* M1_LOG_LEVEL */
+
+/**
+ * \brief           Output of every log call, `printf` unless overridden.
+ *
+ * Compiled out entirely when \ref M1_LOG_LEVEL is \ref M1_LOG_LEVEL_NONE.
+ */
+#ifndef link_raw
+#if M1_LOG_LEVEL > M1_LOG_LEVEL_NONE
 #include <stdio.h>
 #define link_raw(...) printf(__VA_ARGS__)
+#else
+#define link_raw(...)                                                          \
+    do {                                                                       \
+    } while (0)
+#endif /* M1_LOG_LEVEL > M1_LOG_LEVEL_NONE */
+#endif /* link_raw */
+
+/**
+ * \brief           Log through \ref link_raw if `level` is compiled in.
+ */
+#define link_log(level, ...)                                                   \
+    do {                                                                       \
+        if (M1_LOG_LEVEL >= (level)) {                                         \
+            link_raw(__VA_ARGS__);                                             \
+        }                                                                      \
+    } while (0)
+
 #define link_hex(name, width, buf, size)                                       \
     do {                                                                       \
+        if (M1_LOG_LEVEL < M1_LOG_LEVEL_DEBUG) {                               \
+            break;                                                             \
+        }                                                                      \
         link_raw("%s:\n", name);                                               \
         for (size_t i = 0; i < size; i++) {                                    \
             link_raw("%02X ", ((unsigned char*)buf)[i]);                       \
@@ -74,10 +145,10 @@ extern "C" {
         }                                                                      \
     } while (0)
 
-#define link_debug(...)   link_raw(__VA_ARGS__)
-#define link_info(...)    link_raw(__VA_ARGS__)
-#define link_warning(...) link_raw(__VA_ARGS__)
-#define link_error(...)   link_raw(__VA_ARGS__)
+#define link_debug(...)   link_log(M1_LOG_LEVEL_DEBUG, __VA_ARGS__)
+#define link_info(...)    link_log(M1_LOG_LEVEL_INFO, __VA_ARGS__)
+#define link_warning(...) link_log(M1_LOG_LEVEL_WARNING, __VA_ARGS__)
+#define link_error(...)   link_log(M1_LOG_LEVEL_ERROR, __VA_ARGS__)
 
 #ifndef U8_MAX
 
@@ -0,0 +1,110 @@
+/**
+ * \file            m1_work_pool.h
+ * \brief           Keyed work-stealing worker pool.
+ * \date            2026-10-18
+ */
+
+/*
+ * Copyright (c) 2024 Vector Qiu
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE
+ * AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * This file is part of the m1 protocol library.
+ *
+ * Author:          Vector Qiu <vetor.qiu@gmail.com>
+ * Version:         V0.0.1
+ */
+#ifndef __M1_WORK_POOL_H__
+#define __M1_WORK_POOL_H__
+
+/* includes ----------------------------------------------------------------- */
+#include "./m1_protocol/m1_typedef.h" /*!< General type definitions for the M1 protocol. */
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+/**
+ * \defgroup        m1_work_pool_manager
+ * \brief           Worker threads that run RX callbacks off the parser
+ *                  threads.
+ * \{
+ */
+
+/* public typedefs ---------------------------------------------------------- */
+/**
+ * \brief           One unit of work, embedded in the caller's job structure.
+ */
+typedef struct m1_work {
+    single_list_t node;                /*!< Link in the owning strand. */
+    void (*fn)(struct m1_work* work); /*!< Function run by a worker. */
+} m1_work_t;
+
+/**
+ * \brief           Opaque pool handle.
+ *
+ * Work is submitted under an 8-bit key (the source ID for RX callbacks).
+ * Work items sharing a key form a strand: they run one at a time in
+ * submission order, while different strands run in parallel. Every worker
+ * owns a deque of ready strands and idle workers steal strands from their
+ * peers, so one slow strand never holds back the others.
+ */
+typedef struct m1_work_pool m1_work_pool_t;
+
+/* public functions --------------------------------------------------------- */
+/**
+ * \brief           Create a pool and start its workers.
+ *
+ * \param[in]       worker_num: Number of worker threads, at least 1.
+ * \return          Pointer to the pool, or NULL on failure or when
+ *                  \ref M1_USING_PTHREAD is disabled.
+ */
+m1_work_pool_t* m1_work_pool_create(size_t worker_num);
+
+/**
+ * \brief           Run all submitted work, stop the workers and free the
+ *                  pool.
+ *
+ * \param[in]       pool: Pointer to the pool, may be NULL.
+ */
+void m1_work_pool_destroy(m1_work_pool_t* pool);
+
+/**
+ * \brief           Submit a work item. Safe to call from any thread.
+ *
+ * \param[in]       pool: Pointer to the pool.
+ * \param[in]       key: Ordering key, items with the same key never run
+ *                  concurrently and run in submission order.
+ * \param[in]       work: Work item, owned by the pool until `fn` is called.
+ */
+void m1_work_pool_submit(m1_work_pool_t* pool, u8 key, m1_work_t* work);
+
+/**
+ * \}
+ */
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* __M1_WORK_POOL_H__ */
+
+/* ----------------------------- end of file -------------------------------- */
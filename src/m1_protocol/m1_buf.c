@@ -0,0 +1,131 @@
+/**
+ * \file            m1_buf.c
+ * \brief           Reference-counted byte buffers shared between owners.
+ * \date            2026-10-18
+ */
+
+/*
+ * Copyright (c) 2024 Vector Qiu
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE
+ * AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * This file is part of the m1 protocol library.
+ *
+ * Author:          Vector Qiu <vetor.qiu@gmail.com>
+ * Version:         V0.0.1
+ */
+
+/* includes ----------------------------------------------------------------- */
+#include "./m1_protocol/m1_buf.h"
+
+#include <stdatomic.h>
+
+/* private typedefs --------------------------------------------------------- */
+/**
+ * \brief           Buffer state, followed by the bytes in the same
+ *                  allocation.
+ */
+struct m1_buf {
+    atomic_size_t ref; /*!< Number of holders. */
+    size_t len;        /*!< Size of `data`. */
+    _Alignas(max_align_t) u8 data[]; /*!< Buffer bytes. */
+};
+
+/* public functions --------------------------------------------------------- */
+/**
+ * \brief           Allocate a buffer holding one reference.
+ *
+ * \param[in]       len: Size of the buffer in bytes, may be 0.
+ * \return          Pointer to the buffer, or NULL on allocation failure.
+ */
+m1_buf_t* m1_buf_alloc(size_t len) {
+    if (len > SIZE_MAX - sizeof(m1_buf_t)) {
+        return NULL;
+    }
+
+    m1_buf_t* buf = m1_malloc(sizeof(m1_buf_t) + len);
+    if (!buf) {
+        return NULL;
+    }
+    atomic_init(&buf->ref, 1);
+    buf->len = len;
+    return buf;
+}
+
+/**
+ * \brief           Take a reference to a buffer.
+ *
+ * \param[in]       buf: Pointer to the buffer, may be NULL.
+ * \return          `buf`.
+ */
+m1_buf_t* m1_buf_ref(m1_buf_t* buf) {
+    if (buf) {
+        /*! The caller already holds a reference, nothing to order against */
+        atomic_fetch_add_explicit(&buf->ref, 1, memory_order_relaxed);
+    }
+    return buf;
+}
+
+/**
+ * \brief           Drop a reference to a buffer, freeing it with the last
+ *                  one.
+ *
+ * \param[in]       buf: Pointer to the buffer, may be NULL.
+ */
+void m1_buf_unref(m1_buf_t* buf) {
+    if (!buf) {
+        return;
+    }
+    /*! Release our writes to the bytes; the last holder acquires all of
+        them before freeing */
+    if (atomic_fetch_sub_explicit(&buf->ref, 1, memory_order_acq_rel) == 1) {
+        m1_free(buf);
+    }
+}
+
+/**
+ * \brief           Get the bytes of a buffer.
+ *
+ * \param[in]       buf: Pointer to the buffer.
+ * \return          Start of the buffer.
+ */
+u8* m1_buf_data(m1_buf_t* buf) { return buf->data; }
+
+/**
+ * \brief           Get the size of a buffer.
+ *
+ * \param[in]       buf: Pointer to the buffer.
+ * \return          Size given to \ref m1_buf_alloc.
+ */
+size_t m1_buf_len(const m1_buf_t* buf) { return buf->len; }
+
+/**
+ * \brief           Get the number of references held on a buffer.
+ *
+ * \param[in]       buf: Pointer to the buffer.
+ * \return          Reference count, only exact while no other thread holds
+ *                  the buffer.
+ */
+size_t m1_buf_refcnt(const m1_buf_t* buf) {
+    return atomic_load_explicit(&((m1_buf_t*)buf)->ref, memory_order_relaxed);
+}
+
+/* ----------------------------- end of file -------------------------------- */
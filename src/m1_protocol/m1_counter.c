@@ -0,0 +1,194 @@
+/**
+ * \file            m1_counter.c
+ * \brief           Sharded 64-bit event counters.
+ * \date            2026-10-18
+ */
+
+/*
+ * Copyright (c) 2024 Vector Qiu
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE
+ * AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * This file is part of the m1 protocol library.
+ *
+ * Author:          Vector Qiu <vetor.qiu@gmail.com>
+ * Version:         V0.0.1
+ */
+
+/* includes ----------------------------------------------------------------- */
+#include "./m1_protocol/m1_counter.h"
+
+#include <stdatomic.h>
+#include <stdint.h>
+#include <string.h>
+#include "./m1_protocol/m1_protocol_def.h"
+
+/* private typedefs --------------------------------------------------------- */
+/**
+ * \brief           Counter set state.
+ *
+ * Shard `s` holds counter `i` at `value[s * stride + i]`; `stride` is
+ * rounded up to whole cache lines.
+ */
+struct m1_counter {
+    size_t counter_num;           /*!< Number of counters per shard. */
+    size_t stride;                /*!< Distance between two shards. */
+    atomic_uint_least64_t* value; /*!< Cache line aligned shard array. */
+    void* alloc_base;             /*!< Address returned by the allocator. */
+};
+
+/* private variables -------------------------------------------------------- */
+#if M1_USING_PTHREAD
+static atomic_size_t shard_next; /*!< Shard handed to the next new thread. */
+static _Thread_local size_t shard_self; /*!< Shard of this thread plus one,
+                                           0 before its first count. */
+#endif /* M1_USING_PTHREAD */
+
+/* private functions -------------------------------------------------------- */
+/**
+ * \brief           Get the shard of the calling thread.
+ *
+ * \return          Shard index below \ref M1_STATS_SHARD_NUM.
+ */
+static size_t m1_counter_shard(void) {
+#if M1_USING_PTHREAD
+    if (!shard_self) {
+        size_t shard =
+            atomic_fetch_add_explicit(&shard_next, 1, memory_order_relaxed);
+        shard_self = shard % M1_STATS_SHARD_NUM + 1;
+    }
+    return shard_self - 1;
+#else
+    return 0;
+#endif /* M1_USING_PTHREAD */
+}
+
+/* public functions --------------------------------------------------------- */
+/**
+ * \brief           Create a zeroed counter set.
+ *
+ * \param[in]       counter_num: Number of counters in the set.
+ * \return          Pointer to the set, or NULL on invalid size or allocation
+ *                  failure.
+ */
+m1_counter_t* m1_counter_create(size_t counter_num) {
+    const size_t line = M1_CACHE_LINE_SIZE / sizeof(atomic_uint_least64_t);
+    if (counter_num == 0 ||
+        counter_num > SIZE_MAX / M1_STATS_SHARD_NUM / sizeof(u64) - line) {
+        return NULL;
+    }
+
+    size_t stride = (counter_num + line - 1) / line * line;
+    size_t size = sizeof(atomic_uint_least64_t) * stride * M1_STATS_SHARD_NUM;
+    m1_counter_t* counter = m1_malloc(sizeof(m1_counter_t));
+    if (!counter) {
+        return NULL;
+    }
+    void* base = m1_malloc(size + M1_CACHE_LINE_SIZE - 1);
+    if (!base) {
+        m1_free(counter);
+        return NULL;
+    }
+    uintptr_t addr = ((uintptr_t)base + M1_CACHE_LINE_SIZE - 1) &
+                     ~(uintptr_t)(M1_CACHE_LINE_SIZE - 1);
+
+    counter->counter_num = counter_num;
+    counter->stride = stride;
+    counter->value = (atomic_uint_least64_t*)addr;
+    counter->alloc_base = base;
+    for (size_t i = 0; i < stride * M1_STATS_SHARD_NUM; i++) {
+        atomic_init(&counter->value[i], 0);
+    }
+    return counter;
+}
+
+/**
+ * \brief           Destroy a counter set.
+ *
+ * \param[in]       counter: Pointer to the set, may be NULL.
+ */
+void m1_counter_destroy(m1_counter_t* counter) {
+    if (!counter) {
+        return;
+    }
+    m1_free(counter->alloc_base);
+    m1_free(counter);
+}
+
+/**
+ * \brief           Add to a counter. Safe to call from any thread.
+ *
+ * \param[in]       counter: Pointer to the set, may be NULL.
+ * \param[in]       index: Index of the counter, out of range is ignored.
+ * \param[in]       value: Amount to add.
+ */
+void m1_counter_add(m1_counter_t* counter, size_t index, u64 value) {
+    if (!counter || index >= counter->counter_num) {
+        return;
+    }
+    size_t shard = m1_counter_shard();
+    atomic_fetch_add_explicit(&counter->value[shard * counter->stride + index],
+                              value, memory_order_relaxed);
+}
+
+/**
+ * \brief           Read a counter, summed over all shards.
+ *
+ * \param[in]       counter: Pointer to the set.
+ * \param[in]       index: Index of the counter.
+ * \return          The counter, or 0 on invalid arguments.
+ */
+u64 m1_counter_read(const m1_counter_t* counter, size_t index) {
+    if (!counter || index >= counter->counter_num) {
+        return 0;
+    }
+    u64 sum = 0;
+    for (size_t shard = 0; shard < M1_STATS_SHARD_NUM; shard++) {
+        sum += atomic_load_explicit(
+            &counter->value[shard * counter->stride + index],
+            memory_order_relaxed);
+    }
+    return sum;
+}
+
+/**
+ * \brief           Read a run of counters, summed over all shards.
+ *
+ * \param[in]       counter: Pointer to the set.
+ * \param[in]       first: Index of the first counter.
+ * \param[out]      value: Receives `num` counters.
+ * \param[in]       num: Number of counters to read.
+ * \return          `E_STATE_OK` on success, or `E_STATE_INVAL` on invalid
+ *                  arguments.
+ */
+etype_e m1_counter_snapshot(const m1_counter_t* counter, size_t first,
+                            u64* value, size_t num) {
+    if (!counter || !value || first > counter->counter_num ||
+        num > counter->counter_num - first) {
+        return E_STATE_INVAL;
+    }
+    for (size_t i = 0; i < num; i++) {
+        value[i] = m1_counter_read(counter, first + i);
+    }
+    return E_STATE_OK;
+}
+
+/* ----------------------------- end of file -------------------------------- */
@@ -0,0 +1,460 @@
+/**
+ * \file            m1_event.c
+ * \brief           Event loop backend of the M1 protocol.
+ * \date            2026-10-18
+ */
+
+/*
+ * Copyright (c) 2024 Vector Qiu
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE
+ * AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * This file is part of the m1 protocol library.
+ *
+ * Author:          Vector Qiu <vetor.qiu@gmail.com>
+ * Version:         V0.0.1
+ */
+
+/* includes ----------------------------------------------------------------- */
+#include "./m1_protocol/m1_event.h"
+
+#include <time.h>
+#if M1_USING_EPOLL
+#include <errno.h>
+#include <stdatomic.h>
+#include <string.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+#endif /* M1_USING_EPOLL */
+#include "./m1_protocol/m1_layer_datalink.h"
+
+#if M1_USING_EPOLL
+/* private typedefs --------------------------------------------------------- */
+/**
+ * \brief           Deadline source registered by \ref m1_event_add_timeout.
+ */
+typedef struct m1_event_timeout {
+    m1_event_timeout_fn fn; /*!< Time left, NULL if the slot is free. */
+    void* user_data;        /*!< Owner passed to `fn`. */
+} m1_event_timeout_t;
+
+/**
+ * \brief           Event state of one protocol instance.
+ */
+struct m1_event {
+    int epoll_fd;           /*!< Wait set. */
+    int wake_fd;            /*!< eventfd signalled by \ref m1_event_wake. */
+    atomic_bool wake_armed; /*!< Set once `wake_fd` has been signalled and not
+                               yet consumed by the waiter. */
+    bool links_watched;     /*!< RX link descriptors are in the wait set. */
+    m1_event_timeout_t
+        timeout[M1_EVENT_TIMEOUT_NUM]; /*!< Deadlines of outside owners. */
+};
+
+/* private function prototypes ---------------------------------------------- */
+static int m1_event_link_fd(m1_rx_parse_node_t* node);
+static i32 m1_event_poll_timeout(m1_t* m1, i32 timeout_ms);
+static void m1_event_read_link(m1_t* m1, m1_rx_parse_node_t* node);
+
+/* public functions --------------------------------------------------------- */
+/**
+ * \brief           Create the event state of an instance.
+ *
+ * \param[in]       m1: Pointer to the M1 protocol instance.
+ * \return          `E_STATE_OK` on success, `E_STATE_NO_SPACE` on allocation
+ *                  failure, or `E_STATE_ERROR` if the wait set could not be
+ *                  created.
+ */
+etype_e m1_event_init(m1_t* m1) {
+    struct m1_event* event = m1_malloc(sizeof(struct m1_event));
+    if (!event) {
+        return E_STATE_NO_SPACE;
+    }
+    event->epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+    event->wake_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    atomic_init(&event->wake_armed, false);
+    event->links_watched = false;
+    memset(event->timeout, 0, sizeof(event->timeout));
+    m1->event = event;
+    if (event->epoll_fd < 0 || event->wake_fd < 0) {
+        return E_STATE_ERROR;
+    }
+
+    struct epoll_event ev = {.events = EPOLLIN, .data.ptr = NULL};
+    if (epoll_ctl(event->epoll_fd, EPOLL_CTL_ADD, event->wake_fd, &ev)) {
+        return E_STATE_ERROR;
+    }
+    m1_event_watch_links(m1, true);
+    return E_STATE_OK;
+}
+
+/**
+ * \brief           Release the event state of an instance.
+ *
+ * \param[in]       m1: Pointer to the M1 protocol instance.
+ */
+void m1_event_deinit(m1_t* m1) {
+    struct m1_event* event = m1->event;
+    if (!event) {
+        return;
+    }
+    if (event->epoll_fd >= 0) {
+        close(event->epoll_fd);
+    }
+    if (event->wake_fd >= 0) {
+        close(event->wake_fd);
+    }
+    m1_free(event);
+    m1->event = NULL;
+}
+
+/**
+ * \brief           Wake a thread blocked in \ref m1_event_wait.
+ *
+ * \param[in]       m1: Pointer to the M1 protocol instance.
+ */
+void m1_event_wake(m1_t* m1) {
+    struct m1_event* event = m1->event;
+    if (!event || atomic_exchange(&event->wake_armed, true)) {
+        return;
+    }
+    u64 one = 1;
+    ssize_t ret = write(event->wake_fd, &one, sizeof(one));
+    (void)ret; /*!< Counter overflow still leaves the descriptor readable */
+}
+
+/**
+ * \brief           Add or remove the RX link descriptors from the wait set.
+ *
+ * A descriptor the wait set refuses, e.g. a regular file, leaves its link
+ * polled like a link without one.
+ *
+ * \param[in]       m1: Pointer to the M1 protocol instance.
+ * \param[in]       watch: true to wait on the links, false to ignore them.
+ */
+void m1_event_watch_links(m1_t* m1, bool watch) {
+    struct m1_event* event = m1->event;
+    if (!event || event->links_watched == watch) {
+        return;
+    }
+
+    single_list_t* rx_parse_node = m1->rx_parse_head.next;
+    for (; rx_parse_node; rx_parse_node = rx_parse_node->next) {
+        m1_rx_parse_node_t* node =
+            single_list_entry(rx_parse_node, m1_rx_parse_node_t, node);
+        int fd = m1_event_link_fd(node);
+        struct epoll_event ev = {.events = EPOLLIN, .data.ptr = node};
+        if (watch) {
+            node->fd_watched =
+                fd >= 0 && !epoll_ctl(event->epoll_fd, EPOLL_CTL_ADD, fd, &ev);
+        } else if (node->fd_watched) {
+            epoll_ctl(event->epoll_fd, EPOLL_CTL_DEL, fd, &ev);
+            node->fd_watched = false;
+        }
+    }
+    event->links_watched = watch;
+}
+
+/**
+ * \brief           Wake \ref m1_event_wait when a descriptor the instance
+ *                  does not own is ready.
+ *
+ * Such descriptors carry the event state itself as their tag, which no RX
+ * link can have.
+ *
+ * \param[in]       m1: Pointer to the M1 protocol instance.
+ * \param[in]       fd: Descriptor to watch.
+ * \param[in]       events: \ref M1_EVENT_READ and/or \ref M1_EVENT_WRITE, 0
+ *                  to stop watching `fd`.
+ * \return          `E_STATE_OK` on success, or `E_STATE_ERROR` if the wait
+ *                  set refused `fd`.
+ */
+etype_e m1_event_watch_fd(m1_t* m1, int fd, u32 events) {
+    struct m1_event* event = m1 ? m1->event : NULL;
+    if (!event || fd < 0) {
+        return E_STATE_ERROR;
+    }
+
+    struct epoll_event ev = {.events = 0, .data.ptr = event};
+    if (!events) {
+        return epoll_ctl(event->epoll_fd, EPOLL_CTL_DEL, fd, &ev)
+                   ? E_STATE_ERROR
+                   : E_STATE_OK;
+    }
+    ev.events = ((events & M1_EVENT_READ) ? EPOLLIN : 0) |
+                ((events & M1_EVENT_WRITE) ? EPOLLOUT : 0);
+    if (!epoll_ctl(event->epoll_fd, EPOLL_CTL_MOD, fd, &ev) ||
+        (errno == ENOENT &&
+         !epoll_ctl(event->epoll_fd, EPOLL_CTL_ADD, fd, &ev))) {
+        return E_STATE_OK;
+    }
+    return E_STATE_ERROR;
+}
+
+/**
+ * \brief           Cut the waits short to the next deadline of an outside
+ *                  descriptor owner.
+ *
+ * \param[in]       m1: Pointer to the M1 protocol instance.
+ * \param[in]       fn: Returns the time left until the owner's deadline.
+ * \param[in]       user_data: Owner passed to `fn`.
+ * \return          `E_STATE_OK` on success, `E_STATE_INVAL` without `fn`,
+ *                  or `E_STATE_NO_SPACE` if every slot is taken.
+ */
+etype_e m1_event_add_timeout(m1_t* m1, m1_event_timeout_fn fn,
+                             void* user_data) {
+    struct m1_event* event = m1 ? m1->event : NULL;
+    if (!event || !fn) {
+        return E_STATE_INVAL;
+    }
+    for (size_t i = 0; i < M1_EVENT_TIMEOUT_NUM; i++) {
+        if (!event->timeout[i].fn) {
+            event->timeout[i].fn = fn;
+            event->timeout[i].user_data = user_data;
+            return E_STATE_OK;
+        }
+    }
+    return E_STATE_NO_SPACE;
+}
+
+/**
+ * \brief           Unregister an owner added by \ref m1_event_add_timeout.
+ *
+ * \param[in]       m1: Pointer to the M1 protocol instance.
+ * \param[in]       user_data: Owner to remove.
+ */
+void m1_event_remove_timeout(m1_t* m1, void* user_data) {
+    struct m1_event* event = m1 ? m1->event : NULL;
+    for (size_t i = 0; event && i < M1_EVENT_TIMEOUT_NUM; i++) {
+        if (event->timeout[i].fn && event->timeout[i].user_data == user_data) {
+            event->timeout[i].fn = NULL;
+            event->timeout[i].user_data = NULL;
+        }
+    }
+}
+
+/**
+ * \brief           Wait for link data or a wakeup, then read the ready
+ *                  links.
+ *
+ * \param[in]       m1: Pointer to the M1 protocol instance.
+ * \param[in]       timeout_ms: Maximum wait in milliseconds, -1 to wait
+ *                  forever.
+ * \return          `E_STATE_OK` on success, or `E_STATE_ERROR` if the wait
+ *                  failed.
+ */
+etype_e m1_event_wait(m1_t* m1, i32 timeout_ms) {
+    struct m1_event* event = m1->event;
+    if (!event) {
+        return E_STATE_ERROR;
+    }
+
+    timeout_ms = m1_event_poll_timeout(m1, timeout_ms);
+    struct epoll_event ev[M1_EVENT_BATCH_SIZE];
+    int ready = epoll_wait(event->epoll_fd, ev, M1_EVENT_BATCH_SIZE,
+                           timeout_ms);
+    if (ready < 0) {
+        if (errno != EINTR) {
+            return E_STATE_ERROR;
+        }
+        ready = 0;
+    }
+
+    /*! Disarm before the caller drains its queues, so a submission racing
+        with the drain signals the descriptor again */
+    if (atomic_exchange(&event->wake_armed, false)) {
+        u64 cnt;
+        ssize_t ret = read(event->wake_fd, &cnt, sizeof(cnt));
+        (void)ret;
+    }
+
+    for (int i = 0; i < ready; i++) {
+        /*! The wakeup descriptor and outside descriptors only end the wait */
+        if (ev[i].data.ptr && ev[i].data.ptr != event &&
+            event->links_watched) {
+            m1_event_read_link(m1, ev[i].data.ptr);
+        }
+    }
+
+    if (event->links_watched) {
+        single_list_t* rx_parse_node = m1->rx_parse_head.next;
+        for (; rx_parse_node; rx_parse_node = rx_parse_node->next) {
+            m1_rx_parse_node_t* node =
+                single_list_entry(rx_parse_node, m1_rx_parse_node_t, node);
+            if (!node->fd_watched) {
+                m1_datalink_read(m1, node);
+            }
+        }
+    }
+    return E_STATE_OK;
+}
+
+/* private functions -------------------------------------------------------- */
+/**
+ * \brief           Get the descriptor of an RX link.
+ *
+ * \param[in]       node: The receive parsing node of the link.
+ * \return          The descriptor, or -1 if the driver has none.
+ */
+static int m1_event_link_fd(m1_rx_parse_node_t* node) {
+    rx_async_t* rx = node->item.rx;
+    return rx->get_fd ? rx->get_fd(rx->user_data) : -1;
+}
+
+/**
+ * \brief           Bound a wait to the deadlines of outside owners and the
+ *                  read period of the polled links.
+ *
+ * \param[in]       m1: Pointer to the M1 protocol instance.
+ * \param[in]       timeout_ms: Requested wait in milliseconds, -1 for none.
+ * \return          The wait to use.
+ */
+static i32 m1_event_poll_timeout(m1_t* m1, i32 timeout_ms) {
+    struct m1_event* event = m1->event;
+    for (size_t i = 0; i < M1_EVENT_TIMEOUT_NUM; i++) {
+        if (!event->timeout[i].fn) {
+            continue;
+        }
+        i32 left_ms = event->timeout[i].fn(event->timeout[i].user_data);
+        if (left_ms >= 0 && (timeout_ms < 0 || left_ms < timeout_ms)) {
+            timeout_ms = left_ms;
+        }
+    }
+    if (!event->links_watched) {
+        return timeout_ms;
+    }
+
+    single_list_t* rx_parse_node = m1->rx_parse_head.next;
+    for (; rx_parse_node; rx_parse_node = rx_parse_node->next) {
+        m1_rx_parse_node_t* node =
+            single_list_entry(rx_parse_node, m1_rx_parse_node_t, node);
+        if (node->fd_watched) {
+            continue;
+        }
+        u16 read_freq = node->item.read_freq;
+        i32 period_ms = read_freq ? 1000 / read_freq : 1;
+        /*! Above 1 kHz the period rounds to 0, which would busy-poll */
+        if (period_ms < 1) {
+            period_ms = 1;
+        }
+        if (timeout_ms < 0 || period_ms < timeout_ms) {
+            timeout_ms = period_ms;
+        }
+    }
+    return timeout_ms;
+}
+
+/**
+ * \brief           Read a readable link until it runs dry.
+ *
+ * On a byte stream a short read means the driver has nothing more buffered.
+ * Datagram links return whole frames and rarely fill the buffer, so they are
+ * read until empty. The number of reads is bounded by
+ * \ref M1_EVENT_READ_BUDGET so that one busy link cannot starve the others;
+ * the wait set is level triggered and reports the link again on the next
+ * pass.
+ *
+ * \param[in]       m1: Pointer to the M1 protocol instance.
+ * \param[in]       node: The receive parsing node of the link.
+ */
+static void m1_event_read_link(m1_t* m1, m1_rx_parse_node_t* node) {
+    size_t full = node->item.rx_buf_len;
+    if (node->item.rx->ring) {
+        /*! One read drains everything the driver had published */
+        full = SIZE_MAX;
+    }
+    if (M1_LINK_TYPE_IS_DGRAM(node->item.link_type)) {
+        full = 1;
+    }
+    for (size_t i = 0; i < M1_EVENT_READ_BUDGET; i++) {
+        if (m1_datalink_read(m1, node) < full) {
+            break;
+        }
+    }
+}
+
+#else
+etype_e m1_event_init(m1_t* m1) {
+    m1->event = NULL;
+    return E_STATE_OK;
+}
+
+void m1_event_deinit(m1_t* m1) { (void)m1; }
+
+void m1_event_wake(m1_t* m1) { (void)m1; }
+
+void m1_event_watch_links(m1_t* m1, bool watch) {
+    (void)m1;
+    (void)watch;
+}
+
+etype_e m1_event_watch_fd(m1_t* m1, int fd, u32 events) {
+    (void)m1;
+    (void)fd;
+    (void)events;
+    return E_STATE_NOT_IMPLEMENT;
+}
+
+etype_e m1_event_add_timeout(m1_t* m1, m1_event_timeout_fn fn,
+                             void* user_data) {
+    (void)m1;
+    (void)fn;
+    (void)user_data;
+    return E_STATE_NOT_IMPLEMENT;
+}
+
+void m1_event_remove_timeout(m1_t* m1, void* user_data) {
+    (void)m1;
+    (void)user_data;
+}
+
+etype_e m1_event_wait(m1_t* m1, i32 timeout_ms) {
+    (void)m1;
+    (void)timeout_ms;
+    return E_STATE_NOT_IMPLEMENT;
+}
+#endif /* M1_USING_EPOLL */
+
+/**
+ * \brief           Get a monotonic timestamp.
+ *
+ * \return          Milliseconds since an unspecified starting point.
+ */
+u64 m1_event_now_ms(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (u64)ts.tv_sec * 1000u + (u64)ts.tv_nsec / 1000000u;
+}
+
+/**
+ * \brief           Get a monotonic timestamp with microsecond resolution.
+ *
+ * \return          Microseconds since the same starting point as
+ *                  \ref m1_event_now_ms.
+ */
+u64 m1_event_now_us(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (u64)ts.tv_sec * 1000000u + (u64)ts.tv_nsec / 1000u;
+}
+
+/* ----------------------------- end of file -------------------------------- */
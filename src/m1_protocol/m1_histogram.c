@@ -0,0 +1,163 @@
+/**
+ * \file            m1_histogram.c
+ * \brief           Log-linear latency histograms.
+ * \date            2026-10-18
+ */
+
+/*
+ * Copyright (c) 2024 Vector Qiu
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE
+ * AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * This file is part of the m1 protocol library.
+ *
+ * Author:          Vector Qiu <vetor.qiu@gmail.com>
+ * Version:         V0.0.1
+ */
+
+/* includes ----------------------------------------------------------------- */
+#include "./m1_protocol/m1_histogram.h"
+
+#include <string.h>
+
+/* private define ----------------------------------------------------------- */
+/*! Number of buckets per power of two */
+#define SUB_NUM ((u64)1 << M1_HISTOGRAM_SUB_BITS)
+
+/* public functions --------------------------------------------------------- */
+/**
+ * \brief           Empty a histogram.
+ *
+ * \param[out]      hist: Pointer to the histogram.
+ */
+void m1_histogram_reset(m1_histogram_t* hist) {
+    memset(hist, 0, sizeof(m1_histogram_t));
+    hist->min = UINT64_MAX;
+}
+
+/**
+ * \brief           Count one value.
+ *
+ * \param[in,out]   hist: Pointer to the histogram.
+ * \param[in]       value: Value to count.
+ */
+void m1_histogram_record(m1_histogram_t* hist, u64 value) {
+    hist->bucket[m1_histogram_index(value)]++;
+    hist->count++;
+    hist->sum += value;
+    if (value < hist->min) {
+        hist->min = value;
+    }
+    if (value > hist->max) {
+        hist->max = value;
+    }
+}
+
+/**
+ * \brief           Get the bucket a value is counted in.
+ *
+ * The first 2^\ref M1_HISTOGRAM_SUB_BITS buckets hold one value each. After
+ * that every power of two is split into the same number of equal buckets.
+ *
+ * \param[in]       value: Value to look up.
+ * \return          Bucket index, below \ref M1_HISTOGRAM_BUCKET_NUM.
+ */
+size_t m1_histogram_index(u64 value) {
+    if (value < SUB_NUM) {
+        return (size_t)value;
+    }
+
+    u32 msb = 63 - __builtin_clzll((unsigned long long)value);
+    if (msb >= M1_HISTOGRAM_MAX_BITS) {
+        return M1_HISTOGRAM_BUCKET_NUM - 1;
+    }
+    u32 shift = msb - M1_HISTOGRAM_SUB_BITS;
+    return ((size_t)(shift + 1) << M1_HISTOGRAM_SUB_BITS) +
+           (size_t)((value >> shift) - SUB_NUM);
+}
+
+/**
+ * \brief           Get the smallest value counted in a bucket.
+ *
+ * \param[in]       index: Bucket index.
+ * \return          Lower bound of the bucket.
+ */
+u64 m1_histogram_bucket_min(size_t index) {
+    size_t group = index >> M1_HISTOGRAM_SUB_BITS;
+    u64 sub = index & (SUB_NUM - 1);
+    if (group == 0) {
+        return sub;
+    }
+    return (SUB_NUM + sub) << (group - 1);
+}
+
+/**
+ * \brief           Get the largest value counted in a bucket.
+ *
+ * \param[in]       index: Bucket index.
+ * \return          Upper bound of the bucket, UINT64_MAX for the last one.
+ */
+u64 m1_histogram_bucket_max(size_t index) {
+    if (index >= M1_HISTOGRAM_BUCKET_NUM - 1) {
+        return UINT64_MAX;
+    }
+    return m1_histogram_bucket_min(index + 1) - 1;
+}
+
+/**
+ * \brief           Get the value below which a share of the recorded values
+ *                  lie.
+ *
+ * \param[in]       hist: Pointer to the histogram.
+ * \param[in]       percentile: Share in percent, from 0 to 100.
+ * \return          Upper bound of the bucket holding that value, capped at
+ *                  the largest recorded value, or 0 if the histogram is
+ *                  empty.
+ */
+u64 m1_histogram_percentile(const m1_histogram_t* hist, double percentile) {
+    if (!hist->count) {
+        return 0;
+    }
+    if (percentile < 0) {
+        percentile = 0;
+    } else if (percentile > 100) {
+        percentile = 100;
+    }
+
+    /*! Rank of the value, counted from 1 and rounded up */
+    double exact = percentile / 100 * (double)hist->count;
+    u64 rank = (u64)exact;
+    if ((double)rank < exact || rank == 0) {
+        rank++;
+    }
+
+    u64 seen = 0;
+    for (size_t i = 0; i < M1_HISTOGRAM_BUCKET_NUM; i++) {
+        seen += hist->bucket[i];
+        if (seen >= rank) {
+            u64 value = m1_histogram_bucket_max(i);
+            return value < hist->max ? value : hist->max;
+        }
+    }
+    return hist->max;
+}
+
+/* ----------------------------- end of file -------------------------------- */
@@ -0,0 +1,187 @@
+/**
+ * \file            m1_latency.c
+ * \brief           Per-route latency histograms of a protocol instance.
+ * \date            2026-10-18
+ */
+
+/*
+ * Copyright (c) 2024 Vector Qiu
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE
+ * AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * This file is part of the m1 protocol library.
+ *
+ * Author:          Vector Qiu <vetor.qiu@gmail.com>
+ * Version:         V0.0.1
+ */
+
+/* includes ----------------------------------------------------------------- */
+#include "./m1_protocol/m1_latency.h"
+
+#include <stdatomic.h>
+
+/* private typedefs --------------------------------------------------------- */
+/**
+ * \brief           Histogram that several threads record into.
+ */
+typedef struct m1_latency_hist {
+    atomic_uint_least64_t sum; /*!< Sum of the recorded values. */
+    atomic_uint_least64_t min; /*!< Smallest recorded value. */
+    atomic_uint_least64_t max; /*!< Largest recorded value. */
+    atomic_uint_least64_t bucket[M1_HISTOGRAM_BUCKET_NUM]; /*!< Value counts
+                                                              per bucket. */
+} m1_latency_hist_t;
+
+/**
+ * \brief           Histograms of every route, route-major.
+ */
+struct m1_latency {
+    size_t route_num;                              /*!< Number of routes. */
+    m1_latency_hist_t hist[][M1_LATENCY_KIND_MAX]; /*!< Histograms. */
+};
+
+/* private function prototypes ---------------------------------------------- */
+static void m1_latency_hist_reset(m1_latency_hist_t* hist);
+
+/* public functions --------------------------------------------------------- */
+/**
+ * \brief           Create empty histograms for a number of routes.
+ *
+ * \param[in]       route_num: Number of routes.
+ * \return          Pointer to the histograms, or NULL on allocation failure.
+ */
+m1_latency_t* m1_latency_create(size_t route_num) {
+    m1_latency_t* latency =
+        m1_malloc(sizeof(m1_latency_t) + sizeof(latency->hist[0]) * route_num);
+    if (!latency) {
+        return NULL;
+    }
+    latency->route_num = route_num;
+    m1_latency_reset(latency);
+    return latency;
+}
+
+/**
+ * \brief           Destroy the histograms.
+ *
+ * \param[in]       latency: Pointer to the histograms, may be NULL.
+ */
+void m1_latency_destroy(m1_latency_t* latency) { m1_free(latency); }
+
+/**
+ * \brief           Count one latency.
+ *
+ * \param[in]       latency: Pointer to the histograms, may be NULL.
+ * \param[in]       route: Route index; out of range values are ignored.
+ * \param[in]       kind: Measured latency.
+ * \param[in]       value_us: Latency in microseconds.
+ */
+void m1_latency_record(m1_latency_t* latency, size_t route,
+                       m1_latency_kind_e kind, u64 value_us) {
+    if (!latency || route >= latency->route_num ||
+        kind >= M1_LATENCY_KIND_MAX) {
+        return;
+    }
+
+    m1_latency_hist_t* hist = &latency->hist[route][kind];
+    atomic_fetch_add_explicit(&hist->bucket[m1_histogram_index(value_us)], 1,
+                              memory_order_relaxed);
+    atomic_fetch_add_explicit(&hist->sum, value_us, memory_order_relaxed);
+
+    u64 min = atomic_load_explicit(&hist->min, memory_order_relaxed);
+    while (value_us < min &&
+           !atomic_compare_exchange_weak_explicit(&hist->min, &min, value_us,
+                                                  memory_order_relaxed,
+                                                  memory_order_relaxed)) {
+    }
+    u64 max = atomic_load_explicit(&hist->max, memory_order_relaxed);
+    while (value_us > max &&
+           !atomic_compare_exchange_weak_explicit(&hist->max, &max, value_us,
+                                                  memory_order_relaxed,
+                                                  memory_order_relaxed)) {
+    }
+}
+
+/**
+ * \brief           Copy one histogram.
+ *
+ * The count is the sum of the copied buckets, so percentiles of the copy are
+ * consistent even while values are being recorded.
+ *
+ * \param[in]       latency: Pointer to the histograms.
+ * \param[in]       route: Route index.
+ * \param[in]       kind: Measured latency.
+ * \param[out]      hist: Receives the histogram.
+ * \return          `E_STATE_OK` on success, or `E_STATE_INVAL` on invalid
+ *                  arguments.
+ */
+etype_e m1_latency_snapshot(m1_latency_t* latency, size_t route,
+                            m1_latency_kind_e kind, m1_histogram_t* hist) {
+    if (!latency || !hist || route >= latency->route_num ||
+        kind >= M1_LATENCY_KIND_MAX) {
+        return E_STATE_INVAL;
+    }
+
+    m1_latency_hist_t* src = &latency->hist[route][kind];
+    hist->count = 0;
+    for (size_t i = 0; i < M1_HISTOGRAM_BUCKET_NUM; i++) {
+        hist->bucket[i] =
+            atomic_load_explicit(&src->bucket[i], memory_order_relaxed);
+        hist->count += hist->bucket[i];
+    }
+    hist->sum = atomic_load_explicit(&src->sum, memory_order_relaxed);
+    hist->min = atomic_load_explicit(&src->min, memory_order_relaxed);
+    hist->max = atomic_load_explicit(&src->max, memory_order_relaxed);
+    return E_STATE_OK;
+}
+
+/**
+ * \brief           Empty every histogram.
+ *
+ * \param[in]       latency: Pointer to the histograms, may be NULL.
+ */
+void m1_latency_reset(m1_latency_t* latency) {
+    if (!latency) {
+        return;
+    }
+    for (size_t route = 0; route < latency->route_num; route++) {
+        for (size_t kind = 0; kind < M1_LATENCY_KIND_MAX; kind++) {
+            m1_latency_hist_reset(&latency->hist[route][kind]);
+        }
+    }
+}
+
+/* private functions -------------------------------------------------------- */
+/**
+ * \brief           Empty one histogram.
+ *
+ * \param[out]      hist: Pointer to the histogram.
+ */
+static void m1_latency_hist_reset(m1_latency_hist_t* hist) {
+    atomic_store_explicit(&hist->sum, 0, memory_order_relaxed);
+    atomic_store_explicit(&hist->min, UINT64_MAX, memory_order_relaxed);
+    atomic_store_explicit(&hist->max, 0, memory_order_relaxed);
+    for (size_t i = 0; i < M1_HISTOGRAM_BUCKET_NUM; i++) {
+        atomic_store_explicit(&hist->bucket[i], 0, memory_order_relaxed);
+    }
+}
+
+/* ----------------------------- end of file -------------------------------- */
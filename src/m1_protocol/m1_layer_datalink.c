@@ -37,69 +37,453 @@
 #include "./m1_protocol/m1_layer_datalink.h"
 
 #include <string.h>
+#if M1_USING_PTHREAD
+#include <pthread.h>
+#include <stdatomic.h>
+#include <unistd.h>
+#endif /* M1_USING_PTHREAD */
 #include "./crc/crc16_lookup.h"
 #include "./crc/crc8_lookup.h"
+#include "./m1_protocol/m1_event.h"
 #include "./m1_protocol/m1_layer_network.h"
 #include "./m1_protocol/m1_protocol_def.h"
 #include "./m1_protocol/m1_rx_parse.h"
 
+/* private define ----------------------------------------------------------- */
+/*! Length of a frame carrying `data_len` bytes of payload */
+#define M1_FRAME_LEN(data_len)                                                 \
+    (sizeof(m1_frame_head_t) + (data_len) + sizeof(u16))
+
+/* private typedefs --------------------------------------------------------- */
+/**
+ * \brief           A frame completed by a reader thread, waiting for the run
+ *                  loop. Lives in the bytes of an \ref m1_buf_t.
+ */
+typedef struct m1_rx_frame {
+    u64 stamp_us; /*!< Time the frame was verified, 0 if not recorded. */
+    u8 buf[];     /*!< Frame bytes. */
+} m1_rx_frame_t;
+
+#if M1_USING_PTHREAD
+/**
+ * \brief           Reader thread servicing one RX parse node.
+ */
+struct m1_rx_reader {
+    pthread_t thread;         /*!< Reader thread. */
+    atomic_bool run;          /*!< Cleared to stop the thread. */
+    bool started;             /*!< Thread was created. */
+    m1_t* m1;                 /*!< Owning protocol instance. */
+    m1_rx_parse_node_t* node; /*!< Node read and parsed by this thread
+                                 only. */
+};
+#endif /* M1_USING_PTHREAD */
+
 /* private function prototypes ---------------------------------------------- */
-static void m1_frame_parse(m1_rx_parse_node_t* node, u8* buf, size_t len);
+static void m1_frame_deliver(m1_t* m1, m1_rx_parse_node_t* node, u8* frame,
+                             size_t frame_len);
+#if M1_USING_PTHREAD
+static void* m1_rx_reader_main(void* arg);
+#endif /* M1_USING_PTHREAD */
+static void m1_rx_parse(m1_t* m1, m1_rx_parse_node_t* node, u8* buf,
+                        size_t len);
+static size_t m1_datalink_read_ring(m1_t* m1, m1_rx_parse_node_t* node,
+                                    m1_spsc_ring_t* ring);
+static size_t m1_frame_parse_bytes(m1_t* m1, m1_rx_parse_node_t* node,
+                                   u8* buf, size_t len);
+static void m1_frame_parse(m1_t* m1, m1_rx_parse_node_t* node, u8* buf,
+                           size_t len);
+static void m1_frame_parse_dgram(m1_t* m1, m1_rx_parse_node_t* node, u8* buf,
+                                 size_t len);
+static void m1_frame_head_fill(m1_frame_head_t* frame_head,
+                               m1_packet_t* packet);
+static void m1_frame_head_patch(u8* frame_buf, size_t frame_len,
+                                const m1_multicast_target_t* target);
+static u8* m1_frame_encode(m1_t* m1, m1_packet_t* packet, size_t* frame_len);
+static void m1_frame_release(m1_t* m1, m1_packet_t* packet, u8* frame_buf);
 
 /* public functions --------------------------------------------------------- */
 
 /**
  * \brief           Handles data reception at the data link layer.
  *
+ * \param[in]       m1: Pointer to the M1 protocol instance.
  * \param[in]       freq: The frequency at which this function is called.
  * \note            This function processes the data received by invoking the
  *                  appropriate parsing routines for each node in the receive
  *                  parse list.
  */
-void m1_datalink_receive(u32 freq) {
-    /*! Keeps track of the function invocation count. */
-    static u32 run_cnt = 0;
-    u8* rx_buf = m1.datalink_rx_buf; /*!< Pointer to the receive buffer. */
+void m1_datalink_receive(m1_t* m1, u32 freq) {
+    if (m1->rx_reader) {
+        /*! Links are read by their own threads, only route what they parsed */
+        m1_buf_t* frame;
+        while ((frame = m1_mpsc_queue_pop(m1->rx_queue)) != NULL) {
+            m1_rx_frame_t* rx_frame = (m1_rx_frame_t*)m1_buf_data(frame);
+            m1->rx_stamp_us = rx_frame->stamp_us;
+            m1_network_receive(m1, rx_frame->buf,
+                               m1_buf_len(frame) - sizeof(m1_rx_frame_t));
+            m1_buf_unref(frame);
+        }
+        m1->rx_stamp_us = 0;
+        return;
+    }
 
-    single_list_t* rx_parse_node = m1.rx_parse_head.next;
+    single_list_t* rx_parse_node = m1->rx_parse_head.next;
     while (rx_parse_node) {
         m1_rx_parse_node_t* ops =
             single_list_entry(rx_parse_node, m1_rx_parse_node_t, node);
-        size_t rx_len = m1.datalink_rx_buf_len;
-        if (run_cnt % (freq / ops->item.read_freq) == 0) {
-            etype_e ret = ops->item.rx->rx(rx_buf, &rx_len);
-            if (ret == E_STATE_OK && rx_len) {
-                m1_frame_parse(ops, rx_buf, rx_len);
-            }
+        u32 period = ops->item.read_freq ? freq / ops->item.read_freq : 1;
+        if (m1->run_cnt % (period ? period : 1) == 0) {
+            m1_datalink_read(m1, ops);
         }
         rx_parse_node = rx_parse_node->next;
     }
-    run_cnt++;
+    m1->run_cnt++;
+}
+
+/**
+ * \brief           Reads one RX link once and parses the returned bytes.
+ *
+ * A link fed through \ref rx_async_t::ring is not read; the bytes waiting
+ * in its ring are parsed in place and released instead.
+ *
+ * \param[in]       m1: Pointer to the M1 protocol instance.
+ * \param[in]       node: The receive parsing node of the link.
+ * \return          Number of bytes read, 0 if the link had no data or
+ *                  failed.
+ */
+size_t m1_datalink_read(m1_t* m1, m1_rx_parse_node_t* node) {
+    rx_async_t* rx = node->item.rx;
+    if (rx->ring) {
+        return m1_datalink_read_ring(m1, node, rx->ring);
+    }
+
+    size_t rx_len = node->item.rx_buf_len;
+    etype_e ret = rx->rx(rx->user_data, node->item.rx_buf, &rx_len);
+    if (ret != E_STATE_OK || !rx_len) {
+        return 0;
+    }
+    m1_rx_parse(m1, node, node->item.rx_buf, rx_len);
+    return rx_len;
+}
+
+/**
+ * \brief           Get the length of the frame starting at a buffer.
+ *
+ * Only the start of frame byte and the length field are looked at; the
+ * checksums are verified by the parser.
+ *
+ * \param[in]       buf: Start of the frame.
+ * \param[in]       len: Number of bytes available at `buf`.
+ * \return          Length of the whole frame, header and CRC16 included, or
+ *                  0 if `buf` does not start with a frame header.
+ */
+size_t m1_datalink_frame_len(const u8* buf, size_t len) {
+    if (!buf || len < sizeof(m1_frame_head_t) ||
+        buf[0] != M1_FRAME_HEAD_SOF) {
+        return 0;
+    }
+    const m1_frame_head_t* frame_head = (const m1_frame_head_t*)buf;
+    size_t data_len = frame_head->data_len_msb << 8 | frame_head->data_len_lsb;
+    return M1_FRAME_LEN(data_len);
+}
+
+/**
+ * \brief           Push out the frames the TX drivers are holding back.
+ *
+ * \param[in]       m1: Pointer to the M1 protocol instance.
+ */
+void m1_datalink_flush(m1_t* m1) {
+    for (size_t i = 0; i < m1->route_item_len; i++) {
+        tx_async_t* tx = m1->route_item[i].tx;
+        if (tx && tx->flush) {
+            tx->flush(tx->user_data);
+        }
+    }
+}
+
+/**
+ * \brief           Start one reader thread per RX parse node.
+ *
+ * \param[in]       m1: Pointer to the M1 protocol instance.
+ * \return          `E_STATE_OK` on success, `E_STATE_REPEATED` if already
+ *                  started, `E_STATE_NO_SPACE` on allocation failure, or
+ *                  `E_STATE_NOT_IMPLEMENT` without \ref M1_USING_PTHREAD.
+ */
+etype_e m1_datalink_rx_thread_start(m1_t* m1) {
+#if M1_USING_PTHREAD
+    if (m1->rx_reader) {
+        return E_STATE_REPEATED;
+    }
+
+    size_t reader_num = single_list_len(&m1->rx_parse_head);
+    if (reader_num == 0) {
+        return E_STATE_NOT_EXIST;
+    }
+
+    m1->rx_queue = m1_mpsc_queue_create(M1_RX_QUEUE_SIZE);
+    struct m1_rx_reader* reader =
+        m1_malloc(sizeof(struct m1_rx_reader) * reader_num);
+    if (!m1->rx_queue || !reader) {
+        m1_mpsc_queue_destroy(m1->rx_queue);
+        m1->rx_queue = NULL;
+        m1_free(reader);
+        return E_STATE_NO_SPACE;
+    }
+    memset(reader, 0, sizeof(struct m1_rx_reader) * reader_num);
+    m1->rx_reader = reader;
+    m1->rx_reader_num = reader_num;
+
+    size_t i = 0;
+    single_list_t* rx_parse_node = m1->rx_parse_head.next;
+    for (; rx_parse_node; rx_parse_node = rx_parse_node->next, i++) {
+        reader[i].m1 = m1;
+        reader[i].node =
+            single_list_entry(rx_parse_node, m1_rx_parse_node_t, node);
+        atomic_init(&reader[i].run, true);
+        if (pthread_create(&reader[i].thread, NULL, m1_rx_reader_main,
+                           &reader[i])) {
+            m1_datalink_rx_thread_stop(m1);
+            return E_STATE_ERROR;
+        }
+        reader[i].started = true;
+    }
+    return E_STATE_OK;
+#else
+    (void)m1;
+    return E_STATE_NOT_IMPLEMENT;
+#endif /* M1_USING_PTHREAD */
+}
+
+/**
+ * \brief           Stop the reader threads and go back to polling the links
+ *                  from \ref m1_datalink_receive.
+ *
+ * Frames parsed but not yet routed are dropped.
+ *
+ * \param[in]       m1: Pointer to the M1 protocol instance.
+ */
+void m1_datalink_rx_thread_stop(m1_t* m1) {
+#if M1_USING_PTHREAD
+    struct m1_rx_reader* reader = m1->rx_reader;
+    if (!reader) {
+        return;
+    }
+
+    for (size_t i = 0; i < m1->rx_reader_num; i++) {
+        atomic_store(&reader[i].run, false);
+    }
+    for (size_t i = 0; i < m1->rx_reader_num; i++) {
+        if (reader[i].started) {
+            pthread_join(reader[i].thread, NULL);
+        }
+    }
+    m1->rx_reader = NULL;
+    m1->rx_reader_num = 0;
+    m1_free(reader);
+
+    m1_buf_t* frame;
+    while ((frame = m1_mpsc_queue_pop(m1->rx_queue)) != NULL) {
+        m1_buf_unref(frame);
+    }
+    m1_mpsc_queue_destroy(m1->rx_queue);
+    m1->rx_queue = NULL;
+#else
+    (void)m1;
+#endif /* M1_USING_PTHREAD */
 }
 
 /**
  * \brief           Sends a packet over the data link layer.
  *
+ * \param[in]       m1: Pointer to the M1 protocol instance.
  * \param[in]       packet: The packet to send.
  * \return          E_STATE_OK if the packet was sent successfully, or an error
  *                  code otherwise.
  * \note            Constructs a frame by adding headers and CRC, then sends
  *                  the frame using the transport function.
  */
-etype_e m1_datalink_send(m1_packet_t* packet) {
+etype_e m1_datalink_send(m1_t* m1, m1_packet_t* packet) {
     etype_e ret = E_STATE_OK;
-    size_t frame_len =
-        sizeof(m1_frame_head_t) + packet->data->data_len + sizeof(u16);
-    u8* frame_buf = (u8*)MemoryPoolAlloc(m1.tx_pool, frame_len);
+    size_t frame_len;
+    int route = m1_network_route_index(m1, packet->target_id);
+    u8* frame_buf = m1_frame_encode(m1, packet, &frame_len);
     if (frame_buf == NULL) {
         /** Memory allocation failed. */
+        if (route >= 0) {
+            M1_STATS_TX_NO_SPACE(m1, route);
+        }
+        M1_TRACE(m1, M1_TRACE_TX_NO_SPACE, packet->target_id,
+                 packet->data->data_len, 0);
         return E_STATE_NO_SPACE;
     }
-    memset(frame_buf, 0, frame_len);
 
-    m1_frame_head_t* frame_head = (m1_frame_head_t*)frame_buf;
+    /* Transmit the frame */
+    ret = packet->tx->tx(packet->tx->user_data, frame_buf, frame_len);
+
+    m1_frame_release(m1, packet, frame_buf);
+    if (route >= 0) {
+        if (ret == E_STATE_OK) {
+            M1_STATS_TX_FRAME(m1, route, frame_len);
+        } else {
+            M1_STATS_TX_ERR(m1, route);
+        }
+    }
+    if (ret != E_STATE_OK) {
+        M1_TRACE(m1, M1_TRACE_TX_ERR, packet->target_id, packet->seq_num, ret);
+        if (m1->tx_abnormal_cb != NULL) {
+            m1->tx_abnormal_cb(packet);
+        }
+    }
+    return ret;
+}
+
+/**
+ * \brief           Sends one packet to several targets over the data link
+ *                  layer.
+ *
+ * \param[in]       m1: Pointer to the M1 protocol instance.
+ * \param[in]       packet: The packet holding the fields shared by all
+ *                  targets.
+ * \param[in]       target: Per-target fields, grouped by egress link.
+ * \param[in]       target_len: Number of entries in \p target.
+ * \return          E_STATE_OK if every frame was sent successfully, or the
+ *                  first error code otherwise.
+ * \note            The payload is copied and checksummed only for the first
+ *                  target; later frames are derived by patching the header.
+ */
+etype_e m1_datalink_send_multicast(m1_t* m1, m1_packet_t* packet,
+                                   const m1_multicast_target_t* target,
+                                   size_t target_len) {
+    if (!target || !target_len) {
+        return E_STATE_INVAL;
+    }
+
+    etype_e ret = E_STATE_OK;
+    size_t frame_len;
+    packet->target_id = target[0].target_id;
+    packet->seq_num = target[0].seq_num;
+    u8* frame_buf = m1_frame_encode(m1, packet, &frame_len);
+    if (frame_buf == NULL) {
+        /** Memory allocation failed. */
+        for (size_t i = 0; i < target_len; i++) {
+            M1_STATS_TX_NO_SPACE(m1, target[i].route);
+            M1_TRACE(m1, M1_TRACE_TX_NO_SPACE, target[i].target_id,
+                     packet->data->data_len, 0);
+        }
+        return E_STATE_NO_SPACE;
+    }
+
+    for (size_t i = 0; i < target_len; i++) {
+        if (i) {
+            m1_frame_head_patch(frame_buf, frame_len, &target[i]);
+        }
+
+        etype_e tx_ret =
+            target[i].tx->tx(target[i].tx->user_data, frame_buf, frame_len);
+        if (tx_ret == E_STATE_OK) {
+            M1_STATS_TX_FRAME(m1, target[i].route, frame_len);
+        } else {
+            M1_STATS_TX_ERR(m1, target[i].route);
+            M1_TRACE(m1, M1_TRACE_TX_ERR, target[i].target_id,
+                     target[i].seq_num, tx_ret);
+            if (ret == E_STATE_OK) {
+                ret = tx_ret;
+            }
+            if (m1->tx_abnormal_cb != NULL) {
+                packet->target_id = target[i].target_id;
+                packet->seq_num = target[i].seq_num;
+                packet->tx = target[i].tx;
+                m1->tx_abnormal_cb(packet);
+            }
+        }
+    }
+
+    m1_frame_release(m1, packet, frame_buf);
+    return ret;
+}
+
+/**
+ * \brief           Allocate a frame buffer for a payload.
+ *
+ * \param[in]       data_len: Length of the payload.
+ * \return          The buffer holding one reference, or NULL on allocation
+ *                  failure.
+ */
+m1_buf_t* m1_datalink_frame_alloc(size_t data_len) {
+    return m1_buf_alloc(M1_FRAME_LEN(data_len));
+}
+
+/**
+ * \brief           Get the payload area of a frame buffer.
+ *
+ * \param[in]       frame: Buffer from \ref m1_datalink_frame_alloc.
+ * \return          Start of the payload.
+ */
+u8* m1_datalink_frame_data(m1_buf_t* frame) {
+    return m1_buf_data(frame) + sizeof(m1_frame_head_t);
+}
+
+/* private functions -------------------------------------------------------- */
+/**
+ * \brief           Encodes a packet into a frame.
+ *
+ * A packet carried by a frame buffer is encoded in place around its payload;
+ * any other packet is copied into a temporary frame from the TX pool.
+ *
+ * \param[in]       m1: Pointer to the M1 protocol instance.
+ * \param[in]       packet: The packet to encode.
+ * \param[out]      frame_len: Length of the encoded frame.
+ * \return          The encoded frame, or NULL on allocation failure. Must be
+ *                  handed to \ref m1_frame_release.
+ */
+static u8* m1_frame_encode(m1_t* m1, m1_packet_t* packet, size_t* frame_len) {
+    *frame_len = M1_FRAME_LEN(packet->data->data_len);
+
+    u8* frame_buf;
+    if (packet->data->buf) {
+        frame_buf = m1_buf_data(packet->data->buf);
+    } else {
+        frame_buf = (u8*)MemoryPoolAlloc(m1->tx_pool, *frame_len);
+        if (frame_buf == NULL) {
+            return NULL;
+        }
+        if (packet->data->data_len) {
+            memcpy(frame_buf + sizeof(m1_frame_head_t), packet->data->data,
+                   packet->data->data_len);
+        }
+    }
+    memset(frame_buf, 0, sizeof(m1_frame_head_t));
 
     /* Populate frame header fields */
+    m1_frame_head_fill((m1_frame_head_t*)frame_buf, packet);
+
+    /** Calculate CRC for the frame header */
+    crc8_lookup_pack_buf(CRC8_MAXIM_LOOKUP_MODEL, frame_buf,
+                         sizeof(m1_frame_head_t));
+    crc16_lookup_pack_buf(CRC16_MODBUS_LOOKUP_MODEL, frame_buf, *frame_len);
+    return frame_buf;
+}
+
+/**
+ * \brief           Releases a frame returned by \ref m1_frame_encode.
+ *
+ * \param[in]       m1: Pointer to the M1 protocol instance.
+ * \param[in]       packet: The packet the frame was encoded from.
+ * \param[in]       frame_buf: The encoded frame.
+ */
+static void m1_frame_release(m1_t* m1, m1_packet_t* packet, u8* frame_buf) {
+    if (!packet->data->buf) {
+        MemoryPoolFree(m1->tx_pool, frame_buf);
+    }
+}
+
+/**
+ * \brief           Fills a frame header from a packet, except for its CRC8.
+ * \param[out]      frame_head: The frame header to fill.
+ * \param[in]       packet: The packet providing the header fields.
+ */
+static void m1_frame_head_fill(m1_frame_head_t* frame_head,
+                               m1_packet_t* packet) {
     frame_head->sof = M1_FRAME_HEAD_SOF;
     frame_head->version = packet->version;
     frame_head->data_type = packet->data_type;
@@ -114,47 +498,60 @@ etype_e m1_datalink_send(m1_packet_t* packet) {
     frame_head->data_len_msb = (packet->data->data_len & 0xFF00) >> 8;
     frame_head->seq_num = packet->seq_num;
     frame_head->ack_num = packet->ack_num;
+}
 
-    /** Calculate CRC for the frame header */
+/**
+ * \brief           Rewrites the per-target header fields of an encoded frame.
+ *
+ * \param[in,out]   frame_buf: The encoded frame.
+ * \param[in]       frame_len: The length of the encoded frame.
+ * \param[in]       target: The new per-target header fields.
+ * \note            Only the header is read again; the CRC16 update over the
+ *                  unchanged payload is done by \ref crc16_lookup_patch.
+ */
+static void m1_frame_head_patch(u8* frame_buf, size_t frame_len,
+                                const m1_multicast_target_t* target) {
+    m1_frame_head_t* frame_head = (m1_frame_head_t*)frame_buf;
+    u8 old_head[sizeof(m1_frame_head_t)];
+
+    memcpy(old_head, frame_buf, sizeof(m1_frame_head_t));
+    frame_head->target_id = target->target_id;
+    frame_head->seq_num = target->seq_num;
     crc8_lookup_pack_buf(CRC8_MAXIM_LOOKUP_MODEL, frame_buf,
                          sizeof(m1_frame_head_t));
-    memcpy(frame_buf + sizeof(m1_frame_head_t), packet->data->data,
-           packet->data->data_len);
-    crc16_lookup_pack_buf(CRC16_MODBUS_LOOKUP_MODEL, frame_buf, frame_len);
 
-    /* Transmit the frame */
-    ret = packet->tx->tx(frame_buf, frame_len);
-
-    MemoryPoolFree(m1.tx_pool, frame_buf);
-    if (ret != E_STATE_OK) {
-        if (m1.tx_abnormal_cb != NULL) {
-            m1.tx_abnormal_cb(packet);
-        }
-    }
-    return ret;
+    u16 crc16 = frame_buf[frame_len - 2] | (frame_buf[frame_len - 1] << 8);
+    crc16 = crc16_lookup_patch(
+        CRC16_MODBUS_LOOKUP_MODEL, crc16, old_head, frame_buf,
+        sizeof(m1_frame_head_t),
+        frame_len - sizeof(m1_frame_head_t) - sizeof(u16));
+    frame_buf[frame_len - 2] = crc16 & 0xFF;
+    frame_buf[frame_len - 1] = (crc16 >> 8) & 0xFF;
 }
 
-/* private functions -------------------------------------------------------- */
-
 /**
- * \brief           Parses a received frame and processes it.
+ * \brief           Parses received bytes one at a time through the parse cache.
+ *
+ * Used for frames that are split across reads. Parsing stops as soon as the
+ * parser is back in the start of frame state, so the caller can go on looking
+ * for frames in place.
+ *
+ * \param[in]       m1: Pointer to the M1 protocol instance.
  * \param[in]       node: The receive parsing node.
  * \param[in]       buf: The received data buffer.
  * \param[in]       len: The length of the received data.
+ * \return          Number of bytes consumed.
  * \note            This function handles frame structure validation, including
  *                  SOF, header, and CRC checks, and forwards valid frames to
  *                  the network layer.
  */
-static void m1_frame_parse(m1_rx_parse_node_t* node, u8* buf, size_t len) {
-    if (node == NULL) {
-        return;
-    }
+static size_t m1_frame_parse_bytes(m1_t* m1, m1_rx_parse_node_t* node,
+                                   u8* buf, size_t len) {
     m1_parse_t* parse = &node->item.parse;
     m1_frame_head_t* frame_head = NULL;
     size_t data_len = 0;
     size_t frame_len = 0;
 
-    M1_STATS_RX_NODE_TOTAL_BYTES(node, len);
     for (size_t i = 0; i < len; i++) {
         switch (parse->step) {
             case M1_PARSE_FRAME_SOF:
@@ -193,7 +590,7 @@ static void m1_frame_parse(m1_rx_parse_node_t* node, u8* buf, size_t len) {
                 frame_head = (m1_frame_head_t*)parse->cache;
                 data_len =
                     frame_head->data_len_msb << 8 | frame_head->data_len_lsb;
-                frame_len = sizeof(m1_frame_head_t) + data_len + sizeof(u16);
+                frame_len = M1_FRAME_LEN(data_len);
 
                 /* Check if the cache can hold the entire frame */
                 if (frame_len > parse->cache_len) {
@@ -214,7 +611,7 @@ static void m1_frame_parse(m1_rx_parse_node_t* node, u8* buf, size_t len) {
                     parse->index++;
                     if (crc16_lookup_verify_buf(CRC16_MODBUS_LOOKUP_MODEL,
                                                 parse->cache, frame_len)) {
-                        m1_network_receive(parse->cache, frame_len);
+                        m1_frame_deliver(m1, node, parse->cache, frame_len);
                         M1_STATS_RX_NODE_CRC16_OK(node);
                     } else {
                         M1_STATS_RX_NODE_CRC16_ERR(node);
@@ -226,7 +623,260 @@ static void m1_frame_parse(m1_rx_parse_node_t* node, u8* buf, size_t len) {
             default:
                 break;
         }
+        if (parse->step == M1_PARSE_FRAME_SOF) {
+            return i + 1;
+        }
+    }
+    return len;
+}
+
+/**
+ * \brief           Parses a received byte stream and processes its frames.
+ *
+ * Frames that lie whole in `buf` are found with `memchr`, checked and
+ * delivered where they lie. Only a frame cut by the end of a read, or one
+ * left over from the previous read, goes through the byte-wise parser and
+ * the parse cache.
+ *
+ * \param[in]       m1: Pointer to the M1 protocol instance.
+ * \param[in]       node: The receive parsing node.
+ * \param[in]       buf: The received data buffer.
+ * \param[in]       len: The length of the received data.
+ */
+static void m1_frame_parse(m1_t* m1, m1_rx_parse_node_t* node, u8* buf,
+                           size_t len) {
+    if (node == NULL) {
+        return;
+    }
+    m1_parse_t* parse = &node->item.parse;
+
+    M1_STATS_RX_NODE_TOTAL_BYTES(node, len);
+    size_t offset = 0;
+    while (offset < len) {
+        if (parse->step != M1_PARSE_FRAME_SOF) {
+            offset += m1_frame_parse_bytes(m1, node, buf + offset,
+                                           len - offset);
+            continue;
+        }
+
+        u8* frame = memchr(buf + offset, M1_FRAME_HEAD_SOF, len - offset);
+        if (!frame) {
+            M1_STATS_RX_NODE_NOT_FRAME_LEN(node, len - offset);
+            break;
+        }
+        M1_STATS_RX_NODE_NOT_FRAME_LEN(node, frame - (buf + offset));
+        offset = frame - buf;
+
+        size_t frame_len = m1_datalink_frame_len(frame, len - offset);
+        if (!frame_len || frame_len > len - offset) {
+            /*! The frame goes on in the next read */
+            offset += m1_frame_parse_bytes(m1, node, frame, len - offset);
+            continue;
+        }
+
+        M1_STATS_RX_NODE_SOF_OK(node);
+        if (!crc8_lookup_verify_buf(CRC8_MAXIM_LOOKUP_MODEL, frame,
+                                    sizeof(m1_frame_head_t))) {
+            /*! Not a header, look for the next start of frame */
+            M1_STATS_RX_NODE_CRC8_ERR(node);
+            offset++;
+            continue;
+        }
+        M1_STATS_RX_NODE_CRC8_OK(node);
+
+        if (frame_len > parse->cache_len) {
+            M1_STATS_RX_NODE_LEN_OVERFLOW(node);
+        } else if (crc16_lookup_verify_buf(CRC16_MODBUS_LOOKUP_MODEL, frame,
+                                           frame_len)) {
+            m1_frame_deliver(m1, node, frame, frame_len);
+            M1_STATS_RX_NODE_CRC16_OK(node);
+        } else {
+            M1_STATS_RX_NODE_CRC16_ERR(node);
+        }
+        offset += frame_len;
+    }
+}
+
+/**
+ * \brief           Parses the bytes waiting in a link's ring in place.
+ *
+ * At most two spans are parsed, the one up to the end of the ring storage
+ * and the one after the wrap, so a producer that keeps writing cannot hold
+ * the caller here. A frame split by the wrap is joined in the parse cache.
+ *
+ * \param[in]       m1: Pointer to the M1 protocol instance.
+ * \param[in]       node: The receive parsing node of the link.
+ * \param[in]       ring: The ring filled by the link driver.
+ * \return          Number of bytes parsed.
+ */
+static size_t m1_datalink_read_ring(m1_t* m1, m1_rx_parse_node_t* node,
+                                    m1_spsc_ring_t* ring) {
+    size_t total = 0;
+    for (int i = 0; i < 2; i++) {
+        u8* span;
+        size_t len = m1_spsc_ring_read_span(ring, &span);
+        if (!len) {
+            break;
+        }
+        m1_frame_parse(m1, node, span, len);
+        m1_spsc_ring_read_commit(ring, len);
+        total += len;
+    }
+    return total;
+}
+
+/**
+ * \brief           Parses bytes read from a link with the parser matching its
+ *                  link type.
+ *
+ * \param[in]       m1: Pointer to the M1 protocol instance.
+ * \param[in]       node: The receive parsing node.
+ * \param[in]       buf: The received data buffer.
+ * \param[in]       len: The length of the received data.
+ */
+static void m1_rx_parse(m1_t* m1, m1_rx_parse_node_t* node, u8* buf,
+                        size_t len) {
+    if (M1_LINK_TYPE_IS_DGRAM(node->item.link_type)) {
+        m1_frame_parse_dgram(m1, node, buf, len);
+    } else {
+        m1_frame_parse(m1, node, buf, len);
+    }
+}
+
+/**
+ * \brief           Parses whole frames read from a datagram link.
+ *
+ * The driver returns complete frames back to back, so every frame is checked
+ * and delivered where it lies, without the byte-wise start of frame search
+ * and without copying it into the parse cache. A frame with a broken header
+ * makes the position of the following ones unknown, so the rest of the
+ * buffer is dropped.
+ *
+ * \param[in]       m1: Pointer to the M1 protocol instance.
+ * \param[in]       node: The receive parsing node.
+ * \param[in]       buf: Frames received from the link.
+ * \param[in]       len: Total length of the frames.
+ */
+static void m1_frame_parse_dgram(m1_t* m1, m1_rx_parse_node_t* node, u8* buf,
+                                 size_t len) {
+    M1_STATS_RX_NODE_TOTAL_BYTES(node, len);
+    size_t offset = 0;
+    while (offset < len) {
+        u8* frame = buf + offset;
+        size_t frame_len = m1_datalink_frame_len(frame, len - offset);
+        if (!frame_len || frame_len > len - offset) {
+            M1_STATS_RX_NODE_NOT_FRAME_LEN(node, len - offset);
+            break;
+        }
+        M1_STATS_RX_NODE_SOF_OK(node);
+        if (!crc8_lookup_verify_buf(CRC8_MAXIM_LOOKUP_MODEL, frame,
+                                    sizeof(m1_frame_head_t))) {
+            M1_STATS_RX_NODE_CRC8_ERR(node);
+            M1_STATS_RX_NODE_NOT_FRAME_LEN(node, len - offset);
+            break;
+        }
+        M1_STATS_RX_NODE_CRC8_OK(node);
+
+        if (frame_len > node->item.parse.cache_len) {
+            /*! Same limit as on byte stream links */
+            M1_STATS_RX_NODE_LEN_OVERFLOW(node);
+        } else if (crc16_lookup_verify_buf(CRC16_MODBUS_LOOKUP_MODEL, frame,
+                                           frame_len)) {
+            m1_frame_deliver(m1, node, frame, frame_len);
+            M1_STATS_RX_NODE_CRC16_OK(node);
+        } else {
+            M1_STATS_RX_NODE_CRC16_ERR(node);
+        }
+        offset += frame_len;
+    }
+}
+
+/**
+ * \brief           Hands a verified frame to the network layer.
+ *
+ * When the links are read by reader threads the frame is copied onto the
+ * instance's RX queue and routed later by \ref m1_datalink_receive on the run
+ * loop, which owns the transport state. A full queue stalls the reader of
+ * this link until the run loop catches up, and a frame that finds no buffer
+ * is dropped. Otherwise the frame is routed immediately.
+ *
+ * \param[in]       m1: Pointer to the M1 protocol instance.
+ * \param[in]       node: The receive parsing node the frame came from.
+ * \param[in]       frame: The verified frame.
+ * \param[in]       frame_len: Length of the frame.
+ */
+static void m1_frame_deliver(m1_t* m1, m1_rx_parse_node_t* node, u8* frame,
+                             size_t frame_len) {
+    u64 stamp_us = m1->latency ? m1_event_now_us() : 0;
+    if (!m1->rx_queue) {
+        m1->rx_stamp_us = stamp_us;
+        m1_network_receive(m1, frame, frame_len);
+        m1->rx_stamp_us = 0;
+        return;
+    }
+
+    m1_buf_t* rx_frame = m1_buf_alloc(sizeof(m1_rx_frame_t) + frame_len);
+    const m1_frame_head_t* frame_head = (const m1_frame_head_t*)frame;
+    if (!rx_frame) {
+        M1_STATS_RX_NODE_NO_SPACE(node);
+        M1_TRACE(m1, M1_TRACE_RX_DROP, frame_head->source_id,
+                 frame_head->target_id, frame_head->seq_num);
+        return;
+    }
+    m1_rx_frame_t* queued = (m1_rx_frame_t*)m1_buf_data(rx_frame);
+    queued->stamp_us = stamp_us;
+    memcpy(queued->buf, frame, frame_len);
+    if (m1_mpsc_queue_push(m1->rx_queue, rx_frame) == E_STATE_OK) {
+        m1_event_wake(m1);
+        return;
+    }
+
+#if M1_USING_PTHREAD
+    /*! Run loop is behind: hold this link back instead of dropping frames,
+        until the queue has room or the reader is being stopped */
+    for (size_t i = 0; i < m1->rx_reader_num; i++) {
+        struct m1_rx_reader* reader = &m1->rx_reader[i];
+        if (reader->node != node) {
+            continue;
+        }
+        while (atomic_load_explicit(&reader->run, memory_order_relaxed)) {
+            usleep(M1_RX_QUEUE_RETRY_US);
+            if (m1_mpsc_queue_push(m1->rx_queue, rx_frame) == E_STATE_OK) {
+                m1_event_wake(m1);
+                return;
+            }
+        }
+        break;
+    }
+#endif /* M1_USING_PTHREAD */
+
+    M1_STATS_RX_NODE_QUEUE_FULL(node);
+    M1_TRACE(m1, M1_TRACE_RX_DROP, frame_head->source_id,
+             frame_head->target_id, frame_head->seq_num);
+    m1_buf_unref(rx_frame);
+}
+
+#if M1_USING_PTHREAD
+/**
+ * \brief           Reader thread: reads one link and runs its parser.
+ *
+ * Sleeps one read period (1 / `read_freq`) whenever the link has no data.
+ *
+ * \param[in]       arg: Pointer to the \ref m1_rx_reader of this thread.
+ * \return          Always NULL.
+ */
+static void* m1_rx_reader_main(void* arg) {
+    struct m1_rx_reader* reader = arg;
+    u16 read_freq = reader->node->item.read_freq;
+    useconds_t period_us = 1000000 / (read_freq ? read_freq : 1000);
+
+    while (atomic_load_explicit(&reader->run, memory_order_relaxed)) {
+        if (!m1_datalink_read(reader->m1, reader->node)) {
+            usleep(period_us);
+        }
     }
+    return NULL;
 }
+#endif /* M1_USING_PTHREAD */
 
 /* ----------------------------- end of file -------------------------------- */
@@ -36,13 +36,12 @@
 /* includes ----------------------------------------------------------------- */
 #include "./m1_protocol/m1_layer_network.h"
 
+#include <stdint.h>
+#include <string.h>
 #include "./m1_protocol/m1_layer_datalink.h"
 #include "./m1_protocol/m1_layer_transport.h"
 #include "./m1_protocol/m1_protocol_def.h"
 
-/* private function prototypes ---------------------------------------------- */
-static tx_async_t* find_route(u16 target_id);
-
 /* public functions --------------------------------------------------------- */
 
 /**
@@ -52,6 +51,7 @@ static tx_async_t* find_route(u16 target_id);
  * the packet is addressed to the local node or needs to be forwarded to another
  * node via routing.
  *
+ * \param[in]       m1: Pointer to the M1 protocol instance.
  * \param[in]       frame_buf: Pointer to the buffer containing the received
  * frame.
  * \param[in]       frame_len: Length of the received frame in bytes.
@@ -60,24 +60,34 @@ static tx_async_t* find_route(u16 target_id);
  * \return          E_STATE_NOT_EXIST if the target node does not exist in the
  * routing table.
  */
-etype_e m1_network_receive(u8* frame_buf, size_t frame_len) {
+etype_e m1_network_receive(m1_t* m1, u8* frame_buf, size_t frame_len) {
     m1_frame_head_t* frame_head = (m1_frame_head_t*)frame_buf;
 
     // Check if the frame is addressed to this node
-    for (size_t i = 0; i < m1.source_id_len; ++i) {
-        if (frame_head->target_id == m1.source_id[i]) {
-            return m1_transport_receive(frame_buf, frame_len);
+    for (size_t i = 0; i < m1->source_id_len; ++i) {
+        if (frame_head->target_id == m1->source_id[i]) {
+            return m1_transport_receive(m1, frame_buf, frame_len);
         }
     }
 
     // Routing logic for forwarding packets
-    tx_async_t* route_tx = find_route(frame_head->target_id);
-    if (route_tx) {
-        return route_tx->tx(frame_buf, frame_len);
+    int route = m1_network_route_index(m1, frame_head->target_id);
+    if (route >= 0) {
+        tx_async_t* route_tx = m1->route_item[route].tx;
+        etype_e ret = route_tx->tx(route_tx->user_data, frame_buf, frame_len);
+        if (ret == E_STATE_OK) {
+            M1_STATS_TX_FORWARD(m1, route, frame_len);
+        } else {
+            M1_STATS_TX_FORWARD_ERR(m1, route);
+        }
+        return ret;
     }
 
     // Target node does not exist in the routing table
     // TODO: Handle non-existent destination node appropriately
+    M1_STATS_NET(m1, fwd_no_route_cnt);
+    M1_TRACE(m1, M1_TRACE_FWD_NO_ROUTE, frame_head->source_id,
+             frame_head->target_id, 0);
 
     return E_STATE_NOT_EXIST;
 }
@@ -88,6 +98,7 @@ etype_e m1_network_receive(u8* frame_buf, size_t frame_len) {
  * This function determines the appropriate route for the packet based on the
  * target ID and appends a sequence number if required.
  *
+ * \param[in]       m1: Pointer to the M1 protocol instance.
  * \param[in]       packet: Pointer to the packet to be sent.
  * \param[in]       add_seq_num: Flag indicating whether to add a sequence
  *                  number to the packet.
@@ -95,15 +106,15 @@ etype_e m1_network_receive(u8* frame_buf, size_t frame_len) {
  * \return          E_STATE_NOT_EXIST if the target node does not exist in the
  *                  routing table.
  */
-etype_e m1_network_send(m1_packet_t* packet, bool add_seq_num) {
+etype_e m1_network_send(m1_t* m1, m1_packet_t* packet, bool add_seq_num) {
     tx_async_t* route_tx = NULL;
 
     // Find the route for the target ID
-    for (size_t i = 0; i < m1.route_item_len; ++i) {
-        if (packet->target_id == m1.route_item[i].target_id) {
-            route_tx = m1.route_item[i].tx;
+    for (size_t i = 0; i < m1->route_item_len; ++i) {
+        if (packet->target_id == m1->route_item[i].target_id) {
+            route_tx = m1->route_item[i].tx;
             if (add_seq_num) {
-                packet->seq_num = m1.seq_num[i]++;
+                packet->seq_num = m1->seq_num[i]++;
             }
             break;
         }
@@ -111,36 +122,102 @@ etype_e m1_network_send(m1_packet_t* packet, bool add_seq_num) {
 
     if (route_tx) {
         packet->tx = route_tx;
-        return m1_datalink_send(packet);
+        return m1_datalink_send(m1, packet);
     }
 
     // Target node does not exist in the routing table
     // TODO: Handle non-existent destination node appropriately
+    M1_STATS_NET(m1, tx_no_route_cnt);
+    M1_TRACE(m1, M1_TRACE_TX_NO_ROUTE, packet->target_id, 0, 0);
 
     return E_STATE_NOT_EXIST;
 }
 
-/* private functions -------------------------------------------------------- */
 /**
- * \brief           Finds the transmission route for a given target ID.
+ * \brief           Sends a packet to several targets at the network layer.
  *
- * This function searches the routing table to find the transmission mechanism
- * (tx_async_t) corresponding to the specified target ID. If no matching route
- * is found, it returns NULL.
+ * Each target is resolved to its route, sequence numbers are assigned if
+ * required, and the targets are grouped by egress link so that frames for the
+ * same link leave back to back. The data link layer then encodes the packet
+ * once for all of them.
+ *
+ * \param[in]       m1: Pointer to the M1 protocol instance.
+ * \param[in]       packet: Pointer to the packet to be sent.
+ * \param[in]       target_id: Array of target device IDs.
+ * \param[in]       target_id_len: Number of entries in \p target_id.
+ * \param[in]       add_seq_num: Flag indicating whether to add a sequence
+ *                  number to each frame.
+ * \return          E_STATE_OK if the packet is successfully sent.
+ * \return          E_STATE_NOT_EXIST if a target does not exist in the
+ *                  routing table; the other targets are still sent to.
+ * \return          E_STATE_INVAL if \p target_id_len exceeds `UINT8_MAX`.
+ */
+etype_e m1_network_send_multicast(m1_t* m1, m1_packet_t* packet,
+                                  const u8* target_id, size_t target_id_len,
+                                  bool add_seq_num) {
+    if (!packet || !target_id || !target_id_len ||
+        target_id_len > UINT8_MAX) {
+        return E_STATE_INVAL;
+    }
+
+    /*! Bounded by the u8 target count of \ref m1_tx_data_t */
+    m1_multicast_target_t target[UINT8_MAX];
+
+    /* Group targets by egress link, keeping the caller's order otherwise */
+    size_t target_len = 0;
+    size_t no_route_cnt = 0;
+    for (size_t i = 0; i < target_id_len; ++i) {
+        int route = m1_network_route_index(m1, target_id[i]);
+        if (route < 0) {
+            M1_STATS_NET(m1, tx_no_route_cnt);
+            M1_TRACE(m1, M1_TRACE_TX_NO_ROUTE, target_id[i], 0, 0);
+            no_route_cnt++;
+            continue;
+        }
+
+        tx_async_t* route_tx = m1->route_item[route].tx;
+        size_t pos = target_len;
+        for (size_t j = target_len; j > 0; --j) {
+            if (target[j - 1].tx == route_tx) {
+                pos = j;
+                break;
+            }
+        }
+        memmove(&target[pos + 1], &target[pos],
+                sizeof(m1_multicast_target_t) * (target_len - pos));
+
+        target[pos].target_id = target_id[i];
+        target[pos].seq_num =
+            add_seq_num ? m1->seq_num[route]++ : packet->seq_num;
+        target[pos].tx = route_tx;
+        target[pos].route = route;
+        target_len++;
+    }
+
+    etype_e ret = E_STATE_OK;
+    if (target_len) {
+        ret = m1_datalink_send_multicast(m1, packet, target, target_len);
+    }
+    if (ret == E_STATE_OK && no_route_cnt) {
+        ret = E_STATE_NOT_EXIST;
+    }
+    return ret;
+}
+
+/**
+ * \brief           Finds the routing table index for a given target ID.
  *
- * \param[in]       target_id: The ID of the target node for which the route is
- *                  being searched.
- * \return          Pointer to the tx_async_t structure if a matching route is
- *                  found.
- * \return          NULL if no route matches the specified target ID.
+ * \param[in]       m1: Pointer to the M1 protocol instance.
+ * \param[in]       target_id: The ID of the target node.
+ * \return          Index into the routing table, or -1 if no route matches.
  */
-static tx_async_t* find_route(u16 target_id) {
-    for (size_t i = 0; i < m1.route_item_len; ++i) {
-        if (target_id == m1.route_item[i].target_id) {
-            return m1.route_item[i].tx;
+int m1_network_route_index(m1_t* m1, u16 target_id) {
+    for (size_t i = 0; i < m1->route_item_len; ++i) {
+        if (target_id == m1->route_item[i].target_id) {
+            return (int)i;
         }
     }
-    return NULL;
+    return -1;
 }
 
 /* ----------------------------- end of file -------------------------------- */
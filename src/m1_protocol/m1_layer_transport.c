@@ -36,8 +36,14 @@
 /* includes ----------------------------------------------------------------- */
 #include "./m1_protocol/m1_layer_transport.h"
 
+#include <assert.h>
 #include <string.h>
+#if M1_USING_PTHREAD
+#include <unistd.h>
+#endif /* M1_USING_PTHREAD */
+#include "./m1_protocol/m1_event.h"
 #include "./m1_protocol/m1_format_data.h"
+#include "./m1_protocol/m1_layer_datalink.h"
 #include "./m1_protocol/m1_layer_network.h"
 #include "./m1_protocol/m1_protocol_def.h"
 #include "./m1_protocol/m1_rx_parse.h"
@@ -50,12 +56,30 @@
 /*! Maximum retry count for reliable transmission*/
 #define MAX_RETRY_COUNT  5
 
+/* private typedefs --------------------------------------------------------- */
+/**
+ * \brief           RX callback invocation handed to the worker pool.
+ */
+typedef struct m1_rx_job {
+    m1_work_t work;            /*!< Work pool linkage. */
+    m1_rx_parse_callback_t cb; /*!< Callback to run. */
+    u64 stamp_us;              /*!< Time the frame was verified. */
+    int route;                 /*!< Route of the source, -1 if none. */
+    bool pooled;               /*!< Taken from \ref m1_t::rx_job_pool. */
+    m1_rx_data_t rx_data;      /*!< Callback argument, `data` points below. */
+    u8 data[];                 /*!< Copy of the payload. */
+} m1_rx_job_t;
+
 /* private function prototypes ---------------------------------------------- */
-static void handle_ack_retries(u32 freq);
-static etype_e handle_wait_ack_packet(single_list_t* node);
-static etype_e process_acknowledgment(m1_frame_head_t* frame_head);
-static etype_e send_ack_to_source_host(m1_frame_head_t* frame_head);
-static m1_packet_data_t* allocate_ack_data(m1_packet_data_t* src_data);
+static void dispatch_rx_callback(m1_t* m1, m1_rx_parse_callback_t cb,
+                                 m1_rx_data_t* rx_data);
+static m1_rx_job_t* alloc_rx_job(m1_t* m1, size_t data_len);
+static void run_rx_job(m1_work_t* work);
+static void handle_ack_retries(m1_t* m1, u32 elapsed_ms);
+static etype_e handle_wait_ack_packet(m1_t* m1, single_list_t* node);
+static etype_e process_acknowledgment(m1_t* m1, m1_frame_head_t* frame_head);
+static etype_e send_ack_to_source_host(m1_t* m1, m1_frame_head_t* frame_head);
+static m1_buf_t* allocate_ack_data(m1_packet_data_t* src_data);
 
 /* public functions --------------------------------------------------------- */
 /**
@@ -64,11 +88,35 @@ static m1_packet_data_t* allocate_ack_data(m1_packet_data_t* src_data);
  * This function performs tasks such as retransmission handling, timeouts, and
  * state management. It should be called periodically by the application.
  *
- * \param[in]       freq: Frequency of the data reception process in Hz.
+ * \param[in]       m1: Pointer to the M1 protocol instance.
+ * \param[in]       elapsed_ms: Time elapsed since the previous call, in
+ *                  milliseconds.
  */
-void m1_transport_run(u32 freq) {
+void m1_transport_run(m1_t* m1, u32 elapsed_ms) {
     /*! Handle retries for packets awaiting acknowledgment */
-    handle_ack_retries(freq);
+    handle_ack_retries(m1, elapsed_ms);
+}
+
+/**
+ * \brief           Time until the next retransmission deadline.
+ *
+ * \param[in]       m1: Pointer to the M1 protocol instance.
+ * \return          Milliseconds until the earliest packet waiting for an ACK
+ *                  times out (0 if already due), or -1 if none is waiting.
+ */
+i32 m1_transport_next_timeout(m1_t* m1) {
+    i32 timeout = -1;
+    single_list_t* current_node = m1->wait_ack_packet_head.next;
+    while (current_node) {
+        m1_packet_t* packet =
+            single_list_entry(current_node, m1_packet_t, node);
+        i32 wait_time_ms = packet->wait_time_ms > 0 ? packet->wait_time_ms : 0;
+        if (timeout < 0 || wait_time_ms < timeout) {
+            timeout = wait_time_ms;
+        }
+        current_node = current_node->next;
+    }
+    return timeout;
 }
 
 /**
@@ -77,6 +125,7 @@ void m1_transport_run(u32 freq) {
  * This function processes raw data received from the network layer, extracts
  * useful information, and prepares it for further processing at higher layers.
  *
+ * \param[in]       m1: Pointer to the M1 protocol instance.
  * \param[in]       frame_buf: Pointer to the buffer containing the raw
  *                  frame data.
  * \param[in]       frame_len: Length of the raw frame data.
@@ -85,17 +134,17 @@ void m1_transport_run(u32 freq) {
  *                   - `ETYPE_OK` on success.
  *                   - Other error codes indicating specific failures.
  */
-etype_e m1_transport_receive(u8* frame_buf, size_t frame_len) {
+etype_e m1_transport_receive(m1_t* m1, u8* frame_buf, size_t frame_len) {
     (void)frame_len; /*!< Frame length is unused here */
     m1_frame_head_t* frame_head =
         (m1_frame_head_t*)frame_buf; /*!< Cast frame buffer to frame header */
 
     if (frame_head->attr.lsb.reliable == M1_RELIABLE_TX) {
         send_ack_to_source_host(
-            frame_head); /*!< Send acknowledgment for reliable packet */
+            m1, frame_head); /*!< Send acknowledgment for reliable packet */
     } else if (frame_head->attr.lsb.reliable == A1_RELIABLE_TX_ACK) {
         process_acknowledgment(
-            frame_head); /*!< Process received acknowledgment */
+            m1, frame_head); /*!< Process received acknowledgment */
     }
 
     size_t rx_data_len =
@@ -107,6 +156,7 @@ etype_e m1_transport_receive(u8* frame_buf, size_t frame_len) {
         .data_len = rx_data_len,
         .data =
             frame_buf + sizeof(m1_frame_head_t), /*!< Extract data pointer */
+        .m1 = m1,
     };
 
     if (frame_head->data_type >= M1_DATA_TYPE_MAX) {
@@ -116,10 +166,10 @@ etype_e m1_transport_receive(u8* frame_buf, size_t frame_len) {
 
     if (rx_data_len) {
         m1_rx_parse_callback_t rx_parse_cb =
-            m1.rx_parse_cb[frame_head->data_type]; /*!< Fetch the parsing
+            m1->rx_parse_cb[frame_head->data_type]; /*!< Fetch the parsing
                                                       callback */
         if (rx_parse_cb) {
-            rx_parse_cb(&rx_data); /*!< Call the parsing callback */
+            dispatch_rx_callback(m1, rx_parse_cb, &rx_data);
         } else {
             return E_STATE_NOT_EXIST; /*!< Return error if callback is not found
                                        */
@@ -136,21 +186,44 @@ etype_e m1_transport_receive(u8* frame_buf, size_t frame_len) {
  * appropriate transport layer structure and sends it to the network layer for
  * further processing.
  *
+ * \param[in]       m1: Pointer to the M1 protocol instance.
  * \param[in]       tx_data: Pointer to the data structure containing
  *                  information about the transmission.
  * \return          Returns an error code of type `etype_e` indicating the
  *                  success or failure of the operation.
  *                   - `ETYPE_OK` on success.
+ *                   - `E_STATE_BUSY` if a reliable transmission has to wait
+ *                     for packets to be acknowledged; nothing was sent.
+ *                   - `E_STATE_ARGUMENT_BIG` if a reliable transmission has
+ *                     more targets than \ref M1_PACKET_POOL_SIZE.
+ *                   - The network layer error if an unreliable transmission
+ *                     could not be sent to every target.
  *                   - Other error codes indicating specific failures.
  */
-etype_e m1_transport_send(m1_tx_data_t* tx_data) {
-    if (!m1.init_ok) {
+etype_e m1_transport_send(m1_t* m1, m1_tx_data_t* tx_data) {
+    return m1_transport_send_frame(m1, tx_data, NULL);
+}
+
+/**
+ * \brief           Sends data whose payload already sits in a frame buffer.
+ *
+ * \param[in]       m1: Pointer to the M1 protocol instance.
+ * \param[in]       tx_data: Pointer to the data structure containing
+ *                  information about the transmission.
+ * \param[in]       frame: Frame buffer holding the payload, or NULL to send
+ *                  `tx_data->data` as \ref m1_transport_send does.
+ * \return          Same as \ref m1_transport_send.
+ */
+etype_e m1_transport_send_frame(m1_t* m1, m1_tx_data_t* tx_data,
+                                m1_buf_t* frame) {
+    if (!m1->init_ok) {
         return E_STATE_NOT_IMPLEMENT; /*!< Return error if transport layer is
                                          not initialized */
     }
 
     m1_packet_t packet = {0}; /*!< Initialize the packet structure */
     m1_packet_data_t packet_data = {
+        .buf = frame,
         .data = tx_data->data,
         .data_len = tx_data->data_len,
     };
@@ -159,7 +232,7 @@ etype_e m1_transport_send(m1_tx_data_t* tx_data) {
     packet.version = tx_data->version;
     packet.source_id = tx_data->source_id
                            ? tx_data->source_id
-                           : m1.source_id[0]; /*!< Assign source ID */
+                           : m1->source_id[0]; /*!< Assign source ID */
     packet.data_type = tx_data->data_type;
     /* Packet attributes */
     packet.reliable_tx = tx_data->reliable_tx;
@@ -168,82 +241,178 @@ etype_e m1_transport_send(m1_tx_data_t* tx_data) {
     packet.priority = tx_data->priority;
     packet.compress = tx_data->compress;
 
-    m1_packet_data_t* ack_data = NULL;
     if (packet.reliable_tx == M1_RELIABLE_TX) {
+        /*! Every target needs a waiting packet: refuse the whole request up
+            front instead of sending to only some of them */
+        if (tx_data->target_id_len > m1_obj_pool_capacity(m1->packet_pool)) {
+            return E_STATE_ARGUMENT_BIG;
+        }
+        if (m1_obj_pool_available(m1->packet_pool) < tx_data->target_id_len) {
+            return E_STATE_BUSY;
+        }
         packet.retry_num = MAX_RETRY_COUNT;
         packet.wait_time_ms = ACK_WAIT_TIME_MS;
-        ack_data = allocate_ack_data(&packet_data);
-        if (!ack_data) {
-            return E_STATE_NO_SPACE;
+        if (!frame) {
+            /*! Retransmissions outlive the caller's buffer */
+            packet_data.buf = allocate_ack_data(&packet_data);
+            if (!packet_data.buf) {
+                return E_STATE_NO_SPACE;
+            }
         }
     }
 
+    u64 send_us = m1->latency ? m1_event_now_us() : 0;
+    etype_e ret = E_STATE_OK;
     for (size_t i = 0; i < tx_data->target_id_len; ++i) {
         packet.target_id = tx_data->target_id[i]; /*!< Assign target ID */
 
         if (packet.reliable_tx == M1_RELIABLE_TX) {
-            for (size_t i = 0; i < m1.route_item_len; ++i) {
-                if (packet.target_id == m1.route_item[i].target_id) {
-                    packet.seq_num = m1.seq_num[i];
-                    break;
-                }
+            int route = m1_network_route_index(m1, packet.target_id);
+            if (route >= 0) {
+                packet.seq_num = m1->seq_num[route];
             }
-            /*! Allocate memory for acknowledgment waiting packet */
-            m1_packet_t* wait_ack_packet =
-                (m1_packet_t*)MemoryPoolAlloc(m1.tx_pool, sizeof(m1_packet_t));
-            if (!wait_ack_packet) {
-                break; /*!< Exit loop if memory allocation fails */
-            }
-            memcpy(wait_ack_packet, &packet, sizeof(m1_packet_t));
-            wait_ack_packet->data = ack_data;
-            ack_data->reference_counter++;
+            /*! Reserved above, cannot fail */
+            m1_wait_ack_packet_t* wait_ack_packet =
+                m1_obj_pool_alloc(m1->packet_pool);
+            wait_ack_packet->packet = packet;
+            wait_ack_packet->packet.data = &wait_ack_packet->data;
+            wait_ack_packet->data = packet_data;
+            wait_ack_packet->send_us = send_us;
+            wait_ack_packet->route = route;
+            m1_buf_ref(packet_data.buf); /*!< Share the payload */
             single_list_append(
-                &m1.wait_ack_packet_head,
-                &wait_ack_packet->node); /*!< Append to waiting list */
+                &m1->wait_ack_packet_head,
+                &wait_ack_packet->packet.node); /*!< Append to waiting list */
         }
 
-        if (m1_network_send(&packet, true) != E_STATE_OK) {
-            // Log or handle send failure.
+        if (tx_data->target_id_len == 1) {
+            ret = m1_network_send(m1, &packet, true);
         }
     }
 
+    /*! Several targets: encode once and patch the header per target */
+    if (tx_data->target_id_len > 1) {
+        ret = m1_network_send_multicast(m1, &packet, tx_data->target_id,
+                                        tx_data->target_id_len, true);
+    }
+
+    if (packet_data.buf != frame) {
+        m1_buf_unref(packet_data.buf); /*!< The waiting packets own it now */
+    }
+    /*! Waiting packets are retransmitted, so only unreliable frames are
+        lost when the network layer fails */
+    return packet.reliable_tx == M1_RELIABLE_TX ? E_STATE_OK : ret;
+}
+
+/**
+ * \brief           Start the workers running the RX callbacks.
+ *
+ * \param[in]       m1: Pointer to the M1 protocol instance.
+ * \param[in]       worker_num: Number of worker threads, at least 1.
+ * \return          `E_STATE_OK` on success, or an error code otherwise.
+ */
+etype_e m1_transport_rx_pool_start(m1_t* m1, size_t worker_num) {
+    if (!M1_USING_PTHREAD) {
+        return E_STATE_NOT_IMPLEMENT;
+    }
+
+    /*! Payloads never exceed the parse cache of their link */
+    size_t data_size = 0;
+    for (size_t i = 0; i < m1->route_item_len; i++) {
+        if (m1->route_item[i].max_pkg_size > data_size) {
+            data_size = m1->route_item[i].max_pkg_size;
+        }
+    }
+
+    m1->rx_job_data_size = data_size;
+    m1->rx_job_pool = m1_obj_pool_create(sizeof(m1_rx_job_t) + data_size,
+                                         M1_RX_JOB_POOL_SIZE);
+    /*! Room for every pooled job, so handing one back never fails */
+    if (m1->rx_job_pool) {
+        m1->rx_job_free =
+            m1_mpsc_queue_create(m1_obj_pool_capacity(m1->rx_job_pool));
+    }
+    m1->rx_pool = m1_work_pool_create(worker_num);
+    if (!m1->rx_job_pool || !m1->rx_job_free || !m1->rx_pool) {
+        m1_transport_rx_pool_stop(m1);
+        return E_STATE_NO_SPACE;
+    }
     return E_STATE_OK;
 }
 
+/**
+ * \brief           Run the dispatched callbacks to completion and stop the
+ *                  workers.
+ *
+ * \param[in]       m1: Pointer to the M1 protocol instance.
+ */
+void m1_transport_rx_pool_stop(m1_t* m1) {
+    m1_work_pool_destroy(m1->rx_pool);
+    m1->rx_pool = NULL;
+    /*! Every job is finished and the pool goes with its objects */
+    m1_mpsc_queue_destroy(m1->rx_job_free);
+    m1->rx_job_free = NULL;
+    m1_obj_pool_destroy(m1->rx_job_pool);
+    m1->rx_job_pool = NULL;
+}
+
+/**
+ * \brief           Drop every packet waiting for an acknowledgment.
+ *
+ * \param[in]       m1: Pointer to the M1 protocol instance.
+ */
+void m1_transport_clear(m1_t* m1) {
+    while (m1->wait_ack_packet_head.next) {
+        handle_wait_ack_packet(m1, m1->wait_ack_packet_head.next);
+    }
+}
+
 /* private functions -------------------------------------------------------- */
 /**
  * \brief           Handle acknowledgment retries for packets in the waiting
  *                  list.
  *
- * \param           freq: Frequency (in Hz) of the function calls, used to
+ * \param[in]       m1: Pointer to the M1 protocol instance.
+ * \param           elapsed_ms: Time elapsed since the previous call, used to
  *                  adjust timeout.
  */
-static void handle_ack_retries(u32 freq) {
-    if (freq == 0) {
-        return; /*!< Do nothing if frequency is zero */
+static void handle_ack_retries(m1_t* m1, u32 elapsed_ms) {
+    if (elapsed_ms == 0) {
+        return; /*!< Do nothing if no time has passed */
     }
 
-    single_list_t* current_node = m1.wait_ack_packet_head.next;
+    single_list_t* current_node = m1->wait_ack_packet_head.next;
     while (current_node) {
         m1_packet_t* packet = single_list_entry(
             current_node, m1_packet_t, node);  /*!< Get packet from node */
-        packet->wait_time_ms -= (1000 / freq); /*!< Adjust wait time */
+        packet->wait_time_ms -= (i32)elapsed_ms; /*!< Adjust wait time */
 
         if (packet->wait_time_ms <= 0) {
+            int route = ((m1_wait_ack_packet_t*)packet)->route;
             if (--packet->retry_num <= 0) {
-                link_warning("retry transport packet: %d timeout.\n",
-                             packet->seq_num); /*!< Log timeout warning */
+                link_info("retry transport packet: %d timeout.\n",
+                          packet->seq_num); /*!< Counted and traced too */
+                if (route >= 0) {
+                    M1_STATS_TX_RETRY_EXHAUSTED(m1, route);
+                }
+                M1_TRACE(m1, M1_TRACE_RETRY_EXHAUSTED, packet->target_id,
+                         packet->seq_num, 0);
                 single_list_t* next_node = current_node->next;
                 /*! Remove node from list */
-                handle_wait_ack_packet(current_node);
+                handle_wait_ack_packet(m1, current_node);
                 current_node = next_node;
                 continue;
             } else {
-                link_warning("wait [0x%02x] ack [%d] timeout, retry[%d].\n",
-                             packet->target_id, packet->seq_num,
-                             packet->retry_num); /*!< Log retry information */
+                link_debug("wait [0x%02x] ack [%d] timeout, retry[%d].\n",
+                           packet->target_id, packet->seq_num,
+                           packet->retry_num); /*!< Log retry information */
                 packet->wait_time_ms = ACK_WAIT_TIME_MS; /*!< Reset wait time */
-                m1_network_send(packet, false); /*!< Retry sending packet */
+                if (route >= 0) {
+                    M1_STATS_TX_RETRANSMIT(m1, route);
+                }
+                M1_TRACE(m1, M1_TRACE_RETRANSMIT, packet->target_id,
+                         packet->seq_num, packet->retry_num);
+                m1_network_send(m1, packet, false); /*!< Retry sending packet */
             }
         }
 
@@ -255,6 +424,7 @@ static void handle_ack_retries(u32 freq) {
  * \brief           Handle a specific packet node in the acknowledgment waiting
  *                  list.
  *
+ * \param[in]       m1: Pointer to the M1 protocol instance.
  * \param           node: Pointer to the node in the acknowledgment waiting
  *                  list.
  * \return          Returns an error code of type `etype_e` indicating the
@@ -264,21 +434,19 @@ static void handle_ack_retries(u32 freq) {
  * \note            Multi-threaded calls are not allowed, and there is no
  *                  resource mutual exclusion protection.
  */
-static etype_e handle_wait_ack_packet(single_list_t* node) {
+static etype_e handle_wait_ack_packet(m1_t* m1, single_list_t* node) {
     m1_packet_t* packet_node = single_list_entry(node, m1_packet_t, node);
     if (!packet_node) {
         link_error("Invalid packet node!");
         return E_STATE_NOT_EXIST; /*!< Return error if node is invalid */
     }
 
-    /*! Free data if reference count reaches zero */
-    if (--packet_node->data->reference_counter == 0) {
-        MemoryPoolFree(m1.tx_pool, packet_node->data);
-    }
+    /*! Drop this packet's share of the payload */
+    m1_buf_unref(packet_node->data->buf);
 
     /*! Remove node from list */
-    single_list_remove(&m1.wait_ack_packet_head, node);
-    MemoryPoolFree(m1.tx_pool, packet_node); /*!< Free packet memory */
+    single_list_remove(&m1->wait_ack_packet_head, node);
+    m1_obj_pool_free(m1->packet_pool, packet_node); /*!< Free packet memory */
 
     return E_STATE_OK; /*!< Return success */
 }
@@ -286,6 +454,7 @@ static etype_e handle_wait_ack_packet(single_list_t* node) {
 /**
  * \brief           Process acknowledgment packets received from other hosts.
  *
+ * \param[in]       m1: Pointer to the M1 protocol instance.
  * \param           frame_head: Pointer to the frame header of the
  *                  acknowledgment packet.
  * \return          Returns an error code of type `etype_e` indicating the
@@ -293,8 +462,8 @@ static etype_e handle_wait_ack_packet(single_list_t* node) {
  *                   - `ETYPE_OK` on success.
  *                   - Other error codes indicating specific failures..
  */
-static etype_e process_acknowledgment(m1_frame_head_t* frame_head) {
-    single_list_t* current_node = m1.wait_ack_packet_head.next;
+static etype_e process_acknowledgment(m1_t* m1, m1_frame_head_t* frame_head) {
+    single_list_t* current_node = m1->wait_ack_packet_head.next;
     while (current_node) {
         m1_packet_t* packet = single_list_entry(
             current_node, m1_packet_t, node); /*!< Get packet from node */
@@ -302,22 +471,43 @@ static etype_e process_acknowledgment(m1_frame_head_t* frame_head) {
             packet->target_id == frame_head->source_id &&
             packet->source_id == frame_head->target_id) {
             link_info(
-                "receiver reliable ack from 0x%02x",
+                "receiver reliable ack from 0x%02x\n",
                 frame_head->source_id); /*!< Log acknowledgment received */
+            M1_TRACE(m1, M1_TRACE_ACK_RX, frame_head->source_id,
+                     frame_head->ack_num, 0);
+            m1_wait_ack_packet_t* wait_ack_packet =
+                (m1_wait_ack_packet_t*)packet;
+            if (wait_ack_packet->route >= 0) {
+                M1_STATS_TX_ACK(m1, wait_ack_packet->route);
+            }
+            if (m1->latency && wait_ack_packet->route >= 0) {
+                m1_latency_record(m1->latency, wait_ack_packet->route,
+                                  M1_LATENCY_ACK_RTT,
+                                  m1_event_now_us() - wait_ack_packet->send_us);
+            }
             return handle_wait_ack_packet(
-                current_node); /*!< Handle acknowledged packet */
+                m1, current_node); /*!< Handle acknowledged packet */
         }
         current_node = current_node->next; /*!< Move to the next node */
     }
 
-    link_warning("ACK for seq_num [%d] not found!",
-                 frame_head->ack_num); /*!< Log missing acknowledgment */
+    link_debug("ACK for seq_num [%d] not found!\n",
+               frame_head->ack_num); /*!< Counted and traced too */
+    M1_TRACE(m1, M1_TRACE_ACK_UNMATCHED, frame_head->source_id,
+             frame_head->ack_num, 0);
+    int route = m1_network_route_index(m1, frame_head->source_id);
+    if (route >= 0) {
+        M1_STATS_TX_ACK_UNMATCHED(m1, route);
+    } else {
+        M1_STATS_NET(m1, ack_no_route_cnt);
+    }
     return E_STATE_ERROR; /*!< Return error if acknowledgment is not found */
 }
 
 /**
  * \brief           Send an acknowledgment packet to the source host.
  *
+ * \param[in]       m1: Pointer to the M1 protocol instance.
  * \param           frame_head: Pointer to the frame header of the received
  *                  packet.
  * \return          Returns an error code of type `etype_e` indicating the
@@ -325,7 +515,7 @@ static etype_e process_acknowledgment(m1_frame_head_t* frame_head) {
  *                   - `ETYPE_OK` on success.
  *                   - Other error codes indicating specific failures.
  */
-static etype_e send_ack_to_source_host(m1_frame_head_t* frame_head) {
+static etype_e send_ack_to_source_host(m1_t* m1, m1_frame_head_t* frame_head) {
     m1_packet_data_t packet_data = {0}; /*!< Initialize packet data */
     m1_packet_t packet = {
         .source_id = frame_head->target_id, /*!< Set source ID to target ID of
@@ -343,32 +533,143 @@ static etype_e send_ack_to_source_host(m1_frame_head_t* frame_head) {
         .data_type = frame_head->data_type,
         .data = &packet_data, /*!< Set data pointer to empty packet data */
     };
-    return m1_network_send(&packet, false);
+    return m1_network_send(m1, &packet, false);
 }
 
 /**
- * \brief           Allocate memory for acknowledgment packet data.
+ * \brief           Copy a caller's payload into a frame buffer.
  *
  * \param           src_data: Pointer to the source packet data.
- * \return          Pointer to the allocated acknowledgment packet data.
+ * \return          The frame buffer holding one reference, or NULL on
+ *                  allocation failure.
  */
-static m1_packet_data_t* allocate_ack_data(m1_packet_data_t* src_data) {
-    /*! Allocate memory for acknowledgment data */
-    m1_packet_data_t* ack_data = (m1_packet_data_t*)MemoryPoolAlloc(
-        m1.tx_pool, sizeof(m1_packet_data_t) + src_data->data_len);
-    if (!ack_data) {
+static m1_buf_t* allocate_ack_data(m1_packet_data_t* src_data) {
+    m1_buf_t* frame = m1_datalink_frame_alloc(src_data->data_len);
+    if (!frame) {
         link_error("Memory allocation failed for ACK data!");
         return NULL; /*!< Return NULL if memory allocation fails */
     }
 
-    ack_data->data =
-        (u8*)ack_data + sizeof(m1_packet_data_t); /*!< Assign data pointer */
-    ack_data->data_len = src_data->data_len;      /*!< Set data length */
-    memcpy(ack_data->data, src_data->data,
-           src_data->data_len);      /*!< Copy data */
-    ack_data->reference_counter = 0; /*!< Initialize reference counter */
+    u8* data = m1_datalink_frame_data(frame);
+    if (src_data->data_len) {
+        memcpy(data, src_data->data, src_data->data_len); /*!< Copy data */
+    }
+    src_data->data = data;
+    return frame;
+}
+
+/**
+ * \brief           Run an RX callback, on the worker pool when one is
+ *                  attached.
+ *
+ * Jobs are keyed by source ID, so frames from one source are delivered in
+ * order while different sources are handled in parallel. Running a callback
+ * here instead would overtake the jobs still queued for its source, so when
+ * no job can be allocated the run loop waits for the workers to hand one
+ * back. With none in flight the payload is dropped, counted in
+ * \ref m1_stats_net_t::rx_job_drop_cnt and traced.
+ *
+ * \param[in]       m1: Pointer to the M1 protocol instance.
+ * \param[in]       cb: Callback registered for the data type.
+ * \param[in]       rx_data: Received data, only valid during this call.
+ */
+static void dispatch_rx_callback(m1_t* m1, m1_rx_parse_callback_t cb,
+                                 m1_rx_data_t* rx_data) {
+    /*! Only frames stamped by the data link layer are measured */
+    int route = m1->rx_stamp_us
+                    ? m1_network_route_index(m1, rx_data->source_id)
+                    : -1;
+    if (!m1->rx_pool) {
+        if (route >= 0) {
+            m1_latency_record(m1->latency, route, M1_LATENCY_RX_CALLBACK,
+                              m1_event_now_us() - m1->rx_stamp_us);
+        }
+        cb(rx_data);
+        return;
+    }
+
+    m1_rx_job_t* job = alloc_rx_job(m1, rx_data->data_len);
+#if M1_USING_PTHREAD
+    /*! Out of memory: hold the run loop back while workers still own pooled
+        jobs they will return */
+    while (!job && m1_obj_pool_available(m1->rx_job_pool) <
+                       m1_obj_pool_capacity(m1->rx_job_pool)) {
+        usleep(M1_RX_QUEUE_RETRY_US);
+        job = alloc_rx_job(m1, rx_data->data_len);
+    }
+#endif /* M1_USING_PTHREAD */
+    if (!job) {
+        M1_STATS_NET(m1, rx_job_drop_cnt);
+        M1_TRACE(m1, M1_TRACE_RX_DROP, rx_data->source_id, rx_data->target_id,
+                 0);
+        return;
+    }
+
+    job->work.fn = run_rx_job;
+    job->cb = cb;
+    job->stamp_us = m1->rx_stamp_us;
+    job->route = route;
+    job->rx_data = *rx_data;
+    job->rx_data.data = job->data;
+    memcpy(job->data, rx_data->data, rx_data->data_len);
+    m1_work_pool_submit(m1->rx_pool, rx_data->source_id, &job->work);
+}
+
+/**
+ * \brief           Get a callback job for a payload.
+ *
+ * Jobs finished by the workers are first returned to the pool; the pool is
+ * only touched by the run loop, the workers hand jobs back through
+ * \ref m1_t::rx_job_free. A job is allocated on demand when the pool is
+ * empty.
+ *
+ * \param[in]       m1: Pointer to the M1 protocol instance.
+ * \param[in]       data_len: Length of the payload to copy into the job.
+ * \return          The job, or NULL on allocation failure.
+ */
+static m1_rx_job_t* alloc_rx_job(m1_t* m1, size_t data_len) {
+    void* done;
+    while ((done = m1_mpsc_queue_pop(m1->rx_job_free)) != NULL) {
+        m1_obj_pool_free(m1->rx_job_pool, done);
+    }
 
-    return ack_data; /*!< Return pointer to allocated acknowledgment data */
+    m1_rx_job_t* job = NULL;
+    if (data_len <= m1->rx_job_data_size) {
+        job = m1_obj_pool_alloc(m1->rx_job_pool);
+    }
+    if (job) {
+        job->pooled = true;
+        return job;
+    }
+    job = m1_malloc(sizeof(m1_rx_job_t) + data_len);
+    if (job) {
+        job->pooled = false;
+    }
+    return job;
+}
+
+/**
+ * \brief           Worker side of \ref dispatch_rx_callback.
+ *
+ * \param[in]       work: Work item embedded in an \ref m1_rx_job_t.
+ */
+static void run_rx_job(m1_work_t* work) {
+    m1_rx_job_t* job = (m1_rx_job_t*)work;
+    m1_t* m1 = job->rx_data.m1;
+    if (job->route >= 0) {
+        m1_latency_record(m1->latency, job->route, M1_LATENCY_RX_CALLBACK,
+                          m1_event_now_us() - job->stamp_us);
+    }
+    job->cb(&job->rx_data);
+    if (!job->pooled) {
+        m1_free(job);
+        return;
+    }
+    /*! Cannot fail: the queue holds as many slots as the pool has jobs, and
+        a pooled job must never reach m1_free */
+    etype_e ret = m1_mpsc_queue_push(m1->rx_job_free, job);
+    assert(ret == E_STATE_OK);
+    (void)ret;
 }
 
 /* ----------------------------- end of file -------------------------------- */
@@ -0,0 +1,408 @@
+/**
+ * \file            m1_metrics.c
+ * \brief           OpenMetrics text exporter for the stack statistics.
+ * \date            2026-10-18
+ */
+
+/*
+ * Copyright (c) 2024 Vector Qiu
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE
+ * AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * This file is part of the m1 protocol library.
+ *
+ * Author:          Vector Qiu <vetor.qiu@gmail.com>
+ * Version:         V0.0.1
+ */
+
+/* includes ----------------------------------------------------------------- */
+#include "./m1_protocol/m1_metrics.h"
+
+#include <inttypes.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include "./m1_protocol/m1_histogram.h"
+#include "./m1_protocol/m1_protocol.h"
+
+/* private typedefs --------------------------------------------------------- */
+/**
+ * \brief           Output cursor. `pos` keeps counting past the end of the
+ *                  buffer so the full length is known.
+ */
+typedef struct m1_metrics_out {
+    char* buf;  /*!< Output buffer. */
+    size_t len; /*!< Size of `buf`. */
+    size_t pos; /*!< Length of the text rendered so far. */
+} m1_metrics_out_t;
+
+/**
+ * \brief           One counter family backed by a `u64` statistics field.
+ */
+typedef struct m1_metrics_counter {
+    const char* name; /*!< Family name, without `_total`. */
+    const char* help; /*!< HELP text. */
+    size_t index;     /*!< Field index, see \ref M1_STATS_INDEX. */
+} m1_metrics_counter_t;
+
+/* private variables -------------------------------------------------------- */
+/*! Families of \ref m1_stats_rx_parse_t */
+static const m1_metrics_counter_t m1_metrics_rx[] = {
+    {"m1_rx_bytes", "Bytes read from the link.",
+     M1_STATS_INDEX(m1_stats_rx_parse_t, total_bytes)},
+    {"m1_rx_not_frame_bytes", "Bytes read that belong to no frame.",
+     M1_STATS_INDEX(m1_stats_rx_parse_t, not_frame_bytes)},
+    {"m1_rx_sof", "Start-of-frame markers found.",
+     M1_STATS_INDEX(m1_stats_rx_parse_t, sof_ok_cnt)},
+    {"m1_rx_crc8_ok", "Frame headers with a valid CRC8.",
+     M1_STATS_INDEX(m1_stats_rx_parse_t, crc8_ok_cnt)},
+    {"m1_rx_crc8_errors", "Frame headers with a bad CRC8.",
+     M1_STATS_INDEX(m1_stats_rx_parse_t, crc8_err_cnt)},
+    {"m1_rx_frames", "Frames with a valid CRC16.",
+     M1_STATS_INDEX(m1_stats_rx_parse_t, crc16_ok_cnt)},
+    {"m1_rx_crc16_errors", "Frames with a bad CRC16.",
+     M1_STATS_INDEX(m1_stats_rx_parse_t, crc16_err_cnt)},
+    {"m1_rx_len_overflows", "Frames longer than the link allows.",
+     M1_STATS_INDEX(m1_stats_rx_parse_t, len_overflow_cnt)},
+    {"m1_rx_queue_full_drops", "Frames dropped on a full RX queue.",
+     M1_STATS_INDEX(m1_stats_rx_parse_t, queue_full_cnt)},
+    {"m1_rx_no_space_drops", "Frames dropped on RX buffer exhaustion.",
+     M1_STATS_INDEX(m1_stats_rx_parse_t, no_space_cnt)},
+};
+
+/*! Families of \ref m1_stats_tx_t */
+static const m1_metrics_counter_t m1_metrics_tx[] = {
+    {"m1_tx_frames", "Frames handed to the TX link.",
+     M1_STATS_INDEX(m1_stats_tx_t, frame_cnt)},
+    {"m1_tx_bytes", "Bytes handed to the TX link.",
+     M1_STATS_INDEX(m1_stats_tx_t, bytes)},
+    {"m1_tx_errors", "Frames the TX link failed to send.",
+     M1_STATS_INDEX(m1_stats_tx_t, tx_err_cnt)},
+    {"m1_tx_no_space_drops", "Frames dropped on TX pool exhaustion.",
+     M1_STATS_INDEX(m1_stats_tx_t, no_space_cnt)},
+    {"m1_tx_retransmits", "Retransmissions of reliable packets.",
+     M1_STATS_INDEX(m1_stats_tx_t, retransmit_cnt)},
+    {"m1_tx_retries_exhausted", "Reliable packets given up unacknowledged.",
+     M1_STATS_INDEX(m1_stats_tx_t, retry_exhausted_cnt)},
+    {"m1_tx_acks", "ACKs that matched a waiting packet.",
+     M1_STATS_INDEX(m1_stats_tx_t, ack_cnt)},
+    {"m1_tx_acks_unmatched", "ACKs that matched no waiting packet.",
+     M1_STATS_INDEX(m1_stats_tx_t, ack_unmatched_cnt)},
+    {"m1_forward_frames", "Frames forwarded to another node.",
+     M1_STATS_INDEX(m1_stats_tx_t, forward_cnt)},
+    {"m1_forward_bytes", "Bytes forwarded to another node.",
+     M1_STATS_INDEX(m1_stats_tx_t, forward_bytes)},
+    {"m1_forward_errors", "Frames the TX link failed to forward.",
+     M1_STATS_INDEX(m1_stats_tx_t, forward_err_cnt)},
+};
+
+/*! Families of \ref m1_stats_net_t */
+static const m1_metrics_counter_t m1_metrics_net[] = {
+    {"m1_tx_no_route", "Frames to send to a target without a route.",
+     M1_STATS_INDEX(m1_stats_net_t, tx_no_route_cnt)},
+    {"m1_forward_no_route", "Frames for another node without a route.",
+     M1_STATS_INDEX(m1_stats_net_t, fwd_no_route_cnt)},
+    {"m1_ack_no_route", "ACKs from a source without a route.",
+     M1_STATS_INDEX(m1_stats_net_t, ack_no_route_cnt)},
+    {"m1_tx_dropped", "Queued submissions the transport layer rejected.",
+     M1_STATS_INDEX(m1_stats_net_t, tx_drop_cnt)},
+    {"m1_rx_callback_dropped",
+     "Received payloads dropped without an RX callback job.",
+     M1_STATS_INDEX(m1_stats_net_t, rx_job_drop_cnt)},
+};
+
+/*! Summary families, indexed by \ref m1_latency_kind_e */
+static const m1_metrics_counter_t m1_metrics_latency[] = {
+    [M1_LATENCY_ACK_RTT] = {"m1_ack_rtt_seconds",
+                            "Time from sending a reliable packet to its ACK.",
+                            M1_LATENCY_ACK_RTT},
+    [M1_LATENCY_RX_CALLBACK] = {"m1_rx_callback_seconds",
+                                "Time from reading a frame to its callback.",
+                                M1_LATENCY_RX_CALLBACK},
+    [M1_LATENCY_TX_QUEUE] = {"m1_tx_queue_seconds",
+                             "Time from m1_protocol_tx_data to sending.",
+                             M1_LATENCY_TX_QUEUE},
+};
+
+/*! Quantiles reported by the summaries, in percent */
+static const double m1_metrics_quantile[] = {50, 90, 99};
+
+/* private functions -------------------------------------------------------- */
+/**
+ * \brief           Append formatted text.
+ *
+ * \param[in]       out: Output cursor.
+ * \param[in]       fmt: printf format.
+ */
+static void m1_metrics_printf(m1_metrics_out_t* out, const char* fmt, ...) {
+    va_list ap;
+    va_start(ap, fmt);
+    char* dst = out->pos < out->len ? out->buf + out->pos : NULL;
+    size_t room = out->pos < out->len ? out->len - out->pos : 0;
+    int n = vsnprintf(dst, room, fmt, ap);
+    va_end(ap);
+    if (n > 0) {
+        out->pos += (size_t)n;
+    }
+}
+
+/**
+ * \brief           Append a label value, escaped as OpenMetrics requires.
+ *
+ * \param[in]       out: Output cursor.
+ * \param[in]       value: Label value, NULL for an empty one.
+ */
+static void m1_metrics_label(m1_metrics_out_t* out, const char* value) {
+    for (; value && *value; value++) {
+        if (*value == '\\' || *value == '"') {
+            m1_metrics_printf(out, "\\%c", *value);
+        } else if (*value == '\n') {
+            m1_metrics_printf(out, "\\n");
+        } else {
+            m1_metrics_printf(out, "%c", *value);
+        }
+    }
+}
+
+/**
+ * \brief           Append the TYPE and HELP lines of a family.
+ *
+ * \param[in]       out: Output cursor.
+ * \param[in]       name: Family name.
+ * \param[in]       type: OpenMetrics type.
+ * \param[in]       help: HELP text.
+ */
+static void m1_metrics_family(m1_metrics_out_t* out, const char* name,
+                              const char* type, const char* help) {
+    m1_metrics_printf(out, "# TYPE %s %s\n# HELP %s %s\n", name, type, name,
+                      help);
+}
+
+/**
+ * \brief           Append the labels of an instance, and of a route if
+ *                  `route` is not NULL, without the closing brace.
+ *
+ * \param[in]       out: Output cursor.
+ * \param[in]       m1: Pointer to the M1 protocol instance.
+ * \param[in]       route: Route to label, or NULL.
+ * \param[in]       target: Also label the target of `route`.
+ */
+static void m1_metrics_labels(m1_metrics_out_t* out, m1_t* m1,
+                              const m1_route_item_t* route, bool target) {
+    m1_metrics_printf(out, "{instance=\"");
+    m1_metrics_label(out, m1->name);
+    m1_metrics_printf(out, "\"");
+    if (route) {
+        m1_metrics_printf(out, ",link=\"");
+        m1_metrics_label(out, route->link_name);
+        m1_metrics_printf(out, "\"");
+        if (target) {
+            m1_metrics_printf(out, ",target=\"0x%02x\"", route->target_id);
+        }
+    }
+}
+
+/**
+ * \brief           Check whether a route is the first one reading its RX
+ *                  link, so every link is exported once.
+ *
+ * \param[in]       m1: Pointer to the M1 protocol instance.
+ * \param[in]       route: Index of the route.
+ * \return          true if the route owns the export of its link.
+ */
+static bool m1_metrics_rx_owner(m1_t* m1, size_t route) {
+    rx_async_t* rx = m1->route_item[route].rx;
+    if (!rx) {
+        return false;
+    }
+    for (size_t i = 0; i < route; i++) {
+        if (m1->route_item[i].rx == rx) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * \brief           Append the RX, TX and network counter families.
+ *
+ * \param[in]       out: Output cursor.
+ * \param[in]       m1: Pointer to the M1 protocol instance.
+ */
+static void m1_metrics_counters(m1_metrics_out_t* out, m1_t* m1) {
+    for (size_t f = 0; f < ARRAY_SIZE(m1_metrics_rx); f++) {
+        const m1_metrics_counter_t* family = &m1_metrics_rx[f];
+        m1_metrics_family(out, family->name, "counter", family->help);
+        for (size_t i = 0; i < m1->route_item_len; i++) {
+            m1_stats_rx_parse_t stats;
+            if (!m1_metrics_rx_owner(m1, i) ||
+                m1_protocol_rx_stats(m1, i, &stats) != E_STATE_OK) {
+                continue;
+            }
+            m1_metrics_printf(out, "%s_total", family->name);
+            m1_metrics_labels(out, m1, &m1->route_item[i], false);
+            m1_metrics_printf(out, "} %" PRIu64 "\n",
+                              ((u64*)&stats)[family->index]);
+        }
+    }
+
+    for (size_t f = 0; f < ARRAY_SIZE(m1_metrics_tx); f++) {
+        const m1_metrics_counter_t* family = &m1_metrics_tx[f];
+        m1_metrics_family(out, family->name, "counter", family->help);
+        for (size_t i = 0; i < m1->route_item_len; i++) {
+            m1_stats_tx_t stats;
+            if (m1_protocol_tx_stats(m1, i, &stats) != E_STATE_OK) {
+                continue;
+            }
+            m1_metrics_printf(out, "%s_total", family->name);
+            m1_metrics_labels(out, m1, &m1->route_item[i], true);
+            m1_metrics_printf(out, "} %" PRIu64 "\n",
+                              ((u64*)&stats)[family->index]);
+        }
+    }
+
+    m1_stats_net_t net;
+    if (m1_protocol_net_stats(m1, &net) == E_STATE_OK) {
+        for (size_t f = 0; f < ARRAY_SIZE(m1_metrics_net); f++) {
+            const m1_metrics_counter_t* family = &m1_metrics_net[f];
+            m1_metrics_family(out, family->name, "counter", family->help);
+            m1_metrics_printf(out, "%s_total", family->name);
+            m1_metrics_labels(out, m1, NULL, false);
+            m1_metrics_printf(out, "} %" PRIu64 "\n",
+                              ((u64*)&net)[family->index]);
+        }
+    }
+}
+
+/**
+ * \brief           Append the latency summaries.
+ *
+ * \param[in]       out: Output cursor.
+ * \param[in]       m1: Pointer to the M1 protocol instance.
+ */
+static void m1_metrics_latencies(m1_metrics_out_t* out, m1_t* m1) {
+    if (!m1->latency) {
+        return;
+    }
+
+    m1_histogram_t* hist = m1_malloc(sizeof(m1_histogram_t));
+    if (!hist) {
+        return;
+    }
+    for (size_t f = 0; f < ARRAY_SIZE(m1_metrics_latency); f++) {
+        const m1_metrics_counter_t* family = &m1_metrics_latency[f];
+        m1_metrics_family(out, family->name, "summary", family->help);
+        for (size_t i = 0; i < m1->route_item_len; i++) {
+            if (m1_protocol_latency_snapshot(m1, i, family->index, hist) !=
+                E_STATE_OK) {
+                continue;
+            }
+            const m1_route_item_t* route = &m1->route_item[i];
+            for (size_t q = 0; q < ARRAY_SIZE(m1_metrics_quantile); q++) {
+                u64 value =
+                    m1_histogram_percentile(hist, m1_metrics_quantile[q]);
+                m1_metrics_printf(out, "%s", family->name);
+                m1_metrics_labels(out, m1, route, true);
+                m1_metrics_printf(out, ",quantile=\"%g\"} %.6f\n",
+                                  m1_metrics_quantile[q] / 100,
+                                  (double)value / 1e6);
+            }
+            m1_metrics_printf(out, "%s_sum", family->name);
+            m1_metrics_labels(out, m1, route, true);
+            m1_metrics_printf(out, "} %.6f\n", (double)hist->sum / 1e6);
+            m1_metrics_printf(out, "%s_count", family->name);
+            m1_metrics_labels(out, m1, route, true);
+            m1_metrics_printf(out, "} %" PRIu64 "\n", hist->count);
+        }
+    }
+    m1_free(hist);
+}
+
+/**
+ * \brief           Append the memory pool gauges and the trace drop count.
+ *
+ * \param[in]       out: Output cursor.
+ * \param[in]       m1: Pointer to the M1 protocol instance.
+ */
+static void m1_metrics_pools(m1_metrics_out_t* out, m1_t* m1) {
+    const struct {
+        const char* name;
+        const char* help;
+        u64 value;
+    } gauge[] = {
+        {"m1_tx_pool_size_bytes", "Bytes reserved by the TX memory pool.",
+         (u64)GetTotalMemory(m1->tx_pool)},
+        {"m1_tx_pool_used_bytes", "Bytes of the TX memory pool in use.",
+         (u64)GetUsedMemory(m1->tx_pool)},
+        {"m1_tx_pool_data_bytes",
+         "Bytes of the TX memory pool handed out, without chunk headers.",
+         (u64)GetProgMemory(m1->tx_pool)},
+        {"m1_packet_pool_free", "Packets free to wait for an ACK.",
+         (u64)m1_obj_pool_available(m1->packet_pool)},
+        {"m1_packet_pool_capacity", "Packets that can wait for an ACK.",
+         (u64)m1_obj_pool_capacity(m1->packet_pool)},
+    };
+    for (size_t i = 0; i < ARRAY_SIZE(gauge); i++) {
+        m1_metrics_family(out, gauge[i].name, "gauge", gauge[i].help);
+        m1_metrics_printf(out, "%s", gauge[i].name);
+        m1_metrics_labels(out, m1, NULL, false);
+        m1_metrics_printf(out, "} %" PRIu64 "\n", gauge[i].value);
+    }
+
+    m1_metrics_family(out, "m1_tx_pool_usage_ratio", "gauge",
+                      "Share of the TX memory pool in use.");
+    m1_metrics_printf(out, "m1_tx_pool_usage_ratio");
+    m1_metrics_labels(out, m1, NULL, false);
+    m1_metrics_printf(out, "} %.6f\n", MemoryPoolGetUsage(m1->tx_pool));
+
+    m1_metrics_family(out, "m1_trace_dropped", "counter",
+                      "Trace records lost on a full trace ring.");
+    m1_metrics_printf(out, "m1_trace_dropped_total");
+    m1_metrics_labels(out, m1, NULL, false);
+    m1_metrics_printf(out, "} %" PRIu64 "\n", m1_trace_dropped(m1->trace));
+}
+
+/* public functions --------------------------------------------------------- */
+/**
+ * \brief           Render every statistic of an instance as OpenMetrics text.
+ *
+ * \param[in]       m1: Pointer to the M1 protocol instance.
+ * \param[out]      buf: Output buffer, NUL-terminated on success.
+ * \param[in]       len: Size of `buf`.
+ * \param[out]      out_len: Length of the text, without the NUL.
+ * \return          `E_STATE_OK` on success, `E_STATE_NO_SPACE` if `buf` is
+ *                  too small, or `E_STATE_INVAL` on invalid arguments.
+ */
+etype_e m1_metrics_render(m1_t* m1, char* buf, size_t len, size_t* out_len) {
+    if (!m1 || !m1->init_ok || (!buf && len) || !out_len) {
+        return E_STATE_INVAL;
+    }
+
+    m1_metrics_out_t out = {buf, len, 0};
+    m1_metrics_counters(&out, m1);
+    m1_metrics_latencies(&out, m1);
+    m1_metrics_pools(&out, m1);
+    m1_metrics_printf(&out, "# EOF\n");
+
+    *out_len = out.pos;
+    return out.pos < len ? E_STATE_OK : E_STATE_NO_SPACE;
+}
+
+/* ----------------------------- end of file -------------------------------- */
@@ -0,0 +1,207 @@
+/**
+ * \file            m1_mpsc_queue.c
+ * \brief           Bounded lock-free multi-producer single-consumer queue.
+ * \date            2026-10-18
+ */
+
+/*
+ * Copyright (c) 2024 Vector Qiu
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE
+ * AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * This file is part of the m1 protocol library.
+ *
+ * Author:          Vector Qiu <vetor.qiu@gmail.com>
+ * Version:         V0.0.1
+ */
+
+/* includes ----------------------------------------------------------------- */
+#include "./m1_protocol/m1_mpsc_queue.h"
+
+#include <stdatomic.h>
+#include <stdint.h>
+#include <string.h>
+#include "./m1_protocol/m1_protocol_def.h"
+
+/* private typedefs --------------------------------------------------------- */
+/**
+ * \brief           One queue slot.
+ *
+ * `seq` equals the slot index when the slot is free for the producer that
+ * claims that index, and index + 1 once the item has been published.
+ */
+typedef struct m1_mpsc_slot {
+    atomic_size_t seq; /*!< Publication sequence of the slot. */
+    void* item;        /*!< Queued item. */
+} m1_mpsc_slot_t;
+
+/**
+ * \brief           Queue state.
+ *
+ * The producer and consumer indices live on separate cache lines so that
+ * producers spinning on `head` do not invalidate the consumer's `tail`.
+ */
+struct m1_mpsc_queue {
+    _Alignas(M1_CACHE_LINE_SIZE) atomic_size_t head; /*!< Next index to claim
+                                                        by a producer. */
+    _Alignas(M1_CACHE_LINE_SIZE) size_t tail; /*!< Next index to pop, only
+                                                 touched by the consumer. */
+    _Alignas(M1_CACHE_LINE_SIZE) size_t mask; /*!< Capacity - 1. */
+    m1_mpsc_slot_t* slot;                     /*!< Slot array. */
+    void* alloc_base; /*!< Address returned by the allocator. */
+};
+
+/* public functions --------------------------------------------------------- */
+/**
+ * \brief           Create a queue.
+ *
+ * \param[in]       capacity: Minimum number of items the queue can hold,
+ *                  rounded up to the next power of two.
+ * \return          Pointer to the queue, or NULL on invalid capacity or
+ *                  allocation failure.
+ */
+m1_mpsc_queue_t* m1_mpsc_queue_create(size_t capacity) {
+    if (capacity == 0 || capacity > (SIZE_MAX >> 2)) {
+        return NULL;
+    }
+
+    size_t size = 1;
+    while (size < capacity) {
+        size <<= 1;
+    }
+
+    void* base = m1_malloc(sizeof(m1_mpsc_queue_t) + M1_CACHE_LINE_SIZE - 1);
+    if (!base) {
+        return NULL;
+    }
+    uintptr_t addr = ((uintptr_t)base + M1_CACHE_LINE_SIZE - 1) &
+                     ~(uintptr_t)(M1_CACHE_LINE_SIZE - 1);
+    m1_mpsc_queue_t* queue = (m1_mpsc_queue_t*)addr;
+    memset(queue, 0, sizeof(m1_mpsc_queue_t));
+    queue->alloc_base = base;
+
+    queue->slot = m1_malloc(sizeof(m1_mpsc_slot_t) * size);
+    if (!queue->slot) {
+        m1_free(base);
+        return NULL;
+    }
+    for (size_t i = 0; i < size; i++) {
+        atomic_init(&queue->slot[i].seq, i);
+        queue->slot[i].item = NULL;
+    }
+
+    atomic_init(&queue->head, 0);
+    queue->tail = 0;
+    queue->mask = size - 1;
+    return queue;
+}
+
+/**
+ * \brief           Destroy a queue. Items still queued are not released.
+ *
+ * \param[in]       queue: Pointer to the queue, may be NULL.
+ */
+void m1_mpsc_queue_destroy(m1_mpsc_queue_t* queue) {
+    if (!queue) {
+        return;
+    }
+    m1_free(queue->slot);
+    m1_free(queue->alloc_base);
+}
+
+/**
+ * \brief           Push an item. Safe to call from any thread.
+ *
+ * \param[in]       queue: Pointer to the queue.
+ * \param[in]       item: Item to enqueue, must not be NULL.
+ * \return          `E_STATE_OK` on success, `E_STATE_BUSY` if the queue is
+ *                  full, or `E_STATE_INVAL` on invalid arguments.
+ */
+etype_e m1_mpsc_queue_push(m1_mpsc_queue_t* queue, void* item) {
+    if (!queue || !item) {
+        return E_STATE_INVAL;
+    }
+
+    m1_mpsc_slot_t* slot;
+    size_t pos = atomic_load_explicit(&queue->head, memory_order_relaxed);
+    for (;;) {
+        slot = &queue->slot[pos & queue->mask];
+        size_t seq = atomic_load_explicit(&slot->seq, memory_order_acquire);
+        intptr_t diff = (intptr_t)seq - (intptr_t)pos;
+        if (diff == 0) {
+            /*! Slot is free for this index, try to claim it */
+            if (atomic_compare_exchange_weak_explicit(
+                    &queue->head, &pos, pos + 1, memory_order_relaxed,
+                    memory_order_relaxed)) {
+                break;
+            }
+        } else if (diff < 0) {
+            /*! The consumer has not released this slot yet: queue is full */
+            return E_STATE_BUSY;
+        } else {
+            /*! Another producer claimed the index first */
+            pos = atomic_load_explicit(&queue->head, memory_order_relaxed);
+        }
+    }
+
+    slot->item = item;
+    atomic_store_explicit(&slot->seq, pos + 1, memory_order_release);
+    return E_STATE_OK;
+}
+
+/**
+ * \brief           Pop the oldest item. Must only be called by the consumer.
+ *
+ * \param[in]       queue: Pointer to the queue.
+ * \return          The item, or NULL if the queue is empty.
+ */
+void* m1_mpsc_queue_pop(m1_mpsc_queue_t* queue) {
+    if (!queue) {
+        return NULL;
+    }
+
+    size_t pos = queue->tail;
+    m1_mpsc_slot_t* slot = &queue->slot[pos & queue->mask];
+    size_t seq = atomic_load_explicit(&slot->seq, memory_order_acquire);
+    if (seq != pos + 1) {
+        return NULL;
+    }
+
+    void* item = slot->item;
+    slot->item = NULL;
+    /*! Hand the slot back to the producer one lap ahead */
+    atomic_store_explicit(&slot->seq, pos + queue->mask + 1,
+                          memory_order_release);
+    queue->tail = pos + 1;
+    return item;
+}
+
+/**
+ * \brief           Get the capacity of a queue.
+ *
+ * \param[in]       queue: Pointer to the queue.
+ * \return          Number of slots in the queue.
+ */
+size_t m1_mpsc_queue_capacity(const m1_mpsc_queue_t* queue) {
+    return queue ? queue->mask + 1 : 0;
+}
+
+/* ----------------------------- end of file -------------------------------- */
@@ -0,0 +1,185 @@
+/**
+ * \file            m1_obj_pool.c
+ * \brief           Fixed-size object pool with an intrusive free list.
+ * \date            2026-10-18
+ */
+
+/*
+ * Copyright (c) 2024 Vector Qiu
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE
+ * AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * This file is part of the m1 protocol library.
+ *
+ * Author:          Vector Qiu <vetor.qiu@gmail.com>
+ * Version:         V0.0.1
+ */
+
+/* includes ----------------------------------------------------------------- */
+#include "./m1_protocol/m1_obj_pool.h"
+
+#include <stddef.h>
+#include <stdint.h>
+
+/* private typedefs --------------------------------------------------------- */
+/**
+ * \brief           Free object, overlaid on the first bytes of the slot.
+ */
+typedef struct m1_obj_free {
+    struct m1_obj_free* next; /*!< Next free object, NULL at the end. */
+} m1_obj_free_t;
+
+/**
+ * \brief           Pool state, followed by the object slots in the same
+ *                  allocation.
+ */
+struct m1_obj_pool {
+    m1_obj_free_t* free_head; /*!< First free object. */
+    size_t free_num;          /*!< Number of objects on the free list. */
+    size_t capacity;          /*!< Number of slots. */
+    size_t slot_size;         /*!< Object size rounded up to the alignment. */
+    u8* slot;                 /*!< First slot. */
+};
+
+/* private define ----------------------------------------------------------- */
+/*! Alignment of every slot, enough for any object type */
+#define M1_OBJ_POOL_ALIGN _Alignof(max_align_t)
+
+/* public functions --------------------------------------------------------- */
+/**
+ * \brief           Create a pool.
+ *
+ * \param[in]       obj_size: Size of one object in bytes.
+ * \param[in]       capacity: Number of objects the pool holds.
+ * \return          Pointer to the pool, or NULL on invalid arguments or
+ *                  allocation failure.
+ */
+m1_obj_pool_t* m1_obj_pool_create(size_t obj_size, size_t capacity) {
+    if (obj_size == 0 || capacity == 0) {
+        return NULL;
+    }
+    if (obj_size < sizeof(m1_obj_free_t)) {
+        obj_size = sizeof(m1_obj_free_t);
+    }
+
+    size_t slot_size = BYTES_ALIGN(obj_size, M1_OBJ_POOL_ALIGN);
+    size_t head_size = BYTES_ALIGN(sizeof(m1_obj_pool_t), M1_OBJ_POOL_ALIGN);
+    if (slot_size < obj_size || capacity > (SIZE_MAX - head_size) / slot_size) {
+        return NULL;
+    }
+
+    m1_obj_pool_t* pool = m1_malloc(head_size + slot_size * capacity);
+    if (!pool) {
+        return NULL;
+    }
+    pool->capacity = capacity;
+    pool->slot_size = slot_size;
+    pool->slot = (u8*)pool + head_size;
+
+    /*! Thread the free list through the slots in address order */
+    m1_obj_free_t* next = NULL;
+    for (size_t i = capacity; i > 0; i--) {
+        m1_obj_free_t* obj = (m1_obj_free_t*)(pool->slot + (i - 1) * slot_size);
+        obj->next = next;
+        next = obj;
+    }
+    pool->free_head = next;
+    pool->free_num = capacity;
+    return pool;
+}
+
+/**
+ * \brief           Destroy a pool together with every object in it.
+ *
+ * \param[in]       pool: Pointer to the pool, may be NULL.
+ */
+void m1_obj_pool_destroy(m1_obj_pool_t* pool) { m1_free(pool); }
+
+/**
+ * \brief           Take an object from a pool.
+ *
+ * \param[in]       pool: Pointer to the pool.
+ * \return          Pointer to an uninitialized object, or NULL if every
+ *                  object is in use.
+ */
+void* m1_obj_pool_alloc(m1_obj_pool_t* pool) {
+    if (!pool || !pool->free_head) {
+        return NULL;
+    }
+
+    m1_obj_free_t* obj = pool->free_head;
+    pool->free_head = obj->next;
+    pool->free_num--;
+    return obj;
+}
+
+/**
+ * \brief           Return an object to the pool it was taken from.
+ *
+ * \param[in]       pool: Pointer to the pool.
+ * \param[in]       obj: Object returned by \ref m1_obj_pool_alloc, may be
+ *                  NULL.
+ * \return          `E_STATE_OK` on success, or `E_STATE_INVAL` if `obj` does
+ *                  not belong to the pool.
+ */
+etype_e m1_obj_pool_free(m1_obj_pool_t* pool, void* obj) {
+    if (!obj) {
+        return E_STATE_OK;
+    }
+    if (!pool) {
+        return E_STATE_INVAL;
+    }
+
+    uintptr_t offset = (uintptr_t)obj - (uintptr_t)pool->slot;
+    if ((uintptr_t)obj < (uintptr_t)pool->slot ||
+        offset >= pool->slot_size * pool->capacity ||
+        offset % pool->slot_size != 0) {
+        return E_STATE_INVAL;
+    }
+
+    m1_obj_free_t* node = (m1_obj_free_t*)obj;
+    node->next = pool->free_head;
+    pool->free_head = node;
+    pool->free_num++;
+    return E_STATE_OK;
+}
+
+/**
+ * \brief           Get the number of objects that can still be allocated.
+ *
+ * \param[in]       pool: Pointer to the pool.
+ * \return          Number of free objects.
+ */
+size_t m1_obj_pool_available(const m1_obj_pool_t* pool) {
+    return pool ? pool->free_num : 0;
+}
+
+/**
+ * \brief           Get the capacity of a pool.
+ *
+ * \param[in]       pool: Pointer to the pool.
+ * \return          Number of objects in the pool.
+ */
+size_t m1_obj_pool_capacity(const m1_obj_pool_t* pool) {
+    return pool ? pool->capacity : 0;
+}
+
+/* ----------------------------- end of file -------------------------------- */
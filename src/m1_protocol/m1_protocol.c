@@ -39,54 +39,128 @@
 #include "./m1_protocol/m1_protocol.h"
 
 #include <string.h>
+#include "./m1_protocol/m1_event.h"
 #include "./m1_protocol/m1_layer_datalink.h"
+#include "./m1_protocol/m1_layer_network.h"
 #include "./m1_protocol/m1_layer_transport.h"
 
-/* public variables --------------------------------------------------------- */
+/* private typedefs --------------------------------------------------------- */
 /**
- * \brief Global instance of the M1 protocol structure.
+ * \brief           A queued transmission.
+ *
+ * The caller's target list is copied behind the header and its payload into
+ * a frame buffer, so the caller may reuse its buffers as soon as
+ * \ref m1_protocol_tx_data returns. That is the only copy of the payload:
+ * frames are encoded around it and retransmissions share it.
  */
-m1_t m1;
+typedef struct m1_tx_request {
+    m1_tx_data_t tx_data; /*!< Copy of the submitted descriptor. */
+    m1_buf_t* frame;      /*!< Frame buffer holding the payload. */
+    u64 submit_us;        /*!< Time of submission, 0 when latencies are not
+                             recorded. */
+    single_list_t node;   /*!< Link in \ref m1_t::tx_pending. */
+    u8 target_id[];       /*!< Target IDs. */
+} m1_tx_request_t;
 
 /* private function prototypes ---------------------------------------------- */
 /**
  * \brief           Append a new RX parse node to the parse list.
  *
+ * \param[in]       m1: Pointer to the M1 protocol instance.
  * \param[in]       route: Pointer to the route item structure.
  * \return          `E_STATE_OK` on success, or an error code otherwise.
  */
-static etype_e append_rx_parse_node(m1_route_item_t* route);
+static etype_e append_rx_parse_node(m1_t* m1, m1_route_item_t* route);
 
 /**
  * \brief           Check if an RX parse node already exists for the specified
  *                  route.
  *
+ * \param[in]       m1: Pointer to the M1 protocol instance.
  * \param[in]       route: Pointer to the route item structure.
  * \return          true if the RX node exists, false otherwise.
  */
-static bool is_rx_node_existed(m1_route_item_t* route);
+static bool is_rx_node_existed(m1_t* m1, m1_route_item_t* route);
+
+/**
+ * \brief           Get the read buffer size of the link of a route.
+ *
+ * \param[in]       route: Pointer to the route item structure.
+ * \return          Buffer size in bytes.
+ */
+static size_t rx_buf_size(const m1_route_item_t* route);
+
+/**
+ * \brief           Allocate a zeroed protocol instance aligned to
+ *                  \ref M1_CACHE_LINE_SIZE.
+ *
+ * \return          Pointer to the instance, or NULL on allocation failure.
+ */
+static m1_t* m1_instance_alloc(void);
+
+/**
+ * \brief           Send every queued transmission.
+ *
+ * \param[in]       m1: Pointer to the M1 protocol instance.
+ */
+static void m1_tx_queue_drain(m1_t* m1);
+
+/**
+ * \brief           Send one queued transmission and release it, unless it
+ *                  has to wait for free packets.
+ *
+ * \param[in]       m1: Pointer to the M1 protocol instance.
+ * \param[in]       request: Pointer to the request.
+ * \return          `E_STATE_BUSY` if the request was kept, otherwise the
+ *                  result of the send.
+ */
+static etype_e m1_tx_request_send(m1_t* m1, m1_tx_request_t* request);
+
+/**
+ * \brief           Advance the transport timers by the monotonic time elapsed
+ *                  since the previous call.
+ *
+ * \param[in]       m1: Pointer to the M1 protocol instance.
+ */
+static void m1_transport_tick(m1_t* m1);
+
+/**
+ * \brief           Release a queued transmission.
+ *
+ * \param[in]       request: Pointer to the request, may be NULL.
+ */
+static void m1_tx_request_free(m1_tx_request_t* request);
+
+/**
+ * \brief           Release every resource owned by a protocol instance,
+ *                  including the instance itself.
+ *
+ * \param[in]       m1: Pointer to the M1 protocol instance.
+ */
+static void m1_instance_free(m1_t* m1);
 
 /* public functions --------------------------------------------------------- */
 /**
  * \brief           Get the current route table.
  *
+ * \param[in]       m1: Pointer to the M1 protocol instance.
  * \param[out]      table: Pointer to store the route table address.
  * \param[out]      len: Pointer to store the route table length.
  * \return          E_STATE_OK on success, or E_STATE_INVAL if inputs are
  *                  invalid.
  */
-etype_e m1_get_route_table(m1_route_item_t** table, size_t* len) {
-    if (!table || !len) {
+etype_e m1_get_route_table(m1_t* m1, m1_route_item_t** table, size_t* len) {
+    if (!m1 || !table || !len) {
         return E_STATE_INVAL;
     }
 
-    *table = m1.route_item;
-    *len = m1.route_item_len;
+    *table = m1->route_item;
+    *len = m1->route_item_len;
     return E_STATE_OK;
 }
 
 /**
- * \brief           Initialize the M1 protocol.
+ * \brief           Initialize an M1 protocol instance.
  *
  * \param[in]       name: Name of the M1 protocol instance.
  * \param[in]       tx_pool_size: Tx memory pool size.
@@ -98,93 +172,249 @@ etype_e m1_get_route_table(m1_route_item_t** table, size_t* len) {
  * \param[in]       rx_cb_len: Number of callbacks in the table.
  * \param[in]       source_id: Pointer to the source device ID.
  * \param[in]       source_id_len: Length of the source device ID.
- * \return          etype_e indicating success or failure of initialization.
+ * \return          Handle of the new instance, or NULL if the arguments are
+ *                  invalid or memory is exhausted.
  */
-etype_e m1_protocol_init(const char name[], size_t tx_pool_size,
-                         m1_route_item_t* route_table, size_t route_len,
-                         m1_rx_parse_callback_item_t* rx_cb_table,
-                         size_t rx_cb_len, u8* source_id,
-                         size_t source_id_len) {
+m1_t* m1_protocol_init(const char name[], size_t tx_pool_size,
+                       m1_route_item_t* route_table, size_t route_len,
+                       m1_rx_parse_callback_item_t* rx_cb_table,
+                       size_t rx_cb_len, u8* source_id, size_t source_id_len) {
     if (!(tx_pool_size && route_table && route_len && rx_cb_table &&
           rx_cb_len && source_id && source_id_len)) {
-        return E_STATE_INVAL;
+        return NULL;
     }
 
-    if (m1.init_ok) {
-        return E_STATE_OK;
+    m1_t* m1 = m1_instance_alloc();
+    if (!m1) {
+        return NULL;
     }
 
-    m1.name = name;
+    m1->name = name;
+    single_list_init(&m1->rx_parse_head);
+    single_list_init(&m1->wait_ack_packet_head);
 
     /* Initialize memory pool */
-    m1.tx_pool_size = tx_pool_size;
-    m1.tx_pool = MemoryPoolInit(m1.tx_pool_size, m1.tx_pool_size);
-    if (!m1.tx_pool) {
-        return E_STATE_NO_SPACE;
+    m1->tx_pool_size = tx_pool_size;
+    m1->tx_pool = MemoryPoolInit(m1->tx_pool_size, m1->tx_pool_size);
+    if (!m1->tx_pool) {
+        goto err;
+    }
+
+    /* Initialize packet pools */
+    m1->packet_pool =
+        m1_obj_pool_create(sizeof(m1_wait_ack_packet_t), M1_PACKET_POOL_SIZE);
+    m1->rx_node_pool =
+        m1_obj_pool_create(sizeof(m1_rx_parse_node_t), route_len);
+    if (!m1->packet_pool || !m1->rx_node_pool) {
+        goto err;
+    }
+
+    /* Initialize TX submission queue */
+    m1->tx_queue = m1_mpsc_queue_create(M1_TX_QUEUE_SIZE);
+    if (!m1->tx_queue) {
+        goto err;
     }
 
     /* Initialize route table */
-    m1.route_item = route_table;
-    m1.route_item_len = route_len;
+    m1->route_item = route_table;
+    m1->route_item_len = route_len;
 
     /* Initialize RX parse callbacks */
     for (size_t i = 0; i < rx_cb_len; i++) {
-        m1.rx_parse_cb[rx_cb_table[i].data_type] = rx_cb_table[i].cb;
+        m1->rx_parse_cb[rx_cb_table[i].data_type] = rx_cb_table[i].cb;
     }
 
     /* Copy source ID */
-    m1.source_id = m1_malloc(source_id_len);
-    if (!m1.source_id) {
-        return E_STATE_NO_SPACE;
+    m1->source_id = m1_malloc(source_id_len);
+    if (!m1->source_id) {
+        goto err;
     }
-    memcpy(m1.source_id, source_id, source_id_len);
-    m1.source_id_len = source_id_len;
+    memcpy(m1->source_id, source_id, source_id_len);
+    m1->source_id_len = source_id_len;
 
     /* Initialize RX parse node list */
-    single_list_init(&m1.rx_parse_head);
-    for (size_t i = 0; i < m1.route_item_len; i++) {
-        if (m1.route_item[i].rx && !is_rx_node_existed(&m1.route_item[i])) {
-            etype_e result = append_rx_parse_node(&m1.route_item[i]);
-            if (result != E_STATE_OK) {
-                return result;
+    for (size_t i = 0; i < m1->route_item_len; i++) {
+        m1_route_item_t* route = &m1->route_item[i];
+        if (route->rx && !is_rx_node_existed(m1, route)) {
+            if (append_rx_parse_node(m1, route) != E_STATE_OK) {
+                goto err;
             }
         }
     }
 
-    /* Initialize data link layer RX buffer */
-    m1.datalink_rx_buf_len = 128;
-    m1.datalink_rx_buf = m1_malloc(sizeof(u8) * m1.datalink_rx_buf_len);
-    if (!m1.datalink_rx_buf) {
-        return E_STATE_NO_SPACE;
+    /* Initialize sequence numbers */
+    m1->seq_num = m1_malloc(sizeof(u8) * m1->route_item_len);
+    if (!m1->seq_num) {
+        goto err;
     }
+    memset(m1->seq_num, 0, sizeof(u8) * m1->route_item_len);
 
-    /* Initialize sequence numbers */
-    m1.seq_num = m1_malloc(sizeof(u8) * m1.route_item_len);
-    if (!m1.seq_num) {
-        return E_STATE_NO_SPACE;
+    /* Initialize transmit statistics */
+    m1->tx_stats = m1_counter_create(M1_STATS_NUM(m1_stats_tx_t) *
+                                     m1->route_item_len);
+    m1->net_stats = m1_counter_create(M1_STATS_NUM(m1_stats_net_t));
+    if (!m1->tx_stats || !m1->net_stats) {
+        goto err;
+    }
+
+    /* Initialize event loop */
+    if (m1_event_init(m1) != E_STATE_OK) {
+        goto err;
     }
-    memset(m1.seq_num, 0, sizeof(u8) * m1.route_item_len);
 
-    /* Initialize wait ACK packet list */
-    single_list_init(&m1.wait_ack_packet_head);
+#if M1_LATENCY_STATS
+    /* Initialize latency histograms */
+    m1->latency = m1_latency_create(m1->route_item_len);
+    if (!m1->latency) {
+        goto err;
+    }
+#endif /* M1_LATENCY_STATS */
+
+#if M1_TRACE_SIZE
+    /* Initialize trace ring */
+    m1->trace = m1_trace_create(M1_TRACE_SIZE);
+    if (!m1->trace) {
+        goto err;
+    }
+#endif /* M1_TRACE_SIZE */
+
+    m1->init_ok = true;
+
+    return m1;
+
+err:
+    m1_instance_free(m1);
+    return NULL;
+}
 
-    m1.init_ok = true;
+/**
+ * \brief           Release an M1 protocol instance.
+ *
+ * Packets still waiting for an acknowledgment are dropped. The instance must
+ * no longer be run from any thread.
+ *
+ * \param[in]       m1: Pointer to the M1 protocol instance, may be NULL.
+ */
+void m1_protocol_deinit(m1_t* m1) {
+    if (!m1) {
+        return;
+    }
+    m1_instance_free(m1);
+}
 
+/**
+ * \brief           Switch an instance to threaded RX.
+ *
+ * Every RX link gets its own reader thread running the frame parser, and RX
+ * callbacks are executed by a pool of `worker_num` work-stealing threads
+ * instead of the thread calling \ref m1_protocol_run. Frames from the same
+ * source are delivered to the callbacks in order.
+ *
+ * \param[in]       m1: Pointer to the M1 protocol instance.
+ * \param[in]       worker_num: Number of callback workers, 0 keeps the
+ *                  callbacks on the run loop.
+ * \return          `E_STATE_OK` on success, or an error code otherwise.
+ */
+etype_e m1_protocol_rx_thread_start(m1_t* m1, size_t worker_num) {
+    if (!m1 || !m1->init_ok) {
+        return E_STATE_INVAL;
+    }
+    if (m1->rx_reader || m1->rx_pool) {
+        return E_STATE_REPEATED;
+    }
+
+    etype_e ret = E_STATE_OK;
+    if (worker_num) {
+        ret = m1_transport_rx_pool_start(m1, worker_num);
+        if (ret != E_STATE_OK) {
+            return ret;
+        }
+    }
+
+    ret = m1_datalink_rx_thread_start(m1);
+    if (ret != E_STATE_OK) {
+        m1_transport_rx_pool_stop(m1);
+        return ret;
+    }
+    /*! The readers own the links now, \ref m1_protocol_run_wait only waits
+        for the frames they queue */
+    m1_event_watch_links(m1, false);
     return E_STATE_OK;
 }
 
+/**
+ * \brief           Stop the threads started by
+ *                  \ref m1_protocol_rx_thread_start.
+ *
+ * Callbacks already dispatched are run to completion before returning. The
+ * links are polled by \ref m1_protocol_run again afterwards.
+ *
+ * \param[in]       m1: Pointer to the M1 protocol instance.
+ */
+void m1_protocol_rx_thread_stop(m1_t* m1) {
+    if (!m1) {
+        return;
+    }
+    m1_datalink_rx_thread_stop(m1);
+    m1_transport_rx_pool_stop(m1);
+    m1_event_watch_links(m1, true);
+}
+
 /**
  * \brief           Transmit data using the M1 protocol.
  *
+ * The request is copied into the instance's lock-free submission queue and
+ * sent by the next \ref m1_protocol_run, so this function may be called from
+ * any number of threads, including from RX callbacks.
+ *
+ * \param[in]       m1: Pointer to the M1 protocol instance.
  * \param[in]       tx_data: Pointer to the structure containing data to be
  *                  transmitted.
- * \return          etype_e indicating success or failure of the transmission.
+ * \return          `E_STATE_OK` once queued, `E_STATE_BUSY` if the queue is
+ *                  full, `E_STATE_NO_SPACE` on allocation failure,
+ *                  `E_STATE_ARGUMENT_BIG` if a reliable transmission has more
+ *                  targets than \ref M1_PACKET_POOL_SIZE, or `E_STATE_INVAL`
+ *                  on invalid arguments.
  */
-etype_e m1_protocol_tx_data(m1_tx_data_t* tx_data) {
-    if (!tx_data) {
+etype_e m1_protocol_tx_data(m1_t* m1, m1_tx_data_t* tx_data) {
+    if (!m1 || !m1->init_ok || !tx_data || !tx_data->target_id_len ||
+        !tx_data->target_id || (tx_data->data_len && !tx_data->data)) {
         return E_STATE_INVAL;
     }
-    return m1_transport_send(tx_data);
+    /*! Could never get enough packets to wait for its ACKs */
+    if (tx_data->reliable_tx == M1_RELIABLE_TX &&
+        tx_data->target_id_len > m1_obj_pool_capacity(m1->packet_pool)) {
+        return E_STATE_ARGUMENT_BIG;
+    }
+
+    m1_tx_request_t* request =
+        m1_malloc(sizeof(m1_tx_request_t) + tx_data->target_id_len);
+    if (!request) {
+        return E_STATE_NO_SPACE;
+    }
+    request->frame = m1_datalink_frame_alloc(tx_data->data_len);
+    if (!request->frame) {
+        m1_free(request);
+        return E_STATE_NO_SPACE;
+    }
+
+    request->submit_us = m1->latency ? m1_event_now_us() : 0;
+    request->tx_data = *tx_data;
+    request->tx_data.target_id = request->target_id;
+    request->tx_data.data = m1_datalink_frame_data(request->frame);
+    memcpy(request->tx_data.target_id, tx_data->target_id,
+           tx_data->target_id_len);
+    if (tx_data->data_len) {
+        memcpy(request->tx_data.data, tx_data->data, tx_data->data_len);
+    }
+
+    etype_e ret = m1_mpsc_queue_push(m1->tx_queue, request);
+    if (ret != E_STATE_OK) {
+        m1_tx_request_free(request);
+        return ret;
+    }
+    m1_event_wake(m1);
+    return E_STATE_OK;
 }
 
 /**
@@ -193,51 +423,284 @@ etype_e m1_protocol_tx_data(m1_tx_data_t* tx_data) {
  * This function should be called regularly to handle time-dependent tasks such
  * as retransmissions, acknowledgments, and other protocol-specific processes.
  *
+ * \param[in]       m1: Pointer to the M1 protocol instance.
  * \param[in]       freq: Frequency of execution in Hz.
  */
-void m1_protocol_run(u32 freq) {
-    m1_datalink_receive(freq);
-    m1_transport_run(freq);
+void m1_protocol_run(m1_t* m1, u32 freq) {
+    if (!m1 || !m1->init_ok) {
+        return;
+    }
+    m1_tx_queue_drain(m1);
+    m1_datalink_receive(m1, freq);
+    /*! Send replies queued by RX callbacks without waiting a full period */
+    m1_tx_queue_drain(m1);
+    m1_transport_run(m1, freq ? 1000 / freq : 0);
+    /*! ACKs and retransmissions */
+    m1_datalink_flush(m1);
+}
+
+/**
+ * \brief           Run the M1 protocol from an event loop.
+ *
+ * Instead of being called at a fixed frequency, this function blocks until
+ * one of the following happens, then performs the work of
+ * \ref m1_protocol_run:
+ *   - a link whose driver provides `get_fd` becomes readable,
+ *   - a transmission is queued by \ref m1_protocol_tx_data,
+ *   - a reader thread queues a frame (threaded RX),
+ *   - the next retransmission of an unacknowledged packet is due,
+ *   - the read period of a link without a descriptor elapses,
+ *   - `timeout_ms` expires.
+ *
+ * Retransmission timers use the monotonic clock, so the call rate does not
+ * affect them. Call it in a loop from the thread that owns the instance.
+ *
+ * \param[in]       m1: Pointer to the M1 protocol instance.
+ * \param[in]       timeout_ms: Maximum time to block in milliseconds, -1 to
+ *                  block until there is work.
+ * \return          `E_STATE_OK` on success, `E_STATE_INVAL` on invalid
+ *                  arguments, `E_STATE_ERROR` if waiting failed, or
+ *                  `E_STATE_NOT_IMPLEMENT` without \ref M1_USING_EPOLL.
+ */
+etype_e m1_protocol_run_wait(m1_t* m1, i32 timeout_ms) {
+    if (!m1 || !m1->init_ok) {
+        return E_STATE_INVAL;
+    }
+
+    /*! Account for the time spent outside this function first, so packets
+        sent below start their ACK timer from now */
+    m1_transport_tick(m1);
+    m1_tx_queue_drain(m1);
+
+    i32 retry_ms = m1_transport_next_timeout(m1);
+    if (retry_ms >= 0 && (timeout_ms < 0 || retry_ms < timeout_ms)) {
+        timeout_ms = retry_ms;
+    }
+    etype_e ret = m1_event_wait(m1, timeout_ms);
+    if (ret != E_STATE_OK) {
+        return ret;
+    }
+
+    if (m1->rx_reader) {
+        /*! Route the frames queued by the reader threads */
+        m1_datalink_receive(m1, 0);
+    }
+    m1_tx_queue_drain(m1);
+    m1_transport_tick(m1);
+    /*! ACKs and retransmissions */
+    m1_datalink_flush(m1);
+    return E_STATE_OK;
+}
+
+/**
+ * \brief           Copy one latency histogram of a route.
+ *
+ * \param[in]       m1: Pointer to the M1 protocol instance.
+ * \param[in]       route: Index of the route in the route table.
+ * \param[in]       kind: Measured latency.
+ * \param[out]      hist: Receives the histogram, in microseconds.
+ * \return          `E_STATE_OK` on success, `E_STATE_INVAL` on invalid
+ *                  arguments, or `E_STATE_NOT_IMPLEMENT` without
+ *                  \ref M1_LATENCY_STATS.
+ */
+etype_e m1_protocol_latency_snapshot(m1_t* m1, size_t route,
+                                     m1_latency_kind_e kind,
+                                     m1_histogram_t* hist) {
+    if (!m1 || !m1->init_ok) {
+        return E_STATE_INVAL;
+    }
+    if (!m1->latency) {
+        return E_STATE_NOT_IMPLEMENT;
+    }
+    return m1_latency_snapshot(m1->latency, route, kind, hist);
+}
+
+/**
+ * \brief           Empty the latency histograms of every route.
+ *
+ * \param[in]       m1: Pointer to the M1 protocol instance.
+ */
+void m1_protocol_latency_reset(m1_t* m1) {
+    if (!m1) {
+        return;
+    }
+    m1_latency_reset(m1->latency);
+}
+
+/**
+ * \brief           Copy the transmit statistics of a route.
+ *
+ * \param[in]       m1: Pointer to the M1 protocol instance.
+ * \param[in]       route: Index of the route in the route table.
+ * \param[out]      stats: Receives the statistics.
+ * \return          `E_STATE_OK` on success, or `E_STATE_INVAL` on invalid
+ *                  arguments.
+ */
+etype_e m1_protocol_tx_stats(m1_t* m1, size_t route, m1_stats_tx_t* stats) {
+    if (!m1 || !m1->init_ok || !stats || route >= m1->route_item_len) {
+        return E_STATE_INVAL;
+    }
+    return m1_counter_snapshot(m1->tx_stats,
+                               route * M1_STATS_NUM(m1_stats_tx_t),
+                               (u64*)stats, M1_STATS_NUM(m1_stats_tx_t));
+}
+
+/**
+ * \brief           Copy the network statistics that belong to no route.
+ *
+ * \param[in]       m1: Pointer to the M1 protocol instance.
+ * \param[out]      stats: Receives the statistics.
+ * \return          `E_STATE_OK` on success, or `E_STATE_INVAL` on invalid
+ *                  arguments.
+ */
+etype_e m1_protocol_net_stats(m1_t* m1, m1_stats_net_t* stats) {
+    if (!m1 || !m1->init_ok || !stats) {
+        return E_STATE_INVAL;
+    }
+    return m1_counter_snapshot(m1->net_stats, 0, (u64*)stats,
+                               M1_STATS_NUM(m1_stats_net_t));
+}
+
+/**
+ * \brief           Copy the RX parse statistics of the link of a route.
+ *
+ * \param[in]       m1: Pointer to the M1 protocol instance.
+ * \param[in]       route: Index of the route in the route table.
+ * \param[out]      stats: Receives the statistics.
+ * \return          `E_STATE_OK` on success, `E_STATE_INVAL` on invalid
+ *                  arguments, or `E_STATE_NOT_EXIST` if the route has no RX
+ *                  link.
+ */
+etype_e m1_protocol_rx_stats(m1_t* m1, size_t route,
+                             m1_stats_rx_parse_t* stats) {
+    if (!m1 || !m1->init_ok || !stats || route >= m1->route_item_len) {
+        return E_STATE_INVAL;
+    }
+    rx_async_t* rx = m1->route_item[route].rx;
+    single_list_t* rx_parse_node = m1->rx_parse_head.next;
+    while (rx && rx_parse_node) {
+        m1_rx_parse_node_t* ops =
+            single_list_entry(rx_parse_node, m1_rx_parse_node_t, node);
+        if (ops->item.rx == rx) {
+            return m1_counter_snapshot(ops->stats, 0, (u64*)stats,
+                                       M1_STATS_NUM(m1_stats_rx_parse_t));
+        }
+        rx_parse_node = rx_parse_node->next;
+    }
+    return E_STATE_NOT_EXIST;
+}
+
+/**
+ * \brief           Take the oldest records off the trace ring.
+ *
+ * \param[in]       m1: Pointer to the M1 protocol instance.
+ * \param[out]      record: Receives up to `record_num` records.
+ * \param[in]       record_num: Capacity of `record`.
+ * \return          Number of records taken, 0 without \ref M1_TRACE_SIZE.
+ */
+size_t m1_protocol_trace_drain(m1_t* m1, m1_trace_record_t* record,
+                               size_t record_num) {
+    if (!m1 || !m1->init_ok) {
+        return 0;
+    }
+    return m1_trace_drain(m1->trace, record, record_num);
 }
 
 /* private functions -------------------------------------------------------- */
 /**
  * \brief           Append a new RX parse node for a given route.
  *
+ * \param[in]       m1: Pointer to the M1 protocol instance.
  * \param[in]       route: Pointer to the route item.
  * \return          `E_STATE_OK` on success, or E_STATE_NO_SPACE on allocation
  *                  failure.
  */
-static etype_e append_rx_parse_node(m1_route_item_t* route) {
-    m1_rx_parse_node_t* rx_parse_node = m1_malloc(sizeof(m1_rx_parse_node_t));
+static etype_e append_rx_parse_node(m1_t* m1, m1_route_item_t* route) {
+    m1_rx_parse_node_t* rx_parse_node = m1_obj_pool_alloc(m1->rx_node_pool);
     if (!rx_parse_node) {
         return E_STATE_NO_SPACE;
     }
 
     memset(rx_parse_node, 0, sizeof(m1_rx_parse_node_t));
+    rx_parse_node->stats = m1_counter_create(M1_STATS_NUM(m1_stats_rx_parse_t));
+    if (!rx_parse_node->stats) {
+        m1_obj_pool_free(m1->rx_node_pool, rx_parse_node);
+        return E_STATE_NO_SPACE;
+    }
     rx_parse_node->item.parse.cache_len = BYTES_ALIGN(route->max_pkg_size, 4);
     rx_parse_node->item.parse.cache =
         m1_malloc(rx_parse_node->item.parse.cache_len);
     if (!rx_parse_node->item.parse.cache) {
-        m1_free(rx_parse_node);
+        m1_counter_destroy(rx_parse_node->stats);
+        m1_obj_pool_free(m1->rx_node_pool, rx_parse_node);
         return E_STATE_NO_SPACE;
     }
 
     rx_parse_node->item.rx = route->rx;
     rx_parse_node->item.read_freq = route->read_freq;
-    single_list_append(&m1.rx_parse_head, &rx_parse_node->node);
+    rx_parse_node->item.link_type = route->link_type;
+    /*! Bytes of ring-fed links are parsed inside the driver's ring */
+    if (!route->rx->ring) {
+        rx_parse_node->item.rx_buf_len = rx_buf_size(route);
+        rx_parse_node->item.rx_buf =
+            m1_malloc(rx_parse_node->item.rx_buf_len);
+        if (!rx_parse_node->item.rx_buf) {
+            m1_free(rx_parse_node->item.parse.cache);
+            m1_counter_destroy(rx_parse_node->stats);
+            m1_obj_pool_free(m1->rx_node_pool, rx_parse_node);
+            return E_STATE_NO_SPACE;
+        }
+    }
+    single_list_append(&m1->rx_parse_head, &rx_parse_node->node);
 
     return E_STATE_OK;
 }
 
+/**
+ * \brief           Get the read buffer size of the link of a route.
+ *
+ * An explicit `rx_buf_size` wins. Datagram links otherwise get
+ * \ref M1_DGRAM_RX_BUF_SIZE whatever their rate, as a buffer sized for the
+ * byte rate would hold a single, possibly truncated, datagram. Other links
+ * with a known rate get room for \ref M1_RX_BUF_POLL_MARGIN poll periods of
+ * traffic, rounded up to a power of two and clamped to
+ * [\ref M1_RX_BUF_MIN_SIZE, \ref M1_RX_BUF_MAX_SIZE]; e.g. 2 Mbaud
+ * (200 kB/s) polled at 1 kHz gets 512 bytes.
+ *
+ * \param[in]       route: Pointer to the route item.
+ * \return          Buffer size in bytes.
+ */
+static size_t rx_buf_size(const m1_route_item_t* route) {
+    if (route->rx_buf_size) {
+        return route->rx_buf_size;
+    }
+    if (M1_LINK_TYPE_IS_DGRAM(route->link_type)) {
+        return M1_DGRAM_RX_BUF_SIZE;
+    }
+    if (!route->link_rate) {
+        return M1_LINK_TYPE_IS_SOCKET_STREAM(route->link_type)
+                   ? M1_STREAM_RX_BUF_SIZE
+                   : M1_RX_BUF_MIN_SIZE;
+    }
+
+    u16 read_freq = route->read_freq ? route->read_freq : 1;
+    u64 want = (u64)route->link_rate * M1_RX_BUF_POLL_MARGIN / read_freq;
+    size_t size = M1_RX_BUF_MIN_SIZE;
+    while (size < want && size < M1_RX_BUF_MAX_SIZE) {
+        size <<= 1;
+    }
+    return size < M1_RX_BUF_MAX_SIZE ? size : M1_RX_BUF_MAX_SIZE;
+}
+
 /**
  * \brief           Check if an RX node already exists for a given route.
  *
+ * \param[in]       m1: Pointer to the M1 protocol instance.
  * \param[in]       route: Pointer to the route item.
  * \return          true if an RX node exists, false otherwise.
  */
-static bool is_rx_node_existed(m1_route_item_t* route) {
-    single_list_t* rx_parse_node = m1.rx_parse_head.next;
+static bool is_rx_node_existed(m1_t* m1, m1_route_item_t* route) {
+    single_list_t* rx_parse_node = m1->rx_parse_head.next;
     while (rx_parse_node) {
         m1_rx_parse_node_t* ops =
             single_list_entry(rx_parse_node, m1_rx_parse_node_t, node);
@@ -249,4 +712,181 @@ static bool is_rx_node_existed(m1_route_item_t* route) {
     return false;
 }
 
+/**
+ * \brief           Allocate a zeroed protocol instance aligned to
+ *                  \ref M1_CACHE_LINE_SIZE.
+ *
+ * \return          Pointer to the instance, or NULL on allocation failure.
+ */
+static m1_t* m1_instance_alloc(void) {
+    size_t size = BYTES_ALIGN(sizeof(m1_t), M1_CACHE_LINE_SIZE);
+    void* base = m1_malloc(size + M1_CACHE_LINE_SIZE - 1);
+    if (!base) {
+        return NULL;
+    }
+
+    uintptr_t addr = ((uintptr_t)base + M1_CACHE_LINE_SIZE - 1) &
+                     ~(uintptr_t)(M1_CACHE_LINE_SIZE - 1);
+    m1_t* m1 = (m1_t*)addr;
+    memset(m1, 0, size);
+    m1->alloc_base = base;
+    return m1;
+}
+
+/**
+ * \brief           Send every queued transmission.
+ *
+ * A reliable request that finds too few free packets is parked in
+ * \ref m1_t::tx_pending until ACKs or timeouts give some back; reliable
+ * requests behind it are parked too, so they keep their order. Unreliable
+ * requests never wait for packets and are sent right away. Once
+ * \ref M1_TX_QUEUE_SIZE requests are parked, the submission queue is left
+ * to fill and \ref m1_protocol_tx_data reports `E_STATE_BUSY`.
+ *
+ * \param[in]       m1: Pointer to the M1 protocol instance.
+ */
+static void m1_tx_queue_drain(m1_t* m1) {
+    bool sent = false;
+    single_list_t* node;
+    while ((node = single_list_ex_first(&m1->tx_pending)) != NULL) {
+        m1_tx_request_t* request =
+            single_list_entry(node, m1_tx_request_t, node);
+        single_list_ex_remove(&m1->tx_pending, node);
+        if (m1_tx_request_send(m1, request) == E_STATE_BUSY) {
+            single_list_ex_insert(&m1->tx_pending, node);
+            break;
+        }
+        m1->tx_pending_num--;
+        sent = true;
+    }
+
+    m1_tx_request_t* request;
+    while (m1->tx_pending_num < M1_TX_QUEUE_SIZE &&
+           (request = m1_mpsc_queue_pop(m1->tx_queue)) != NULL) {
+        /*! Reliable requests queue up behind parked ones to keep order */
+        bool wait = request->tx_data.reliable_tx == M1_RELIABLE_TX &&
+                    m1->tx_pending_num;
+        if (wait || m1_tx_request_send(m1, request) == E_STATE_BUSY) {
+            single_list_ex_append(&m1->tx_pending, &request->node);
+            m1->tx_pending_num++;
+            continue;
+        }
+        sent = true;
+    }
+    if (sent) {
+        m1_datalink_flush(m1);
+    }
+}
+
+/**
+ * \brief           Send one queued transmission and release it, unless it
+ *                  has to wait for free packets.
+ *
+ * A request the transport layer rejects for any other reason is dropped,
+ * counted in \ref m1_stats_net_t::tx_drop_cnt and traced.
+ *
+ * \param[in]       m1: Pointer to the M1 protocol instance.
+ * \param[in]       request: Pointer to the request.
+ * \return          `E_STATE_BUSY` if the request was kept, otherwise the
+ *                  result of the send.
+ */
+static etype_e m1_tx_request_send(m1_t* m1, m1_tx_request_t* request) {
+    u64 now_us = request->submit_us ? m1_event_now_us() : 0;
+    etype_e ret =
+        m1_transport_send_frame(m1, &request->tx_data, request->frame);
+    if (ret == E_STATE_BUSY) {
+        return ret;
+    }
+
+    if (ret != E_STATE_OK) {
+        M1_STATS_NET(m1, tx_drop_cnt);
+        M1_TRACE(m1, M1_TRACE_TX_DROP, request->target_id[0],
+                 request->tx_data.target_id_len, ret);
+        now_us = 0;
+    }
+    for (size_t i = 0; now_us && i < request->tx_data.target_id_len; i++) {
+        int route = m1_network_route_index(m1, request->target_id[i]);
+        if (route >= 0) {
+            m1_latency_record(m1->latency, route, M1_LATENCY_TX_QUEUE,
+                              now_us - request->submit_us);
+        }
+    }
+    m1_tx_request_free(request);
+    return ret;
+}
+
+/**
+ * \brief           Advance the transport timers by the monotonic time elapsed
+ *                  since the previous call.
+ *
+ * \param[in]       m1: Pointer to the M1 protocol instance.
+ */
+static void m1_transport_tick(m1_t* m1) {
+    u64 now_ms = m1_event_now_ms();
+    u64 elapsed_ms = m1->last_run_ms ? now_ms - m1->last_run_ms : 0;
+    m1->last_run_ms = now_ms;
+    m1_transport_run(m1, (u32)elapsed_ms);
+}
+
+/**
+ * \brief           Release a queued transmission.
+ *
+ * \param[in]       request: Pointer to the request, may be NULL.
+ */
+static void m1_tx_request_free(m1_tx_request_t* request) {
+    if (!request) {
+        return;
+    }
+    m1_buf_unref(request->frame);
+    m1_free(request);
+}
+
+/**
+ * \brief           Release every resource owned by a protocol instance,
+ *                  including the instance itself.
+ *
+ * \param[in]       m1: Pointer to the M1 protocol instance.
+ */
+static void m1_instance_free(m1_t* m1) {
+    m1_protocol_rx_thread_stop(m1);
+    m1_event_deinit(m1);
+
+    single_list_t* node;
+    while ((node = single_list_ex_first(&m1->tx_pending)) != NULL) {
+        single_list_ex_remove(&m1->tx_pending, node);
+        m1_tx_request_free(single_list_entry(node, m1_tx_request_t, node));
+    }
+    if (m1->tx_queue) {
+        m1_tx_request_t* request;
+        while ((request = m1_mpsc_queue_pop(m1->tx_queue)) != NULL) {
+            m1_tx_request_free(request);
+        }
+        m1_mpsc_queue_destroy(m1->tx_queue);
+    }
+
+    single_list_t* rx_parse_node = m1->rx_parse_head.next;
+    while (rx_parse_node) {
+        m1_rx_parse_node_t* ops =
+            single_list_entry(rx_parse_node, m1_rx_parse_node_t, node);
+        rx_parse_node = rx_parse_node->next;
+        m1_free(ops->item.parse.cache);
+        m1_free(ops->item.rx_buf);
+        m1_counter_destroy(ops->stats);
+    }
+
+    m1_transport_clear(m1);
+    if (m1->tx_pool) {
+        MemoryPoolDestroy(m1->tx_pool);
+    }
+    m1_obj_pool_destroy(m1->packet_pool);
+    m1_latency_destroy(m1->latency);
+    m1_obj_pool_destroy(m1->rx_node_pool);
+    m1_free(m1->source_id);
+    m1_free(m1->seq_num);
+    m1_counter_destroy(m1->tx_stats);
+    m1_counter_destroy(m1->net_stats);
+    m1_trace_destroy(m1->trace);
+    m1_free(m1->alloc_base);
+}
+
 /* ----------------------------- end of file -------------------------------- */
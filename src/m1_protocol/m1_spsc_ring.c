@@ -0,0 +1,237 @@
+/**
+ * \file            m1_spsc_ring.c
+ * \brief           Lock-free single-producer single-consumer byte ring.
+ * \date            2026-10-18
+ */
+
+/*
+ * Copyright (c) 2024 Vector Qiu
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE
+ * AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * This file is part of the m1 protocol library.
+ *
+ * Author:          Vector Qiu <vetor.qiu@gmail.com>
+ * Version:         V0.0.1
+ */
+
+/* includes ----------------------------------------------------------------- */
+#include "./m1_protocol/m1_spsc_ring.h"
+
+#include <stdatomic.h>
+#include <stdint.h>
+#include <string.h>
+#include "./m1_protocol/m1_protocol_def.h"
+
+/* private typedefs --------------------------------------------------------- */
+/**
+ * \brief           Ring state.
+ *
+ * `head` and `tail` run freely and are masked on access, so the ring is
+ * full when they are `mask + 1` apart. Each side keeps a private copy of
+ * the other side's index on its own cache line and only reloads it when the
+ * copy cannot fill the span up to the end of the storage.
+ */
+struct m1_spsc_ring {
+    _Alignas(M1_CACHE_LINE_SIZE) atomic_size_t head; /*!< Next byte to write,
+                                                        owned by the
+                                                        producer. */
+    size_t tail_cache; /*!< Producer's copy of `tail`. */
+    _Alignas(M1_CACHE_LINE_SIZE) atomic_size_t tail; /*!< Next byte to read,
+                                                        owned by the
+                                                        consumer. */
+    size_t head_cache; /*!< Consumer's copy of `head`. */
+    _Alignas(M1_CACHE_LINE_SIZE) size_t mask; /*!< Capacity - 1. */
+    u8* buf;                                  /*!< Ring storage. */
+    void* alloc_base; /*!< Address returned by the allocator. */
+};
+
+/* public functions --------------------------------------------------------- */
+/**
+ * \brief           Create a ring.
+ *
+ * \param[in]       capacity: Minimum number of bytes the ring can hold,
+ *                  rounded up to the next power of two.
+ * \return          Pointer to the ring, or NULL on invalid capacity or
+ *                  allocation failure.
+ */
+m1_spsc_ring_t* m1_spsc_ring_create(size_t capacity) {
+    if (capacity == 0 || capacity > (SIZE_MAX >> 2)) {
+        return NULL;
+    }
+
+    size_t size = 1;
+    while (size < capacity) {
+        size <<= 1;
+    }
+
+    void* base = m1_malloc(sizeof(m1_spsc_ring_t) + M1_CACHE_LINE_SIZE - 1);
+    if (!base) {
+        return NULL;
+    }
+    uintptr_t addr = ((uintptr_t)base + M1_CACHE_LINE_SIZE - 1) &
+                     ~(uintptr_t)(M1_CACHE_LINE_SIZE - 1);
+    m1_spsc_ring_t* ring = (m1_spsc_ring_t*)addr;
+    memset(ring, 0, sizeof(m1_spsc_ring_t));
+    ring->alloc_base = base;
+
+    ring->buf = m1_malloc(size);
+    if (!ring->buf) {
+        m1_free(base);
+        return NULL;
+    }
+
+    atomic_init(&ring->head, 0);
+    atomic_init(&ring->tail, 0);
+    ring->mask = size - 1;
+    return ring;
+}
+
+/**
+ * \brief           Destroy a ring.
+ *
+ * \param[in]       ring: Pointer to the ring, may be NULL.
+ */
+void m1_spsc_ring_destroy(m1_spsc_ring_t* ring) {
+    if (!ring) {
+        return;
+    }
+    m1_free(ring->buf);
+    m1_free(ring->alloc_base);
+}
+
+/**
+ * \brief           Get the next contiguous writable span. Producer only.
+ *
+ * \param[in]       ring: Pointer to the ring.
+ * \param[out]      span: Start of the span.
+ * \return          Length of the span, 0 if the ring is full.
+ */
+size_t m1_spsc_ring_write_span(m1_spsc_ring_t* ring, u8** span) {
+    size_t size = ring->mask + 1;
+    size_t head = atomic_load_explicit(&ring->head, memory_order_relaxed);
+    size_t offset = head & ring->mask;
+    size_t free_len = size - (head - ring->tail_cache);
+    if (free_len < size - offset) {
+        ring->tail_cache =
+            atomic_load_explicit(&ring->tail, memory_order_acquire);
+        free_len = size - (head - ring->tail_cache);
+    }
+
+    *span = ring->buf + offset;
+    return free_len < size - offset ? free_len : size - offset;
+}
+
+/**
+ * \brief           Publish bytes written into the span from
+ *                  \ref m1_spsc_ring_write_span. Producer only.
+ *
+ * \param[in]       ring: Pointer to the ring.
+ * \param[in]       len: Number of bytes written, at most the span length.
+ */
+void m1_spsc_ring_write_commit(m1_spsc_ring_t* ring, size_t len) {
+    size_t head = atomic_load_explicit(&ring->head, memory_order_relaxed);
+    atomic_store_explicit(&ring->head, head + len, memory_order_release);
+}
+
+/**
+ * \brief           Copy bytes into the ring. Producer only.
+ *
+ * \param[in]       ring: Pointer to the ring.
+ * \param[in]       buf: Bytes to copy.
+ * \param[in]       len: Number of bytes to copy.
+ * \return          Number of bytes copied.
+ */
+size_t m1_spsc_ring_write(m1_spsc_ring_t* ring, const u8* buf, size_t len) {
+    size_t done = 0;
+    while (done < len) {
+        u8* span;
+        size_t span_len = m1_spsc_ring_write_span(ring, &span);
+        if (!span_len) {
+            break;
+        }
+        if (span_len > len - done) {
+            span_len = len - done;
+        }
+        memcpy(span, buf + done, span_len);
+        m1_spsc_ring_write_commit(ring, span_len);
+        done += span_len;
+    }
+    return done;
+}
+
+/**
+ * \brief           Get the next contiguous readable span. Consumer only.
+ *
+ * \param[in]       ring: Pointer to the ring.
+ * \param[out]      span: Start of the span.
+ * \return          Length of the span, 0 if the ring is empty.
+ */
+size_t m1_spsc_ring_read_span(m1_spsc_ring_t* ring, u8** span) {
+    size_t size = ring->mask + 1;
+    size_t tail = atomic_load_explicit(&ring->tail, memory_order_relaxed);
+    size_t offset = tail & ring->mask;
+    size_t used = ring->head_cache - tail;
+    if (used < size - offset) {
+        ring->head_cache =
+            atomic_load_explicit(&ring->head, memory_order_acquire);
+        used = ring->head_cache - tail;
+    }
+
+    *span = ring->buf + offset;
+    return used < size - offset ? used : size - offset;
+}
+
+/**
+ * \brief           Release bytes of the span from
+ *                  \ref m1_spsc_ring_read_span. Consumer only.
+ *
+ * \param[in]       ring: Pointer to the ring.
+ * \param[in]       len: Number of bytes consumed, at most the span length.
+ */
+void m1_spsc_ring_read_commit(m1_spsc_ring_t* ring, size_t len) {
+    size_t tail = atomic_load_explicit(&ring->tail, memory_order_relaxed);
+    atomic_store_explicit(&ring->tail, tail + len, memory_order_release);
+}
+
+/**
+ * \brief           Get the number of bytes waiting in a ring.
+ *
+ * \param[in]       ring: Pointer to the ring.
+ * \return          Number of bytes written and not yet consumed.
+ */
+size_t m1_spsc_ring_used(m1_spsc_ring_t* ring) {
+    size_t tail = atomic_load_explicit(&ring->tail, memory_order_acquire);
+    size_t head = atomic_load_explicit(&ring->head, memory_order_acquire);
+    return head - tail;
+}
+
+/**
+ * \brief           Get the capacity of a ring.
+ *
+ * \param[in]       ring: Pointer to the ring.
+ * \return          Number of bytes the ring holds.
+ */
+size_t m1_spsc_ring_capacity(const m1_spsc_ring_t* ring) {
+    return ring ? ring->mask + 1 : 0;
+}
+
+/* ----------------------------- end of file -------------------------------- */
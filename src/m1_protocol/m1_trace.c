@@ -0,0 +1,256 @@
+/**
+ * \file            m1_trace.c
+ * \brief           Binary in-memory trace ring.
+ * \date            2026-10-18
+ */
+
+/*
+ * Copyright (c) 2024 Vector Qiu
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE
+ * AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * This file is part of the m1 protocol library.
+ *
+ * Author:          Vector Qiu <vetor.qiu@gmail.com>
+ * Version:         V0.0.1
+ */
+
+/* includes ----------------------------------------------------------------- */
+#include "./m1_protocol/m1_trace.h"
+
+#include <inttypes.h>
+#include <stdatomic.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include "./m1_protocol/m1_event.h"
+#include "./m1_protocol/m1_protocol_def.h"
+
+/* private typedefs --------------------------------------------------------- */
+/**
+ * \brief           One ring slot, sequenced like \ref m1_mpsc_queue_t.
+ */
+typedef struct m1_trace_slot {
+    atomic_size_t seq;        /*!< Publication sequence of the slot. */
+    m1_trace_record_t record; /*!< Recorded event. */
+} m1_trace_slot_t;
+
+/**
+ * \brief           Trace ring state.
+ */
+struct m1_trace {
+    _Alignas(M1_CACHE_LINE_SIZE) atomic_size_t head; /*!< Next index to claim
+                                                        by a producer. */
+    atomic_uint_least64_t dropped; /*!< Records lost on a full ring. */
+    _Alignas(M1_CACHE_LINE_SIZE) size_t tail; /*!< Next index to drain, only
+                                                 touched by the consumer. */
+    _Alignas(M1_CACHE_LINE_SIZE) size_t mask; /*!< Capacity - 1. */
+    m1_trace_slot_t* slot;                    /*!< Slot array. */
+    void* alloc_base; /*!< Address returned by the allocator. */
+};
+
+/* private variables -------------------------------------------------------- */
+/*! Names of the stack's events, indexed by \ref m1_trace_event_e */
+static const char* const m1_trace_event_name[] = {
+    [M1_TRACE_ACK_RX] = "ack_rx",
+    [M1_TRACE_ACK_UNMATCHED] = "ack_unmatched",
+    [M1_TRACE_RETRANSMIT] = "retransmit",
+    [M1_TRACE_RETRY_EXHAUSTED] = "retry_exhausted",
+    [M1_TRACE_TX_ERR] = "tx_err",
+    [M1_TRACE_TX_NO_SPACE] = "tx_no_space",
+    [M1_TRACE_TX_NO_ROUTE] = "tx_no_route",
+    [M1_TRACE_FWD_NO_ROUTE] = "fwd_no_route",
+    [M1_TRACE_RX_DROP] = "rx_drop",
+    [M1_TRACE_TX_DROP] = "tx_drop",
+};
+
+/* public functions --------------------------------------------------------- */
+/**
+ * \brief           Create a trace ring.
+ *
+ * \param[in]       capacity: Minimum number of records the ring holds,
+ *                  rounded up to the next power of two.
+ * \return          Pointer to the ring, or NULL on invalid capacity or
+ *                  allocation failure.
+ */
+m1_trace_t* m1_trace_create(size_t capacity) {
+    if (capacity == 0 || capacity > (SIZE_MAX >> 6)) {
+        return NULL;
+    }
+
+    size_t size = 1;
+    while (size < capacity) {
+        size <<= 1;
+    }
+
+    void* base = m1_malloc(sizeof(m1_trace_t) + M1_CACHE_LINE_SIZE - 1);
+    if (!base) {
+        return NULL;
+    }
+    uintptr_t addr = ((uintptr_t)base + M1_CACHE_LINE_SIZE - 1) &
+                     ~(uintptr_t)(M1_CACHE_LINE_SIZE - 1);
+    m1_trace_t* trace = (m1_trace_t*)addr;
+    memset(trace, 0, sizeof(m1_trace_t));
+    trace->alloc_base = base;
+
+    trace->slot = m1_malloc(sizeof(m1_trace_slot_t) * size);
+    if (!trace->slot) {
+        m1_free(base);
+        return NULL;
+    }
+    for (size_t i = 0; i < size; i++) {
+        atomic_init(&trace->slot[i].seq, i);
+    }
+
+    atomic_init(&trace->head, 0);
+    atomic_init(&trace->dropped, 0);
+    trace->tail = 0;
+    trace->mask = size - 1;
+    return trace;
+}
+
+/**
+ * \brief           Destroy a trace ring.
+ *
+ * \param[in]       trace: Pointer to the ring, may be NULL.
+ */
+void m1_trace_destroy(m1_trace_t* trace) {
+    if (!trace) {
+        return;
+    }
+    m1_free(trace->slot);
+    m1_free(trace->alloc_base);
+}
+
+/**
+ * \brief           Record an event. Safe to call from any thread.
+ *
+ * \param[in]       trace: Pointer to the ring, may be NULL.
+ * \param[in]       event: Event ID, see \ref m1_trace_event_e.
+ * \param[in]       arg0: First argument.
+ * \param[in]       arg1: Second argument.
+ * \param[in]       arg2: Third argument.
+ */
+void m1_trace_record(m1_trace_t* trace, u32 event, u32 arg0, u32 arg1,
+                     u32 arg2) {
+    if (!trace) {
+        return;
+    }
+
+    m1_trace_slot_t* slot;
+    size_t pos = atomic_load_explicit(&trace->head, memory_order_relaxed);
+    for (;;) {
+        slot = &trace->slot[pos & trace->mask];
+        size_t seq = atomic_load_explicit(&slot->seq, memory_order_acquire);
+        intptr_t diff = (intptr_t)seq - (intptr_t)pos;
+        if (diff == 0) {
+            if (atomic_compare_exchange_weak_explicit(
+                    &trace->head, &pos, pos + 1, memory_order_relaxed,
+                    memory_order_relaxed)) {
+                break;
+            }
+        } else if (diff < 0) {
+            /*! Full: keep the older records, the drain is behind */
+            atomic_fetch_add_explicit(&trace->dropped, 1,
+                                      memory_order_relaxed);
+            return;
+        } else {
+            pos = atomic_load_explicit(&trace->head, memory_order_relaxed);
+        }
+    }
+
+    slot->record.stamp_us = m1_event_now_us();
+    slot->record.event = event;
+    slot->record.arg[0] = arg0;
+    slot->record.arg[1] = arg1;
+    slot->record.arg[2] = arg2;
+    atomic_store_explicit(&slot->seq, pos + 1, memory_order_release);
+}
+
+/**
+ * \brief           Take the oldest records off the ring. Must only be called
+ *                  by one thread at a time.
+ *
+ * \param[in]       trace: Pointer to the ring.
+ * \param[out]      record: Receives up to `record_num` records.
+ * \param[in]       record_num: Capacity of `record`.
+ * \return          Number of records taken.
+ */
+size_t m1_trace_drain(m1_trace_t* trace, m1_trace_record_t* record,
+                      size_t record_num) {
+    if (!trace || !record) {
+        return 0;
+    }
+
+    size_t num = 0;
+    while (num < record_num) {
+        size_t pos = trace->tail;
+        m1_trace_slot_t* slot = &trace->slot[pos & trace->mask];
+        size_t seq = atomic_load_explicit(&slot->seq, memory_order_acquire);
+        if (seq != pos + 1) {
+            break;
+        }
+        record[num++] = slot->record;
+        atomic_store_explicit(&slot->seq, pos + trace->mask + 1,
+                              memory_order_release);
+        trace->tail = pos + 1;
+    }
+    return num;
+}
+
+/**
+ * \brief           Get the number of records dropped on a full ring.
+ *
+ * \param[in]       trace: Pointer to the ring.
+ * \return          Number of dropped records.
+ */
+u64 m1_trace_dropped(const m1_trace_t* trace) {
+    return trace ? atomic_load_explicit(&trace->dropped, memory_order_relaxed)
+                 : 0;
+}
+
+/**
+ * \brief           Render a record as one line of text.
+ *
+ * \param[in]       record: Record to render.
+ * \param[out]      buf: Output buffer, always NUL-terminated if `len` > 0.
+ * \param[in]       len: Size of `buf`.
+ * \return          Length of the full line, as `snprintf` reports it.
+ */
+int m1_trace_format(const m1_trace_record_t* record, char* buf, size_t len) {
+    const char* name = NULL;
+    if (record->event < sizeof(m1_trace_event_name) / sizeof(char*)) {
+        name = m1_trace_event_name[record->event];
+    }
+
+    char id[16];
+    if (!name) {
+        snprintf(id, sizeof(id), "event_%" PRIu32, record->event);
+        name = id;
+    }
+    return snprintf(buf, len,
+                    "%" PRIu64 ".%06" PRIu64 " %s 0x%" PRIx32 " %" PRIu32
+                    " %" PRIu32 "\n",
+                    record->stamp_us / 1000000u, record->stamp_us % 1000000u,
+                    name, record->arg[0], record->arg[1], record->arg[2]);
+}
+
+/* ----------------------------- end of file -------------------------------- */
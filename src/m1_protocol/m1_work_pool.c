@@ -0,0 +1,392 @@
+/**
+ * \file            m1_work_pool.c
+ * \brief           Keyed work-stealing worker pool.
+ * \date            2026-10-18
+ */
+
+/*
+ * Copyright (c) 2024 Vector Qiu
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE
+ * AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * This file is part of the m1 protocol library.
+ *
+ * Author:          Vector Qiu <vetor.qiu@gmail.com>
+ * Version:         V0.0.1
+ */
+
+/* includes ----------------------------------------------------------------- */
+#include "./m1_protocol/m1_work_pool.h"
+
+#if M1_USING_PTHREAD
+
+#include <pthread.h>
+#include <string.h>
+#include "./m1_protocol/m1_protocol_def.h"
+
+/* private definitions ------------------------------------------------------ */
+/*! Number of keys, one strand per possible source ID. */
+#define M1_WORK_POOL_KEY_NUM 256
+
+/*! Work items run from one strand before it yields to the others. */
+#define M1_WORK_POOL_BUDGET  16
+
+/* private typedefs --------------------------------------------------------- */
+/**
+ * \brief           Singly linked FIFO with a tail pointer.
+ */
+typedef struct m1_work_fifo {
+    single_list_t head;  /*!< Head node, `head.next` is the oldest entry. */
+    single_list_t* tail; /*!< Last node, or `&head` when empty. */
+} m1_work_fifo_t;
+
+/**
+ * \brief           Ordered queue of work items sharing one key.
+ *
+ * A strand is either idle, queued in exactly one worker deque, or being run
+ * by exactly one worker; `scheduled` tells the first state from the others.
+ */
+typedef struct m1_strand {
+    pthread_mutex_t lock; /*!< Protects `work` and `scheduled`. */
+    m1_work_fifo_t work;  /*!< Pending work items. */
+    bool scheduled;       /*!< Strand is queued or running. */
+    single_list_t node;   /*!< Link in a worker deque. */
+} m1_strand_t;
+
+/**
+ * \brief           Worker thread and its deque of ready strands.
+ */
+typedef struct m1_worker {
+    _Alignas(M1_CACHE_LINE_SIZE) pthread_mutex_t lock; /*!< Protects `ready`.
+                                                        */
+    m1_work_fifo_t ready;         /*!< Strands ready to run. */
+    pthread_t thread;             /*!< Worker thread. */
+    struct m1_work_pool* pool;    /*!< Owning pool. */
+    size_t index;                 /*!< Index of the worker in the pool. */
+} m1_worker_t;
+
+/**
+ * \brief           Pool state.
+ */
+struct m1_work_pool {
+    m1_worker_t* worker; /*!< Worker array. */
+    size_t worker_num;   /*!< Number of workers. */
+    size_t started;      /*!< Number of workers successfully started. */
+
+    pthread_mutex_t idle_lock; /*!< Protects `pending` and `stop`. */
+    pthread_cond_t idle_cond;  /*!< Signalled when a strand becomes ready. */
+    size_t pending;            /*!< Strands queued in worker deques. */
+    bool stop;                 /*!< Workers exit once nothing is pending. */
+
+    m1_strand_t strand[M1_WORK_POOL_KEY_NUM]; /*!< One strand per key. */
+};
+
+/* private function prototypes ---------------------------------------------- */
+static void fifo_init(m1_work_fifo_t* fifo);
+static void fifo_push(m1_work_fifo_t* fifo, single_list_t* node);
+static single_list_t* fifo_pop(m1_work_fifo_t* fifo);
+static void worker_push(m1_worker_t* worker, m1_strand_t* strand);
+static m1_strand_t* worker_pop(m1_worker_t* worker);
+static m1_strand_t* worker_next(m1_worker_t* worker);
+static void strand_run(m1_worker_t* worker, m1_strand_t* strand);
+static void* worker_main(void* arg);
+
+/* public functions --------------------------------------------------------- */
+/**
+ * \brief           Create a pool and start its workers.
+ *
+ * \param[in]       worker_num: Number of worker threads, at least 1.
+ * \return          Pointer to the pool, or NULL on failure.
+ */
+m1_work_pool_t* m1_work_pool_create(size_t worker_num) {
+    if (worker_num == 0) {
+        return NULL;
+    }
+
+    m1_work_pool_t* pool = m1_malloc(sizeof(m1_work_pool_t));
+    if (!pool) {
+        return NULL;
+    }
+    memset(pool, 0, sizeof(m1_work_pool_t));
+
+    pool->worker = m1_malloc(sizeof(m1_worker_t) * worker_num);
+    if (!pool->worker) {
+        m1_free(pool);
+        return NULL;
+    }
+    memset(pool->worker, 0, sizeof(m1_worker_t) * worker_num);
+    pool->worker_num = worker_num;
+
+    pthread_mutex_init(&pool->idle_lock, NULL);
+    pthread_cond_init(&pool->idle_cond, NULL);
+    for (size_t i = 0; i < M1_WORK_POOL_KEY_NUM; i++) {
+        pthread_mutex_init(&pool->strand[i].lock, NULL);
+        fifo_init(&pool->strand[i].work);
+    }
+    for (size_t i = 0; i < worker_num; i++) {
+        pthread_mutex_init(&pool->worker[i].lock, NULL);
+        fifo_init(&pool->worker[i].ready);
+        pool->worker[i].pool = pool;
+        pool->worker[i].index = i;
+    }
+
+    for (size_t i = 0; i < worker_num; i++) {
+        if (pthread_create(&pool->worker[i].thread, NULL, worker_main,
+                           &pool->worker[i])) {
+            m1_work_pool_destroy(pool);
+            return NULL;
+        }
+        pool->started++;
+    }
+    return pool;
+}
+
+/**
+ * \brief           Run all submitted work, stop the workers and free the
+ *                  pool.
+ *
+ * \param[in]       pool: Pointer to the pool, may be NULL.
+ */
+void m1_work_pool_destroy(m1_work_pool_t* pool) {
+    if (!pool) {
+        return;
+    }
+
+    pthread_mutex_lock(&pool->idle_lock);
+    pool->stop = true;
+    pthread_cond_broadcast(&pool->idle_cond);
+    pthread_mutex_unlock(&pool->idle_lock);
+
+    for (size_t i = 0; i < pool->started; i++) {
+        pthread_join(pool->worker[i].thread, NULL);
+    }
+
+    for (size_t i = 0; i < pool->worker_num; i++) {
+        pthread_mutex_destroy(&pool->worker[i].lock);
+    }
+    for (size_t i = 0; i < M1_WORK_POOL_KEY_NUM; i++) {
+        pthread_mutex_destroy(&pool->strand[i].lock);
+    }
+    pthread_cond_destroy(&pool->idle_cond);
+    pthread_mutex_destroy(&pool->idle_lock);
+    m1_free(pool->worker);
+    m1_free(pool);
+}
+
+/**
+ * \brief           Submit a work item. Safe to call from any thread.
+ *
+ * \param[in]       pool: Pointer to the pool.
+ * \param[in]       key: Ordering key.
+ * \param[in]       work: Work item, owned by the pool until `fn` is called.
+ */
+void m1_work_pool_submit(m1_work_pool_t* pool, u8 key, m1_work_t* work) {
+    m1_strand_t* strand = &pool->strand[key];
+    bool schedule = false;
+
+    pthread_mutex_lock(&strand->lock);
+    fifo_push(&strand->work, &work->node);
+    if (!strand->scheduled) {
+        strand->scheduled = true;
+        schedule = true;
+    }
+    pthread_mutex_unlock(&strand->lock);
+
+    if (schedule) {
+        /*! A strand starts on its home worker; idle peers may steal it */
+        worker_push(&pool->worker[key % pool->worker_num], strand);
+    }
+}
+
+/* private functions -------------------------------------------------------- */
+/**
+ * \brief           Make a FIFO empty.
+ *
+ * \param[out]      fifo: FIFO to initialize.
+ */
+static void fifo_init(m1_work_fifo_t* fifo) {
+    single_list_init(&fifo->head);
+    fifo->tail = &fifo->head;
+}
+
+/**
+ * \brief           Append a node to a FIFO.
+ *
+ * \param[in]       fifo: FIFO to append to.
+ * \param[in]       node: Node to append, not linked anywhere else.
+ */
+static void fifo_push(m1_work_fifo_t* fifo, single_list_t* node) {
+    node->next = NULL;
+    fifo->tail->next = node;
+    fifo->tail = node;
+}
+
+/**
+ * \brief           Remove the oldest node of a FIFO.
+ *
+ * \param[in]       fifo: FIFO to take from.
+ * \return          The oldest node, or NULL if the FIFO is empty.
+ */
+static single_list_t* fifo_pop(m1_work_fifo_t* fifo) {
+    single_list_t* node = fifo->head.next;
+    if (node) {
+        fifo->head.next = node->next;
+        if (fifo->tail == node) {
+            fifo->tail = &fifo->head;
+        }
+    }
+    return node;
+}
+
+/**
+ * \brief           Queue a ready strand on a worker and wake one sleeper.
+ *
+ * \param[in]       worker: Worker whose deque receives the strand.
+ * \param[in]       strand: Strand with pending work, not queued anywhere.
+ */
+static void worker_push(m1_worker_t* worker, m1_strand_t* strand) {
+    m1_work_pool_t* pool = worker->pool;
+
+    pthread_mutex_lock(&worker->lock);
+    fifo_push(&worker->ready, &strand->node);
+    pthread_mutex_unlock(&worker->lock);
+
+    pthread_mutex_lock(&pool->idle_lock);
+    pool->pending++;
+    pthread_cond_signal(&pool->idle_cond);
+    pthread_mutex_unlock(&pool->idle_lock);
+}
+
+/**
+ * \brief           Take the oldest ready strand of a worker.
+ *
+ * \param[in]       worker: Worker to take from, the caller's own or a
+ *                  victim of work stealing.
+ * \return          The strand, or NULL if the deque is empty.
+ */
+static m1_strand_t* worker_pop(m1_worker_t* worker) {
+    pthread_mutex_lock(&worker->lock);
+    single_list_t* node = fifo_pop(&worker->ready);
+    pthread_mutex_unlock(&worker->lock);
+    if (!node) {
+        return NULL;
+    }
+
+    m1_work_pool_t* pool = worker->pool;
+    pthread_mutex_lock(&pool->idle_lock);
+    pool->pending--;
+    pthread_mutex_unlock(&pool->idle_lock);
+    return single_list_entry(node, m1_strand_t, node);
+}
+
+/**
+ * \brief           Find the next strand to run: own deque first, then steal
+ *                  from the other workers, then sleep until work arrives.
+ *
+ * \param[in]       worker: Worker looking for work.
+ * \return          A strand, or NULL when the pool is stopping and drained.
+ */
+static m1_strand_t* worker_next(m1_worker_t* worker) {
+    m1_work_pool_t* pool = worker->pool;
+
+    for (;;) {
+        m1_strand_t* strand = worker_pop(worker);
+        for (size_t i = 1; !strand && i < pool->worker_num; i++) {
+            strand = worker_pop(
+                &pool->worker[(worker->index + i) % pool->worker_num]);
+        }
+        if (strand) {
+            return strand;
+        }
+
+        pthread_mutex_lock(&pool->idle_lock);
+        while (pool->pending == 0 && !pool->stop) {
+            pthread_cond_wait(&pool->idle_cond, &pool->idle_lock);
+        }
+        bool done = pool->pending == 0 && pool->stop;
+        pthread_mutex_unlock(&pool->idle_lock);
+        if (done) {
+            return NULL;
+        }
+    }
+}
+
+/**
+ * \brief           Run up to \ref M1_WORK_POOL_BUDGET items of a strand, then
+ *                  requeue it behind the other ready strands if it still has
+ *                  work.
+ *
+ * \param[in]       worker: Worker running the strand.
+ * \param[in]       strand: Strand taken by \ref worker_next.
+ */
+static void strand_run(m1_worker_t* worker, m1_strand_t* strand) {
+    for (size_t i = 0; i < M1_WORK_POOL_BUDGET; i++) {
+        pthread_mutex_lock(&strand->lock);
+        single_list_t* node = fifo_pop(&strand->work);
+        if (!node) {
+            strand->scheduled = false;
+            pthread_mutex_unlock(&strand->lock);
+            return;
+        }
+        pthread_mutex_unlock(&strand->lock);
+
+        m1_work_t* work = single_list_entry(node, m1_work_t, node);
+        work->fn(work);
+    }
+    worker_push(worker, strand);
+}
+
+/**
+ * \brief           Thread entry of a worker: run strands until the pool
+ *                  stops.
+ *
+ * \param[in]       arg: The \ref m1_worker_t of the thread.
+ * \return          Always NULL.
+ */
+static void* worker_main(void* arg) {
+    m1_worker_t* worker = arg;
+    m1_strand_t* strand;
+    while ((strand = worker_next(worker)) != NULL) {
+        strand_run(worker, strand);
+    }
+    return NULL;
+}
+
+#else /* M1_USING_PTHREAD */
+
+m1_work_pool_t* m1_work_pool_create(size_t worker_num) {
+    (void)worker_num;
+    return NULL;
+}
+
+void m1_work_pool_destroy(m1_work_pool_t* pool) {
+    (void)pool;
+}
+
+void m1_work_pool_submit(m1_work_pool_t* pool, u8 key, m1_work_t* work) {
+    (void)pool;
+    (void)key;
+    work->fn(work);
+}
+
+#endif /* M1_USING_PTHREAD */
+
+/* ----------------------------- end of file -------------------------------- */
@@ -57,10 +57,10 @@
         }                                                                      \
     } while (0)
 
-etype_e master_send(u8* buf, size_t len);
-etype_e master_recv(u8* buf, size_t* len);
-etype_e salve_send(u8* buf, size_t len);
-etype_e salve_recv(u8* buf, size_t* len);
+etype_e master_send(void* user_data, u8* buf, size_t len);
+etype_e master_recv(void* user_data, u8* buf, size_t* len);
+etype_e salve_send(void* user_data, u8* buf, size_t len);
+etype_e salve_recv(void* user_data, u8* buf, size_t* len);
 void m1_callback(m1_rx_data_t* rx);
 void h1_protocol_callback(m1_rx_data_t* rx);
 
@@ -117,11 +117,11 @@ m1_rx_parse_callback_item_t rx_callback_table[] = {
 };
 
 void* thread_function(void* arg) {
-    (void)arg;
+    m1_t* m1 = arg;
 
     u32 run_cnt = 0;
     while (1) {
-        m1_protocol_run(2);
+        m1_protocol_run(m1, 2);
 
         run_cnt++;
         usleep(1000 * 1000 * 1000 / 500);
@@ -193,10 +193,22 @@ int main(int argc, char* argv[]) {
         printf("argv[%d]: %s\n", i, argv[i]);
     }
 
+    u8 source_id[] = {
+        HOST_ID_PC,
+    };
+    m1_t* m1 = m1_protocol_init("m1", 4096, route_table,
+                                ARRAY_SIZE(route_table), rx_callback_table,
+                                ARRAY_SIZE(rx_callback_table), source_id,
+                                ARRAY_SIZE(source_id));
+    if (!m1) {
+        fprintf(stderr, "Error initializing m1 protocol\n");
+        return EXIT_FAILURE;
+    }
+
     pthread_t thread;
 
     // 创建线程
-    if (pthread_create(&thread, NULL, thread_function, NULL)) {
+    if (pthread_create(&thread, NULL, thread_function, m1)) {
         fprintf(stderr, "Error creating thread\n");
         return EXIT_FAILURE;
     }
@@ -207,12 +219,6 @@ int main(int argc, char* argv[]) {
         return EXIT_FAILURE;
     }
 
-    u8 source_id[] = {
-        HOST_ID_PC,
-    };
-    m1_protocol_init("m1", 4096, route_table, ARRAY_SIZE(route_table),
-                     rx_callback_table, ARRAY_SIZE(rx_callback_table),
-                     source_id, ARRAY_SIZE(source_id));
     m1_tx_data_t tx_data = {0};
     u8 data[10] = {0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08, 0x09};
     tx_data.data = data;
@@ -224,22 +230,22 @@ int main(int argc, char* argv[]) {
 
     u8 target_id = HOST_ID_MASTER;
     tx_data.target_id = &target_id;
-    m1_protocol_tx_data(&tx_data);
+    m1_protocol_tx_data(m1, &tx_data);
 
     target_id = HOST_ID_SLAVE;
     tx_data.target_id = &target_id;
-    m1_protocol_tx_data(&tx_data);
+    m1_protocol_tx_data(m1, &tx_data);
 
     u32 run_cnt = 0;
     while (1) {
         // if (run_cnt % 10 == 0) {
         //     u8 target_id = 0x01;
         //     tx_data.target_id = &target_id;
-        //     m1_protocol_tx_data(&tx_data);
+        //     m1_protocol_tx_data(m1, &tx_data);
         // } else if (run_cnt % 5 == 0) {
         //     u8 target_id = 0x02;
         //     tx_data.target_id = &target_id;
-        //     m1_protocol_tx_data(&tx_data);
+        //     m1_protocol_tx_data(m1, &tx_data);
         // }
         sleep(1);
         run_cnt++;
@@ -247,24 +253,28 @@ int main(int argc, char* argv[]) {
     return 0;
 }
 
-etype_e master_send(u8* buf, size_t len) {
+etype_e master_send(void* user_data, u8* buf, size_t len) {
+    (void)user_data;
     LOG_HEX("master_send", 10, buf, len);
     return E_STATE_OK;
 }
 
-etype_e master_recv(u8* buf, size_t* len) {
+etype_e master_recv(void* user_data, u8* buf, size_t* len) {
+    (void)user_data;
     size_t data_len = sizeof(master_data_h1_ping_req);
     memcpy(buf, master_data_h1_ping_req, data_len);
     *len = data_len;
     return E_STATE_OK;
 }
 
-etype_e salve_send(u8* buf, size_t len) {
+etype_e salve_send(void* user_data, u8* buf, size_t len) {
+    (void)user_data;
     LOG_HEX("salve_send", 10, buf, len);
     return E_STATE_OK;
 }
 
-etype_e salve_recv(u8* buf, size_t* len) {
+etype_e salve_recv(void* user_data, u8* buf, size_t* len) {
+    (void)user_data;
     size_t data_len = sizeof(salve_data_h1_ping_req);
     memcpy(buf, salve_data_h1_ping_req, data_len);
     *len = data_len;
@@ -13,17 +13,111 @@
 extern "C" {
 #endif /* __cplusplus */
 
-#define mem_size_t unsigned int
+// 64位平台上单个内存池可超过 4GB
+#define mem_size_t size_t
 #define KB         (mem_size_t)(1 << 10)
 #define MB         (mem_size_t)(1 << 20)
 #define GB         (mem_size_t)(1 << 30)
+// 内存池总大小上限, 保证两个大小相加不会溢出
+#define MP_MAX_POOL_SIZE ((mem_size_t)-1 / 2)
+
+/*
+ *  小块分级(slab)配置: 用户大小不超过 MP_SLAB_MAX_SIZE 的申请走按大小分级的
+ *  slab, 分级为 2^MP_SLAB_MIN_SHIFT ... MP_SLAB_MAX_SIZE, O(1) 分配释放
+ *  MP_SLAB_CLASS_NUM 定义为 0 可关闭
+ */
+#ifndef MP_SLAB_MIN_SHIFT
+#define MP_SLAB_MIN_SHIFT 4
+#endif
+#ifndef MP_SLAB_CLASS_NUM
+#define MP_SLAB_CLASS_NUM 6
+#endif
+// 每个slab从通用内存池申请的字节数上限(另受 mempool_size / 8 限制)
+#ifndef MP_SLAB_SIZE
+#define MP_SLAB_SIZE (4 * 1024)
+#endif
+#define MP_SLAB_MAX_SIZE                                                       \
+    (MP_SLAB_CLASS_NUM ? (1 << (MP_SLAB_MIN_SHIFT + MP_SLAB_CLASS_NUM - 1)) : 0)
+
+/*
+ *  每线程缓存(magazine), 仅定义 _Z_MEMORYPOOL_THREAD_ 时有效: 每个线程为每个
+ *  slab分级缓存最多 MP_MAGAZINE_SIZE 个对象, 命中时只取本线程缓存的锁(无竞争),
+ *  空了/满了再持内存池锁批量补充/归还. 空间不足时归还所有线程的缓存.
+ *  定义为 0 可关闭
+ */
+#ifndef MP_MAGAZINE_SIZE
+#define MP_MAGAZINE_SIZE 32
+#endif
+
+// MemoryPoolInitEx 的 flags: 低4位为分配策略
+#define MP_STRATEGY_MASK      0x0f
+#define MP_STRATEGY_FIRST_FIT 0x00 // 首次适配(默认)
+#define MP_STRATEGY_TLSF      0x01 // 两级分离适配, 分配释放均为 O(1)
+
+// flags 中的区域选项, 仅 POSIX 有效, 否则忽略并使用 malloc
+#define MP_REGION_MMAP     0x10 // 区域用匿名 mmap 申请, Clear 时把空闲页还给系统
+#define MP_REGION_HUGEPAGE 0x20 // 先试 MAP_HUGETLB, 无预留大页时退回透明大页
+#define MP_REGION_POPULATE 0x40 // MAP_POPULATE 预先建立页表, 避免首次访问缺页
+#define MP_REGION_LOCK     0x80 // mlock 常驻内存, 超出 RLIMIT_MEMLOCK 时不锁定
+// 后三项隐含 MP_REGION_MMAP
+
+// MAP_HUGETLB 区域按此大小取整
+#ifndef MP_HUGEPAGE_SIZE
+#define MP_HUGEPAGE_SIZE (2 * 1024 * 1024)
+#endif
+
+// TLSF 每个一级分级再分为 2^MP_TLSF_SL_SHIFT 个二级分级, 不超过5
+#ifndef MP_TLSF_SL_SHIFT
+#define MP_TLSF_SL_SHIFT 4
+#endif
+#define MP_TLSF_SL_NUM (1 << MP_TLSF_SL_SHIFT)
+#define MP_TLSF_FL_NUM (int)(sizeof(mem_size_t) * 8)
+
+// is_free 的取值
+#define MP_CHUNK_USED 0
+#define MP_CHUNK_FREE 1
+#define MP_CHUNK_SLAB 2 // slab对象, 头部为 _MP_SlabObj
+
+struct _mp_mempool_list;
 
 typedef struct _mp_chunk {
     mem_size_t alloc_mem;
     struct _mp_chunk *prev, *next;
-    int is_free;
+    struct _mp_mempool_list* owner; // 所在内存池, 释放时无需遍历 mlist
+    int is_free; // 必须是最后一个成员, 与 _MP_SlabObj 共用位置
 } _MP_Chunk;
 
+struct _mp_slab_class;
+
+// 一个slab: 从通用内存池申请的一块内存, 头部之后切分为等大的对象
+typedef struct _mp_slab {
+    struct _mp_slab *prev, *next; // 所在分级的 partial 链表, 满时不在链表中
+    struct _mp_slab_class* cls;
+    void* free_obj;  // 空闲对象单链表
+    mem_size_t used; // 已分配对象数
+} _MP_Slab;
+
+// slab对象头
+typedef struct _mp_slab_obj {
+    _MP_Slab* slab;
+    int is_free; // 固定为 MP_CHUNK_SLAB
+} _MP_SlabObj;
+
+typedef struct _mp_slab_class {
+    mem_size_t obj_size;  // 对象步长, 含对象头
+    mem_size_t obj_num;   // 每个slab的对象数
+    _MP_Slab* partial;    // 有空闲对象的slab
+    _MP_Slab* empty;      // 缓存一个全空slab, 避免反复申请释放
+    mem_size_t slab_cnt;  // 当前slab数
+} _MP_SlabClass;
+
+// TLSF 空闲块索引, 所有内存池的空闲块按大小挂在同一张表上
+typedef struct _mp_tlsf {
+    mem_size_t fl_bitmap;                   // 非空的一级分级
+    unsigned int sl_bitmap[MP_TLSF_FL_NUM]; // 各一级分级中非空的二级分级
+    _MP_Chunk* free[MP_TLSF_FL_NUM][MP_TLSF_SL_NUM];
+} _MP_Tlsf;
+
 typedef struct _mp_mempool_list {
     char* start;
     unsigned int id;
@@ -34,6 +128,7 @@ typedef struct _mp_mempool_list {
                         // 当前池内实际分配给应用程序的内存总大小(减去内存管理元信息)
     _MP_Chunk *free_list, *alloc_list;
     struct _mp_mempool_list* next;
+    size_t map_len; // mmap 映射长度(含本结构), 0 表示由 malloc 申请
 } _MP_Memory;
 
 typedef struct _mp_mempool {
@@ -43,8 +138,21 @@ typedef struct _mp_mempool {
     mem_size_t max_mempool_size;   // 固定值 所有内存池加和总上限
     mem_size_t alloc_mempool_size; // 统计值 当前已分配的内存池总大小
     struct _mp_mempool_list* mlist;
+    int region_flags; // MP_REGION_*
+    mem_size_t trim_threshold; // 自动收缩保留的空闲字节数, 0 不自动收缩
+    _MP_Tlsf* tlsf; // 非NULL时使用TLSF策略, 此时各内存池的 free_list 不用
+    int slab_enable;
+    mem_size_t slab_size;     // 每个slab的字节数
+    mem_size_t slab_mem;      // 统计值 slab占用的通用内存池数据空间
+    mem_size_t slab_prog_mem; // 统计值 slab中实际分配给应用程序的内存
+#if MP_SLAB_CLASS_NUM
+    _MP_SlabClass slab[MP_SLAB_CLASS_NUM];
+#endif
 #ifdef _Z_MEMORYPOOL_THREAD_
     pthread_mutex_t lock;
+    pthread_key_t mag_key;      // 当前线程的缓存
+    int mag_key_ok;             // mag_key 创建成功, 否则不使用缓存
+    struct _mp_magazine* mags;  // 所有线程的缓存, 持锁访问
 #endif
 } MemoryPool;
 
@@ -64,11 +172,24 @@ int get_memory_id(_MP_Memory* mm);
  */
 
 MemoryPool* MemoryPoolInit(mem_size_t maxmempoolsize, mem_size_t mempoolsize);
+// 同 MemoryPoolInit, flags 为一个 MP_STRATEGY_* 与若干 MP_REGION_* 的组合
+MemoryPool* MemoryPoolInitEx(mem_size_t maxmempoolsize, mem_size_t mempoolsize,
+                             int flags);
 void* MemoryPoolAlloc(MemoryPool* mp, mem_size_t wantsize);
 int MemoryPoolFree(MemoryPool* mp, void* p);
+// 作废所有已分配的块(包括各线程缓存中的对象), 调用时其他线程不应再使用
+// 已分配的块
 MemoryPool* MemoryPoolClear(MemoryPool* mp);
 int MemoryPoolDestroy(MemoryPool* mp);
 int MemoryPoolSetThreadSafe(MemoryPool* mp, int thread_safe);
+// 开关小块slab(默认开启), 已分配的slab对象仍可正常释放
+int MemoryPoolSetSlab(MemoryPool* mp, int enable);
+// 释放所有整块空闲的扩展区域, 初始区域保留(映射区域把空闲页还给系统)
+// 返回释放的字节数
+mem_size_t MemoryPoolTrim(MemoryPool* mp);
+// 扩展区域变为整块空闲时, 若其余区域仍至少有 threshold 字节空闲则立即释放
+// 0 关闭(默认)
+int MemoryPoolSetTrimThreshold(MemoryPool* mp, mem_size_t threshold);
 
 /*
  *  内存池信息API
@@ -1,7 +1,42 @@
 #include "./memory_pool/memory_pool.h"
 
+#include <stddef.h>
+#ifdef _Z_MEMORYPOOL_THREAD_
+#include <stdatomic.h>
+#endif
+#if defined(__unix__) || defined(__APPLE__)
+#include <sys/mman.h>
+#include <unistd.h>
+#define MP_HAVE_MMAP 1
+#else
+#define MP_HAVE_MMAP 0
+#endif
+
 #define MP_CHUNKHEADER sizeof(struct _mp_chunk)
 #define MP_CHUNKEND    sizeof(struct _mp_chunk*)
+#define MP_SLABHEADER  MP_ALIGN_SIZE(sizeof(struct _mp_slab))
+
+// 用户指针之前固定偏移处的 is_free, 用于区分通用块与slab对象
+#define MP_CHUNK_TAG(p)                                                        \
+    (*(int*)((char*)(p) - (MP_CHUNKHEADER - offsetof(_MP_Chunk, is_free))))
+// 通用块中实际分配给应用程序的字节数
+#define MP_CHUNK_PROG(p)                                                       \
+    (((_MP_Chunk*)((char*)(p) - MP_CHUNKHEADER))->alloc_mem - MP_CHUNKHEADER - \
+     MP_CHUNKEND)
+
+#if defined(_Z_MEMORYPOOL_THREAD_) && MP_SLAB_CLASS_NUM && MP_MAGAZINE_SIZE
+#define MP_USE_MAGAZINE 1
+#else
+#define MP_USE_MAGAZINE 0
+#endif
+
+_Static_assert(sizeof(_MP_SlabObj) - offsetof(_MP_SlabObj, is_free) ==
+                   sizeof(_MP_Chunk) - offsetof(_MP_Chunk, is_free),
+               "is_free must sit at the same place before the user pointer");
+
+// 最高/最低置位的序号, x 不为0
+#define MP_FLS(x) (63 - __builtin_clzll((unsigned long long)(x)))
+#define MP_FFS(x) __builtin_ctzll((unsigned long long)(x))
 
 #define MP_LOCK(lockobj)                                                       \
     do {                                                                       \
@@ -23,6 +58,7 @@
         mm->alloc_prog_mem = 0;                                                \
         mm->free_list = (_MP_Chunk*)mm->start;                                 \
         mm->free_list->is_free = 1;                                            \
+        mm->free_list->owner = mm;                                             \
         mm->free_list->alloc_mem = mempool_sz;                                 \
         mm->free_list->prev = NULL;                                            \
         mm->free_list->next = NULL;                                            \
@@ -69,7 +105,6 @@ void get_memory_list_count(MemoryPool* mp, mem_size_t* mlist_len) {
 
 void get_memory_info(MemoryPool* mp, _MP_Memory* mm, mem_size_t* free_list_len,
                      mem_size_t* alloc_list_len) {
-    (void)mp;
 #ifdef _Z_MEMORYPOOL_THREAD_
     MP_LOCK(mp);
 #endif
@@ -79,6 +114,12 @@ void get_memory_info(MemoryPool* mp, _MP_Memory* mm, mem_size_t* free_list_len,
         free_l++;
         p = p->next;
     }
+    // TLSF 的空闲块不在 free_list 中, 按物理顺序遍历
+    if (mp->tlsf) {
+        for (p = (_MP_Chunk*)mm->start; (char*)p < mm->start + mm->mempool_size;
+             p = (_MP_Chunk*)((char*)p + p->alloc_mem))
+            free_l += p->is_free == MP_CHUNK_FREE;
+    }
 
     p = mm->alloc_list;
     while (p) {
@@ -96,14 +137,93 @@ int get_memory_id(_MP_Memory* mm) {
     return mm->id;
 }
 
+/*
+ *  内存池区域: 头部 _MP_Memory 之后紧跟数据区, 按 region_flags 由 malloc 或
+ *  mmap 申请
+ */
+
+static _MP_Memory* region_alloc(MemoryPool* mp, mem_size_t size) {
+    size_t len = sizeof(_MP_Memory) + (size_t)size;
+#if MP_HAVE_MMAP
+    if (mp->region_flags) {
+        int flags = MAP_PRIVATE | MAP_ANONYMOUS;
+        void* s = MAP_FAILED;
+#ifdef MAP_POPULATE
+        if (mp->region_flags & MP_REGION_POPULATE)
+            flags |= MAP_POPULATE;
+#endif
+#ifdef MAP_HUGETLB
+        if (mp->region_flags & MP_REGION_HUGEPAGE) {
+            size_t huge_len = (len + MP_HUGEPAGE_SIZE - 1) &
+                              ~(size_t)(MP_HUGEPAGE_SIZE - 1);
+            s = mmap(NULL, huge_len, PROT_READ | PROT_WRITE,
+                     flags | MAP_HUGETLB, -1, 0);
+            if (s != MAP_FAILED)
+                len = huge_len;
+        }
+#endif
+        if (s == MAP_FAILED) {
+            size_t page = (size_t)sysconf(_SC_PAGESIZE);
+            len = (len + page - 1) & ~(page - 1);
+            s = mmap(NULL, len, PROT_READ | PROT_WRITE, flags, -1, 0);
+            if (s == MAP_FAILED)
+                return NULL;
+#ifdef MADV_HUGEPAGE
+            if (mp->region_flags & MP_REGION_HUGEPAGE)
+                madvise(s, len, MADV_HUGEPAGE);
+#endif
+        }
+        // 锁定失败(超出 RLIMIT_MEMLOCK)不影响使用
+        if (mp->region_flags & MP_REGION_LOCK)
+            mlock(s, len);
+
+        _MP_Memory* mm = (_MP_Memory*)s;
+        mm->map_len = len;
+        return mm;
+    }
+#endif
+    _MP_Memory* mm = (_MP_Memory*)malloc(len);
+    if (!mm)
+        return NULL;
+    mm->map_len = 0;
+    return mm;
+}
+
+static void region_free(_MP_Memory* mm) {
+#if MP_HAVE_MMAP
+    if (mm->map_len) {
+        munmap(mm, mm->map_len);
+        return;
+    }
+#endif
+    free(mm);
+}
+
+// 把区域中首个块头之后的整页还给系统, 区域须整块空闲
+static void region_discard(MemoryPool* mp, _MP_Memory* mm) {
+#if MP_HAVE_MMAP
+    // 预建页表或锁定的区域本就要求常驻
+    if (!mm->map_len ||
+        (mp->region_flags & (MP_REGION_POPULATE | MP_REGION_LOCK)))
+        return;
+    uintptr_t page = (uintptr_t)sysconf(_SC_PAGESIZE);
+    uintptr_t from =
+        ((uintptr_t)mm->start + MP_CHUNKHEADER + page - 1) & ~(page - 1);
+    uintptr_t to = (uintptr_t)mm + mm->map_len;
+    if (from < to)
+        madvise((void*)from, to - from, MADV_DONTNEED);
+#else
+    (void)mp;
+    (void)mm;
+#endif
+}
+
 static _MP_Memory* extend_memory_list(MemoryPool* mp,
                                       mem_size_t new_mempool_sz) {
-    char* s = (char*)malloc(sizeof(_MP_Memory) + new_mempool_sz * sizeof(char));
-    if (!s)
+    _MP_Memory* mm = region_alloc(mp, new_mempool_sz);
+    if (!mm)
         return NULL;
-
-    _MP_Memory* mm = (_MP_Memory*)s;
-    mm->start = s + sizeof(_MP_Memory);
+    mm->start = (char*)mm + sizeof(_MP_Memory);
 
     MP_INIT_MEMORY_STRUCT(mm, new_mempool_sz);
     mm->id = mp->last_id++;
@@ -112,17 +232,6 @@ static _MP_Memory* extend_memory_list(MemoryPool* mp,
     return mm;
 }
 
-static _MP_Memory* find_memory_list(MemoryPool* mp, void* p) {
-    _MP_Memory* tmp = mp->mlist;
-    while (tmp) {
-        if (tmp->start <= (char*)p && tmp->start + mp->mempool_size > (char*)p)
-            break;
-        tmp = tmp->next;
-    }
-
-    return tmp;
-}
-
 static int merge_free_chunk(MemoryPool* mp, _MP_Memory* mm, _MP_Chunk* c) {
     _MP_Chunk *p0 = c, *p1 = c;
     while (p0->is_free) {
@@ -133,75 +242,241 @@ static int merge_free_chunk(MemoryPool* mp, _MP_Memory* mm, _MP_Chunk* c) {
     }
 
     p0 = (_MP_Chunk*)((char*)p1 + p1->alloc_mem);
-    while ((char*)p0 < mm->start + mp->mempool_size && p0->is_free) {
+    while ((char*)p0 < mm->start + mm->mempool_size && p0->is_free) {
         MP_DLINKLIST_DEL(mm->free_list, p0);
         p1->alloc_mem += p0->alloc_mem;
         p0 = (_MP_Chunk*)((char*)p0 + p0->alloc_mem);
     }
 
     *(_MP_Chunk**)((char*)p1 + p1->alloc_mem - MP_CHUNKEND) = p1;
-#ifdef _Z_MEMORYPOOL_THREAD_
-    MP_UNLOCK(mp);
-#endif
     return 0;
 }
 
-MemoryPool* MemoryPoolInit(mem_size_t max_mempool_size,
-                           mem_size_t mempool_size) {
-    if (mempool_size > max_mempool_size) {
-        // printf("[MemoryPool_Init] MemPool Init ERROR! Mempoolsize is too big!
-        // \n");
+// 自动扩展出一个能放下 total_needed_size 的新内存池, 调用者持锁
+static _MP_Memory* extend_for_chunk(MemoryPool* mp,
+                                    mem_size_t total_needed_size) {
+    if (!mp->auto_extend)
+        return NULL;
+    // 超过总内存限制
+    if (mp->alloc_mempool_size + total_needed_size > mp->max_mempool_size) {
         return NULL;
     }
-
-    MemoryPool* mp = (MemoryPool*)malloc(sizeof(MemoryPool));
-    if (!mp)
+    // 剩余可新增内存池大小
+    mem_size_t add_mem_sz = mp->max_mempool_size - mp->alloc_mempool_size;
+    // 如果空间足够则按 mempool_size 新增, 不足则分配剩下所有内存
+    add_mem_sz =
+        add_mem_sz >= mp->mempool_size ? mp->mempool_size : add_mem_sz;
+    _MP_Memory* mm = extend_memory_list(mp, add_mem_sz);
+    if (!mm)
         return NULL;
+    // 更新实际分配内存
+    mp->alloc_mempool_size += add_mem_sz;
+    return mm;
+}
 
-    mp->last_id = 0;
-    if (mempool_size < max_mempool_size)
-        mp->auto_extend = 1;
-    mp->max_mempool_size = max_mempool_size;
-    mp->alloc_mempool_size = mp->mempool_size =
-        mempool_size; // 初始分配一个内存池
+/*
+ *  TLSF(Two-Level Segregated Fit), 调用者持锁
+ *  空闲块按大小映射到 (fl, sl) 两级分级: fl 为最高置位, sl 为其后
+ *  MP_TLSF_SL_SHIFT 位. 分配时把请求向上取整到下一分级, 用位图直接找到
+ *  非空分级的第一个块, 释放时与物理相邻的空闲块立即合并, 均不需遍历
+ */
 
-#ifdef _Z_MEMORYPOOL_THREAD_
-    pthread_mutex_init(&mp->lock, NULL);
-#endif
+static void tlsf_mapping(mem_size_t size, int* fl, int* sl) {
+    if (size < MP_TLSF_SL_NUM) {
+        *fl = 0;
+        *sl = (int)size;
+        return;
+    }
+    *fl = MP_FLS(size);
+    *sl = (int)(size >> (*fl - MP_TLSF_SL_SHIFT)) - MP_TLSF_SL_NUM;
+}
 
-    char* s =
-        (char*)malloc(sizeof(_MP_Memory) + sizeof(char) * mp->mempool_size);
-    if (!s) {
-        free(mp);
-        return NULL;
+static void tlsf_insert(_MP_Tlsf* t, _MP_Chunk* c) {
+    int fl, sl;
+    tlsf_mapping(c->alloc_mem, &fl, &sl);
+    MP_DLINKLIST_INS_FRT(t->free[fl][sl], c);
+    t->fl_bitmap |= (mem_size_t)1 << fl;
+    t->sl_bitmap[fl] |= 1U << sl;
+}
+
+static void tlsf_remove(_MP_Tlsf* t, _MP_Chunk* c) {
+    int fl, sl;
+    tlsf_mapping(c->alloc_mem, &fl, &sl);
+    MP_DLINKLIST_DEL(t->free[fl][sl], c);
+    if (!t->free[fl][sl]) {
+        t->sl_bitmap[fl] &= ~(1U << sl);
+        if (!t->sl_bitmap[fl])
+            t->fl_bitmap &= ~((mem_size_t)1 << fl);
     }
+}
 
-    mp->mlist = (_MP_Memory*)s;
-    mp->mlist->start = s + sizeof(_MP_Memory);
-    MP_INIT_MEMORY_STRUCT(mp->mlist, mp->mempool_size);
-    mp->mlist->next = NULL;
-    mp->mlist->id = mp->last_id++;
+// 找一个不小于 size 的空闲块, 分级内任意一块都够用
+static _MP_Chunk* tlsf_find(_MP_Tlsf* t, mem_size_t size) {
+    int fl, sl;
+    if (size >= MP_TLSF_SL_NUM) {
+        mem_size_t round =
+            ((mem_size_t)1 << (MP_FLS(size) - MP_TLSF_SL_SHIFT)) - 1;
+        if (size + round < size)
+            return NULL;
+        size += round;
+    }
+    tlsf_mapping(size, &fl, &sl);
 
-    return mp;
+    unsigned int sl_map = t->sl_bitmap[fl] & (~0U << sl);
+    if (!sl_map) {
+        if (fl + 1 >= MP_TLSF_FL_NUM)
+            return NULL;
+        mem_size_t fl_map = t->fl_bitmap & (~(mem_size_t)0 << (fl + 1));
+        if (!fl_map)
+            return NULL;
+        fl = MP_FFS(fl_map);
+        sl_map = t->sl_bitmap[fl];
+    }
+    sl = MP_FFS(sl_map);
+    return t->free[fl][sl];
 }
 
-void* MemoryPoolAlloc(MemoryPool* mp, mem_size_t wantsize) {
-    if (wantsize <= 0)
+// 把内存池(刚初始化, 整块空闲)交给TLSF管理
+static void tlsf_add_memory(_MP_Tlsf* t, _MP_Memory* mm) {
+    _MP_Chunk* c = mm->free_list;
+    mm->free_list = NULL;
+    tlsf_insert(t, c);
+}
+
+static void tlsf_reset(MemoryPool* mp) {
+    memset(mp->tlsf, 0, sizeof(_MP_Tlsf));
+    for (_MP_Memory* mm = mp->mlist; mm; mm = mm->next)
+        tlsf_add_memory(mp->tlsf, mm);
+}
+
+static void* tlsf_alloc(MemoryPool* mp, mem_size_t total_needed_size) {
+    _MP_Chunk* c = tlsf_find(mp->tlsf, total_needed_size);
+    if (c) {
+        tlsf_remove(mp->tlsf, c);
+    } else {
+        // 新内存池整块够用, 直接从中分配
+        _MP_Memory* mm = extend_for_chunk(mp, total_needed_size);
+        if (!mm)
+            return NULL;
+        c = mm->free_list;
+        mm->free_list = NULL;
+    }
+
+    _MP_Memory* mm = c->owner;
+    // 剩余部分足够大则分割出来放回索引
+    if (c->alloc_mem - total_needed_size > MP_CHUNKHEADER + MP_CHUNKEND) {
+        _MP_Chunk* rest = (_MP_Chunk*)((char*)c + total_needed_size);
+        rest->alloc_mem = c->alloc_mem - total_needed_size;
+        rest->owner = mm;
+        rest->is_free = MP_CHUNK_FREE;
+        *(_MP_Chunk**)((char*)rest + rest->alloc_mem - MP_CHUNKEND) = rest;
+        tlsf_insert(mp->tlsf, rest);
+
+        c->alloc_mem = total_needed_size;
+        *(_MP_Chunk**)((char*)c + total_needed_size - MP_CHUNKEND) = c;
+    }
+    c->is_free = MP_CHUNK_USED;
+    MP_DLINKLIST_INS_FRT(mm->alloc_list, c);
+
+    mm->alloc_mem += c->alloc_mem;
+    mm->alloc_prog_mem += (c->alloc_mem - MP_CHUNKHEADER - MP_CHUNKEND);
+    return (void*)((char*)c + MP_CHUNKHEADER);
+}
+
+static void tlsf_free(MemoryPool* mp, _MP_Chunk* c) {
+    _MP_Memory* mm = c->owner;
+    MP_DLINKLIST_DEL(mm->alloc_list, c);
+    mm->alloc_mem -= c->alloc_mem;
+    mm->alloc_prog_mem -= (c->alloc_mem - MP_CHUNKHEADER - MP_CHUNKEND);
+
+    // 空闲块两侧不会再有空闲块, 各看一个邻居即可
+    if ((char*)c > mm->start) {
+        _MP_Chunk* prev = *(_MP_Chunk**)((char*)c - MP_CHUNKEND);
+        if (prev->is_free == MP_CHUNK_FREE) {
+            tlsf_remove(mp->tlsf, prev);
+            prev->alloc_mem += c->alloc_mem;
+            c = prev;
+        }
+    }
+    _MP_Chunk* next = (_MP_Chunk*)((char*)c + c->alloc_mem);
+    if ((char*)next < mm->start + mm->mempool_size &&
+        next->is_free == MP_CHUNK_FREE) {
+        tlsf_remove(mp->tlsf, next);
+        c->alloc_mem += next->alloc_mem;
+    }
+
+    c->is_free = MP_CHUNK_FREE;
+    *(_MP_Chunk**)((char*)c + c->alloc_mem - MP_CHUNKEND) = c;
+    tlsf_insert(mp->tlsf, c);
+}
+
+/*
+ *  收缩: 释放整块空闲的扩展区域, 初始区域(mlist 末尾)始终保留, 调用者持锁
+ */
+
+static void region_release(MemoryPool* mp, _MP_Memory* mm) {
+    if (mp->tlsf)
+        tlsf_remove(mp->tlsf, (_MP_Chunk*)mm->start);
+    _MP_Memory** pp = &mp->mlist;
+    while (*pp != mm)
+        pp = &(*pp)->next;
+    *pp = mm->next;
+    mp->alloc_mempool_size -= mm->mempool_size;
+    region_free(mm);
+}
+
+// 区域刚变为整块空闲时调用
+static void region_auto_trim(MemoryPool* mp, _MP_Memory* mm) {
+    if (!mm->next)
+        return;
+    mem_size_t headroom = 0;
+    for (_MP_Memory* it = mp->mlist; it; it = it->next) {
+        if (it != mm)
+            headroom += it->mempool_size - it->alloc_mem;
+    }
+    if (headroom >= mp->trim_threshold)
+        region_release(mp, mm);
+}
+
+static mem_size_t region_trim(MemoryPool* mp) {
+    mem_size_t released = 0;
+    _MP_Memory* mm = mp->mlist;
+    while (mm) {
+        _MP_Memory* next = mm->next;
+        if (!mm->alloc_mem) {
+            if (next) {
+                released += mm->mempool_size;
+                region_release(mp, mm);
+            } else {
+                region_discard(mp, mm);
+            }
+        }
+        mm = next;
+    }
+    return released;
+}
+
+/*
+ *  通用内存池(First Fit), 调用者持锁
+ */
+
+static void* chunk_alloc(MemoryPool* mp, mem_size_t wantsize) {
+    // 先比较再计算, 避免超大 wantsize 加上块头后回绕
+    if (wantsize > mp->mempool_size)
         return NULL;
     mem_size_t total_needed_size =
         MP_ALIGN_SIZE(wantsize + MP_CHUNKHEADER + MP_CHUNKEND);
     if (total_needed_size > mp->mempool_size)
         return NULL;
+    if (mp->tlsf)
+        return tlsf_alloc(mp, total_needed_size);
 
     _MP_Memory* mm = NULL;
     _MP_Chunk *_free = NULL, *_not_free = NULL;
-#ifdef _Z_MEMORYPOOL_THREAD_
-    MP_LOCK(mp);
-#endif
 FIND_FREE_CHUNK:
     mm = mp->mlist;
     while (mm) {
-        if (mp->mempool_size - mm->alloc_mem < total_needed_size) {
+        if (mm->mempool_size - mm->alloc_mem < total_needed_size) {
             mm = mm->next;
             continue;
         }
@@ -232,7 +507,7 @@ FIND_FREE_CHUNK:
                     if (_free->next)
                         _free->next->prev = _free;
 
-                    _not_free->is_free = 0;
+                    _not_free->is_free = MP_CHUNK_USED;
                     _not_free->alloc_mem = total_needed_size;
 
                     *(_MP_Chunk**)((char*)_not_free + total_needed_size -
@@ -242,16 +517,13 @@ FIND_FREE_CHUNK:
                 else {
                     _not_free = _free;
                     MP_DLINKLIST_DEL(mm->free_list, _not_free);
-                    _not_free->is_free = 0;
+                    _not_free->is_free = MP_CHUNK_USED;
                 }
                 MP_DLINKLIST_INS_FRT(mm->alloc_list, _not_free);
 
                 mm->alloc_mem += _not_free->alloc_mem;
                 mm->alloc_prog_mem +=
                     (_not_free->alloc_mem - MP_CHUNKHEADER - MP_CHUNKEND);
-#ifdef _Z_MEMORYPOOL_THREAD_
-                MP_UNLOCK(mp);
-#endif
                 return (void*)((char*)_not_free + MP_CHUNKHEADER);
             }
             _free = _free->next;
@@ -260,52 +532,444 @@ FIND_FREE_CHUNK:
         mm = mm->next;
     }
 
-    if (mp->auto_extend) {
-        // 超过总内存限制
-        if (mp->alloc_mempool_size + total_needed_size > mp->max_mempool_size) {
-            goto err_out;
+    if (extend_for_chunk(mp, total_needed_size))
+        goto FIND_FREE_CHUNK;
+
+    // printf("[MemoryPool_Alloc] No enough memory! \n");
+    return NULL;
+}
+
+static void chunk_free(MemoryPool* mp, void* p) {
+    _MP_Chunk* ck = (_MP_Chunk*)((char*)p - MP_CHUNKHEADER);
+    _MP_Memory* mm = ck->owner;
+    if (mp->tlsf) {
+        tlsf_free(mp, ck);
+    } else {
+        MP_DLINKLIST_DEL(mm->alloc_list, ck);
+        MP_DLINKLIST_INS_FRT(mm->free_list, ck);
+        ck->is_free = MP_CHUNK_FREE;
+
+        mm->alloc_mem -= ck->alloc_mem;
+        mm->alloc_prog_mem -= (ck->alloc_mem - MP_CHUNKHEADER - MP_CHUNKEND);
+
+        merge_free_chunk(mp, mm, ck);
+    }
+    if (mp->trim_threshold && !mm->alloc_mem)
+        region_auto_trim(mp, mm);
+}
+
+/*
+ *  小块分级slab, 调用者持锁
+ *  slab本身是通用内存池中的一个块, 头部 _MP_Slab 之后切分为等大对象,
+ *  空闲对象通过用户区的第一个指针串成单链表
+ */
+
+#if MP_SLAB_CLASS_NUM
+static void slab_init(MemoryPool* mp) {
+    mp->slab_size = mp->mempool_size / 8 < MP_SLAB_SIZE ? mp->mempool_size / 8
+                                                        : MP_SLAB_SIZE;
+    mp->slab_mem = 0;
+    mp->slab_prog_mem = 0;
+    for (int i = 0; i < MP_SLAB_CLASS_NUM; i++) {
+        _MP_SlabClass* cls = &mp->slab[i];
+        cls->obj_size = MP_ALIGN_SIZE(sizeof(_MP_SlabObj) +
+                                      (1 << (MP_SLAB_MIN_SHIFT + i)));
+        cls->obj_num = mp->slab_size > MP_SLABHEADER
+                           ? (mp->slab_size - MP_SLABHEADER) / cls->obj_size
+                           : 0;
+        cls->partial = NULL;
+        cls->empty = NULL;
+        cls->slab_cnt = 0;
+    }
+}
+
+static int slab_class_index(mem_size_t size) {
+    int i = 0;
+    while (((mem_size_t)1 << (MP_SLAB_MIN_SHIFT + i)) < size)
+        i++;
+    return i;
+}
+
+static _MP_Slab* slab_new(MemoryPool* mp, _MP_SlabClass* cls) {
+    if (cls->empty) {
+        _MP_Slab* slab = cls->empty;
+        cls->empty = NULL;
+        return slab;
+    }
+
+    _MP_Slab* slab = (_MP_Slab*)chunk_alloc(mp, mp->slab_size);
+    if (!slab)
+        return NULL;
+    slab->cls = cls;
+    slab->used = 0;
+    slab->free_obj = NULL;
+    // 逆序串链, 使分配按地址递增
+    char* base = (char*)slab + MP_SLABHEADER;
+    for (mem_size_t i = cls->obj_num; i > 0; i--) {
+        _MP_SlabObj* obj = (_MP_SlabObj*)(base + (i - 1) * cls->obj_size);
+        *(void**)(obj + 1) = slab->free_obj;
+        slab->free_obj = obj;
+    }
+    cls->slab_cnt++;
+    mp->slab_mem += MP_CHUNK_PROG(slab);
+    return slab;
+}
+
+static void* slab_alloc(MemoryPool* mp, mem_size_t wantsize) {
+    int idx = slab_class_index(wantsize);
+    _MP_SlabClass* cls = &mp->slab[idx];
+    if (!cls->obj_num)
+        return NULL;
+
+    _MP_Slab* slab = cls->partial;
+    if (!slab) {
+        slab = slab_new(mp, cls);
+        if (!slab)
+            return NULL;
+        MP_DLINKLIST_INS_FRT(cls->partial, slab);
+    }
+
+    _MP_SlabObj* obj = (_MP_SlabObj*)slab->free_obj;
+    slab->free_obj = *(void**)(obj + 1);
+    if (++slab->used == cls->obj_num) {
+        MP_DLINKLIST_DEL(cls->partial, slab);
+        slab->prev = slab->next = NULL;
+    }
+
+    obj->slab = slab;
+    obj->is_free = MP_CHUNK_SLAB;
+    mp->slab_prog_mem += (mem_size_t)1 << (MP_SLAB_MIN_SHIFT + idx);
+    return (void*)(obj + 1);
+}
+
+static void slab_free(MemoryPool* mp, void* p) {
+    _MP_SlabObj* obj = (_MP_SlabObj*)p - 1;
+    _MP_Slab* slab = obj->slab;
+    _MP_SlabClass* cls = slab->cls;
+
+    // 满slab重新回到partial链表
+    if (slab->used == cls->obj_num)
+        MP_DLINKLIST_INS_FRT(cls->partial, slab);
+    *(void**)p = slab->free_obj;
+    slab->free_obj = obj;
+    slab->used--;
+    mp->slab_prog_mem -= (mem_size_t)1
+                         << (MP_SLAB_MIN_SHIFT + (int)(cls - mp->slab));
+    if (slab->used)
+        return;
+
+    // 全空: 缓存一个, 其余还给通用内存池. 自动收缩时不缓存扩展区域中的slab,
+    // 以免它让整个区域无法释放
+    MP_DLINKLIST_DEL(cls->partial, slab);
+    _MP_Memory* owner = ((_MP_Chunk*)((char*)slab - MP_CHUNKHEADER))->owner;
+    if (!cls->empty && (!mp->trim_threshold || !owner->next)) {
+        cls->empty = slab;
+        return;
+    }
+    cls->slab_cnt--;
+    mp->slab_mem -= MP_CHUNK_PROG(slab);
+    chunk_free(mp, slab);
+}
+
+// 把缓存的全空slab还给通用内存池, 返回是否有释放
+static int slab_release_empty(MemoryPool* mp) {
+    int released = 0;
+    for (int i = 0; i < MP_SLAB_CLASS_NUM; i++) {
+        _MP_Slab* slab = mp->slab[i].empty;
+        if (!slab)
+            continue;
+        mp->slab[i].empty = NULL;
+        mp->slab[i].slab_cnt--;
+        mp->slab_mem -= MP_CHUNK_PROG(slab);
+        chunk_free(mp, slab);
+        released = 1;
+    }
+    return released;
+}
+#endif
+
+/*
+ *  每线程缓存(magazine)
+ *  缓存中的对象在slab看来仍是已分配的, 统计时按 cnt 扣除. obj/cnt 由
+ *  mag->lock 保护: 所属线程命中时只持它, 其他线程(空间不足时归还全部缓存,
+ *  Clear)持内存池锁后再持它. 加锁顺序固定为先内存池后缓存. 统计只读 cnt
+ */
+
+#if MP_USE_MAGAZINE
+typedef struct _mp_magazine {
+    struct _mp_magazine *prev, *next; // mp->mags 链表
+    MemoryPool* mp;
+    pthread_mutex_t lock; // 几乎只被所属线程获取, 无竞争
+    atomic_int cnt[MP_SLAB_CLASS_NUM];
+    void* obj[MP_SLAB_CLASS_NUM][MP_MAGAZINE_SIZE];
+} _MP_Magazine;
+
+// 归还分级 idx 的缓存对象直到只剩 keep 个, 调用者持两把锁, 返回剩余个数
+static int magazine_drain(MemoryPool* mp, _MP_Magazine* mag, int idx,
+                          int keep) {
+    int n = atomic_load_explicit(&mag->cnt[idx], memory_order_relaxed);
+    while (n > keep)
+        slab_free(mp, mag->obj[idx][--n]);
+    atomic_store_explicit(&mag->cnt[idx], n, memory_order_relaxed);
+    return n;
+}
+
+// 线程退出时归还其缓存
+static void magazine_exit(void* arg) {
+    _MP_Magazine* mag = (_MP_Magazine*)arg;
+    MemoryPool* mp = mag->mp;
+    MP_LOCK(mp);
+    MP_LOCK(mag);
+    for (int i = 0; i < MP_SLAB_CLASS_NUM; i++)
+        magazine_drain(mp, mag, i, 0);
+    MP_UNLOCK(mag);
+    MP_DLINKLIST_DEL(mp->mags, mag);
+    MP_UNLOCK(mp);
+    pthread_mutex_destroy(&mag->lock);
+    free(mag);
+}
+
+static _MP_Magazine* magazine_get(MemoryPool* mp) {
+    if (!mp->mag_key_ok)
+        return NULL;
+    _MP_Magazine* mag = (_MP_Magazine*)pthread_getspecific(mp->mag_key);
+    if (mag)
+        return mag;
+
+    mag = (_MP_Magazine*)malloc(sizeof(_MP_Magazine));
+    if (!mag)
+        return NULL;
+    mag->mp = mp;
+    pthread_mutex_init(&mag->lock, NULL);
+    for (int i = 0; i < MP_SLAB_CLASS_NUM; i++)
+        atomic_init(&mag->cnt[i], 0);
+    if (pthread_setspecific(mp->mag_key, mag)) {
+        pthread_mutex_destroy(&mag->lock);
+        free(mag);
+        return NULL;
+    }
+    MP_LOCK(mp);
+    MP_DLINKLIST_INS_FRT(mp->mags, mag);
+    MP_UNLOCK(mp);
+    return mag;
+}
+
+static void* magazine_alloc(MemoryPool* mp, mem_size_t wantsize) {
+    _MP_Magazine* mag = magazine_get(mp);
+    if (!mag)
+        return NULL;
+    int idx = slab_class_index(wantsize);
+    MP_LOCK(mag);
+    int n = atomic_load_explicit(&mag->cnt[idx], memory_order_relaxed);
+    if (!n) {
+        // 补充半个缓存, 且不超过一个slab的对象数, 避免小内存池被单个线程占满
+        int batch = (MP_MAGAZINE_SIZE + 1) / 2;
+        if ((mem_size_t)batch > mp->slab[idx].obj_num)
+            batch = (int)mp->slab[idx].obj_num;
+        MP_UNLOCK(mag);
+        MP_LOCK(mp);
+        MP_LOCK(mag);
+        mem_size_t size = (mem_size_t)1 << (MP_SLAB_MIN_SHIFT + idx);
+        n = atomic_load_explicit(&mag->cnt[idx], memory_order_relaxed);
+        while (n < batch) {
+            void* p = slab_alloc(mp, size);
+            if (!p)
+                break;
+            mag->obj[idx][n++] = p;
+        }
+        MP_UNLOCK(mp);
+        if (!n) {
+            MP_UNLOCK(mag);
+            return NULL;
         }
-        // 剩余可新增内存池大小
-        mem_size_t add_mem_sz = mp->max_mempool_size - mp->mempool_size;
-        // 如果空间足够则按 mempool_size 新增, 不足则分配剩下所有内存
-        add_mem_sz =
-            add_mem_sz >= mp->mempool_size ? mp->mempool_size : add_mem_sz;
-        if (!extend_memory_list(mp, add_mem_sz))
-            goto err_out;
-        // 更新实际分配内存
-        mp->alloc_mempool_size += add_mem_sz;
+    }
+    void* p = mag->obj[idx][--n];
+    atomic_store_explicit(&mag->cnt[idx], n, memory_order_relaxed);
+    MP_UNLOCK(mag);
+    return p;
+}
 
-        goto FIND_FREE_CHUNK;
+// 放入当前线程缓存, 返回0表示未缓存
+static int magazine_free(MemoryPool* mp, void* p) {
+    _MP_Magazine* mag = magazine_get(mp);
+    if (!mag)
+        return 0;
+    // 对象已分配期间其slab不会释放, cls 不变, 无需持锁
+    int idx = (int)(((_MP_SlabObj*)p - 1)->slab->cls - mp->slab);
+    MP_LOCK(mag);
+    int n = atomic_load_explicit(&mag->cnt[idx], memory_order_relaxed);
+    if (n == MP_MAGAZINE_SIZE) {
+        MP_UNLOCK(mag);
+        MP_LOCK(mp);
+        MP_LOCK(mag);
+        n = magazine_drain(mp, mag, idx, MP_MAGAZINE_SIZE / 2);
+        MP_UNLOCK(mp);
+    }
+    mag->obj[idx][n++] = p;
+    atomic_store_explicit(&mag->cnt[idx], n, memory_order_relaxed);
+    MP_UNLOCK(mag);
+    return 1;
+}
+
+// 归还一个缓存的全部对象, 调用者持内存池锁, 返回是否有归还
+static int magazine_flush(MemoryPool* mp, _MP_Magazine* mag) {
+    int flushed = 0;
+    MP_LOCK(mag);
+    for (int i = 0; i < MP_SLAB_CLASS_NUM; i++) {
+        flushed |= atomic_load_explicit(&mag->cnt[i], memory_order_relaxed);
+        magazine_drain(mp, mag, i, 0);
+    }
+    MP_UNLOCK(mag);
+    return flushed != 0;
+}
+
+// 归还所有线程的全部缓存, 调用者持内存池锁, 返回是否有归还
+static int magazine_flush_all(MemoryPool* mp) {
+    int flushed = 0;
+    for (_MP_Magazine* mag = mp->mags; mag; mag = mag->next)
+        flushed |= magazine_flush(mp, mag);
+    return flushed;
+}
+
+// 所有线程缓存中的字节数, 调用者持锁
+static mem_size_t magazine_cached(MemoryPool* mp) {
+    mem_size_t cached = 0;
+    for (_MP_Magazine* mag = mp->mags; mag; mag = mag->next) {
+        for (int i = 0; i < MP_SLAB_CLASS_NUM; i++)
+            cached += (mem_size_t)atomic_load_explicit(&mag->cnt[i],
+                                                       memory_order_relaxed)
+                      << (MP_SLAB_MIN_SHIFT + i);
+    }
+    return cached;
+}
+#endif
+
+MemoryPool* MemoryPoolInit(mem_size_t max_mempool_size,
+                           mem_size_t mempool_size) {
+    return MemoryPoolInitEx(max_mempool_size, mempool_size,
+                            MP_STRATEGY_FIRST_FIT);
+}
+
+MemoryPool* MemoryPoolInitEx(mem_size_t max_mempool_size,
+                             mem_size_t mempool_size, int flags) {
+    if (mempool_size > max_mempool_size ||
+        max_mempool_size > MP_MAX_POOL_SIZE) {
+        // printf("[MemoryPool_Init] MemPool Init ERROR! Mempoolsize is too big!
+        // \n");
+        return NULL;
     }
 
-err_out:
-// printf("[MemoryPool_Alloc] No enough memory! \n");
+    MemoryPool* mp = (MemoryPool*)malloc(sizeof(MemoryPool));
+    if (!mp)
+        return NULL;
+
+    mp->last_id = 0;
+    mp->auto_extend = mempool_size < max_mempool_size;
+    mp->max_mempool_size = max_mempool_size;
+    mp->alloc_mempool_size = mp->mempool_size =
+        mempool_size; // 初始分配一个内存池
+
+#ifdef _Z_MEMORYPOOL_THREAD_
+    pthread_mutex_init(&mp->lock, NULL);
+#endif
+
+    mp->trim_threshold = 0;
+    mp->region_flags = flags & ~MP_STRATEGY_MASK;
+    if (mp->region_flags)
+        mp->region_flags |= MP_REGION_MMAP;
+    mp->mlist = NULL;
+    if (!extend_memory_list(mp, mp->mempool_size)) {
+        free(mp);
+        return NULL;
+    }
+
+    mp->tlsf = NULL;
+    if ((flags & MP_STRATEGY_MASK) == MP_STRATEGY_TLSF) {
+        mp->tlsf = (_MP_Tlsf*)malloc(sizeof(_MP_Tlsf));
+        if (!mp->tlsf) {
+            region_free(mp->mlist);
+            free(mp);
+            return NULL;
+        }
+        tlsf_reset(mp);
+    }
+
+    mp->slab_enable = MP_SLAB_CLASS_NUM > 0;
+    mp->slab_size = mp->slab_mem = mp->slab_prog_mem = 0;
+#if MP_SLAB_CLASS_NUM
+    slab_init(mp);
+#endif
+#ifdef _Z_MEMORYPOOL_THREAD_
+    mp->mags = NULL;
+#if MP_USE_MAGAZINE
+    mp->mag_key_ok = !pthread_key_create(&mp->mag_key, magazine_exit);
+#else
+    mp->mag_key_ok = 0;
+#endif
+#endif
+    return mp;
+}
+
+void* MemoryPoolAlloc(MemoryPool* mp, mem_size_t wantsize) {
+    if (wantsize <= 0)
+        return NULL;
+    void* p = NULL;
+#if MP_USE_MAGAZINE
+    if (mp->slab_enable && wantsize <= MP_SLAB_MAX_SIZE) {
+        p = magazine_alloc(mp, wantsize);
+        if (p)
+            return p;
+    }
+#endif
+#ifdef _Z_MEMORYPOOL_THREAD_
+    MP_LOCK(mp);
+#endif
+#if MP_SLAB_CLASS_NUM
+    // slab无法满足(如通用内存池放不下新slab)时退回通用分配
+    if (mp->slab_enable && wantsize <= MP_SLAB_MAX_SIZE)
+        p = slab_alloc(mp, wantsize);
+#endif
+    if (!p)
+        p = chunk_alloc(mp, wantsize);
+#if MP_SLAB_CLASS_NUM
+    // 空间不足时先归还所有线程的缓存, 回收缓存的空slab再试一次
+    if (!p) {
+        int released = 0;
+#if MP_USE_MAGAZINE
+        released |= magazine_flush_all(mp);
+#endif
+        released |= slab_release_empty(mp);
+        if (released)
+            p = chunk_alloc(mp, wantsize);
+    }
+#endif
 #ifdef _Z_MEMORYPOOL_THREAD_
     MP_UNLOCK(mp);
 #endif
-    return NULL;
+    return p;
 }
 
 int MemoryPoolFree(MemoryPool* mp, void* p) {
     if (p == NULL || mp == NULL)
         return 1;
+#if MP_USE_MAGAZINE
+    if (mp->slab_enable && MP_CHUNK_TAG(p) == MP_CHUNK_SLAB &&
+        magazine_free(mp, p))
+        return 0;
+#endif
 #ifdef _Z_MEMORYPOOL_THREAD_
     MP_LOCK(mp);
 #endif
-    _MP_Memory* mm = mp->mlist;
-    if (mp->auto_extend)
-        mm = find_memory_list(mp, p);
-
-    _MP_Chunk* ck = (_MP_Chunk*)((char*)p - MP_CHUNKHEADER);
-
-    MP_DLINKLIST_DEL(mm->alloc_list, ck);
-    MP_DLINKLIST_INS_FRT(mm->free_list, ck);
-    ck->is_free = 1;
-
-    mm->alloc_mem -= ck->alloc_mem;
-    mm->alloc_prog_mem -= (ck->alloc_mem - MP_CHUNKHEADER - MP_CHUNKEND);
-
-    return merge_free_chunk(mp, mm, ck);
+#if MP_SLAB_CLASS_NUM
+    if (MP_CHUNK_TAG(p) == MP_CHUNK_SLAB)
+        slab_free(mp, p);
+    else
+#endif
+        chunk_free(mp, p);
+#ifdef _Z_MEMORYPOOL_THREAD_
+    MP_UNLOCK(mp);
+#endif
+    return 0;
 }
 
 MemoryPool* MemoryPoolClear(MemoryPool* mp) {
@@ -316,15 +980,76 @@ MemoryPool* MemoryPoolClear(MemoryPool* mp) {
 #endif
     _MP_Memory* mm = mp->mlist;
     while (mm) {
+        region_discard(mp, mm);
         MP_INIT_MEMORY_STRUCT(mm, mm->mempool_size);
         mm = mm->next;
     }
+    if (mp->tlsf)
+        tlsf_reset(mp);
+#if MP_SLAB_CLASS_NUM
+    slab_init(mp);
+#endif
+#if MP_USE_MAGAZINE
+    // 缓存中的对象随内存池一起作废
+    for (_MP_Magazine* mag = mp->mags; mag; mag = mag->next) {
+        MP_LOCK(mag);
+        for (int i = 0; i < MP_SLAB_CLASS_NUM; i++)
+            atomic_store_explicit(&mag->cnt[i], 0, memory_order_relaxed);
+        MP_UNLOCK(mag);
+    }
+#endif
 #ifdef _Z_MEMORYPOOL_THREAD_
     MP_UNLOCK(mp);
 #endif
     return mp;
 }
 
+int MemoryPoolSetSlab(MemoryPool* mp, int enable) {
+    if (!mp)
+        return 1;
+#ifdef _Z_MEMORYPOOL_THREAD_
+    MP_LOCK(mp);
+#endif
+    mp->slab_enable = MP_SLAB_CLASS_NUM > 0 && enable;
+#ifdef _Z_MEMORYPOOL_THREAD_
+    MP_UNLOCK(mp);
+#endif
+    return 0;
+}
+
+mem_size_t MemoryPoolTrim(MemoryPool* mp) {
+    if (!mp)
+        return 0;
+#ifdef _Z_MEMORYPOOL_THREAD_
+    MP_LOCK(mp);
+#endif
+    // 先让空slab回到通用内存池, 区域才可能整块空闲
+#if MP_USE_MAGAZINE
+    magazine_flush_all(mp);
+#endif
+#if MP_SLAB_CLASS_NUM
+    slab_release_empty(mp);
+#endif
+    mem_size_t released = region_trim(mp);
+#ifdef _Z_MEMORYPOOL_THREAD_
+    MP_UNLOCK(mp);
+#endif
+    return released;
+}
+
+int MemoryPoolSetTrimThreshold(MemoryPool* mp, mem_size_t threshold) {
+    if (!mp)
+        return 1;
+#ifdef _Z_MEMORYPOOL_THREAD_
+    MP_LOCK(mp);
+#endif
+    mp->trim_threshold = threshold;
+#ifdef _Z_MEMORYPOOL_THREAD_
+    MP_UNLOCK(mp);
+#endif
+    return 0;
+}
+
 int MemoryPoolDestroy(MemoryPool* mp) {
     if (mp == NULL)
         return 1;
@@ -335,8 +1060,20 @@ int MemoryPoolDestroy(MemoryPool* mp) {
     while (mm) {
         mm1 = mm;
         mm = mm->next;
-        free(mm1);
+        region_free(mm1);
+    }
+    free(mp->tlsf);
+#if MP_USE_MAGAZINE
+    // 删除 key 后线程退出不再回调, 由这里释放所有缓存
+    if (mp->mag_key_ok)
+        pthread_key_delete(mp->mag_key);
+    while (mp->mags) {
+        struct _mp_magazine* mag = mp->mags;
+        mp->mags = mag->next;
+        pthread_mutex_destroy(&mag->lock);
+        free(mag);
     }
+#endif
 #ifdef _Z_MEMORYPOOL_THREAD_
     MP_UNLOCK(mp);
     pthread_mutex_destroy(&mp->lock);
@@ -375,6 +1112,11 @@ mem_size_t GetProgMemory(MemoryPool* mp) {
         total_alloc_prog += mm->alloc_prog_mem;
         mm = mm->next;
     }
+    // slab按其中已分配的对象计入
+    total_alloc_prog = total_alloc_prog - mp->slab_mem + mp->slab_prog_mem;
+#if MP_USE_MAGAZINE
+    total_alloc_prog -= magazine_cached(mp);
+#endif
 #ifdef _Z_MEMORYPOOL_THREAD_
     MP_UNLOCK(mp);
 #endif
@@ -391,6 +1133,13 @@ float MemoryPoolGetProgUsage(MemoryPool* mp) {
 
 #undef MP_CHUNKHEADER
 #undef MP_CHUNKEND
+#undef MP_SLABHEADER
+#undef MP_CHUNK_TAG
+#undef MP_CHUNK_PROG
+#undef MP_FLS
+#undef MP_FFS
+#undef MP_USE_MAGAZINE
+#undef MP_HAVE_MMAP
 #undef MP_LOCK
 #undef MP_ALIGN_SIZE
 #undef MP_INIT_MEMORY_STRUCT
@@ -0,0 +1,139 @@
+/**
+ * \file            test_crc.cc
+ * \brief           CRC combine and patch tests
+ * \date            2026-10-18
+ */
+
+/*
+ * Copyright (c) 2024 Vector Qiu
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE
+ * AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * This file is part of the your library name library.
+ *
+ * Author:          Vector Qiu <vetor.qiu@gmail.com>
+ * Version:         _version_
+ */
+/* includes ----------------------------------------------------------------- */
+#include <gtest/gtest.h>
+#include <vector>
+#include "./crc/crc16.h"
+#include "./crc/crc16_lookup.h"
+#include "./crc/crc32.h"
+#include "./crc/crc32_lookup.h"
+
+/* Private functions -------------------------------------------------------- */
+static std::vector<uint8_t> make_data(size_t len) {
+    std::vector<uint8_t> data(len);
+    for (size_t i = 0; i < len; i++) {
+        data[i] = (uint8_t)(i * 131 + 7);
+    }
+    return data;
+}
+
+/* Public functions --------------------------------------------------------- */
+TEST(CrcCombine, Crc16MatchesDirectCalculation) {
+    const crc16_param_model_e models[] = {
+        CRC16_IBM_MODEL,    CRC16_MAXIM_MODEL,       CRC16_USB_MODEL,
+        CRC16_MODBUS_MODEL, CRC16_CCITT_FALSE_MODEL, CRC16_X25_MODEL,
+        CRC16_XMODEM_MODEL, CRC16_DNP_MODEL,
+    };
+    std::vector<uint8_t> data = make_data(300);
+
+    for (crc16_param_model_e model : models) {
+        for (uint32_t split : {0u, 1u, 12u, 150u, 300u}) {
+            uint16_t crc1 = crc16_calculate(model, data.data(), split);
+            uint16_t crc2 =
+                crc16_calculate(model, data.data() + split, 300 - split);
+            EXPECT_EQ(crc16_combine(model, crc1, crc2, 300 - split),
+                      crc16_calculate(model, data.data(), 300))
+                << "model " << model << " split " << split;
+        }
+    }
+}
+
+TEST(CrcCombine, Crc32MatchesDirectCalculation) {
+    std::vector<uint8_t> data = make_data(1000);
+
+    for (crc32_param_model_e model : {CRC32_MODEL, CRC32_MPEG2_MODEL}) {
+        for (uint32_t split : {0u, 5u, 999u, 1000u}) {
+            uint32_t crc1 = crc32_calculate(model, data.data(), split);
+            uint32_t crc2 =
+                crc32_calculate(model, data.data() + split, 1000 - split);
+            EXPECT_EQ(crc32_combine(model, crc1, crc2, 1000 - split),
+                      crc32_calculate(model, data.data(), 1000));
+        }
+    }
+}
+
+TEST(CrcCombine, LookupMatchesDirectCalculation) {
+    std::vector<uint8_t> data = make_data(64);
+
+    uint16_t a16 = crc16_lookup_calculate(CRC16_MODBUS_LOOKUP_MODEL,
+                                          data.data(), 20);
+    uint16_t b16 = crc16_lookup_calculate(CRC16_MODBUS_LOOKUP_MODEL,
+                                          data.data() + 20, 44);
+    EXPECT_EQ(crc16_lookup_combine(CRC16_MODBUS_LOOKUP_MODEL, a16, b16, 44),
+              crc16_lookup_calculate(CRC16_MODBUS_LOOKUP_MODEL, data.data(),
+                                     64));
+
+    uint32_t a32 =
+        crc32_lookup_calculate(CRC32_LOOKUP_MODEL, data.data(), 33);
+    uint32_t b32 =
+        crc32_lookup_calculate(CRC32_LOOKUP_MODEL, data.data() + 33, 31);
+    EXPECT_EQ(crc32_lookup_combine(CRC32_LOOKUP_MODEL, a32, b32, 31),
+              crc32_lookup_calculate(CRC32_LOOKUP_MODEL, data.data(), 64));
+}
+
+TEST(CrcPatch, HeaderRewriteMatchesRecalculation) {
+    std::vector<uint8_t> frame = make_data(12 + 256);
+    std::vector<uint8_t> patched = frame;
+    patched[3] ^= 0x5A;  /* target id */
+    patched[8] += 1;     /* sequence number */
+    patched[11] ^= 0xC3; /* header crc8 */
+
+    uint16_t crc16 = crc16_lookup_calculate(CRC16_MODBUS_LOOKUP_MODEL,
+                                            frame.data(), frame.size());
+    EXPECT_EQ(crc16_lookup_patch(CRC16_MODBUS_LOOKUP_MODEL, crc16,
+                                 frame.data(), patched.data(), 12, 256),
+              crc16_lookup_calculate(CRC16_MODBUS_LOOKUP_MODEL,
+                                     patched.data(), patched.size()));
+
+    crc16 = crc16_calculate(CRC16_XMODEM_MODEL, frame.data(), frame.size());
+    EXPECT_EQ(crc16_patch(CRC16_XMODEM_MODEL, crc16, frame.data(),
+                          patched.data(), 12, 256),
+              crc16_calculate(CRC16_XMODEM_MODEL, patched.data(),
+                              patched.size()));
+
+    uint32_t crc32 = crc32_calculate(CRC32_MODEL, frame.data(), frame.size());
+    EXPECT_EQ(crc32_patch(CRC32_MODEL, crc32, frame.data(), patched.data(),
+                          12, 256),
+              crc32_calculate(CRC32_MODEL, patched.data(), patched.size()));
+
+    crc32 = crc32_lookup_calculate(CRC32_MPEG2_LOOKUP_MODEL, frame.data(),
+                                   frame.size());
+    EXPECT_EQ(crc32_lookup_patch(CRC32_MPEG2_LOOKUP_MODEL, crc32,
+                                 frame.data(), patched.data(), 12, 256),
+              crc32_lookup_calculate(CRC32_MPEG2_LOOKUP_MODEL,
+                                     patched.data(), patched.size()));
+}
+
+/* ----------------------------- end of file -------------------------------- */
@@ -0,0 +1,860 @@
+/**
+ * \file            test_m1_link.cc
+ * \brief           M1 link driver tests
+ * \date            2026-10-18
+ */
+
+/*
+ * Copyright (c) 2024 Vector Qiu
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE
+ * AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * This file is part of the your library name library.
+ *
+ * Author:          Vector Qiu <vetor.qiu@gmail.com>
+ * Version:         _version_
+ */
+/* includes ----------------------------------------------------------------- */
+#include <fcntl.h>
+#include <gtest/gtest.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <stdlib.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <atomic>
+#include <string>
+#include <thread>
+#include <vector>
+#include "./m1_link/m1_link_dgram.h"
+#include "./m1_link/m1_link_metrics.h"
+#include "./m1_link/m1_link_serial.h"
+#include "./m1_link/m1_link_stream.h"
+#include "./m1_protocol/m1_event.h"
+#include "./m1_protocol/m1_protocol.h"
+
+/* Private variables -------------------------------------------------------- */
+static std::atomic<size_t> rx_frame_cnt{0};
+static std::vector<std::vector<u8>> captured;
+
+/* Private functions -------------------------------------------------------- */
+/* Driver with only the callbacks a test needs, the others left NULL */
+static tx_async_t make_tx(etype_e (*tx)(void*, u8*, size_t),
+                          void* user_data = NULL) {
+    tx_async_t out = {};
+    out.tx = tx;
+    out.user_data = user_data;
+    return out;
+}
+
+static rx_async_t make_rx(etype_e (*rx)(void*, u8*, size_t*),
+                          int (*get_fd)(void*) = NULL,
+                          void* user_data = NULL) {
+    rx_async_t out = {};
+    out.rx = rx;
+    out.get_fd = get_fd;
+    out.user_data = user_data;
+    return out;
+}
+
+/* Route whose RX buffer is sized from the link type */
+static m1_route_item_t make_route(const char* link_name,
+                                  m1_link_type_e link_type, u8 target_id,
+                                  const char* host_name, tx_async_t* tx,
+                                  rx_async_t* rx, u16 read_freq,
+                                  size_t max_pkg_size) {
+    m1_route_item_t item = {};
+    item.link_name = (char*)link_name;
+    item.link_type = link_type;
+    item.target_id = target_id;
+    item.host_name = (char*)host_name;
+    item.tx = tx;
+    item.rx = rx;
+    item.read_freq = read_freq;
+    item.max_pkg_size = max_pkg_size;
+    return item;
+}
+
+/* Master side of a pseudo terminal, the slave path is returned in `path` */
+static int open_pty(std::string& path) {
+    int fd = posix_openpt(O_RDWR | O_NOCTTY);
+    if (fd < 0 || grantpt(fd) || unlockpt(fd)) {
+        return -1;
+    }
+    path = ptsname(fd);
+    return fd;
+}
+
+/* Read exactly `len` bytes from `fd`, waiting at most one second */
+static std::vector<u8> read_exact(int fd, size_t len) {
+    std::vector<u8> out;
+    while (out.size() < len) {
+        struct pollfd pfd = {fd, POLLIN, 0};
+        if (poll(&pfd, 1, 1000) <= 0) {
+            break;
+        }
+        u8 buf[4096];
+        ssize_t n = read(fd, buf, std::min(sizeof(buf), len - out.size()));
+        if (n <= 0) {
+            break;
+        }
+        out.insert(out.end(), buf, buf + n);
+    }
+    return out;
+}
+
+static etype_e fd_send(void* user_data, u8* buf, size_t len) {
+    int fd = *(int*)user_data;
+    return write(fd, buf, len) == (ssize_t)len ? E_STATE_OK : E_STATE_ERROR;
+}
+
+static etype_e capture_send(void* user_data, u8* buf, size_t len) {
+    (void)user_data;
+    captured.emplace_back(buf, buf + len);
+    return E_STATE_OK;
+}
+
+static void drop_rx(m1_rx_data_t* rx) { (void)rx; }
+
+/* Forwards to the rx_async_t in user_data, counting the calls */
+static size_t recv_call_cnt;
+
+static etype_e counted_recv(void* user_data, u8* buf, size_t* len) {
+    rx_async_t* rx = (rx_async_t*)user_data;
+    recv_call_cnt++;
+    return rx->rx(rx->user_data, buf, len);
+}
+
+static int counted_get_fd(void* user_data) {
+    rx_async_t* rx = (rx_async_t*)user_data;
+    return rx->get_fd(rx->user_data);
+}
+
+static void count_rx(m1_rx_data_t* rx) {
+    (void)rx;
+    rx_frame_cnt++;
+}
+
+/* Send `frame_num` frames of `data_len` bytes from `source_id` to 0x02
+   over `tx` */
+static void encode_frames(u8 source_id, tx_async_t* tx, size_t frame_num,
+                          size_t data_len = 8) {
+    m1_route_item_t route[] = {
+        make_route("out", M1_LINK_TYPE_UART, 0x02, "rx", tx, NULL, 1,
+                   64 + data_len),
+    };
+    m1_rx_parse_callback_item_t rx_cb[] = {
+        {M1_TRANSPORT_LAYER_PROTOCOL_TYPE, drop_rx},
+    };
+    m1_t* m1 = m1_protocol_init("enc", 4096, route, 1, rx_cb, 1, &source_id,
+                                1);
+    ASSERT_NE(m1, nullptr);
+
+    u8 target_id = 0x02;
+    for (u32 i = 0; i < frame_num; i++) {
+        std::vector<u8> data(data_len < sizeof(i) ? sizeof(i) : data_len);
+        memcpy(data.data(), &i, sizeof(i));
+        m1_tx_data_t tx_data = {};
+        tx_data.target_id = &target_id;
+        tx_data.target_id_len = 1;
+        tx_data.data = data.data();
+        tx_data.data_len = data.size();
+        tx_data.data_type = M1_TRANSPORT_LAYER_PROTOCOL_TYPE;
+        ASSERT_EQ(m1_protocol_tx_data(m1, &tx_data), E_STATE_OK);
+        m1_protocol_run(m1, 1);
+    }
+    m1_protocol_deinit(m1);
+}
+
+/* Public functions --------------------------------------------------------- */
+TEST(LinkSerial, OpensRatesWithoutATermiosConstant) {
+    std::string path;
+    int master = open_pty(path);
+    ASSERT_GE(master, 0);
+
+    /* 6, 8 and 12 Mbaud go through termios2 */
+    for (u32 baud : {6000000u, 8000000u, 12000000u}) {
+        m1_link_serial_t serial;
+        ASSERT_EQ(m1_link_serial_open(&serial, path.c_str(), baud),
+                  E_STATE_OK);
+        EXPECT_EQ(m1_link_serial_set_rate(serial.fd, baud), E_STATE_OK);
+        m1_link_serial_close(&serial);
+    }
+    m1_link_serial_t serial;
+    EXPECT_EQ(m1_link_serial_open(&serial, "/nonexistent/tty", 115200),
+              E_STATE_IO);
+    close(master);
+}
+
+TEST(LinkSerial, WritevAndRawReadOverPty) {
+    std::string path;
+    int master = open_pty(path);
+    ASSERT_GE(master, 0);
+
+    m1_link_serial_t serial;
+    ASSERT_EQ(m1_link_serial_open(&serial, path.c_str(), 115200), E_STATE_OK);
+    EXPECT_EQ(serial.rx.get_fd(serial.rx.user_data), serial.fd);
+    EXPECT_EQ(serial.tx.get_state(serial.tx.user_data), E_STATE_OK);
+
+    /* Header and payload in one call; raw mode keeps 0x0A and 0x0D intact */
+    u8 head[] = {0xAA, 0x0A, 0x0D};
+    u8 body[] = {0x11, 0x03, 0x7F, 0x00};
+    struct iovec iov[2] = {{head, sizeof(head)}, {body, sizeof(body)}};
+    ASSERT_EQ(m1_link_serial_writev(&serial, iov, 2), E_STATE_OK);
+    std::vector<u8> wire = read_exact(master, sizeof(head) + sizeof(body));
+    std::vector<u8> expect = {0xAA, 0x0A, 0x0D, 0x11, 0x03, 0x7F, 0x00};
+    EXPECT_EQ(wire, expect);
+
+    /* An empty port reads zero bytes without blocking */
+    u8 buf[64];
+    size_t len = sizeof(buf);
+    EXPECT_EQ(serial.rx.rx(serial.rx.user_data, buf, &len), E_STATE_OK);
+    EXPECT_EQ(len, 0u);
+
+    ASSERT_EQ(write(master, expect.data(), expect.size()),
+              (ssize_t)expect.size());
+    struct pollfd pfd = {serial.fd, POLLIN, 0};
+    ASSERT_EQ(poll(&pfd, 1, 1000), 1);
+    len = sizeof(buf);
+    EXPECT_EQ(serial.rx.rx(serial.rx.user_data, buf, &len), E_STATE_OK);
+    EXPECT_EQ(std::vector<u8>(buf, buf + len), expect);
+
+    m1_link_serial_close(&serial);
+    close(master);
+}
+
+TEST(LinkSerial, KeepsFramesWholeUnderBackpressure) {
+    std::string path;
+    int master = open_pty(path);
+    ASSERT_GE(master, 0);
+
+    m1_link_serial_t serial;
+    ASSERT_EQ(m1_link_serial_open(&serial, path.c_str(), 0), E_STATE_OK);
+
+    /* Nobody reads the master: the pty fills, then the pending buffer */
+    std::vector<u8> frame(1000);
+    size_t sent = 0;
+    etype_e ret = E_STATE_OK;
+    for (size_t i = 0; i < 10000 && ret == E_STATE_OK; i++) {
+        memset(frame.data(), (int)(sent & 0xFF), frame.size());
+        ret = serial.tx.tx(serial.tx.user_data, frame.data(), frame.size());
+        if (ret == E_STATE_OK) {
+            sent++;
+        }
+    }
+    ASSERT_EQ(ret, E_STATE_BUSY);
+    EXPECT_EQ(serial.tx.get_state(serial.tx.user_data), E_STATE_BUSY);
+
+    /* Every accepted frame arrives complete and in order */
+    std::vector<u8> wire;
+    for (size_t i = 0; i < 1000 && wire.size() < sent * frame.size(); i++) {
+        size_t want = std::min<size_t>(4096, sent * frame.size() - wire.size());
+        std::vector<u8> part = read_exact(master, want);
+        wire.insert(wire.end(), part.begin(), part.end());
+        m1_link_serial_flush(&serial);
+    }
+    ASSERT_EQ(wire.size(), sent * frame.size());
+    for (size_t i = 0; i < sent; i++) {
+        ASSERT_EQ(wire[i * frame.size()], (u8)(i & 0xFF));
+        ASSERT_EQ(wire[i * frame.size() + frame.size() - 1], (u8)(i & 0xFF));
+    }
+    EXPECT_EQ(serial.tx.get_state(serial.tx.user_data), E_STATE_OK);
+
+    m1_link_serial_close(&serial);
+    close(master);
+}
+
+TEST(LinkSerial, DrivesRunWait) {
+    std::string path;
+    int master = open_pty(path);
+    ASSERT_GE(master, 0);
+
+    m1_link_serial_t serial;
+    ASSERT_EQ(m1_link_serial_open(&serial, path.c_str(), 3000000),
+              E_STATE_OK);
+    m1_route_item_t route[] = {
+        make_route("tty", M1_LINK_TYPE_UART, 0x01, "tty", &serial.tx,
+                   &serial.rx, 1, 64),
+    };
+    m1_rx_parse_callback_item_t rx_cb[] = {
+        {M1_TRANSPORT_LAYER_PROTOCOL_TYPE, count_rx},
+    };
+    u8 source_id = 0x02;
+    m1_t* m1 = m1_protocol_init("rx", 4096, route, 1, rx_cb, 1, &source_id,
+                                1);
+    ASSERT_NE(m1, nullptr);
+
+    const size_t frame_num = 100;
+    tx_async_t pty_tx = make_tx(fd_send, &master);
+    encode_frames(0x01, &pty_tx, frame_num);
+
+    rx_frame_cnt = 0;
+    for (size_t i = 0; i < 100 && rx_frame_cnt < frame_num; i++) {
+        ASSERT_EQ(m1_protocol_run_wait(m1, 100), E_STATE_OK);
+    }
+    EXPECT_EQ(rx_frame_cnt.load(), frame_num);
+
+    m1_protocol_deinit(m1);
+    m1_link_serial_close(&serial);
+    close(master);
+}
+
+TEST(LinkSerial, LeavesTheWaitSetOnHangup) {
+    std::string path;
+    int master = open_pty(path);
+    ASSERT_GE(master, 0);
+
+    m1_link_serial_t serial;
+    ASSERT_EQ(m1_link_serial_open(&serial, path.c_str(), 0), E_STATE_OK);
+    m1_route_item_t route[] = {
+        make_route("tty", M1_LINK_TYPE_UART, 0x01, "tty", &serial.tx,
+                   &serial.rx, 1, 64),
+    };
+    m1_rx_parse_callback_item_t rx_cb[] = {
+        {M1_TRANSPORT_LAYER_PROTOCOL_TYPE, count_rx},
+    };
+    u8 source_id = 0x02;
+    m1_t* m1 = m1_protocol_init("rx", 4096, route, 1, rx_cb, 1, &source_id,
+                                1);
+    ASSERT_NE(m1, nullptr);
+
+    /* The hung up port is closed by the pass that notices it */
+    close(master);
+    ASSERT_EQ(m1_protocol_run_wait(m1, 100), E_STATE_OK);
+    EXPECT_EQ(serial.state, E_STATE_IO);
+    EXPECT_EQ(serial.fd, -1);
+
+    /* Afterwards the loop sleeps instead of spinning on the hangup */
+    u64 start_ms = m1_event_now_ms();
+    for (int i = 0; i < 3; i++) {
+        ASSERT_EQ(m1_protocol_run_wait(m1, 20), E_STATE_OK);
+    }
+    EXPECT_GE(m1_event_now_ms() - start_ms, 50u);
+
+    m1_protocol_deinit(m1);
+    m1_link_serial_close(&serial);
+}
+
+TEST(LinkDgram, CarriesFramesThroughTheStack) {
+    int sv[2];
+    ASSERT_EQ(socketpair(AF_UNIX, SOCK_DGRAM, 0, sv), 0);
+    m1_link_dgram_t a;
+    m1_link_dgram_t b;
+    ASSERT_EQ(m1_link_dgram_attach(&a, sv[0]), E_STATE_OK);
+    ASSERT_EQ(m1_link_dgram_attach(&b, sv[1]), E_STATE_OK);
+
+    m1_route_item_t route[] = {
+        make_route("dgram", M1_LINK_TYPE_UNIX_DGRAM, 0x01, "dgram", &b.tx,
+                   &b.rx, 1, 64),
+    };
+    m1_rx_parse_callback_item_t rx_cb[] = {
+        {M1_TRANSPORT_LAYER_PROTOCOL_TYPE, count_rx},
+    };
+    u8 source_id = 0x02;
+    m1_t* m1 = m1_protocol_init("rx", 4096, route, 1, rx_cb, 1, &source_id,
+                                1);
+    ASSERT_NE(m1, nullptr);
+
+    /* A datagram that is not exactly one frame is dropped by the driver */
+    u8 junk[] = {0x55, 0x00, 0x01};
+    ASSERT_EQ(send(a.fd, junk, sizeof(junk), 0), (ssize_t)sizeof(junk));
+
+    const size_t frame_num = 100;
+    encode_frames(0x01, &a.tx, frame_num);
+
+    rx_frame_cnt = 0;
+    for (size_t i = 0; i < 100 && rx_frame_cnt < frame_num; i++) {
+        ASSERT_EQ(m1_protocol_run_wait(m1, 100), E_STATE_OK);
+    }
+    EXPECT_EQ(rx_frame_cnt.load(), frame_num);
+    EXPECT_EQ(b.rx_drop_cnt, 1u);
+
+    m1_protocol_deinit(m1);
+    m1_link_dgram_close(&a);
+    m1_link_dgram_close(&b);
+}
+
+TEST(LinkDgram, BatchesLargeFramesThroughTheStack) {
+    int sv[2];
+    ASSERT_EQ(socketpair(AF_UNIX, SOCK_DGRAM, 0, sv), 0);
+    m1_link_dgram_t a;
+    m1_link_dgram_t b;
+    ASSERT_EQ(m1_link_dgram_attach(&a, sv[0]), E_STATE_OK);
+    ASSERT_EQ(m1_link_dgram_attach(&b, sv[1]), E_STATE_OK);
+
+    /* Count the driver reads of the stack */
+    rx_async_t counted_rx = make_rx(counted_recv, counted_get_fd, &b.rx);
+    m1_route_item_t route[] = {
+        make_route("dgram", M1_LINK_TYPE_UNIX_DGRAM, 0x01, "dgram", &b.tx,
+                   &counted_rx, 1, 512),
+    };
+    m1_rx_parse_callback_item_t rx_cb[] = {
+        {M1_TRANSPORT_LAYER_PROTOCOL_TYPE, count_rx},
+    };
+    u8 source_id = 0x02;
+    m1_t* m1 = m1_protocol_init("rx", 4096, route, 1, rx_cb, 1, &source_id,
+                                1);
+    ASSERT_NE(m1, nullptr);
+
+    /* Frames well over M1_RX_BUF_MIN_SIZE, all waiting for one wakeup */
+    const size_t frame_num = 10;
+    encode_frames(0x01, &a.tx, frame_num, 300);
+
+    rx_frame_cnt = 0;
+    recv_call_cnt = 0;
+    ASSERT_EQ(m1_protocol_run_wait(m1, 1000), E_STATE_OK);
+    EXPECT_EQ(rx_frame_cnt.load(), frame_num);
+    EXPECT_EQ(b.rx_drop_cnt, 0u);
+    /* One batch with every frame, then one empty read */
+    EXPECT_LE(recv_call_cnt, 2u);
+
+    m1_protocol_deinit(m1);
+    m1_link_dgram_close(&a);
+    m1_link_dgram_close(&b);
+}
+
+TEST(LinkDgram, HoldsFramesUntilFlushAndReceivesInOneCall) {
+    captured.clear();
+    tx_async_t capture_tx = make_tx(capture_send);
+    encode_frames(0x01, &capture_tx, 10);
+    ASSERT_EQ(captured.size(), 10u);
+
+    int sv[2];
+    ASSERT_EQ(socketpair(AF_UNIX, SOCK_SEQPACKET, 0, sv), 0);
+    m1_link_dgram_t a;
+    m1_link_dgram_t b;
+    ASSERT_EQ(m1_link_dgram_attach(&a, sv[0]), E_STATE_OK);
+    ASSERT_EQ(m1_link_dgram_attach(&b, sv[1]), E_STATE_OK);
+
+    std::vector<u8> expect;
+    for (auto& frame : captured) {
+        ASSERT_EQ(a.tx.tx(a.tx.user_data, frame.data(), frame.size()),
+                  E_STATE_OK);
+        expect.insert(expect.end(), frame.begin(), frame.end());
+    }
+
+    std::vector<u8> buf(64 * 1024);
+    size_t len = buf.size();
+    ASSERT_EQ(b.rx.rx(b.rx.user_data, buf.data(), &len), E_STATE_OK);
+    EXPECT_EQ(len, 0u);
+
+    ASSERT_EQ(a.tx.flush(a.tx.user_data), E_STATE_OK);
+    len = buf.size();
+    ASSERT_EQ(b.rx.rx(b.rx.user_data, buf.data(), &len), E_STATE_OK);
+    ASSERT_EQ(len, expect.size());
+    EXPECT_TRUE(std::equal(expect.begin(), expect.end(), buf.begin()));
+
+    m1_link_dgram_close(&a);
+    m1_link_dgram_close(&b);
+}
+
+TEST(LinkDgram, UdpLoopback) {
+    captured.clear();
+    tx_async_t capture_tx = make_tx(capture_send);
+    encode_frames(0x01, &capture_tx, 1);
+    ASSERT_EQ(captured.size(), 1u);
+
+    m1_link_dgram_t server;
+    ASSERT_EQ(m1_link_dgram_open_udp(&server, "127.0.0.1", 0, NULL, 0),
+              E_STATE_OK);
+    struct sockaddr_in addr;
+    socklen_t addr_len = sizeof(addr);
+    ASSERT_EQ(getsockname(server.fd, (struct sockaddr*)&addr, &addr_len), 0);
+
+    m1_link_dgram_t client;
+    EXPECT_EQ(m1_link_dgram_open_udp(&client, "localhost", 0, NULL, 0),
+              E_STATE_ADDR);
+    ASSERT_EQ(m1_link_dgram_open_udp(&client, "127.0.0.1", 0, "127.0.0.1",
+                                     ntohs(addr.sin_port)),
+              E_STATE_OK);
+
+    std::vector<u8>& frame = captured[0];
+    ASSERT_EQ(client.tx.tx(client.tx.user_data, frame.data(), frame.size()),
+              E_STATE_OK);
+    ASSERT_EQ(m1_link_dgram_flush(&client), E_STATE_OK);
+
+    struct pollfd pfd = {server.fd, POLLIN, 0};
+    ASSERT_EQ(poll(&pfd, 1, 1000), 1);
+    u8 buf[256];
+    size_t len = sizeof(buf);
+    ASSERT_EQ(server.rx.rx(server.rx.user_data, buf, &len), E_STATE_OK);
+    EXPECT_EQ(std::vector<u8>(buf, buf + len), frame);
+
+    m1_link_dgram_close(&client);
+    m1_link_dgram_close(&server);
+}
+
+TEST(LinkStream, ParsesFramesSplitAcrossReads) {
+    captured.clear();
+    tx_async_t capture_tx = make_tx(capture_send);
+    const size_t frame_num = 300;
+    encode_frames(0x01, &capture_tx, frame_num);
+    ASSERT_EQ(captured.size(), frame_num);
+
+    /* Frames separated by runs of noise that hold no start of frame */
+    std::vector<u8> wire;
+    for (size_t i = 0; i < frame_num; i++) {
+        wire.insert(wire.end(), i % 7, 0xAA);
+        wire.insert(wire.end(), captured[i].begin(), captured[i].end());
+    }
+
+    int sv[2];
+    ASSERT_EQ(socketpair(AF_UNIX, SOCK_STREAM, 0, sv), 0);
+    m1_link_stream_t b;
+    ASSERT_EQ(m1_link_stream_attach(&b, sv[1]), E_STATE_OK);
+
+    m1_route_item_t route[] = {
+        make_route("stream", M1_LINK_TYPE_UNIX_STREAM, 0x01, "stream", &b.tx,
+                   &b.rx, 1, 64),
+    };
+    m1_rx_parse_callback_item_t rx_cb[] = {
+        {M1_TRANSPORT_LAYER_PROTOCOL_TYPE, count_rx},
+    };
+    u8 source_id = 0x02;
+    m1_t* m1 = m1_protocol_init("rx", 4096, route, 1, rx_cb, 1, &source_id,
+                                1);
+    ASSERT_NE(m1, nullptr);
+
+    /* Every read ends at a different place inside a frame */
+    rx_frame_cnt = 0;
+    size_t offset = 0;
+    for (size_t chunk = 1; offset < wire.size(); chunk = chunk % 97 + 1) {
+        size_t len = std::min(chunk, wire.size() - offset);
+        ASSERT_EQ(send(sv[0], wire.data() + offset, len, 0), (ssize_t)len);
+        offset += len;
+        ASSERT_EQ(m1_protocol_run_wait(m1, 100), E_STATE_OK);
+    }
+    EXPECT_EQ(rx_frame_cnt.load(), frame_num);
+
+    /* The peer hanging up closes the link */
+    close(sv[0]);
+    ASSERT_EQ(m1_protocol_run_wait(m1, 100), E_STATE_OK);
+    EXPECT_EQ(b.state, E_STATE_IO);
+    EXPECT_EQ(b.fd, -1);
+
+    m1_protocol_deinit(m1);
+    m1_link_stream_close(&b);
+}
+
+TEST(LinkStream, CoalescesFramesBelowTheNodelayPriority) {
+    captured.clear();
+    tx_async_t capture_tx = make_tx(capture_send);
+    encode_frames(0x01, &capture_tx, 10);
+    ASSERT_EQ(captured.size(), 10u);
+
+    int sv[2];
+    ASSERT_EQ(socketpair(AF_UNIX, SOCK_STREAM, 0, sv), 0);
+    m1_link_stream_t a;
+    m1_link_stream_t b;
+    ASSERT_EQ(m1_link_stream_attach(&a, sv[0]), E_STATE_OK);
+    ASSERT_EQ(m1_link_stream_attach(&b, sv[1]), E_STATE_OK);
+
+    std::vector<u8> expect;
+    for (auto& frame : captured) {
+        ASSERT_EQ(a.tx.tx(a.tx.user_data, frame.data(), frame.size()),
+                  E_STATE_OK);
+        expect.insert(expect.end(), frame.begin(), frame.end());
+    }
+
+    std::vector<u8> buf(64 * 1024);
+    size_t len = buf.size();
+    ASSERT_EQ(b.rx.rx(b.rx.user_data, buf.data(), &len), E_STATE_OK);
+    EXPECT_EQ(len, 0u);
+
+    ASSERT_EQ(a.tx.flush(a.tx.user_data), E_STATE_OK);
+    len = buf.size();
+    ASSERT_EQ(b.rx.rx(b.rx.user_data, buf.data(), &len), E_STATE_OK);
+    ASSERT_EQ(len, expect.size());
+    EXPECT_TRUE(std::equal(expect.begin(), expect.end(), buf.begin()));
+
+    /* Frames at or above the threshold go out at once */
+    a.nodelay_priority = 0;
+    std::vector<u8>& frame = captured[0];
+    ASSERT_EQ(a.tx.tx(a.tx.user_data, frame.data(), frame.size()),
+              E_STATE_OK);
+    len = buf.size();
+    ASSERT_EQ(b.rx.rx(b.rx.user_data, buf.data(), &len), E_STATE_OK);
+    EXPECT_EQ(len, frame.size());
+
+    m1_link_stream_close(&a);
+    m1_link_stream_close(&b);
+}
+
+TEST(LinkStream, TcpLoopback) {
+    captured.clear();
+    tx_async_t capture_tx = make_tx(capture_send);
+    encode_frames(0x01, &capture_tx, 1);
+    ASSERT_EQ(captured.size(), 1u);
+
+    int listener = socket(AF_INET, SOCK_STREAM, 0);
+    ASSERT_GE(listener, 0);
+    struct sockaddr_in addr = {};
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    socklen_t addr_len = sizeof(addr);
+    ASSERT_EQ(bind(listener, (struct sockaddr*)&addr, sizeof(addr)), 0);
+    ASSERT_EQ(listen(listener, 1), 0);
+    ASSERT_EQ(getsockname(listener, (struct sockaddr*)&addr, &addr_len), 0);
+
+    m1_link_stream_t client;
+    EXPECT_EQ(m1_link_stream_open_tcp(&client, "localhost", 1), E_STATE_ADDR);
+    ASSERT_EQ(m1_link_stream_open_tcp(&client, "127.0.0.1",
+                                      ntohs(addr.sin_port)),
+              E_STATE_OK);
+    m1_link_stream_t server;
+    ASSERT_EQ(m1_link_stream_attach(&server, accept(listener, NULL, NULL)),
+              E_STATE_OK);
+
+    std::vector<u8>& frame = captured[0];
+    ASSERT_EQ(client.tx.tx(client.tx.user_data, frame.data(), frame.size()),
+              E_STATE_OK);
+    ASSERT_EQ(m1_link_stream_flush(&client), E_STATE_OK);
+    EXPECT_EQ(client.tx_len, 0u);
+
+    struct pollfd pfd = {server.fd, POLLIN, 0};
+    ASSERT_EQ(poll(&pfd, 1, 1000), 1);
+    u8 buf[256];
+    size_t len = sizeof(buf);
+    ASSERT_EQ(server.rx.rx(server.rx.user_data, buf, &len), E_STATE_OK);
+    EXPECT_EQ(std::vector<u8>(buf, buf + len), frame);
+
+    m1_link_stream_close(&client);
+    m1_link_stream_close(&server);
+    close(listener);
+}
+
+TEST(LinkMetrics, ServesScrapesOverUnixSocket) {
+    tx_async_t capture_tx = make_tx(capture_send);
+    m1_route_item_t route[] = {
+        make_route("out", M1_LINK_TYPE_UART, 0x02, "rx", &capture_tx, NULL, 1,
+                   64),
+    };
+    m1_rx_parse_callback_item_t rx_cb[] = {
+        {M1_TRANSPORT_LAYER_PROTOCOL_TYPE, drop_rx},
+    };
+    u8 source_id = 0x01;
+    m1_t* m1 = m1_protocol_init("node", 4096, route, 1, rx_cb, 1, &source_id,
+                                1);
+    ASSERT_NE(m1, nullptr);
+
+    std::string path =
+        "/tmp/m1_link_metrics_" + std::to_string(getpid()) + ".sock";
+    m1_link_metrics_t server;
+    ASSERT_EQ(m1_link_metrics_open_unix(&server, m1, path.c_str()),
+              E_STATE_OK);
+    EXPECT_EQ(m1_link_metrics_poll(&server), 0u);
+
+    auto scrape = [&](const char* request) {
+        m1_link_stream_t client;
+        EXPECT_EQ(m1_link_stream_open_unix(&client, path.c_str()),
+                  E_STATE_OK);
+        int fd = client.fd;
+        client.fd = -1;
+        m1_link_stream_close(&client);
+        EXPECT_EQ(write(fd, request, strlen(request)),
+                  (ssize_t)strlen(request));
+        EXPECT_EQ(m1_link_metrics_poll(&server), 1u);
+        std::string response;
+        for (;;) {
+            struct pollfd pfd = {fd, POLLIN, 0};
+            char buf[4096];
+            ssize_t n = poll(&pfd, 1, 1000) == 1 ? read(fd, buf, sizeof(buf))
+                                                 : 0;
+            if (n <= 0) {
+                break;
+            }
+            response.append(buf, n);
+        }
+        close(fd);
+        return response;
+    };
+
+    std::string response = scrape("GET /metrics HTTP/1.0\r\n\r\n");
+    EXPECT_EQ(response.rfind("HTTP/1.0 200 OK\r\n", 0), 0u);
+    EXPECT_NE(response.find("Content-Type: application/openmetrics-text"),
+              std::string::npos);
+    EXPECT_NE(response.find("m1_tx_frames_total{instance=\"node\""),
+              std::string::npos);
+    EXPECT_EQ(response.substr(response.size() - 6), "# EOF\n");
+
+    response = scrape("GET /other HTTP/1.0\r\n\r\n");
+    EXPECT_EQ(response.rfind("HTTP/1.0 404", 0), 0u);
+    response = scrape("POST /metrics HTTP/1.0\r\n\r\n");
+    EXPECT_EQ(response.rfind("HTTP/1.0 405", 0), 0u);
+
+    m1_link_metrics_close(&server);
+    EXPECT_NE(access(path.c_str(), F_OK), 0);
+    m1_protocol_deinit(m1);
+}
+
+TEST(LinkMetrics, SilentClientDoesNotDelayTheRunLoop) {
+    tx_async_t capture_tx = make_tx(capture_send);
+    m1_route_item_t route[] = {
+        make_route("out", M1_LINK_TYPE_UART, 0x02, "rx", &capture_tx, NULL, 1,
+                   64),
+    };
+    m1_rx_parse_callback_item_t rx_cb[] = {
+        {M1_TRANSPORT_LAYER_PROTOCOL_TYPE, drop_rx},
+    };
+    u8 source_id = 0x01;
+    m1_t* m1 = m1_protocol_init("node", 4096, route, 1, rx_cb, 1, &source_id,
+                                1);
+    ASSERT_NE(m1, nullptr);
+
+    std::string path =
+        "/tmp/m1_link_metrics_silent_" + std::to_string(getpid()) + ".sock";
+    m1_link_metrics_t server;
+    ASSERT_EQ(m1_link_metrics_open_unix(&server, m1, path.c_str()),
+              E_STATE_OK);
+    auto connect_client = [&]() {
+        m1_link_stream_t client;
+        EXPECT_EQ(m1_link_stream_open_unix(&client, path.c_str()),
+                  E_STATE_OK);
+        int fd = client.fd;
+        client.fd = -1;
+        m1_link_stream_close(&client);
+        return fd;
+    };
+
+    /* A connecting client wakes the loop, then never sends a byte */
+    int silent = connect_client();
+    u64 start_ms = m1_event_now_ms();
+    EXPECT_EQ(m1_protocol_run_wait(m1, 1000), E_STATE_OK);
+    EXPECT_EQ(m1_link_metrics_poll(&server), 0u);
+    EXPECT_LT(m1_event_now_ms() - start_ms, 50u);
+
+    /* The loop keeps its own pace while the client stays connected */
+    start_ms = m1_event_now_ms();
+    for (int i = 0; i < 5; i++) {
+        EXPECT_EQ(m1_protocol_run_wait(m1, 10), E_STATE_OK);
+        EXPECT_EQ(m1_link_metrics_poll(&server), 0u);
+    }
+    EXPECT_LT(m1_event_now_ms() - start_ms, 100u);
+
+    /* Another scrape is answered meanwhile, as soon as it is sent */
+    int fd = connect_client();
+    const char* request = "GET /metrics HTTP/1.0\r\n\r\n";
+    ASSERT_EQ(write(fd, request, strlen(request)), (ssize_t)strlen(request));
+    start_ms = m1_event_now_ms();
+    size_t served = 0;
+    while (!served && m1_event_now_ms() - start_ms < 1000) {
+        EXPECT_EQ(m1_protocol_run_wait(m1, 1000), E_STATE_OK);
+        served = m1_link_metrics_poll(&server);
+    }
+    EXPECT_EQ(served, 1u);
+    EXPECT_LT(m1_event_now_ms() - start_ms, 50u);
+    char buf[32] = {0};
+    EXPECT_GT(read(fd, buf, sizeof(buf) - 1), 0);
+    EXPECT_EQ(std::string(buf).rfind("HTTP/1.0 200 OK\r\n", 0), 0u);
+    close(fd);
+
+    /* The silent client loses its slot once it expires */
+    usleep((M1_LINK_METRICS_TIMEOUT_MS + 10) * 1000);
+    EXPECT_EQ(m1_link_metrics_poll(&server), 0u);
+    struct pollfd pfd = {silent, POLLIN, 0};
+    ASSERT_EQ(poll(&pfd, 1, 1000), 1);
+    EXPECT_EQ(read(silent, buf, sizeof(buf)), 0);
+    close(silent);
+
+    m1_link_metrics_close(&server);
+    m1_protocol_deinit(m1);
+}
+
+TEST(LinkMetrics, SilentClientsExpireWithoutARunWaitTimeout) {
+    tx_async_t capture_tx = make_tx(capture_send);
+    m1_route_item_t route[] = {
+        make_route("out", M1_LINK_TYPE_UART, 0x02, "rx", &capture_tx, NULL, 1,
+                   64),
+    };
+    m1_rx_parse_callback_item_t rx_cb[] = {
+        {M1_TRANSPORT_LAYER_PROTOCOL_TYPE, drop_rx},
+    };
+    u8 source_id = 0x01;
+    m1_t* m1 = m1_protocol_init("node", 4096, route, 1, rx_cb, 1, &source_id,
+                                1);
+    ASSERT_NE(m1, nullptr);
+
+    std::string path =
+        "/tmp/m1_link_metrics_expire_" + std::to_string(getpid()) + ".sock";
+    m1_link_metrics_t server;
+    ASSERT_EQ(m1_link_metrics_open_unix(&server, m1, path.c_str()),
+              E_STATE_OK);
+    EXPECT_EQ(m1_link_metrics_next_timeout(&server), -1);
+    auto connect_client = [&]() {
+        m1_link_stream_t client;
+        EXPECT_EQ(m1_link_stream_open_unix(&client, path.c_str()),
+                  E_STATE_OK);
+        int fd = client.fd;
+        client.fd = -1;
+        m1_link_stream_close(&client);
+        return fd;
+    };
+
+    /* Silent clients take every slot, so the listener leaves the wait set */
+    std::vector<int> silent;
+    for (size_t i = 0; i < M1_LINK_METRICS_CLIENT_NUM; i++) {
+        silent.push_back(connect_client());
+    }
+    u64 start_ms = m1_event_now_ms();
+    while (server.accepting && m1_event_now_ms() - start_ms < 1000) {
+        EXPECT_EQ(m1_protocol_run_wait(m1, 100), E_STATE_OK);
+        m1_link_metrics_poll(&server);
+    }
+    ASSERT_FALSE(server.accepting);
+    i32 timeout_ms = m1_link_metrics_next_timeout(&server);
+    EXPECT_GT(timeout_ms, 0);
+    EXPECT_LE(timeout_ms, M1_LINK_METRICS_TIMEOUT_MS);
+
+    /* A scrape waiting in the backlog is answered once they expire */
+    int fd = connect_client();
+    const char* request = "GET /metrics HTTP/1.0\r\n\r\n";
+    ASSERT_EQ(write(fd, request, strlen(request)), (ssize_t)strlen(request));
+    std::atomic<bool> done{false};
+    std::thread watchdog([&]() {
+        for (int i = 0; i < 300 && !done; i++) {
+            usleep(10 * 1000);
+        }
+        m1_event_wake(m1);
+    });
+    start_ms = m1_event_now_ms();
+    size_t served = 0;
+    while (!served && m1_event_now_ms() - start_ms < 3000) {
+        EXPECT_EQ(m1_protocol_run_wait(m1, -1), E_STATE_OK);
+        served = m1_link_metrics_poll(&server);
+    }
+    done = true;
+    watchdog.join();
+    EXPECT_EQ(served, 1u);
+    EXPECT_LT(m1_event_now_ms() - start_ms, M1_LINK_METRICS_TIMEOUT_MS + 500u);
+    char buf[32] = {0};
+    EXPECT_GT(read(fd, buf, sizeof(buf) - 1), 0);
+    EXPECT_EQ(std::string(buf).rfind("HTTP/1.0 200 OK\r\n", 0), 0u);
+    close(fd);
+    for (int client : silent) {
+        EXPECT_EQ(read(client, buf, sizeof(buf)), 0);
+        close(client);
+    }
+
+    m1_link_metrics_close(&server);
+    m1_protocol_deinit(m1);
+}
+
+/* ----------------------------- end of file -------------------------------- */
@@ -0,0 +1,1465 @@
+/**
+ * \file            test_m1_protocol.cc
+ * \brief           M1 protocol stack tests
+ * \date            2026-10-18
+ */
+
+/*
+ * Copyright (c) 2024 Vector Qiu
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE
+ * AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * This file is part of the your library name library.
+ *
+ * Author:          Vector Qiu <vetor.qiu@gmail.com>
+ * Version:         _version_
+ */
+/* includes ----------------------------------------------------------------- */
+/* includes ----------------------------------------------------------------- */
+#include <gtest/gtest.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "./m1_protocol/m1_buf.h"
+#include "./m1_protocol/m1_counter.h"
+#include "./m1_protocol/m1_histogram.h"
+#include "./m1_protocol/m1_layer_datalink.h"
+#include "./m1_protocol/m1_layer_network.h"
+#include "./m1_protocol/m1_layer_transport.h"
+#include "./m1_protocol/m1_metrics.h"
+#include "./m1_protocol/m1_mpsc_queue.h"
+#include "./m1_protocol/m1_obj_pool.h"
+#include "./m1_protocol/m1_protocol.h"
+#include "./m1_protocol/m1_spsc_ring.h"
+#include "./m1_protocol/m1_trace.h"
+#include "./m1_protocol/m1_work_pool.h"
+
+/* Private variables -------------------------------------------------------- */
+static std::atomic<size_t> tx_frame_cnt{0};
+
+/* Private functions -------------------------------------------------------- */
+/* Driver with only the callbacks a test needs, the others left NULL */
+static tx_async_t make_tx(etype_e (*tx)(void*, u8*, size_t),
+                          void* user_data = NULL) {
+    tx_async_t out = {};
+    out.tx = tx;
+    out.user_data = user_data;
+    return out;
+}
+
+static rx_async_t make_rx(etype_e (*rx)(void*, u8*, size_t*),
+                          int (*get_fd)(void*) = NULL,
+                          void* user_data = NULL) {
+    rx_async_t out = {};
+    out.rx = rx;
+    out.get_fd = get_fd;
+    out.user_data = user_data;
+    return out;
+}
+
+/* Route whose RX buffer is sized from the link type */
+static m1_route_item_t make_route(const char* link_name,
+                                  m1_link_type_e link_type, u8 target_id,
+                                  const char* host_name, tx_async_t* tx,
+                                  rx_async_t* rx, u16 read_freq,
+                                  size_t max_pkg_size) {
+    m1_route_item_t item = {};
+    item.link_name = (char*)link_name;
+    item.link_type = link_type;
+    item.target_id = target_id;
+    item.host_name = (char*)host_name;
+    item.tx = tx;
+    item.rx = rx;
+    item.read_freq = read_freq;
+    item.max_pkg_size = max_pkg_size;
+    return item;
+}
+
+static etype_e count_send(void* user_data, u8* buf, size_t len) {
+    (void)user_data;
+    (void)buf;
+    (void)len;
+    tx_frame_cnt++;
+    return E_STATE_OK;
+}
+
+static void drop_rx(m1_rx_data_t* rx) { (void)rx; }
+
+/* Wire between a sending instance and one RX link of the receiver */
+struct wire {
+    std::mutex lock;
+    std::vector<u8> bytes;
+    size_t read_pos = 0;
+};
+
+static wire wire_a;
+static wire wire_b;
+
+static etype_e wire_write(wire& w, u8* buf, size_t len) {
+    std::lock_guard<std::mutex> guard(w.lock);
+    w.bytes.insert(w.bytes.end(), buf, buf + len);
+    return E_STATE_OK;
+}
+
+static etype_e wire_read(wire& w, u8* buf, size_t* len) {
+    std::lock_guard<std::mutex> guard(w.lock);
+    size_t n = std::min(*len, w.bytes.size() - w.read_pos);
+    memcpy(buf, w.bytes.data() + w.read_pos, n);
+    w.read_pos += n;
+    *len = n;
+    return E_STATE_OK;
+}
+
+static etype_e wire_a_send(void* user_data, u8* buf, size_t len) {
+    (void)user_data;
+    return wire_write(wire_a, buf, len);
+}
+
+static etype_e wire_b_send(void* user_data, u8* buf, size_t len) {
+    (void)user_data;
+    return wire_write(wire_b, buf, len);
+}
+
+static etype_e wire_a_recv(void* user_data, u8* buf, size_t* len) {
+    (void)user_data;
+    return wire_read(wire_a, buf, len);
+}
+
+static etype_e wire_b_recv(void* user_data, u8* buf, size_t* len) {
+    (void)user_data;
+    return wire_read(wire_b, buf, len);
+}
+
+static etype_e drop_send(void* user_data, u8* buf, size_t len) {
+    (void)user_data;
+    (void)buf;
+    (void)len;
+    return E_STATE_OK;
+}
+
+static etype_e fail_send(void* user_data, u8* buf, size_t len) {
+    (void)user_data;
+    (void)buf;
+    (void)len;
+    return E_STATE_ERROR;
+}
+
+/* Payload sequence numbers seen by the threaded receiver, per source */
+static std::mutex rx_seq_lock;
+static std::vector<u32> rx_seq[256];
+static std::atomic<size_t> rx_frame_cnt{0};
+
+static void record_rx(m1_rx_data_t* rx) {
+    u32 seq;
+    memcpy(&seq, rx->data, sizeof(seq));
+    if (rx->source_id == 0x01) {
+        /* Slow handler on one link must not stall the other */
+        std::this_thread::sleep_for(std::chrono::microseconds(50));
+    }
+    {
+        std::lock_guard<std::mutex> guard(rx_seq_lock);
+        rx_seq[rx->source_id].push_back(seq);
+    }
+    rx_frame_cnt++;
+}
+
+/* Link driver over a socket, user_data points to the descriptor */
+static etype_e sock_send(void* user_data, u8* buf, size_t len) {
+    int fd = *(int*)user_data;
+    return send(fd, buf, len, 0) == (ssize_t)len ? E_STATE_OK : E_STATE_ERROR;
+}
+
+static etype_e sock_recv(void* user_data, u8* buf, size_t* len) {
+    ssize_t n = recv(*(int*)user_data, buf, *len, MSG_DONTWAIT);
+    *len = n > 0 ? (size_t)n : 0;
+    return E_STATE_OK;
+}
+
+static int sock_get_fd(void* user_data) { return *(int*)user_data; }
+
+/* Link driver over a regular file, which epoll refuses to watch */
+static etype_e file_recv(void* user_data, u8* buf, size_t* len) {
+    ssize_t n = read(*(int*)user_data, buf, *len);
+    *len = n > 0 ? (size_t)n : 0;
+    return E_STATE_OK;
+}
+
+/* Counts the reads in the size_t at user_data, returns no data */
+static etype_e count_recv(void* user_data, u8* buf, size_t* len) {
+    (void)buf;
+    (*(size_t*)user_data)++;
+    *len = 0;
+    return E_STATE_OK;
+}
+
+/* Records the buffer size offered by each read, returns no data */
+static etype_e offer_recv(void* user_data, u8* buf, size_t* len) {
+    (void)buf;
+    *(size_t*)user_data = *len;
+    *len = 0;
+    return E_STATE_OK;
+}
+
+/* Appends every frame to the std::vector<u8> in user_data */
+static etype_e append_send(void* user_data, u8* buf, size_t len) {
+    std::vector<u8>* out = (std::vector<u8>*)user_data;
+    out->insert(out->end(), buf, buf + len);
+    return E_STATE_OK;
+}
+
+/* Appends every frame to a frame_log and records where it was sent from */
+struct frame_log {
+    std::vector<u8> bytes;
+    std::vector<const u8*> addr;
+};
+
+static etype_e log_send(void* user_data, u8* buf, size_t len) {
+    frame_log* log = (frame_log*)user_data;
+    log->bytes.insert(log->bytes.end(), buf, buf + len);
+    log->addr.push_back(buf);
+    return E_STATE_OK;
+}
+
+static std::vector<std::vector<u8>> rx_payload;
+
+static void keep_rx(m1_rx_data_t* rx) {
+    rx_payload.emplace_back(rx->data, rx->data + rx->data_len);
+}
+
+static void count_rx(m1_rx_data_t* rx) {
+    (void)rx;
+    rx_frame_cnt++;
+}
+
+static i64 elapsed_ms_since(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration_cast<std::chrono::milliseconds>(
+               std::chrono::steady_clock::now() - start)
+        .count();
+}
+
+/* Encode `frame_num` numbered frames from `source_id` to 0x02 */
+static void encode_frames(u8 source_id, tx_async_t* tx, size_t frame_num) {
+    m1_route_item_t route[] = {
+        make_route("out", M1_LINK_TYPE_UART, 0x02, "rx", tx, NULL, 1, 64),
+    };
+    m1_rx_parse_callback_item_t rx_cb[] = {
+        {M1_TRANSPORT_LAYER_PROTOCOL_TYPE, drop_rx},
+    };
+    m1_t* m1 = m1_protocol_init("enc", 4096, route, 1, rx_cb, 1, &source_id,
+                                1);
+    ASSERT_NE(m1, nullptr);
+
+    u8 target_id = 0x02;
+    for (u32 i = 0; i < frame_num; i++) {
+        u8 data[8] = {0};
+        memcpy(data, &i, sizeof(i));
+        m1_tx_data_t tx_data = {};
+        tx_data.target_id = &target_id;
+        tx_data.target_id_len = 1;
+        tx_data.data = data;
+        tx_data.data_len = sizeof(data);
+        tx_data.data_type = M1_TRANSPORT_LAYER_PROTOCOL_TYPE;
+        ASSERT_EQ(m1_protocol_tx_data(m1, &tx_data), E_STATE_OK);
+        m1_protocol_run(m1, 1);
+    }
+    m1_protocol_deinit(m1);
+}
+
+/* Public functions --------------------------------------------------------- */
+TEST(MpscQueue, RoundsCapacityAndReportsFull) {
+    m1_mpsc_queue_t* queue = m1_mpsc_queue_create(5);
+    ASSERT_NE(queue, nullptr);
+    EXPECT_EQ(m1_mpsc_queue_capacity(queue), 8u);
+
+    uintptr_t item = 1;
+    for (size_t i = 0; i < 8; i++) {
+        EXPECT_EQ(m1_mpsc_queue_push(queue, (void*)(item + i)), E_STATE_OK);
+    }
+    EXPECT_EQ(m1_mpsc_queue_push(queue, (void*)item), E_STATE_BUSY);
+
+    for (size_t i = 0; i < 8; i++) {
+        EXPECT_EQ(m1_mpsc_queue_pop(queue), (void*)(item + i));
+    }
+    EXPECT_EQ(m1_mpsc_queue_pop(queue), nullptr);
+    m1_mpsc_queue_destroy(queue);
+}
+
+TEST(MpscQueue, ConcurrentProducersKeepPerProducerOrder) {
+    const size_t producer_num = 4;
+    const size_t item_num = 20000;
+    m1_mpsc_queue_t* queue = m1_mpsc_queue_create(64);
+    ASSERT_NE(queue, nullptr);
+
+    std::vector<std::thread> producers;
+    for (size_t p = 0; p < producer_num; p++) {
+        producers.emplace_back([queue, p, item_num] {
+            for (size_t i = 1; i <= item_num; i++) {
+                /* Producer id in the top byte, sequence below */
+                uintptr_t item = ((uintptr_t)p << 24) | i;
+                while (m1_mpsc_queue_push(queue, (void*)item) != E_STATE_OK) {
+                    std::this_thread::yield();
+                }
+            }
+        });
+    }
+
+    std::vector<size_t> last(producer_num, 0);
+    size_t received = 0;
+    while (received < producer_num * item_num) {
+        uintptr_t item = (uintptr_t)m1_mpsc_queue_pop(queue);
+        if (!item) {
+            std::this_thread::yield();
+            continue;
+        }
+        size_t p = item >> 24;
+        size_t seq = item & 0xFFFFFF;
+        ASSERT_LT(p, producer_num);
+        ASSERT_EQ(seq, last[p] + 1);
+        last[p] = seq;
+        received++;
+    }
+
+    for (auto& producer : producers) {
+        producer.join();
+    }
+    EXPECT_EQ(m1_mpsc_queue_pop(queue), nullptr);
+    m1_mpsc_queue_destroy(queue);
+}
+
+TEST(SpscRing, RoundsCapacityAndWrapsSpans) {
+    m1_spsc_ring_t* ring = m1_spsc_ring_create(10);
+    ASSERT_NE(ring, nullptr);
+    EXPECT_EQ(m1_spsc_ring_capacity(ring), 16u);
+
+    u8 in[16];
+    for (size_t i = 0; i < sizeof(in); i++) {
+        in[i] = (u8)i;
+    }
+    EXPECT_EQ(m1_spsc_ring_write(ring, in, 12), 12u);
+    EXPECT_EQ(m1_spsc_ring_used(ring), 12u);
+
+    u8* span;
+    ASSERT_EQ(m1_spsc_ring_read_span(ring, &span), 12u);
+    EXPECT_EQ(memcmp(span, in, 12), 0);
+    m1_spsc_ring_read_commit(ring, 10);
+
+    /* Writes wrap; the free space is returned as two spans */
+    ASSERT_EQ(m1_spsc_ring_write_span(ring, &span), 4u);
+    EXPECT_EQ(m1_spsc_ring_write(ring, in, sizeof(in)), 14u);
+    EXPECT_EQ(m1_spsc_ring_write_span(ring, &span), 0u);
+    EXPECT_EQ(m1_spsc_ring_used(ring), 16u);
+
+    /* Reads stop at the end of the storage, then continue at its start */
+    ASSERT_EQ(m1_spsc_ring_read_span(ring, &span), 6u);
+    EXPECT_EQ(span[0], 10);
+    EXPECT_EQ(span[2], 0);
+    m1_spsc_ring_read_commit(ring, 6);
+    ASSERT_EQ(m1_spsc_ring_read_span(ring, &span), 10u);
+    EXPECT_EQ(memcmp(span, in + 4, 10), 0);
+    m1_spsc_ring_read_commit(ring, 10);
+    EXPECT_EQ(m1_spsc_ring_read_span(ring, &span), 0u);
+    m1_spsc_ring_destroy(ring);
+}
+
+TEST(SpscRing, ConcurrentProducerKeepsByteOrder) {
+    const size_t byte_num = 1 << 20;
+    m1_spsc_ring_t* ring = m1_spsc_ring_create(256);
+    ASSERT_NE(ring, nullptr);
+
+    std::thread producer([ring, byte_num] {
+        size_t sent = 0;
+        while (sent < byte_num) {
+            u8* span;
+            size_t len = m1_spsc_ring_write_span(ring, &span);
+            if (!len) {
+                std::this_thread::yield();
+                continue;
+            }
+            len = std::min(len, byte_num - sent);
+            for (size_t i = 0; i < len; i++) {
+                span[i] = (u8)((sent + i) * 7);
+            }
+            m1_spsc_ring_write_commit(ring, len);
+            sent += len;
+        }
+    });
+
+    size_t received = 0;
+    while (received < byte_num) {
+        u8* span;
+        size_t len = m1_spsc_ring_read_span(ring, &span);
+        if (!len) {
+            std::this_thread::yield();
+            continue;
+        }
+        for (size_t i = 0; i < len; i++) {
+            ASSERT_EQ(span[i], (u8)((received + i) * 7));
+        }
+        m1_spsc_ring_read_commit(ring, len);
+        received += len;
+    }
+    producer.join();
+    m1_spsc_ring_destroy(ring);
+}
+
+TEST(M1Protocol, TxDataFromSeveralThreads) {
+    tx_async_t tx = make_tx(count_send);
+    m1_route_item_t route[] = {
+        make_route("link", M1_LINK_TYPE_UART, 0x10, "peer", &tx, NULL, 1, 64),
+    };
+    m1_rx_parse_callback_item_t rx_cb[] = {
+        {M1_TRANSPORT_LAYER_PROTOCOL_TYPE, drop_rx},
+    };
+    u8 source_id = 0x01;
+    m1_t* m1 = m1_protocol_init("test", 4096, route, 1, rx_cb, 1, &source_id,
+                                1);
+    ASSERT_NE(m1, nullptr);
+
+    const size_t producer_num = 4;
+    const size_t frame_num = 500;
+    std::atomic<bool> done{false};
+    tx_frame_cnt = 0;
+    std::thread runner([m1, &done] {
+        while (!done) {
+            m1_protocol_run(m1, 1);
+        }
+        m1_protocol_run(m1, 1);
+    });
+
+    std::vector<std::thread> producers;
+    for (size_t p = 0; p < producer_num; p++) {
+        producers.emplace_back([m1, frame_num] {
+            u8 target_id = 0x10;
+            u8 data[8] = {1, 2, 3, 4, 5, 6, 7, 8};
+            m1_tx_data_t tx_data = {};
+            tx_data.target_id = &target_id;
+            tx_data.target_id_len = 1;
+            tx_data.data = data;
+            tx_data.data_len = sizeof(data);
+            tx_data.data_type = M1_TRANSPORT_LAYER_PROTOCOL_TYPE;
+            for (size_t i = 0; i < frame_num; i++) {
+                while (m1_protocol_tx_data(m1, &tx_data) == E_STATE_BUSY) {
+                    std::this_thread::yield();
+                }
+            }
+        });
+    }
+    for (auto& producer : producers) {
+        producer.join();
+    }
+    done = true;
+    runner.join();
+
+    EXPECT_EQ(tx_frame_cnt.load(), producer_num * frame_num);
+    m1_protocol_deinit(m1);
+}
+
+TEST(M1Protocol, TxDataReportsBackpressure) {
+    tx_async_t tx = make_tx(count_send);
+    m1_route_item_t route[] = {
+        make_route("link", M1_LINK_TYPE_UART, 0x10, "peer", &tx, NULL, 1, 64),
+    };
+    m1_rx_parse_callback_item_t rx_cb[] = {
+        {M1_TRANSPORT_LAYER_PROTOCOL_TYPE, drop_rx},
+    };
+    u8 source_id = 0x01;
+    m1_t* m1 = m1_protocol_init("test", 4096, route, 1, rx_cb, 1, &source_id,
+                                1);
+    ASSERT_NE(m1, nullptr);
+
+    u8 target_id = 0x10;
+    u8 data[4] = {0};
+    m1_tx_data_t tx_data = {};
+    tx_data.target_id = &target_id;
+    tx_data.target_id_len = 1;
+    tx_data.data = data;
+    tx_data.data_len = sizeof(data);
+    tx_data.data_type = M1_TRANSPORT_LAYER_PROTOCOL_TYPE;
+
+    size_t queued = 0;
+    while (m1_protocol_tx_data(m1, &tx_data) == E_STATE_OK) {
+        queued++;
+    }
+    EXPECT_EQ(queued, m1_mpsc_queue_capacity(m1->tx_queue));
+
+    tx_frame_cnt = 0;
+    m1_protocol_run(m1, 1);
+    EXPECT_EQ(tx_frame_cnt.load(), queued);
+    EXPECT_EQ(m1_protocol_tx_data(m1, &tx_data), E_STATE_OK);
+    m1_protocol_deinit(m1);
+}
+
+TEST(ObjPool, HandsOutEveryObjectOnce) {
+    const size_t capacity = 8;
+    m1_obj_pool_t* pool = m1_obj_pool_create(3, capacity);
+    ASSERT_NE(pool, nullptr);
+    EXPECT_EQ(m1_obj_pool_capacity(pool), capacity);
+
+    std::vector<void*> obj;
+    for (size_t i = 0; i < capacity; i++) {
+        void* p = m1_obj_pool_alloc(pool);
+        ASSERT_NE(p, nullptr);
+        EXPECT_EQ((uintptr_t)p % alignof(max_align_t), 0u);
+        memset(p, 0xa5, 3);
+        obj.push_back(p);
+    }
+    std::sort(obj.begin(), obj.end());
+    EXPECT_EQ(std::unique(obj.begin(), obj.end()), obj.end());
+    EXPECT_EQ(m1_obj_pool_available(pool), 0u);
+    EXPECT_EQ(m1_obj_pool_alloc(pool), nullptr);
+
+    u8 foreign[16];
+    EXPECT_EQ(m1_obj_pool_free(pool, foreign), E_STATE_INVAL);
+    EXPECT_EQ(m1_obj_pool_free(pool, (u8*)obj[0] + 1), E_STATE_INVAL);
+
+    EXPECT_EQ(m1_obj_pool_free(pool, obj[3]), E_STATE_OK);
+    EXPECT_EQ(m1_obj_pool_available(pool), 1u);
+    EXPECT_EQ(m1_obj_pool_alloc(pool), obj[3]);
+    for (void* p : obj) {
+        EXPECT_EQ(m1_obj_pool_free(pool, p), E_STATE_OK);
+    }
+    EXPECT_EQ(m1_obj_pool_available(pool), capacity);
+    m1_obj_pool_destroy(pool);
+}
+
+TEST(M1Protocol, ReliableTxWaitsForFreePackets) {
+    tx_async_t tx = make_tx(count_send);
+    m1_route_item_t route[] = {
+        make_route("link", M1_LINK_TYPE_UART, 0x10, "peer", &tx, NULL, 1, 64),
+    };
+    m1_rx_parse_callback_item_t rx_cb[] = {
+        {M1_TRANSPORT_LAYER_PROTOCOL_TYPE, drop_rx},
+    };
+    u8 source_id = 0x01;
+    m1_t* m1 = m1_protocol_init("test", 4096, route, 1, rx_cb, 1, &source_id,
+                                1);
+    ASSERT_NE(m1, nullptr);
+
+    u8 target_id = 0x10;
+    u8 data[4] = {0};
+    m1_tx_data_t tx_data = {};
+    tx_data.target_id = &target_id;
+    tx_data.target_id_len = 1;
+    tx_data.data = data;
+    tx_data.data_len = sizeof(data);
+    tx_data.data_type = M1_TRANSPORT_LAYER_PROTOCOL_TYPE;
+    tx_data.reliable_tx = M1_RELIABLE_TX;
+
+    /* Every packet of the pool ends up waiting for its ACK */
+    tx_frame_cnt = 0;
+    for (size_t i = 0; i < M1_PACKET_POOL_SIZE; i++) {
+        ASSERT_EQ(m1_transport_send(m1, &tx_data), E_STATE_OK);
+    }
+    m1_datalink_flush(m1);
+    EXPECT_EQ(tx_frame_cnt.load(), (size_t)M1_PACKET_POOL_SIZE);
+    EXPECT_EQ(m1_transport_send(m1, &tx_data), E_STATE_BUSY);
+
+    /* The submission stays queued instead of being dropped */
+    ASSERT_EQ(m1_protocol_tx_data(m1, &tx_data), E_STATE_OK);
+    m1_protocol_run(m1, 1000);
+    EXPECT_EQ(tx_frame_cnt.load(), (size_t)M1_PACKET_POOL_SIZE);
+
+    /* Unreliable submissions need no packet and pass the parked one */
+    m1_tx_data_t unreliable = tx_data;
+    unreliable.reliable_tx = M1_RELIABLE_NONE;
+    ASSERT_EQ(m1_protocol_tx_data(m1, &unreliable), E_STATE_OK);
+    m1_protocol_run(m1, 1000);
+    EXPECT_EQ(tx_frame_cnt.load(), (size_t)M1_PACKET_POOL_SIZE + 1);
+
+    m1_frame_head_t ack = {};
+    ack.source_id = target_id;
+    ack.target_id = source_id;
+    ack.attr.lsb.reliable = A1_RELIABLE_TX_ACK;
+    ack.ack_num = 0;
+    EXPECT_EQ(m1_transport_receive(m1, (u8*)&ack, sizeof(ack)), E_STATE_OK);
+    m1_protocol_run(m1, 1000);
+    EXPECT_EQ(tx_frame_cnt.load(), (size_t)M1_PACKET_POOL_SIZE + 2);
+
+    /* More targets than packets could never be sent */
+    u8 targets[M1_PACKET_POOL_SIZE + 1];
+    memset(targets, target_id, sizeof(targets));
+    tx_data.target_id = targets;
+    tx_data.target_id_len = sizeof(targets);
+    EXPECT_EQ(m1_protocol_tx_data(m1, &tx_data), E_STATE_ARGUMENT_BIG);
+
+    /* Rejected submissions are counted instead of vanishing */
+    u8 unknown_id = 0x33;
+    unreliable.target_id = &unknown_id;
+    ASSERT_EQ(m1_protocol_tx_data(m1, &unreliable), E_STATE_OK);
+    m1_protocol_run(m1, 1000);
+    m1_stats_net_t net;
+    ASSERT_EQ(m1_protocol_net_stats(m1, &net), E_STATE_OK);
+    EXPECT_EQ(net.tx_drop_cnt, 1u);
+    m1_protocol_deinit(m1);
+}
+
+TEST(Buf, CountsReferencesFromSeveralThreads) {
+    m1_buf_t* buf = m1_buf_alloc(16);
+    ASSERT_NE(buf, nullptr);
+    EXPECT_EQ(m1_buf_len(buf), 16u);
+    EXPECT_EQ(m1_buf_refcnt(buf), 1u);
+    memset(m1_buf_data(buf), 0x5a, m1_buf_len(buf));
+
+    const size_t thread_num = 4;
+    const size_t ref_num = 10000;
+    std::vector<std::thread> holders;
+    for (size_t t = 0; t < thread_num; t++) {
+        holders.emplace_back([buf, ref_num] {
+            for (size_t i = 0; i < ref_num; i++) {
+                m1_buf_ref(buf);
+            }
+            for (size_t i = 0; i < ref_num; i++) {
+                m1_buf_unref(buf);
+            }
+        });
+    }
+    for (auto& holder : holders) {
+        holder.join();
+    }
+    EXPECT_EQ(m1_buf_refcnt(buf), 1u);
+    EXPECT_EQ(m1_buf_ref(buf), buf);
+    EXPECT_EQ(m1_buf_refcnt(buf), 2u);
+    m1_buf_unref(buf);
+    m1_buf_unref(buf);
+    m1_buf_unref(NULL);
+}
+
+TEST(M1Protocol, ReliableMulticastSharesOnePayloadCopy) {
+    frame_log log;
+    tx_async_t tx = make_tx(log_send, &log);
+    m1_route_item_t route[] = {
+        make_route("link", M1_LINK_TYPE_UART, 0x10, "a", &tx, NULL, 1, 64),
+        make_route("link", M1_LINK_TYPE_UART, 0x11, "b", &tx, NULL, 1, 64),
+    };
+    m1_rx_parse_callback_item_t rx_cb[] = {
+        {M1_TRANSPORT_LAYER_PROTOCOL_TYPE, drop_rx},
+    };
+    u8 source_id = 0x01;
+    m1_t* m1 = m1_protocol_init("test", 4096, route, 2, rx_cb, 1, &source_id,
+                                1);
+    ASSERT_NE(m1, nullptr);
+
+    u8 target_id[] = {0x10, 0x11};
+    u8 data[8] = {1, 2, 3, 4, 5, 6, 7, 8};
+    const std::vector<u8> sent(data, data + sizeof(data));
+    m1_tx_data_t tx_data = {};
+    tx_data.target_id = target_id;
+    tx_data.target_id_len = sizeof(target_id);
+    tx_data.data = data;
+    tx_data.data_len = sizeof(data);
+    tx_data.data_type = M1_TRANSPORT_LAYER_PROTOCOL_TYPE;
+    tx_data.reliable_tx = M1_RELIABLE_TX;
+    ASSERT_EQ(m1_protocol_tx_data(m1, &tx_data), E_STATE_OK);
+    memset(data, 0, sizeof(data));
+
+    m1_protocol_run(m1, 1000);
+    ASSERT_EQ(log.addr.size(), 2u);
+    /* Both targets time out and are sent again from the same copy */
+    m1_transport_run(m1, 1000);
+    ASSERT_EQ(log.addr.size(), 4u);
+    for (const u8* addr : log.addr) {
+        EXPECT_EQ(addr, log.addr[0]);
+    }
+    m1_protocol_deinit(m1);
+
+    /* Every frame still decodes to the submitted payload */
+    tx_async_t ack_tx = make_tx(drop_send);
+    rx_async_t rx = make_rx(wire_b_recv);
+    m1_route_item_t rx_route[] = {
+        make_route("link", M1_LINK_TYPE_UART, 0x01, "src", &ack_tx, &rx, 1000,
+                   64),
+    };
+    m1_rx_parse_callback_item_t keep_cb[] = {
+        {M1_TRANSPORT_LAYER_PROTOCOL_TYPE, keep_rx},
+    };
+    m1_t* receiver = m1_protocol_init("rx", 4096, rx_route, 1, keep_cb, 1,
+                                      target_id, sizeof(target_id));
+    ASSERT_NE(receiver, nullptr);
+    {
+        std::lock_guard<std::mutex> guard(wire_b.lock);
+        wire_b.bytes = log.bytes;
+        wire_b.read_pos = 0;
+    }
+    rx_payload.clear();
+    for (int i = 0; i < 16 && rx_payload.size() < 4; i++) {
+        m1_protocol_run(receiver, 1000);
+    }
+    ASSERT_EQ(rx_payload.size(), 4u);
+    for (const auto& payload : rx_payload) {
+        EXPECT_EQ(payload, sent);
+    }
+    m1_protocol_deinit(receiver);
+}
+
+TEST(Histogram, BucketsKeepRelativeErrorBounded) {
+    size_t last = 0;
+    for (u64 v = 0; v < (1u << 20); v += 1 + v / 64) {
+        size_t index = m1_histogram_index(v);
+        ASSERT_LT(index, (size_t)M1_HISTOGRAM_BUCKET_NUM);
+        ASSERT_GE(index, last);
+        ASSERT_LE(m1_histogram_bucket_min(index), v);
+        ASSERT_GE(m1_histogram_bucket_max(index), v);
+        u64 width = m1_histogram_bucket_max(index) -
+                    m1_histogram_bucket_min(index) + 1;
+        ASSERT_LE(width, std::max<u64>(1, v >> M1_HISTOGRAM_SUB_BITS));
+        last = index;
+    }
+    EXPECT_EQ(m1_histogram_index(UINT64_MAX), M1_HISTOGRAM_BUCKET_NUM - 1u);
+
+    m1_histogram_t hist;
+    m1_histogram_reset(&hist);
+    EXPECT_EQ(m1_histogram_percentile(&hist, 50), 0u);
+    for (u64 v = 1; v <= 1000; v++) {
+        m1_histogram_record(&hist, v);
+    }
+    EXPECT_EQ(hist.count, 1000u);
+    EXPECT_EQ(hist.min, 1u);
+    EXPECT_EQ(hist.max, 1000u);
+    EXPECT_NEAR((double)m1_histogram_percentile(&hist, 50), 500, 500 / 16.0);
+    EXPECT_NEAR((double)m1_histogram_percentile(&hist, 99), 990, 990 / 16.0);
+    EXPECT_EQ(m1_histogram_percentile(&hist, 100), 1000u);
+    EXPECT_EQ(m1_histogram_percentile(&hist, 0), 1u);
+}
+
+TEST(M1Protocol, RecordsLatencyPerRoute) {
+    tx_async_t tx = make_tx(count_send);
+    m1_route_item_t route[] = {
+        make_route("link", M1_LINK_TYPE_UART, 0x10, "peer", &tx, NULL, 1, 64),
+    };
+    m1_rx_parse_callback_item_t rx_cb[] = {
+        {M1_TRANSPORT_LAYER_PROTOCOL_TYPE, drop_rx},
+    };
+    u8 source_id = 0x01;
+    m1_t* m1 = m1_protocol_init("test", 4096, route, 1, rx_cb, 1, &source_id,
+                                1);
+    ASSERT_NE(m1, nullptr);
+
+    u8 target_id = 0x10;
+    u8 data[4] = {0};
+    m1_tx_data_t tx_data = {};
+    tx_data.target_id = &target_id;
+    tx_data.target_id_len = 1;
+    tx_data.data = data;
+    tx_data.data_len = sizeof(data);
+    tx_data.data_type = M1_TRANSPORT_LAYER_PROTOCOL_TYPE;
+    tx_data.reliable_tx = M1_RELIABLE_TX;
+    ASSERT_EQ(m1_protocol_tx_data(m1, &tx_data), E_STATE_OK);
+    std::this_thread::sleep_for(std::chrono::milliseconds(2));
+    m1_protocol_run(m1, 1000);
+    std::this_thread::sleep_for(std::chrono::milliseconds(3));
+
+    m1_frame_head_t ack = {};
+    ack.source_id = target_id;
+    ack.target_id = source_id;
+    ack.attr.lsb.reliable = A1_RELIABLE_TX_ACK;
+    ack.ack_num = 0;
+    ASSERT_EQ(m1_transport_receive(m1, (u8*)&ack, sizeof(ack)), E_STATE_OK);
+
+    m1_histogram_t hist;
+    ASSERT_EQ(m1_protocol_latency_snapshot(m1, 0, M1_LATENCY_TX_QUEUE, &hist),
+              E_STATE_OK);
+    EXPECT_EQ(hist.count, 1u);
+    EXPECT_GE(hist.max, 2000u);
+    ASSERT_EQ(m1_protocol_latency_snapshot(m1, 0, M1_LATENCY_ACK_RTT, &hist),
+              E_STATE_OK);
+    EXPECT_EQ(hist.count, 1u);
+    EXPECT_GE(m1_histogram_percentile(&hist, 99), 3000u);
+    EXPECT_EQ(m1_protocol_latency_snapshot(m1, 1, M1_LATENCY_ACK_RTT, &hist),
+              E_STATE_INVAL);
+
+    m1_protocol_latency_reset(m1);
+    ASSERT_EQ(m1_protocol_latency_snapshot(m1, 0, M1_LATENCY_ACK_RTT, &hist),
+              E_STATE_OK);
+    EXPECT_EQ(hist.count, 0u);
+    m1_protocol_deinit(m1);
+
+    /* Frames read from a link are timed up to their callback */
+    {
+        std::lock_guard<std::mutex> guard(wire_b.lock);
+        wire_b.bytes.clear();
+        wire_b.read_pos = 0;
+    }
+    tx_async_t wire_tx = make_tx(wire_b_send);
+    encode_frames(0x01, &wire_tx, 3);
+    tx_async_t ack_tx = make_tx(drop_send);
+    rx_async_t rx = make_rx(wire_b_recv);
+    m1_route_item_t rx_route[] = {
+        make_route("link", M1_LINK_TYPE_UART, 0x01, "src", &ack_tx, &rx, 1000,
+                   64),
+    };
+    u8 rx_id = 0x02;
+    m1_t* receiver = m1_protocol_init("rx", 4096, rx_route, 1, rx_cb, 1,
+                                      &rx_id, 1);
+    ASSERT_NE(receiver, nullptr);
+    m1_protocol_run(receiver, 1000);
+    ASSERT_EQ(m1_protocol_latency_snapshot(receiver, 0,
+                                           M1_LATENCY_RX_CALLBACK, &hist),
+              E_STATE_OK);
+    EXPECT_EQ(hist.count, 3u);
+    m1_protocol_deinit(receiver);
+}
+
+TEST(M1Protocol, CountsTxStatsPerRoute) {
+    tx_async_t tx = make_tx(count_send);
+    tx_async_t broken_tx = make_tx(fail_send);
+    m1_route_item_t route[] = {
+        make_route("link", M1_LINK_TYPE_UART, 0x10, "peer", &tx, NULL, 1, 64),
+        make_route("broken", M1_LINK_TYPE_UART, 0x20, "peer", &broken_tx, NULL,
+                   1, 64),
+    };
+    m1_rx_parse_callback_item_t rx_cb[] = {
+        {M1_TRANSPORT_LAYER_PROTOCOL_TYPE, drop_rx},
+    };
+    u8 source_id = 0x01;
+    m1_t* m1 = m1_protocol_init("test", 4096, route, 2, rx_cb, 1, &source_id,
+                                1);
+    ASSERT_NE(m1, nullptr);
+
+    u8 target_id = 0x10;
+    u8 data[4] = {0};
+    m1_tx_data_t tx_data = {};
+    tx_data.target_id = &target_id;
+    tx_data.target_id_len = 1;
+    tx_data.data = data;
+    tx_data.data_len = sizeof(data);
+    tx_data.data_type = M1_TRANSPORT_LAYER_PROTOCOL_TYPE;
+    tx_data.reliable_tx = M1_RELIABLE_TX;
+
+    /* Unacknowledged: four retransmissions, then the packet is given up */
+    ASSERT_EQ(m1_transport_send(m1, &tx_data), E_STATE_OK);
+    for (int i = 0; i < 5; i++) {
+        m1_transport_run(m1, 1000);
+    }
+
+    /* Acknowledged once, then the same ACK again */
+    ASSERT_EQ(m1_transport_send(m1, &tx_data), E_STATE_OK);
+    m1_frame_head_t ack = {};
+    ack.source_id = target_id;
+    ack.target_id = source_id;
+    ack.attr.lsb.reliable = A1_RELIABLE_TX_ACK;
+    ack.ack_num = 1;
+    EXPECT_EQ(m1_transport_receive(m1, (u8*)&ack, sizeof(ack)), E_STATE_OK);
+    EXPECT_EQ(m1_transport_receive(m1, (u8*)&ack, sizeof(ack)), E_STATE_OK);
+    ack.source_id = 0x77;
+    EXPECT_EQ(m1_transport_receive(m1, (u8*)&ack, sizeof(ack)), E_STATE_OK);
+
+    m1_stats_tx_t stats;
+    ASSERT_EQ(m1_protocol_tx_stats(m1, 0, &stats), E_STATE_OK);
+    size_t frame_len = sizeof(m1_frame_head_t) + sizeof(data) + sizeof(u16);
+    EXPECT_EQ(stats.frame_cnt, 6u);
+    EXPECT_EQ(stats.bytes, 6 * frame_len);
+    EXPECT_EQ(stats.retransmit_cnt, 4u);
+    EXPECT_EQ(stats.retry_exhausted_cnt, 1u);
+    EXPECT_EQ(stats.ack_cnt, 1u);
+    EXPECT_EQ(stats.ack_unmatched_cnt, 1u);
+    EXPECT_EQ(stats.tx_err_cnt, 0u);
+
+    /* A failing link and a target without a route */
+    tx_data.reliable_tx = M1_RELIABLE_NONE;
+    u8 broken_id[] = {0x20, 0x99};
+    tx_data.target_id = broken_id;
+    tx_data.target_id_len = 2;
+    EXPECT_EQ(m1_transport_send(m1, &tx_data), E_STATE_ERROR);
+    ASSERT_EQ(m1_protocol_tx_stats(m1, 1, &stats), E_STATE_OK);
+    EXPECT_EQ(stats.frame_cnt, 0u);
+    EXPECT_EQ(stats.tx_err_cnt, 1u);
+
+    /* Frames for other nodes are forwarded or dropped */
+    m1_frame_head_t frame = {};
+    frame.source_id = 0x30;
+    frame.target_id = 0x10;
+    EXPECT_EQ(m1_network_receive(m1, (u8*)&frame, sizeof(frame)), E_STATE_OK);
+    frame.target_id = 0x99;
+    EXPECT_EQ(m1_network_receive(m1, (u8*)&frame, sizeof(frame)),
+              E_STATE_NOT_EXIST);
+    ASSERT_EQ(m1_protocol_tx_stats(m1, 0, &stats), E_STATE_OK);
+    EXPECT_EQ(stats.forward_cnt, 1u);
+    EXPECT_EQ(stats.forward_bytes, sizeof(frame));
+
+    m1_stats_net_t net;
+    ASSERT_EQ(m1_protocol_net_stats(m1, &net), E_STATE_OK);
+    EXPECT_EQ(net.tx_no_route_cnt, 1u);
+    EXPECT_EQ(net.fwd_no_route_cnt, 1u);
+    EXPECT_EQ(net.ack_no_route_cnt, 1u);
+    EXPECT_EQ(m1_protocol_tx_stats(m1, 2, &stats), E_STATE_INVAL);
+
+    /* The same events are in the trace ring, in order */
+    m1_trace_record_t record[32];
+    size_t record_num = m1_protocol_trace_drain(m1, record, 32);
+    std::vector<u32> event;
+    for (size_t i = 0; i < record_num; i++) {
+        event.push_back(record[i].event);
+    }
+    std::vector<u32> expect(4, M1_TRACE_RETRANSMIT);
+    expect.insert(expect.end(),
+                  {M1_TRACE_RETRY_EXHAUSTED, M1_TRACE_ACK_RX,
+                   M1_TRACE_ACK_UNMATCHED, M1_TRACE_ACK_UNMATCHED,
+                   M1_TRACE_TX_NO_ROUTE, M1_TRACE_TX_ERR,
+                   M1_TRACE_FWD_NO_ROUTE});
+    EXPECT_EQ(event, expect);
+    EXPECT_EQ(record[5].arg[0], 0x10u);
+    EXPECT_EQ(record[5].arg[1], 1u);
+    EXPECT_EQ(m1_protocol_trace_drain(m1, record, 32), 0u);
+    m1_protocol_deinit(m1);
+}
+
+TEST(Metrics, RendersOpenMetricsText) {
+    tx_async_t tx = make_tx(count_send);
+    m1_route_item_t route[] = {
+        make_route("li\"nk", M1_LINK_TYPE_UART, 0x10, "peer", &tx, NULL, 1, 64),
+    };
+    m1_rx_parse_callback_item_t rx_cb[] = {
+        {M1_TRANSPORT_LAYER_PROTOCOL_TYPE, drop_rx},
+    };
+    u8 source_id = 0x01;
+    m1_t* m1 = m1_protocol_init("test", 4096, route, 1, rx_cb, 1, &source_id,
+                                1);
+    ASSERT_NE(m1, nullptr);
+
+    u8 target_id = 0x10;
+    u8 data[4] = {0};
+    m1_tx_data_t tx_data = {};
+    tx_data.target_id = &target_id;
+    tx_data.target_id_len = 1;
+    tx_data.data = data;
+    tx_data.data_len = sizeof(data);
+    tx_data.data_type = M1_TRANSPORT_LAYER_PROTOCOL_TYPE;
+    for (int i = 0; i < 2; i++) {
+        ASSERT_EQ(m1_protocol_tx_data(m1, &tx_data), E_STATE_OK);
+        m1_protocol_run(m1, 1);
+    }
+
+    size_t len = 0;
+    char small[16];
+    EXPECT_EQ(m1_metrics_render(NULL, small, sizeof(small), &len),
+              E_STATE_INVAL);
+    ASSERT_EQ(m1_metrics_render(m1, small, sizeof(small), &len),
+              E_STATE_NO_SPACE);
+    std::vector<char> buf(len + 1);
+    size_t text_len = 0;
+    ASSERT_EQ(m1_metrics_render(m1, buf.data(), buf.size(), &text_len),
+              E_STATE_OK);
+    EXPECT_EQ(text_len, len);
+    std::string text(buf.data());
+    EXPECT_EQ(text.size(), len);
+
+    const char* labels =
+        "{instance=\"test\",link=\"li\\\"nk\",target=\"0x10\"}";
+    EXPECT_NE(text.find("# TYPE m1_tx_frames counter\n"), std::string::npos);
+    EXPECT_NE(text.find(std::string("m1_tx_frames_total") + labels + " 2\n"),
+              std::string::npos);
+    EXPECT_NE(text.find(std::string("m1_tx_queue_seconds_count") + labels +
+                        " 2\n"),
+              std::string::npos);
+    EXPECT_NE(text.find("m1_tx_no_route_total{instance=\"test\"} 0\n"),
+              std::string::npos);
+    EXPECT_NE(text.find("# TYPE m1_tx_pool_usage_ratio gauge\n"),
+              std::string::npos);
+    /* Route without an RX link exports no RX samples */
+    EXPECT_EQ(text.find("m1_rx_bytes_total"), std::string::npos);
+    ASSERT_GE(text.size(), 6u);
+    EXPECT_EQ(text.substr(text.size() - 6), "# EOF\n");
+    m1_protocol_deinit(m1);
+}
+
+TEST(M1Protocol, MulticastReportsTargetsWithoutRoute) {
+    tx_frame_cnt = 0;
+    tx_async_t tx = make_tx(count_send);
+    m1_route_item_t route[] = {
+        make_route("a", M1_LINK_TYPE_UART, 0x10, "peer", &tx, NULL, 1, 64),
+        make_route("b", M1_LINK_TYPE_UART, 0x20, "peer", &tx, NULL, 1, 64),
+    };
+    m1_rx_parse_callback_item_t rx_cb[] = {
+        {M1_TRANSPORT_LAYER_PROTOCOL_TYPE, drop_rx},
+    };
+    u8 source_id = 0x01;
+    m1_t* m1 = m1_protocol_init("test", 4096, route, 2, rx_cb, 1, &source_id,
+                                1);
+    ASSERT_NE(m1, nullptr);
+
+    u8 data[4] = {0};
+    m1_packet_data_t packet_data = {};
+    packet_data.data = data;
+    packet_data.data_len = sizeof(data);
+    m1_packet_t packet = {};
+    packet.source_id = source_id;
+    packet.data_type = M1_TRANSPORT_LAYER_PROTOCOL_TYPE;
+    packet.data = &packet_data;
+
+    /* Reachable targets are still sent to */
+    u8 target_id[] = {0x10, 0x99, 0x20};
+    EXPECT_EQ(m1_network_send_multicast(m1, &packet, target_id, 3, true),
+              E_STATE_NOT_EXIST);
+    EXPECT_EQ(tx_frame_cnt, 2u);
+    m1_stats_net_t net;
+    ASSERT_EQ(m1_protocol_net_stats(m1, &net), E_STATE_OK);
+    EXPECT_EQ(net.tx_no_route_cnt, 1u);
+
+    EXPECT_EQ(m1_network_send_multicast(m1, &packet, target_id, 2, true),
+              E_STATE_NOT_EXIST);
+    EXPECT_EQ(m1_network_send_multicast(m1, &packet, &target_id[2], 1, true),
+              E_STATE_OK);
+    std::vector<u8> many(UINT8_MAX + 1, 0x10);
+    EXPECT_EQ(m1_network_send_multicast(m1, &packet, many.data(), many.size(),
+                                        true),
+              E_STATE_INVAL);
+    EXPECT_EQ(tx_frame_cnt, 4u);
+    m1_protocol_deinit(m1);
+}
+
+TEST(Counter, SumsShardsOfSeveralThreads) {
+    const size_t thread_num = 8;
+    const u64 add_num = 100000;
+    m1_counter_t* counter = m1_counter_create(3);
+    ASSERT_NE(counter, nullptr);
+
+    std::vector<std::thread> threads;
+    for (size_t t = 0; t < thread_num; t++) {
+        threads.emplace_back([counter, add_num] {
+            for (u64 i = 0; i < add_num; i++) {
+                m1_counter_add(counter, 1, 1);
+                m1_counter_add(counter, 2, 1ull << 32);
+            }
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    m1_counter_add(counter, 3, 1);
+
+    u64 value[3];
+    ASSERT_EQ(m1_counter_snapshot(counter, 0, value, 3), E_STATE_OK);
+    EXPECT_EQ(value[0], 0u);
+    EXPECT_EQ(value[1], thread_num * add_num);
+    EXPECT_EQ(value[2], (thread_num * add_num) << 32);
+    EXPECT_EQ(m1_counter_read(counter, 1), thread_num * add_num);
+    EXPECT_EQ(m1_counter_snapshot(counter, 1, value, 3), E_STATE_INVAL);
+    m1_counter_destroy(counter);
+}
+
+TEST(Trace, KeepsOldestRecordsAndCountsDrops) {
+    m1_trace_t* trace = m1_trace_create(3);
+    ASSERT_NE(trace, nullptr);
+    for (u32 i = 0; i < 6; i++) {
+        m1_trace_record(trace, M1_TRACE_ACK_RX, 0x10, i, 0);
+    }
+    EXPECT_EQ(m1_trace_dropped(trace), 2u);
+
+    m1_trace_record_t record[8];
+    ASSERT_EQ(m1_trace_drain(trace, record, 8), 4u);
+    for (u32 i = 0; i < 4; i++) {
+        EXPECT_EQ(record[i].arg[1], i);
+    }
+    EXPECT_LE(record[0].stamp_us, record[3].stamp_us);
+
+    char line[64];
+    m1_trace_format(&record[1], line, sizeof(line));
+    EXPECT_NE(strstr(line, " ack_rx 0x10 1 0\n"), nullptr);
+    record[1].event = M1_TRACE_USER;
+    m1_trace_format(&record[1], line, sizeof(line));
+    EXPECT_NE(strstr(line, " event_32768 "), nullptr);
+    m1_trace_destroy(trace);
+}
+
+TEST(Trace, ConcurrentProducersKeepPerProducerOrder) {
+    const u32 producer_num = 4;
+    const u32 record_num = 2000;
+    m1_trace_t* trace = m1_trace_create(producer_num * record_num);
+    ASSERT_NE(trace, nullptr);
+
+    std::vector<std::thread> threads;
+    for (u32 p = 0; p < producer_num; p++) {
+        threads.emplace_back([trace, p, record_num] {
+            for (u32 i = 0; i < record_num; i++) {
+                m1_trace_record(trace, M1_TRACE_USER, p, i, 0);
+            }
+        });
+    }
+    std::vector<u32> next(producer_num, 0);
+    m1_trace_record_t record[64];
+    size_t total = 0;
+    while (total < producer_num * record_num) {
+        size_t num = m1_trace_drain(trace, record, 64);
+        for (size_t i = 0; i < num; i++) {
+            ASSERT_EQ(record[i].arg[1], next[record[i].arg[0]]++);
+        }
+        total += num;
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    EXPECT_EQ(m1_trace_dropped(trace), 0u);
+    m1_trace_destroy(trace);
+}
+
+TEST(WorkPool, KeepsPerKeyOrder) {
+    struct job {
+        m1_work_t work;
+        u8 key;
+        u32 seq;
+    };
+    static std::mutex lock;
+    static std::vector<u32> seen[4];
+    static std::atomic<size_t> done{0};
+
+    m1_work_pool_t* pool = m1_work_pool_create(4);
+    ASSERT_NE(pool, nullptr);
+
+    const u32 job_num = 5000;
+    std::vector<job> jobs(4 * job_num);
+    for (u32 i = 0; i < job_num; i++) {
+        for (u8 key = 0; key < 4; key++) {
+            job& j = jobs[i * 4 + key];
+            j.key = key;
+            j.seq = i;
+            j.work.fn = [](m1_work_t* work) {
+                job* j = (job*)work;
+                std::lock_guard<std::mutex> guard(lock);
+                seen[j->key].push_back(j->seq);
+                done++;
+            };
+            m1_work_pool_submit(pool, key, &j.work);
+        }
+    }
+    m1_work_pool_destroy(pool);
+
+    EXPECT_EQ(done.load(), 4 * job_num);
+    for (u8 key = 0; key < 4; key++) {
+        ASSERT_EQ(seen[key].size(), job_num);
+        for (u32 i = 0; i < job_num; i++) {
+            ASSERT_EQ(seen[key][i], i);
+        }
+    }
+}
+
+TEST(M1Protocol, ThreadedRxKeepsPerSourceOrder) {
+    const size_t frame_num = 1000;
+    tx_async_t tx_a = make_tx(wire_a_send);
+    tx_async_t tx_b = make_tx(wire_b_send);
+    encode_frames(0x01, &tx_a, frame_num);
+    encode_frames(0x03, &tx_b, frame_num);
+
+    tx_async_t tx = make_tx(drop_send);
+    rx_async_t rx_a = make_rx(wire_a_recv);
+    rx_async_t rx_b = make_rx(wire_b_recv);
+    m1_route_item_t route[] = {
+        make_route("a", M1_LINK_TYPE_UART, 0x01, "a", &tx, &rx_a, 1000, 64),
+        make_route("b", M1_LINK_TYPE_UART, 0x03, "b", &tx, &rx_b, 1000, 64),
+    };
+    m1_rx_parse_callback_item_t rx_cb[] = {
+        {M1_TRANSPORT_LAYER_PROTOCOL_TYPE, record_rx},
+    };
+    u8 source_id = 0x02;
+    m1_t* m1 = m1_protocol_init("rx", 4096, route, 2, rx_cb, 1, &source_id,
+                                1);
+    ASSERT_NE(m1, nullptr);
+    ASSERT_EQ(m1_protocol_rx_thread_start(m1, 2), E_STATE_OK);
+    EXPECT_EQ(m1_protocol_rx_thread_start(m1, 2), E_STATE_REPEATED);
+
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+    while (rx_frame_cnt < 2 * frame_num &&
+           std::chrono::steady_clock::now() < deadline) {
+        m1_protocol_run(m1, 1000);
+        std::this_thread::sleep_for(std::chrono::microseconds(100));
+    }
+    m1_protocol_rx_thread_stop(m1);
+
+    EXPECT_EQ(rx_frame_cnt.load(), 2 * frame_num);
+    for (u8 source : {0x01, 0x03}) {
+        ASSERT_EQ(rx_seq[source].size(), frame_num);
+        for (u32 i = 0; i < frame_num; i++) {
+            ASSERT_EQ(rx_seq[source][i], i);
+        }
+    }
+
+    /* Counted by the reader threads, summed here */
+    m1_stats_rx_parse_t stats;
+    for (size_t i = 0; i < 2; i++) {
+        ASSERT_EQ(m1_protocol_rx_stats(m1, i, &stats), E_STATE_OK);
+        EXPECT_EQ(stats.crc16_ok_cnt, frame_num);
+        EXPECT_EQ(stats.crc16_err_cnt, 0u);
+        EXPECT_GT(stats.total_bytes, frame_num * sizeof(m1_frame_head_t));
+    }
+    m1_protocol_deinit(m1);
+}
+
+TEST(M1Protocol, RunWaitWakesOnLinkData) {
+    int sv[2];
+    ASSERT_EQ(socketpair(AF_UNIX, SOCK_STREAM, 0, sv), 0);
+
+    tx_async_t tx = make_tx(drop_send);
+    rx_async_t rx = make_rx(sock_recv, sock_get_fd, &sv[0]);
+    m1_route_item_t route[] = {
+        make_route("sock", M1_LINK_TYPE_UART, 0x01, "sock", &tx, &rx, 1, 64),
+    };
+    m1_rx_parse_callback_item_t rx_cb[] = {
+        {M1_TRANSPORT_LAYER_PROTOCOL_TYPE, count_rx},
+    };
+    u8 source_id = 0x02;
+    m1_t* m1 = m1_protocol_init("rx", 4096, route, 1, rx_cb, 1, &source_id,
+                                1);
+    ASSERT_NE(m1, nullptr);
+
+    /* A 1 Hz link would be polled once a second; the descriptor wakes the
+       loop as soon as the frame arrives */
+    rx_frame_cnt = 0;
+    auto start = std::chrono::steady_clock::now();
+    std::thread runner([m1] { m1_protocol_run_wait(m1, 5000); });
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    tx_async_t sock_tx = make_tx(sock_send, &sv[1]);
+    encode_frames(0x01, &sock_tx, 1);
+    runner.join();
+
+    EXPECT_EQ(rx_frame_cnt.load(), 1u);
+    EXPECT_LT(elapsed_ms_since(start), 1000);
+    m1_protocol_deinit(m1);
+    close(sv[0]);
+    close(sv[1]);
+}
+
+TEST(M1Protocol, RunWaitPollsLinksThatCannotBeWatched) {
+    std::vector<u8> wire;
+    tx_async_t wire_tx = make_tx(append_send, &wire);
+    encode_frames(0x01, &wire_tx, 1);
+    ASSERT_FALSE(wire.empty());
+
+    char path[] = "/tmp/m1_file_link_XXXXXX";
+    int fd = mkstemp(path);
+    ASSERT_GE(fd, 0);
+    unlink(path);
+    ASSERT_EQ(write(fd, wire.data(), wire.size()), (ssize_t)wire.size());
+    ASSERT_EQ(lseek(fd, 0, SEEK_SET), 0);
+
+    tx_async_t tx = make_tx(drop_send);
+    rx_async_t rx = make_rx(file_recv, sock_get_fd, &fd);
+    m1_route_item_t route[] = {
+        make_route("file", M1_LINK_TYPE_UART, 0x01, "file", &tx, &rx, 100, 64),
+    };
+    m1_rx_parse_callback_item_t rx_cb[] = {
+        {M1_TRANSPORT_LAYER_PROTOCOL_TYPE, count_rx},
+    };
+    u8 source_id = 0x02;
+    m1_t* m1 = m1_protocol_init("rx", 4096, route, 1, rx_cb, 1, &source_id,
+                                1);
+    ASSERT_NE(m1, nullptr);
+
+    /* Polled at its 100 Hz read period instead of waiting for readiness */
+    rx_frame_cnt = 0;
+    auto start = std::chrono::steady_clock::now();
+    EXPECT_EQ(m1_protocol_run_wait(m1, 5000), E_STATE_OK);
+    EXPECT_EQ(rx_frame_cnt.load(), 1u);
+    EXPECT_LT(elapsed_ms_since(start), 1000);
+    m1_protocol_deinit(m1);
+    close(fd);
+}
+
+TEST(M1Protocol, RunWaitPollsFastLinksAtLeastOneMsApart) {
+    size_t read_cnt = 0;
+    tx_async_t tx = make_tx(drop_send);
+    rx_async_t rx = make_rx(count_recv, NULL, &read_cnt);
+    m1_route_item_t route[] = {
+        make_route("fast", M1_LINK_TYPE_UART, 0x01, "fast", &tx, &rx, 5000, 64),
+    };
+    m1_rx_parse_callback_item_t rx_cb[] = {
+        {M1_TRANSPORT_LAYER_PROTOCOL_TYPE, drop_rx},
+    };
+    u8 source_id = 0x02;
+    m1_t* m1 = m1_protocol_init("rx", 4096, route, 1, rx_cb, 1, &source_id,
+                                1);
+    ASSERT_NE(m1, nullptr);
+
+    /* 5 kHz rounds to a 0 ms period, which must not turn into busy polling */
+    auto start = std::chrono::steady_clock::now();
+    while (elapsed_ms_since(start) < 50) {
+        EXPECT_EQ(m1_protocol_run_wait(m1, 1000), E_STATE_OK);
+    }
+    EXPECT_LE(read_cnt, 100u);
+    m1_protocol_deinit(m1);
+}
+
+TEST(M1Protocol, RunWaitWakesOnTxData) {
+    tx_async_t tx = make_tx(count_send);
+    m1_route_item_t route[] = {
+        make_route("link", M1_LINK_TYPE_UART, 0x10, "peer", &tx, NULL, 1, 64),
+    };
+    m1_rx_parse_callback_item_t rx_cb[] = {
+        {M1_TRANSPORT_LAYER_PROTOCOL_TYPE, drop_rx},
+    };
+    u8 source_id = 0x01;
+    m1_t* m1 = m1_protocol_init("test", 4096, route, 1, rx_cb, 1, &source_id,
+                                1);
+    ASSERT_NE(m1, nullptr);
+
+    tx_frame_cnt = 0;
+    auto start = std::chrono::steady_clock::now();
+    std::thread runner([m1] { m1_protocol_run_wait(m1, 5000); });
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    u8 target_id = 0x10;
+    u8 data[4] = {0};
+    m1_tx_data_t tx_data = {};
+    tx_data.target_id = &target_id;
+    tx_data.target_id_len = 1;
+    tx_data.data = data;
+    tx_data.data_len = sizeof(data);
+    tx_data.data_type = M1_TRANSPORT_LAYER_PROTOCOL_TYPE;
+    ASSERT_EQ(m1_protocol_tx_data(m1, &tx_data), E_STATE_OK);
+    runner.join();
+
+    EXPECT_EQ(tx_frame_cnt.load(), 1u);
+    EXPECT_LT(elapsed_ms_since(start), 1000);
+    m1_protocol_deinit(m1);
+}
+
+TEST(M1Protocol, RunWaitWakesForRetransmission) {
+    tx_async_t tx = make_tx(count_send);
+    m1_route_item_t route[] = {
+        make_route("link", M1_LINK_TYPE_UART, 0x10, "peer", &tx, NULL, 1, 64),
+    };
+    m1_rx_parse_callback_item_t rx_cb[] = {
+        {M1_TRANSPORT_LAYER_PROTOCOL_TYPE, drop_rx},
+    };
+    u8 source_id = 0x01;
+    m1_t* m1 = m1_protocol_init("test", 4096, route, 1, rx_cb, 1, &source_id,
+                                1);
+    ASSERT_NE(m1, nullptr);
+
+    u8 target_id = 0x10;
+    u8 data[4] = {0};
+    m1_tx_data_t tx_data = {};
+    tx_data.target_id = &target_id;
+    tx_data.target_id_len = 1;
+    tx_data.data = data;
+    tx_data.data_len = sizeof(data);
+    tx_data.data_type = M1_TRANSPORT_LAYER_PROTOCOL_TYPE;
+    tx_data.reliable_tx = M1_RELIABLE_TX;
+    ASSERT_EQ(m1_protocol_tx_data(m1, &tx_data), E_STATE_OK);
+
+    /* Nothing but the missing ACK can end an unbounded wait */
+    const i64 ack_wait_ms = 1000; /* ACK_WAIT_TIME_MS of the transport */
+    tx_frame_cnt = 0;
+    auto start = std::chrono::steady_clock::now();
+    while (tx_frame_cnt < 2) {
+        ASSERT_EQ(m1_protocol_run_wait(m1, -1), E_STATE_OK);
+    }
+    i64 elapsed_ms = elapsed_ms_since(start);
+    EXPECT_GE(elapsed_ms, ack_wait_ms - 10);
+    EXPECT_LT(elapsed_ms, ack_wait_ms + 500);
+    m1_protocol_deinit(m1);
+}
+
+TEST(M1Protocol, SizesRxBuffersPerLink) {
+    size_t offered[4] = {0};
+    rx_async_t rx[4] = {
+        make_rx(offer_recv, NULL, &offered[0]),
+        make_rx(offer_recv, NULL, &offered[1]),
+        make_rx(offer_recv, NULL, &offered[2]),
+        make_rx(offer_recv, NULL, &offered[3]),
+    };
+    tx_async_t tx = make_tx(count_send);
+    m1_route_item_t route[] = {
+        make_route("uart0", M1_LINK_TYPE_UART, 0x10, "a", &tx, &rx[0], 1, 64),
+        make_route("uart1", M1_LINK_TYPE_UART, 0x11, "b", &tx, &rx[1], 1000,
+                   64),
+        make_route("uart2", M1_LINK_TYPE_UART, 0x12, "c", &tx, &rx[2], 1, 64),
+        make_route("uart3", M1_LINK_TYPE_UART, 0x13, "d", &tx, &rx[3], 1, 64),
+    };
+    /* uart0: nothing known about the link */
+    /* uart1: 2 Mbaud polled at 1 kHz, 200 bytes per poll, twice that rounded */
+    route[1].link_rate = 200000;
+    /* uart2: explicit size wins over the rate */
+    route[2].link_rate = 200000;
+    route[2].rx_buf_size = 3000;
+    /* uart3: rate far beyond one poll period is clamped */
+    route[3].link_rate = 100000000;
+    m1_rx_parse_callback_item_t rx_cb[] = {
+        {M1_TRANSPORT_LAYER_PROTOCOL_TYPE, drop_rx},
+    };
+    u8 source_id = 0x01;
+    m1_t* m1 = m1_protocol_init("test", 4096, route, 4, rx_cb, 1, &source_id,
+                                1);
+    ASSERT_NE(m1, nullptr);
+
+    m1_protocol_run(m1, 1);
+    EXPECT_EQ(offered[0], (size_t)M1_RX_BUF_MIN_SIZE);
+    EXPECT_EQ(offered[1], 512u);
+    EXPECT_EQ(offered[2], 3000u);
+    EXPECT_EQ(offered[3], (size_t)M1_RX_BUF_MAX_SIZE);
+    m1_protocol_deinit(m1);
+}
+
+TEST(M1Protocol, ParsesRingFedLinkInPlace) {
+    std::vector<u8> wire;
+    tx_async_t encode_tx = make_tx(append_send, &wire);
+    const size_t frame_num = 2000;
+    encode_frames(0x01, &encode_tx, frame_num);
+
+    /* Smaller than the traffic, so frames keep crossing the wrap */
+    m1_spsc_ring_t* ring = m1_spsc_ring_create(1000);
+    ASSERT_NE(ring, nullptr);
+    rx_async_t rx = {};
+    rx.ring = ring;
+    tx_async_t tx = make_tx(count_send);
+    m1_route_item_t route[] = {
+        make_route("isr", M1_LINK_TYPE_UART, 0x01, "isr", &tx, &rx, 1000, 64),
+    };
+    m1_rx_parse_callback_item_t rx_cb[] = {
+        {M1_TRANSPORT_LAYER_PROTOCOL_TYPE, count_rx},
+    };
+    u8 source_id = 0x02;
+    m1_t* m1 = m1_protocol_init("rx", 4096, route, 1, rx_cb, 1, &source_id,
+                                1);
+    ASSERT_NE(m1, nullptr);
+
+    /* Stands in for the driver's interrupt handler */
+    std::thread producer([ring, &wire] {
+        size_t sent = 0;
+        for (size_t chunk = 1; sent < wire.size(); chunk = chunk % 61 + 1) {
+            size_t len = std::min(chunk, wire.size() - sent);
+            size_t done = m1_spsc_ring_write(ring, wire.data() + sent, len);
+            if (!done) {
+                std::this_thread::yield();
+            }
+            sent += done;
+        }
+    });
+
+    rx_frame_cnt = 0;
+    auto start = std::chrono::steady_clock::now();
+    while (rx_frame_cnt < frame_num && elapsed_ms_since(start) < 5000) {
+        m1_protocol_run(m1, 1000);
+    }
+    producer.join();
+    m1_protocol_run(m1, 1000);
+    EXPECT_EQ(rx_frame_cnt.load(), frame_num);
+    EXPECT_EQ(m1_spsc_ring_used(ring), 0u);
+
+    m1_protocol_deinit(m1);
+    m1_spsc_ring_destroy(ring);
+}
+
+/* ----------------------------- end of file -------------------------------- */
@@ -34,22 +34,755 @@
  */
 /* includes ----------------------------------------------------------------- */
 #include <gtest/gtest.h>
+#include <algorithm>
+#include <barrier>
+#include <chrono>
+#include <deque>
+#include <random>
+#include <thread>
+#include <vector>
 #include "./memory_pool/memory_pool.h"
+#ifdef __linux__
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
 
 /* Private configuration ---------------------------------------------------- */
 
 /* Private definitions ------------------------------------------------------ */
 
 /* Private typedefs --------------------------------------------------------- */
+/* Outcome of one run of the traffic mix */
+struct mix_result {
+    double ns_per_op;     /* Mean time of one allocation or free */
+    double overhead;      /* Used pool bytes per byte handed out */
+    mem_size_t max_alloc; /* Largest block still available afterwards */
+    size_t failed;        /* Allocations the pool refused */
+};
+
+/* Per-operation latency of one allocator */
+struct latency_result {
+    double mean_ns;
+    double p99_ns;
+    double p999_ns;
+    double max_ns;
+};
 
 /* Private variables -------------------------------------------------------- */
 
 /* Private function prototypes ---------------------------------------------- */
+static mem_size_t max_alloc(MemoryPool* mp);
+static mix_result run_traffic_mix(MemoryPool* mp, size_t msg_num);
+static latency_result run_fragmented_churn(MemoryPool* mp, size_t op_num);
+static void expect_fully_merged(MemoryPool* mp);
+#ifdef __linux__
+static size_t resident_pages(_MP_Memory* mm);
+#endif
 
 /* Public variables --------------------------------------------------------- */
 
 /* Public functions --------------------------------------------------------- */
+TEST(MemoryPool, SmallAllocationsComeFromSlabs) {
+    MemoryPool* mp = MemoryPoolInit(64 * KB, 64 * KB);
+    ASSERT_NE(mp, nullptr);
+
+    std::vector<u_char*> blocks;
+    mem_size_t prog = 0;
+    for (mem_size_t size = 1; size <= MP_SLAB_MAX_SIZE; size += 7) {
+        u_char* p = (u_char*)MemoryPoolAlloc(mp, size);
+        ASSERT_NE(p, nullptr);
+        memset(p, (int)size, size);
+        blocks.push_back(p);
+        mem_size_t cls = 1 << MP_SLAB_MIN_SHIFT;
+        while (cls < size) {
+            cls <<= 1;
+        }
+        prog += cls;
+    }
+    /* Accounted by size class, not by the slabs holding them */
+    EXPECT_EQ(GetProgMemory(mp), prog);
+
+    for (size_t i = 0; i < blocks.size(); i++) {
+        mem_size_t size = 1 + 7 * (mem_size_t)i;
+        for (mem_size_t j = 0; j < size; j++) {
+            ASSERT_EQ(blocks[i][j], (u_char)size);
+        }
+        EXPECT_EQ(MemoryPoolFree(mp, blocks[i]), 0);
+    }
+    EXPECT_EQ(GetProgMemory(mp), 0u);
+    MemoryPoolDestroy(mp);
+}
+
+TEST(MemoryPool, SlabsDoNotStarveLargeAllocations) {
+    MemoryPool* mp = MemoryPoolInit(4 * KB, 4 * KB);
+    ASSERT_NE(mp, nullptr);
+
+    /* Leave an empty slab cached in every size class */
+    for (mem_size_t size = 16; size <= MP_SLAB_MAX_SIZE; size <<= 1) {
+        void* p = MemoryPoolAlloc(mp, size);
+        ASSERT_NE(p, nullptr);
+        MemoryPoolFree(mp, p);
+    }
+    void* big = MemoryPoolAlloc(mp, 3 * KB);
+    EXPECT_NE(big, nullptr);
+    MemoryPoolFree(mp, big);
+    MemoryPoolDestroy(mp);
+}
+
+TEST(MemoryPool, LargeAndDisabledSlabAllocationsUseFirstFit) {
+    MemoryPool* mp = MemoryPoolInit(64 * KB, 64 * KB);
+    ASSERT_NE(mp, nullptr);
+
+    void* big = MemoryPoolAlloc(mp, MP_SLAB_MAX_SIZE + 1);
+    ASSERT_NE(big, nullptr);
+    void* slab_obj = MemoryPoolAlloc(mp, 32);
+    ASSERT_NE(slab_obj, nullptr);
+
+    ASSERT_EQ(MemoryPoolSetSlab(mp, 0), 0);
+    mem_size_t used = GetUsedMemory(mp);
+    void* small = MemoryPoolAlloc(mp, 32);
+    ASSERT_NE(small, nullptr);
+    /* A first-fit chunk carries its own header and trailer */
+    EXPECT_GT(GetUsedMemory(mp), used + 32);
+
+    /* Objects from either path can be freed whatever the setting */
+    EXPECT_EQ(MemoryPoolFree(mp, slab_obj), 0);
+    EXPECT_EQ(MemoryPoolFree(mp, small), 0);
+    EXPECT_EQ(MemoryPoolFree(mp, big), 0);
+    EXPECT_EQ(GetProgMemory(mp), 0u);
+    MemoryPoolDestroy(mp);
+}
+
+TEST(MemoryPool, ClearDropsSlabs) {
+    MemoryPool* mp = MemoryPoolInit(16 * KB, 16 * KB);
+    ASSERT_NE(mp, nullptr);
+    for (int i = 0; i < 100; i++) {
+        ASSERT_NE(MemoryPoolAlloc(mp, 24), nullptr);
+    }
+    MemoryPoolClear(mp);
+    EXPECT_EQ(GetUsedMemory(mp), 0u);
+    EXPECT_EQ(GetProgMemory(mp), 0u);
+    EXPECT_NE(MemoryPoolAlloc(mp, 12 * KB), nullptr);
+    MemoryPoolDestroy(mp);
+}
+
+TEST(MemoryPool, FreesIntoTheOwningBlockAfterExtending) {
+    /* The last extension is only half as large as the others */
+    MemoryPool* mp = MemoryPoolInit(34 * KB, 4 * KB);
+    ASSERT_NE(mp, nullptr);
+    MemoryPoolSetSlab(mp, 0);
+
+    std::vector<void*> blocks;
+    void* p;
+    while ((p = MemoryPoolAlloc(mp, 1000)) != nullptr) {
+        blocks.push_back(p);
+    }
+    mem_size_t mlist_len = 0;
+    get_memory_list_count(mp, &mlist_len);
+    EXPECT_EQ(mlist_len, 9u);
+    EXPECT_EQ(GetTotalMemory(mp), 34 * KB);
+
+    std::shuffle(blocks.begin(), blocks.end(), std::mt19937(7));
+    for (void* b : blocks) {
+        ASSERT_EQ(MemoryPoolFree(mp, b), 0);
+    }
+    EXPECT_EQ(GetUsedMemory(mp), 0u);
+
+    /* Every block merged back into a single free chunk */
+    for (_MP_Memory* mm = mp->mlist; mm; mm = mm->next) {
+        mem_size_t free_len = 0, alloc_len = 0;
+        get_memory_info(mp, mm, &free_len, &alloc_len);
+        EXPECT_EQ(free_len, 1u);
+        EXPECT_EQ(alloc_len, 0u);
+    }
+    MemoryPoolDestroy(mp);
+}
+
+TEST(MemoryPool, TlsfKeepsDataAndMergesOnFree) {
+    MemoryPool* mp = MemoryPoolInitEx(256 * KB, 32 * KB, MP_STRATEGY_TLSF);
+    ASSERT_NE(mp, nullptr);
+    MemoryPoolSetSlab(mp, 0);
+
+    std::mt19937 rng(3);
+    std::uniform_int_distribution<mem_size_t> size(1, 3000);
+    std::vector<std::pair<u_char*, mem_size_t>> live;
+    for (int i = 0; i < 20000; i++) {
+        if (live.empty() || rng() % 3) {
+            mem_size_t len = size(rng);
+            u_char* p = (u_char*)MemoryPoolAlloc(mp, len);
+            if (!p) {
+                continue;
+            }
+            memset(p, (int)(len & 0xff), len);
+            live.emplace_back(p, len);
+        } else {
+            size_t idx = rng() % live.size();
+            u_char* p = live[idx].first;
+            mem_size_t len = live[idx].second;
+            ASSERT_TRUE(std::all_of(p, p + len, [len](u_char c) {
+                return c == (u_char)(len & 0xff);
+            }));
+            ASSERT_EQ(MemoryPoolFree(mp, p), 0);
+            live[idx] = live.back();
+            live.pop_back();
+        }
+    }
+    mem_size_t mlist_len = 0;
+    get_memory_list_count(mp, &mlist_len);
+    EXPECT_GT(mlist_len, 1u);
+
+    for (auto& b : live) {
+        MemoryPoolFree(mp, b.first);
+    }
+    EXPECT_EQ(GetUsedMemory(mp), 0u);
+    EXPECT_EQ(GetProgMemory(mp), 0u);
+    expect_fully_merged(mp);
+
+    /* A whole block is available again */
+    void* big = MemoryPoolAlloc(mp, 30 * KB);
+    EXPECT_NE(big, nullptr);
+    MemoryPoolFree(mp, big);
+    MemoryPoolClear(mp);
+    expect_fully_merged(mp);
+    MemoryPoolDestroy(mp);
+}
+
+TEST(MemoryPool, TlsfReportsTheSameStatsAsFirstFit) {
+    MemoryPool* ff = MemoryPoolInit(64 * KB, 64 * KB);
+    MemoryPool* tlsf = MemoryPoolInitEx(64 * KB, 64 * KB, MP_STRATEGY_TLSF);
+    ASSERT_NE(ff, nullptr);
+    ASSERT_NE(tlsf, nullptr);
+
+    void* a[2][3];
+    MemoryPool* pools[2] = {ff, tlsf};
+    for (int i = 0; i < 2; i++) {
+        a[i][0] = MemoryPoolAlloc(pools[i], 20);
+        a[i][1] = MemoryPoolAlloc(pools[i], 1000);
+        a[i][2] = MemoryPoolAlloc(pools[i], 5000);
+        MemoryPoolFree(pools[i], a[i][1]);
+    }
+    EXPECT_EQ(GetUsedMemory(ff), GetUsedMemory(tlsf));
+    EXPECT_EQ(GetProgMemory(ff), GetProgMemory(tlsf));
+    EXPECT_FLOAT_EQ(MemoryPoolGetUsage(ff), MemoryPoolGetUsage(tlsf));
+    EXPECT_FLOAT_EQ(MemoryPoolGetProgUsage(ff), MemoryPoolGetProgUsage(tlsf));
+
+    for (int i = 0; i < 2; i++) {
+        MemoryPoolFree(pools[i], a[i][0]);
+        MemoryPoolFree(pools[i], a[i][2]);
+        MemoryPoolDestroy(pools[i]);
+    }
+}
+
+/*
+ * Benchmark, run with --gtest_also_run_disabled_tests. Replays the TX
+ * allocation pattern of the m1 stack (packet, packet data with payload and a
+ * short-lived frame buffer per message, the first two held until their ACK)
+ * with and without the slabs.
+ */
+TEST(MemoryPoolBench, DISABLED_SlabVersusFirstFit) {
+    const size_t msg_num = 200000;
+    for (int slab = 1; slab >= 0; slab--) {
+        MemoryPool* mp = MemoryPoolInit(256 * KB, 256 * KB);
+        ASSERT_NE(mp, nullptr);
+        MemoryPoolSetSlab(mp, slab);
+        mix_result res = run_traffic_mix(mp, msg_num);
+        printf("%-10s %7.1f ns/op  overhead %.2f  largest free %u  "
+               "failed %zu\n",
+               slab ? "slab" : "first-fit", res.ns_per_op, res.overhead,
+               (unsigned int)res.max_alloc, res.failed);
+        MemoryPoolDestroy(mp);
+    }
+}
+
+/*
+ * Benchmark, run with --gtest_also_run_disabled_tests. Churns a fragmented
+ * pool with mixed sizes and reports the latency distribution of every
+ * allocation and free under both strategies. Slabs are off so only the
+ * general allocator is measured.
+ */
+TEST(MemoryPoolBench, DISABLED_TlsfVersusFirstFitLatency) {
+    const size_t op_num = 200000;
+    const int strategies[] = {MP_STRATEGY_FIRST_FIT, MP_STRATEGY_TLSF};
+    for (int strategy : strategies) {
+        MemoryPool* mp = MemoryPoolInitEx(4 * MB, 4 * MB, strategy);
+        ASSERT_NE(mp, nullptr);
+        MemoryPoolSetSlab(mp, 0);
+        latency_result res = run_fragmented_churn(mp, op_num);
+        printf("%-10s mean %6.1f ns  p99 %7.1f ns  p99.9 %8.1f ns  "
+               "max %9.1f ns\n",
+               strategy == MP_STRATEGY_TLSF ? "tlsf" : "first-fit",
+               res.mean_ns, res.p99_ns, res.p999_ns, res.max_ns);
+        MemoryPoolDestroy(mp);
+    }
+}
+
+TEST(MemoryPool, TrimReleasesIdleExtendedRegions) {
+    const int strategies[] = {MP_STRATEGY_FIRST_FIT, MP_STRATEGY_TLSF};
+    for (int strategy : strategies) {
+        MemoryPool* mp = MemoryPoolInitEx(64 * KB, 8 * KB, strategy);
+        ASSERT_NE(mp, nullptr);
+
+        std::vector<void*> big, small;
+        void* p;
+        while ((p = MemoryPoolAlloc(mp, 2000)) != nullptr) {
+            big.push_back(p);
+            small.push_back(MemoryPoolAlloc(mp, 40));
+        }
+        ASSERT_EQ(GetTotalMemory(mp), 64 * KB);
+
+        /* One object keeps the newest region alive */
+        void* pinned = big.back();
+        big.pop_back();
+        for (void* b : big) {
+            MemoryPoolFree(mp, b);
+        }
+        for (void* b : small) {
+            MemoryPoolFree(mp, b);
+        }
+        mem_size_t released = MemoryPoolTrim(mp);
+        EXPECT_EQ(released, 48 * KB) << strategy;
+        EXPECT_EQ(GetTotalMemory(mp), 16 * KB);
+        mem_size_t mlist_len = 0;
+        get_memory_list_count(mp, &mlist_len);
+        EXPECT_EQ(mlist_len, 2u);
+
+        MemoryPoolFree(mp, pinned);
+        EXPECT_EQ(MemoryPoolTrim(mp), 8 * KB);
+        EXPECT_EQ(GetTotalMemory(mp), 8 * KB);
+        EXPECT_EQ(MemoryPoolTrim(mp), 0u);
+        expect_fully_merged(mp);
+
+        /* The pool can grow again */
+        for (int i = 0; i < 20; i++) {
+            ASSERT_NE(MemoryPoolAlloc(mp, 2000), nullptr);
+        }
+        EXPECT_GT(GetTotalMemory(mp), 8 * KB);
+        MemoryPoolDestroy(mp);
+    }
+}
+
+TEST(MemoryPool, TrimThresholdKeepsHeadroom) {
+    const int strategies[] = {MP_STRATEGY_FIRST_FIT, MP_STRATEGY_TLSF};
+    for (int strategy : strategies) {
+        MemoryPool* mp = MemoryPoolInitEx(64 * KB, 8 * KB, strategy);
+        ASSERT_NE(mp, nullptr);
+        ASSERT_EQ(MemoryPoolSetTrimThreshold(mp, 12 * KB), 0);
+
+        /*
+         * A burst of packets and payloads spreads over every region. It runs
+         * on its own thread so that a thread cache, if any, is handed back
+         * when it ends.
+         */
+        std::thread([mp] {
+            std::deque<void*> burst;
+            void* p;
+            while ((p = MemoryPoolAlloc(mp, 88)) != nullptr) {
+                burst.push_back(p);
+                if ((p = MemoryPoolAlloc(mp, 700)) == nullptr) {
+                    break;
+                }
+                burst.push_back(p);
+            }
+            EXPECT_EQ(GetTotalMemory(mp), 64 * KB);
+
+            while (!burst.empty()) {
+                MemoryPoolFree(mp, burst.front());
+                burst.pop_front();
+            }
+        }).join();
+        /* Back to the first region plus one idle region of headroom */
+        EXPECT_EQ(GetTotalMemory(mp), 16 * KB) << strategy;
+        EXPECT_EQ(GetProgMemory(mp), 0u);
+        MemoryPoolDestroy(mp);
+    }
+}
+
+TEST(MemoryPool, RejectsSizesThatWouldWrapAround) {
+    const mem_size_t huge = (mem_size_t)-1;
+    EXPECT_EQ(MemoryPoolInit(huge, 1 * MB), nullptr);
+    EXPECT_EQ(MemoryPoolInit(MP_MAX_POOL_SIZE + 1, 1 * MB), nullptr);
+
+    const int strategies[] = {MP_STRATEGY_FIRST_FIT, MP_STRATEGY_TLSF};
+    for (int strategy : strategies) {
+        MemoryPool* mp = MemoryPoolInitEx(MP_MAX_POOL_SIZE, 64 * KB, strategy);
+        ASSERT_NE(mp, nullptr);
+        EXPECT_EQ(MemoryPoolAlloc(mp, huge), nullptr);
+        EXPECT_EQ(MemoryPoolAlloc(mp, huge - 8), nullptr);
+        EXPECT_EQ(MemoryPoolAlloc(mp, MP_MAX_POOL_SIZE), nullptr);
+        EXPECT_EQ(MemoryPoolAlloc(mp, 64 * KB), nullptr);
+        /* Exactly what fits next to a chunk header and trailer */
+        mem_size_t fit = 64 * KB - sizeof(_MP_Chunk) - sizeof(_MP_Chunk*);
+        void* p = MemoryPoolAlloc(mp, fit);
+        ASSERT_NE(p, nullptr) << strategy;
+        /* Larger than a region can ever hold, extending does not help */
+        EXPECT_EQ(MemoryPoolAlloc(mp, fit + 1), nullptr);
+        MemoryPoolFree(mp, p);
+        MemoryPoolDestroy(mp);
+    }
+}
+
+#ifdef __linux__
+TEST(MemoryPool, ServesBlocksLargerThan4GB) {
+    if (sizeof(mem_size_t) < 8) {
+        GTEST_SKIP() << "32-bit build";
+    }
+    const int strategies[] = {MP_STRATEGY_FIRST_FIT, MP_STRATEGY_TLSF};
+    for (int strategy : strategies) {
+        /* Only the touched pages are ever backed */
+        const mem_size_t region = 4 * GB + GB / 2;
+        MemoryPool* mp =
+            MemoryPoolInitEx(2 * region, region, strategy | MP_REGION_MMAP);
+        if (!mp) {
+            GTEST_SKIP() << "cannot reserve 4.5 GB of address space";
+        }
+        EXPECT_EQ(GetTotalMemory(mp), region);
+
+        mem_size_t size = 4 * GB + 123;
+        u_char* p = (u_char*)MemoryPoolAlloc(mp, size);
+        ASSERT_NE(p, nullptr) << strategy;
+        p[0] = 1;
+        p[4 * GB] = 2;
+        p[size - 1] = 3;
+        EXPECT_GT(GetUsedMemory(mp), size);
+        EXPECT_GE(GetProgMemory(mp), size);
+        EXPECT_GT(MemoryPoolGetUsage(mp), 0.8f);
+
+        /* The rest of the region and a second region still work */
+        void* small = MemoryPoolAlloc(mp, 100 * MB);
+        EXPECT_NE(small, nullptr);
+        void* second = MemoryPoolAlloc(mp, 4 * GB);
+        EXPECT_NE(second, nullptr);
+        EXPECT_EQ(GetTotalMemory(mp), 2 * region);
+
+        MemoryPoolFree(mp, p);
+        MemoryPoolFree(mp, small);
+        MemoryPoolFree(mp, second);
+        EXPECT_EQ(GetUsedMemory(mp), 0u);
+        EXPECT_EQ(MemoryPoolTrim(mp), region);
+        MemoryPoolDestroy(mp);
+    }
+}
+
+TEST(MemoryPool, MapsRegionsWithTheRequestedOptions) {
+    const int flag_sets[] = {
+        MP_REGION_MMAP,
+        MP_REGION_POPULATE,
+        MP_REGION_HUGEPAGE | MP_STRATEGY_TLSF,
+        MP_REGION_LOCK | MP_REGION_POPULATE,
+    };
+    size_t page = (size_t)sysconf(_SC_PAGESIZE);
+    for (int flags : flag_sets) {
+        MemoryPool* mp = MemoryPoolInitEx(256 * KB, 64 * KB, flags);
+        ASSERT_NE(mp, nullptr) << flags;
+        std::vector<void*> blocks;
+        for (int i = 0; i < 200; i++) {
+            void* p = MemoryPoolAlloc(mp, 1000);
+            ASSERT_NE(p, nullptr) << flags;
+            memset(p, i, 1000);
+            blocks.push_back(p);
+        }
+        for (_MP_Memory* mm = mp->mlist; mm; mm = mm->next) {
+            EXPECT_NE(mm->map_len, 0u);
+            EXPECT_EQ(mm->map_len % page, 0u);
+            EXPECT_GE(mm->map_len, sizeof(_MP_Memory) + mm->mempool_size);
+        }
+        for (void* p : blocks) {
+            MemoryPoolFree(mp, p);
+        }
+        EXPECT_EQ(GetUsedMemory(mp), 0u);
+        MemoryPoolDestroy(mp);
+    }
+}
+
+TEST(MemoryPool, ClearReturnsMappedPagesToTheSystem) {
+    MemoryPool* mp = MemoryPoolInitEx(4 * MB, 4 * MB, MP_REGION_MMAP);
+    ASSERT_NE(mp, nullptr);
+    void* p = MemoryPoolAlloc(mp, 3 * MB);
+    ASSERT_NE(p, nullptr);
+    memset(p, 1, 3 * MB);
+    size_t touched = resident_pages(mp->mlist);
+    size_t page = (size_t)sysconf(_SC_PAGESIZE);
+    EXPECT_GE(touched, 3 * MB / page);
+
+    MemoryPoolFree(mp, p);
+    MemoryPoolClear(mp);
+    EXPECT_LE(resident_pages(mp->mlist), 2u);
+    /* The pool is still usable, pages come back zeroed on demand */
+    p = MemoryPoolAlloc(mp, 3 * MB);
+    ASSERT_NE(p, nullptr);
+    memset(p, 2, 3 * MB);
+    MemoryPoolDestroy(mp);
+}
+#endif /* __linux__ */
+
+#ifdef _Z_MEMORYPOOL_THREAD_
+TEST(MemoryPool, ThreadCachesHandBackCrossThreadFrees) {
+    const int thread_num = 4;
+    const int obj_num = 500;
+    MemoryPool* mp = MemoryPoolInit(1 * MB, 1 * MB);
+    ASSERT_NE(mp, nullptr);
+
+    std::vector<std::vector<std::pair<u_char*, mem_size_t>>> objs(thread_num);
+    std::barrier sync(thread_num);
+    std::vector<std::thread> threads;
+    for (int t = 0; t < thread_num; t++) {
+        threads.emplace_back([&, t] {
+            std::mt19937 rng(t);
+            std::uniform_int_distribution<mem_size_t> size(1, MP_SLAB_MAX_SIZE);
+            for (int i = 0; i < obj_num; i++) {
+                mem_size_t len = size(rng);
+                u_char* p = (u_char*)MemoryPoolAlloc(mp, len);
+                if (p) {
+                    memset(p, t, len);
+                    objs[t].emplace_back(p, len);
+                }
+            }
+            sync.arrive_and_wait();
+            /* Free what the neighbouring thread allocated */
+            for (auto& obj : objs[(t + 1) % thread_num]) {
+                int owner = (t + 1) % thread_num;
+                EXPECT_TRUE(std::all_of(obj.first, obj.first + obj.second,
+                                        [owner](u_char c) {
+                                            return c == (u_char)owner;
+                                        }));
+                MemoryPoolFree(mp, obj.first);
+            }
+        });
+    }
+    for (auto& th : threads) {
+        th.join();
+    }
+    for (auto& v : objs) {
+        EXPECT_EQ(v.size(), (size_t)obj_num);
+    }
+
+    /* Exiting threads returned their caches */
+    EXPECT_EQ(GetProgMemory(mp), 0u);
+    void* big = MemoryPoolAlloc(mp, 1 * MB - 4 * KB);
+    EXPECT_NE(big, nullptr);
+    MemoryPoolFree(mp, big);
+    MemoryPoolDestroy(mp);
+}
+
+TEST(MemoryPool, ExhaustionDrainsEveryThreadCache) {
+    MemoryPool* mp = MemoryPoolInit(64 * KB, 64 * KB);
+    ASSERT_NE(mp, nullptr);
+    mem_size_t fresh = max_alloc(mp);
+
+    /* Another thread caches a few objects and stays alive */
+    std::barrier sync(2);
+    std::thread holder([&] {
+        void* p[8];
+        for (auto& obj : p) {
+            obj = MemoryPoolAlloc(mp, 64);
+            EXPECT_NE(obj, nullptr);
+        }
+        for (auto& obj : p) {
+            MemoryPoolFree(mp, obj);
+        }
+        sync.arrive_and_wait();
+        sync.arrive_and_wait();
+        /* Its cache was handed back, the next allocation refills it */
+        void* again = MemoryPoolAlloc(mp, 64);
+        EXPECT_NE(again, nullptr);
+        MemoryPoolFree(mp, again);
+    });
+    sync.arrive_and_wait();
+    EXPECT_EQ(max_alloc(mp), fresh);
+    sync.arrive_and_wait();
+    holder.join();
+    EXPECT_EQ(GetProgMemory(mp), 0u);
+    MemoryPoolDestroy(mp);
+}
+
+/*
+ * Benchmark, run with --gtest_also_run_disabled_tests. Every thread keeps a
+ * small window of packet-sized objects alive, once served from the thread
+ * caches and once from the locked first-fit path.
+ */
+TEST(MemoryPoolBench, DISABLED_ThreadCacheScaling) {
+    const size_t op_num = 1000000;
+    for (int slab = 1; slab >= 0; slab--) {
+        for (int thread_num = 1; thread_num <= 4; thread_num <<= 1) {
+            MemoryPool* mp = MemoryPoolInit(4 * MB, 4 * MB);
+            ASSERT_NE(mp, nullptr);
+            MemoryPoolSetSlab(mp, slab);
+            auto start = std::chrono::steady_clock::now();
+            std::vector<std::thread> threads;
+            for (int t = 0; t < thread_num; t++) {
+                threads.emplace_back([&] {
+                    std::deque<void*> window;
+                    for (size_t i = 0; i < op_num / thread_num; i++) {
+                        window.push_back(MemoryPoolAlloc(mp, 88));
+                        if (window.size() > 16) {
+                            MemoryPoolFree(mp, window.front());
+                            window.pop_front();
+                        }
+                    }
+                    for (void* p : window) {
+                        MemoryPoolFree(mp, p);
+                    }
+                });
+            }
+            for (auto& th : threads) {
+                th.join();
+            }
+            auto ns = std::chrono::duration<double, std::nano>(
+                          std::chrono::steady_clock::now() - start)
+                          .count();
+            printf("%-10s %d threads %7.1f ns per alloc+free\n",
+                   slab ? "cache" : "locked", thread_num, ns / op_num);
+            MemoryPoolDestroy(mp);
+        }
+    }
+}
+#endif /* _Z_MEMORYPOOL_THREAD_ */
 
 /* Private functions -------------------------------------------------------- */
+/* Largest block the pool can still hand out */
+static mem_size_t max_alloc(MemoryPool* mp) {
+    mem_size_t lo = 0;
+    mem_size_t hi = GetTotalMemory(mp);
+    while (lo < hi) {
+        mem_size_t mid = lo + (hi - lo + 1) / 2;
+        void* p = MemoryPoolAlloc(mp, mid);
+        if (p) {
+            MemoryPoolFree(mp, p);
+            lo = mid;
+        } else {
+            hi = mid - 1;
+        }
+    }
+    return lo;
+}
+
+static mix_result run_traffic_mix(MemoryPool* mp, size_t msg_num) {
+    const size_t window = 64;       /* Messages waiting for their ACK */
+    const mem_size_t packet = 88;   /* sizeof(m1_packet_t) */
+    const mem_size_t data_head = 24; /* sizeof(m1_packet_data_t) */
+    const mem_size_t frame_head = 14; /* Frame header and CRC16 */
+    std::mt19937 rng(1);
+    std::uniform_int_distribution<int> payload(1, 256);
+    std::deque<std::pair<void*, void*>> pending;
+
+    mix_result res = {};
+    size_t ops = 0;
+    mem_size_t peak_used = 0;
+    mem_size_t peak_prog = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < msg_num; i++) {
+        mem_size_t len = (mem_size_t)payload(rng);
+        void* pkt = MemoryPoolAlloc(mp, packet);
+        void* data = MemoryPoolAlloc(mp, data_head + len);
+        void* frame = MemoryPoolAlloc(mp, frame_head + len);
+        ops += 3;
+        res.failed += !pkt + !data + !frame;
+        MemoryPoolFree(mp, frame);
+        ops++;
+
+        pending.emplace_back(pkt, data);
+        if (pending.size() > window) {
+            /* ACKs do not always come back in order */
+            size_t idx = rng() % 4;
+            MemoryPoolFree(mp, pending[idx].first);
+            MemoryPoolFree(mp, pending[idx].second);
+            pending.erase(pending.begin() + idx);
+            ops += 2;
+        }
+        if (i % 1024 == 0) {
+            peak_used = std::max(peak_used, GetUsedMemory(mp));
+            peak_prog = std::max(peak_prog, GetProgMemory(mp));
+        }
+    }
+    auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                  std::chrono::steady_clock::now() - start)
+                  .count();
+    res.ns_per_op = (double)ns / ops;
+    res.overhead = peak_prog ? (double)peak_used / peak_prog : 0;
+    res.max_alloc = max_alloc(mp);
+
+    for (auto& msg : pending) {
+        MemoryPoolFree(mp, msg.first);
+        MemoryPoolFree(mp, msg.second);
+    }
+    return res;
+}
+
+static latency_result run_fragmented_churn(MemoryPool* mp, size_t op_num) {
+    std::mt19937 rng(5);
+    std::uniform_int_distribution<mem_size_t> size(16, 4096);
+    std::vector<void*> live;
+
+    /* Fill about 70% of the pool, then punch holes into it */
+    void* p;
+    while (GetUsedMemory(mp) < GetTotalMemory(mp) / 10 * 7 &&
+           (p = MemoryPoolAlloc(mp, size(rng))) != nullptr) {
+        live.push_back(p);
+    }
+    for (size_t i = 0; i < live.size(); i += 2) {
+        MemoryPoolFree(mp, live[i]);
+        live[i] = live.back();
+        live.pop_back();
+    }
+
+    std::vector<double> ns;
+    ns.reserve(op_num);
+    for (size_t i = 0; i < op_num; i++) {
+        bool do_alloc = live.empty() || rng() % 2;
+        mem_size_t len = size(rng);
+        size_t idx = live.empty() ? 0 : rng() % live.size();
+        auto start = std::chrono::steady_clock::now();
+        if (do_alloc) {
+            p = MemoryPoolAlloc(mp, len);
+        } else {
+            MemoryPoolFree(mp, live[idx]);
+        }
+        auto end = std::chrono::steady_clock::now();
+        ns.push_back(
+            std::chrono::duration<double, std::nano>(end - start).count());
+        if (!do_alloc) {
+            live[idx] = live.back();
+            live.pop_back();
+        } else if (p) {
+            live.push_back(p);
+        }
+    }
+    for (void* b : live) {
+        MemoryPoolFree(mp, b);
+    }
+
+    latency_result res = {};
+    for (double v : ns) {
+        res.mean_ns += v;
+    }
+    res.mean_ns /= ns.size();
+    std::sort(ns.begin(), ns.end());
+    res.p99_ns = ns[ns.size() * 99 / 100];
+    res.p999_ns = ns[ns.size() * 999 / 1000];
+    res.max_ns = ns.back();
+    return res;
+}
+
+#ifdef __linux__
+static size_t resident_pages(_MP_Memory* mm) {
+    size_t page = (size_t)sysconf(_SC_PAGESIZE);
+    std::vector<unsigned char> vec((mm->map_len + page - 1) / page);
+    if (mincore(mm, mm->map_len, vec.data())) {
+        return 0;
+    }
+    return (size_t)std::count_if(vec.begin(), vec.end(),
+                                 [](unsigned char v) { return v & 1; });
+}
+#endif
+
+/* Every block of an idle pool is one free chunk again */
+static void expect_fully_merged(MemoryPool* mp) {
+    for (_MP_Memory* mm = mp->mlist; mm; mm = mm->next) {
+        mem_size_t free_len = 0, alloc_len = 0;
+        get_memory_info(mp, mm, &free_len, &alloc_len);
+        EXPECT_EQ(free_len, 1u);
+        EXPECT_EQ(alloc_len, 0u);
+    }
+}
 
 /* ----------------------------- end of file -------------------------------- */